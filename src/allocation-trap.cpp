@@ -0,0 +1,152 @@
+// Global allocation replacements, linked only when LIMIT_ALLOCATION_TRAP is
+// enabled. Allocations made inside a ScopedRealtimeSection are counted before
+// being forwarded to malloc so the sanitizer test run can flag audio-thread
+// allocations without aborting the process.
+//
+// JUCE containers (HeapBlock, Array, MidiBuffer) call malloc and realloc
+// directly, so on GCC/Clang builds the C allocator is wrapped at link time
+// (LIMIT_ALLOCATION_TRAP_WRAPS_MALLOC, see CMakeLists.txt) and operator new
+// is counted on its way through malloc. Without the wrap, only operator new
+// is counted. Frees are never counted.
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include "realtime-guard.h"
+
+namespace {
+void noteAllocation() {
+  if (limit::isInRealtimeSection()) {
+    limit::noteRealtimeAllocation();
+  }
+}
+
+// Under the malloc wrap these calls land in the __wrap_ functions below,
+// which do the counting.
+auto trappedAllocate(std::size_t size) -> void * {
+#if !defined(LIMIT_ALLOCATION_TRAP_WRAPS_MALLOC)
+  noteAllocation();
+#endif
+  // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+auto trappedAllocateAligned(std::size_t size, std::align_val_t alignment) -> void * {
+#if !defined(LIMIT_ALLOCATION_TRAP_WRAPS_MALLOC)
+  noteAllocation();
+#endif
+  const auto align = static_cast<std::size_t>(alignment);
+  const auto padded = std::max<std::size_t>(((size + align - 1) / align) * align, align);
+  // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+  return std::aligned_alloc(align, padded);
+}
+
+void trappedFree(void *pointer) {
+  // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+  std::free(pointer);
+}
+} // namespace
+
+#if defined(LIMIT_ALLOCATION_TRAP_WRAPS_MALLOC)
+// NOLINTBEGIN(bugprone-reserved-identifier,modernize-use-trailing-return-type)
+extern "C" {
+void *__real_malloc(std::size_t size);
+void *__real_calloc(std::size_t count, std::size_t size);
+void *__real_realloc(void *pointer, std::size_t size);
+void *__real_aligned_alloc(std::size_t alignment, std::size_t size);
+int __real_posix_memalign(void **pointer, std::size_t alignment, std::size_t size);
+
+void *__wrap_malloc(std::size_t size) {
+  noteAllocation();
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(std::size_t count, std::size_t size) {
+  noteAllocation();
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, std::size_t size) {
+  noteAllocation();
+  return __real_realloc(pointer, size);
+}
+
+void *__wrap_aligned_alloc(std::size_t alignment, std::size_t size) {
+  noteAllocation();
+  return __real_aligned_alloc(alignment, size);
+}
+
+int __wrap_posix_memalign(void **pointer, std::size_t alignment, std::size_t size) {
+  noteAllocation();
+  return __real_posix_memalign(pointer, alignment, size);
+}
+}
+// NOLINTEND(bugprone-reserved-identifier,modernize-use-trailing-return-type)
+#endif
+
+// NOLINTBEGIN(cppcoreguidelines-owning-memory,modernize-use-trailing-return-type)
+void *operator new(std::size_t size) {
+  if (auto *pointer = trappedAllocate(size)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+  if (auto *pointer = trappedAllocate(size)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t & /*tag*/) noexcept {
+  return trappedAllocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t & /*tag*/) noexcept {
+  return trappedAllocate(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  if (auto *pointer = trappedAllocateAligned(size, alignment)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  if (auto *pointer = trappedAllocateAligned(size, alignment)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment,
+                   const std::nothrow_t & /*tag*/) noexcept {
+  return trappedAllocateAligned(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment,
+                     const std::nothrow_t & /*tag*/) noexcept {
+  return trappedAllocateAligned(size, alignment);
+}
+
+void operator delete(void *pointer) noexcept { trappedFree(pointer); }
+void operator delete[](void *pointer) noexcept { trappedFree(pointer); }
+void operator delete(void *pointer, std::size_t /*size*/) noexcept { trappedFree(pointer); }
+void operator delete[](void *pointer, std::size_t /*size*/) noexcept { trappedFree(pointer); }
+void operator delete(void *pointer, std::align_val_t /*alignment*/) noexcept {
+  trappedFree(pointer);
+}
+void operator delete[](void *pointer, std::align_val_t /*alignment*/) noexcept {
+  trappedFree(pointer);
+}
+void operator delete(void *pointer, std::size_t /*size*/, std::align_val_t /*alignment*/) noexcept {
+  trappedFree(pointer);
+}
+void operator delete[](void *pointer, std::size_t /*size*/,
+                       std::align_val_t /*alignment*/) noexcept {
+  trappedFree(pointer);
+}
+// NOLINTEND(cppcoreguidelines-owning-memory,modernize-use-trailing-return-type)
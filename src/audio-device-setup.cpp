@@ -0,0 +1,276 @@
+#include "audio-device-setup.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace limit {
+namespace {
+constexpr int kJackRank = 3;
+constexpr int kAlsaRank = 2;
+constexpr int kDirectHardwareRank = 3;
+constexpr int kConvertingHardwareRank = 2;
+constexpr int kOtherDeviceRank = 1;
+constexpr double kLatencyProbeTimeoutSeconds = 1.0;
+constexpr double kMillisecondsPerSecond = 1000.0;
+
+auto contains(std::string_view text, std::string_view part) -> bool {
+  return text.find(part) != std::string_view::npos;
+}
+
+auto trim(std::string_view text) -> std::string_view {
+  const auto first = text.find_first_not_of(" \t\r");
+  if (first == std::string_view::npos) {
+    return {};
+  }
+  const auto last = text.find_last_not_of(" \t\r");
+  return text.substr(first, last - first + 1);
+}
+
+template <typename Number> auto parseNumber(std::string_view text) -> std::optional<Number> {
+  Number value{};
+  const auto *end = text.data() + text.size();
+  const auto [ptr, error] = std::from_chars(text.data(), end, value);
+  if (error != std::errc{} || ptr != end) {
+    return std::nullopt;
+  }
+  return value;
+}
+} // namespace
+
+auto parseAudioDeviceProfile(std::string_view text) -> std::optional<AudioDeviceProfile> {
+  AudioDeviceProfile profile;
+  while (!text.empty()) {
+    const auto end = text.find('\n');
+    const auto line = trim(text.substr(0, end));
+    text = end == std::string_view::npos ? std::string_view{} : text.substr(end + 1);
+
+    const auto split = line.find(' ');
+    if (line.empty() || line.front() == '#' || split == std::string_view::npos) {
+      continue;
+    }
+    const auto key = line.substr(0, split);
+    const auto value = trim(line.substr(split + 1));
+    if (key == "type") {
+      profile.type = value;
+    } else if (key == "output") {
+      profile.output_device = value;
+    } else if (key == "input") {
+      profile.input_device = value;
+    } else if (key == "sample-rate") {
+      const auto rate = parseNumber<double>(value);
+      if (!rate || *rate <= 0.0) {
+        return std::nullopt;
+      }
+      profile.sample_rate = *rate;
+    } else if (key == "buffer-size") {
+      const auto size = parseNumber<int>(value);
+      if (!size || *size <= 0) {
+        return std::nullopt;
+      }
+      profile.buffer_size = *size;
+    }
+  }
+  if (profile.type.empty() || profile.output_device.empty() || profile.buffer_size <= 0) {
+    return std::nullopt;
+  }
+  return profile;
+}
+
+auto formatAudioDeviceProfile(const AudioDeviceProfile &profile) -> std::string {
+  std::ostringstream out;
+  out << "type " << profile.type << "\n";
+  out << "output " << profile.output_device << "\n";
+  if (!profile.input_device.empty()) {
+    out << "input " << profile.input_device << "\n";
+  }
+  out << "sample-rate " << profile.sample_rate << "\n";
+  out << "buffer-size " << profile.buffer_size << "\n";
+  return out.str();
+}
+
+auto loadAudioDeviceProfile(const std::filesystem::path &path)
+    -> std::optional<AudioDeviceProfile> {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return std::nullopt;
+  }
+  const std::string text{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+  return parseAudioDeviceProfile(text);
+}
+
+auto saveAudioDeviceProfile(const std::filesystem::path &path, const AudioDeviceProfile &profile)
+    -> bool {
+  std::error_code error;
+  std::filesystem::create_directories(path.parent_path(), error);
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << formatAudioDeviceProfile(profile);
+  return static_cast<bool>(file);
+}
+
+auto deviceTypeRank(std::string_view type) -> int {
+  if (contains(type, "JACK")) {
+    return kJackRank;
+  }
+  if (contains(type, "ALSA")) {
+    return kAlsaRank;
+  }
+  return 0;
+}
+
+auto deviceRank(std::string_view type, std::string_view name) -> int {
+  if (!contains(type, "ALSA")) {
+    return kOtherDeviceRank;
+  }
+  // ALSA names are either the PCM id or its description, depending on how
+  // the device was enumerated, so both spellings are recognised.
+  if (name.starts_with("hw:") || contains(name, "Direct hardware device")) {
+    return kDirectHardwareRank;
+  }
+  if (name.starts_with("plughw:") || contains(name, "Hardware device with all software")) {
+    return kConvertingHardwareRank;
+  }
+  return 0;
+}
+
+auto pickDevice(std::string_view type, std::span<const std::string> names)
+    -> std::optional<std::size_t> {
+  std::optional<std::size_t> best;
+  auto best_rank = -1;
+  for (std::size_t index = 0; index < names.size(); ++index) {
+    const auto rank = deviceRank(type, names[index]);
+    if (rank > best_rank) {
+      best = index;
+      best_rank = rank;
+    }
+  }
+  return best;
+}
+
+auto chooseSampleRate(std::span<const double> available) -> double {
+  if (available.empty()) {
+    return kPreferredSampleRate;
+  }
+  return *std::min_element(available.begin(), available.end(), [](double left, double right) {
+    return std::abs(left - kPreferredSampleRate) < std::abs(right - kPreferredSampleRate);
+  });
+}
+
+auto roundTripSamples(const DeviceLatency &latency) -> int {
+  return latency.input_samples + latency.output_samples + (2 * latency.buffer_size);
+}
+
+auto samplesToMilliseconds(int samples, double sample_rate) -> double {
+  return sample_rate > 0.0 ? static_cast<double>(samples) * kMillisecondsPerSecond / sample_rate
+                           : 0.0;
+}
+
+auto BufferSizeNegotiator::begin(std::span<const int> available_sizes) -> int {
+  candidates.assign(available_sizes.begin(), available_sizes.end());
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+  // Keep the largest size even if every size is below the floor.
+  const auto first = std::lower_bound(candidates.begin(), candidates.end(), kMinDeviceBufferSize);
+  if (first == candidates.end() && !candidates.empty()) {
+    candidates.erase(candidates.begin(), candidates.end() - 1);
+  } else {
+    candidates.erase(candidates.begin(), first);
+  }
+  current = 0;
+  xruns_at_start = -1;
+  started_at = 0.0;
+  settled = candidates.size() <= 1;
+  return bufferSize();
+}
+
+void BufferSizeNegotiator::settleAt(int buffer_size) {
+  candidates.assign(1, buffer_size);
+  current = 0;
+  settled = true;
+}
+
+auto BufferSizeNegotiator::observe(int xrun_count, double seconds) -> std::optional<int> {
+  if (settled) {
+    return std::nullopt;
+  }
+  if (xrun_count < 0) {
+    settled = true;
+    return std::nullopt;
+  }
+  // The count restarts with the device, so the first reading after a
+  // switch is the baseline.
+  if (xruns_at_start < 0) {
+    xruns_at_start = xrun_count;
+    started_at = seconds;
+    return std::nullopt;
+  }
+  if (xrun_count > xruns_at_start) {
+    if (current + 1 < candidates.size()) {
+      ++current;
+      xruns_at_start = -1;
+      return bufferSize();
+    }
+    settled = true;
+    return std::nullopt;
+  }
+  if (seconds - started_at >= kBufferProbationSeconds) {
+    settled = true;
+  }
+  return std::nullopt;
+}
+
+auto BufferSizeNegotiator::bufferSize() const -> int {
+  return candidates.empty() ? 0 : candidates.at(current);
+}
+
+auto BufferSizeNegotiator::isSettled() const -> bool { return settled; }
+
+void LatencyProbe::prepare(double sample_rate) {
+  timeout_samples = static_cast<std::int64_t>(sample_rate * kLatencyProbeTimeoutSeconds);
+  listened = 0;
+  probe_state.store(State::kIdle, std::memory_order_relaxed);
+}
+
+void LatencyProbe::arm() { probe_state.store(State::kArmed, std::memory_order_release); }
+
+auto LatencyProbe::state() const -> State { return probe_state.load(std::memory_order_acquire); }
+
+auto LatencyProbe::measuredSamples() const -> int {
+  return measured.load(std::memory_order_relaxed);
+}
+
+void LatencyProbe::scanInput(std::span<const float> input) {
+  if (probe_state.load(std::memory_order_relaxed) != State::kListening) {
+    return;
+  }
+  for (std::size_t sample = 0; sample < input.size(); ++sample) {
+    if (std::abs(input[sample]) >= kDetectLevel) {
+      measured.store(static_cast<int>(listened + static_cast<std::int64_t>(sample)),
+                     std::memory_order_relaxed);
+      probe_state.store(State::kMeasured, std::memory_order_release);
+      return;
+    }
+  }
+  listened += static_cast<std::int64_t>(input.size());
+  if (listened >= timeout_samples) {
+    probe_state.store(State::kTimedOut, std::memory_order_release);
+  }
+}
+
+void LatencyProbe::writeOutput(std::span<float> left, std::span<float> right) {
+  if (probe_state.load(std::memory_order_acquire) != State::kArmed || left.empty()) {
+    return;
+  }
+  left.front() += kClickLevel;
+  if (!right.empty()) {
+    right.front() += kClickLevel;
+  }
+  // Counted from the click, so the first sample of the next input block is
+  // one block after it.
+  listened = static_cast<std::int64_t>(left.size());
+  probe_state.store(State::kListening, std::memory_order_relaxed);
+}
+} // namespace limit
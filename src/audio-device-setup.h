@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace limit {
+constexpr double kPreferredSampleRate = 48000.0;
+// Design target for input-to-output latency.
+constexpr double kLatencyTargetMs = 10.0;
+// Smaller buffers are offered by some drivers but never survive the graph.
+constexpr int kMinDeviceBufferSize = 32;
+// How long a buffer size must run without an xrun before it is kept.
+constexpr double kBufferProbationSeconds = 5.0;
+
+// The device configuration that proved stable, so the next start can open it
+// directly instead of scanning every device type. Stored as one setting per
+// line:
+//
+//   type ALSA
+//   output Scarlett 2i2 USB, USB Audio; Direct hardware device without any conversions
+//   input Scarlett 2i2 USB, USB Audio; Direct hardware device without any conversions
+//   sample-rate 48000
+//   buffer-size 64
+//
+// Unknown keys are ignored so older builds can read newer files.
+struct AudioDeviceProfile {
+  std::string type;
+  std::string output_device;
+  std::string input_device;
+  double sample_rate = kPreferredSampleRate;
+  int buffer_size = 0;
+
+  auto operator==(const AudioDeviceProfile &other) const -> bool = default;
+};
+
+// nullopt unless the text names a device type, an output and a buffer size.
+auto parseAudioDeviceProfile(std::string_view text) -> std::optional<AudioDeviceProfile>;
+auto formatAudioDeviceProfile(const AudioDeviceProfile &profile) -> std::string;
+auto loadAudioDeviceProfile(const std::filesystem::path &path)
+    -> std::optional<AudioDeviceProfile>;
+auto saveAudioDeviceProfile(const std::filesystem::path &path, const AudioDeviceProfile &profile)
+    -> bool;
+
+// Preference between device types and devices; higher is better, and 0
+// means usable but not preferred. JACK comes first, then ALSA, whose direct
+// hw: devices beat plughw: conversions and the sound-server routes (default,
+// pulse, pipewire, dmix), which add a period or more of latency.
+auto deviceTypeRank(std::string_view type) -> int;
+auto deviceRank(std::string_view type, std::string_view name) -> int;
+// Index of the best-ranked name, first on ties; nullopt when there are none.
+auto pickDevice(std::string_view type, std::span<const std::string> names)
+    -> std::optional<std::size_t>;
+
+// kPreferredSampleRate if the device offers it, else the closest rate.
+auto chooseSampleRate(std::span<const double> available) -> double;
+
+// Reported latency of an open device, in samples.
+struct DeviceLatency {
+  double sample_rate = 0.0;
+  int buffer_size = 0;
+  int input_samples = 0;
+  int output_samples = 0;
+};
+
+// The driver's input and output latency plus one buffer each way: a block
+// is only processed once its input buffer is full, and its output waits
+// behind the buffer being played.
+auto roundTripSamples(const DeviceLatency &latency) -> int;
+auto samplesToMilliseconds(int samples, double sample_rate) -> double;
+
+// Finds the smallest buffer size that runs without xruns. It starts at the
+// smallest size the device offers (no smaller than kMinDeviceBufferSize),
+// moves one size up whenever the device reports an xrun, and settles once a
+// size has run for kBufferProbationSeconds. Devices that cannot count xruns
+// settle on the first size. Message thread.
+class BufferSizeNegotiator {
+public:
+  // available_sizes in any order. Returns the size to open first.
+  auto begin(std::span<const int> available_sizes) -> int;
+  // Keeps the current size without probing, as for a saved profile.
+  void settleAt(int buffer_size);
+
+  // Called periodically with the device's xrun count (-1 if unknown) and
+  // the time since begin(). Returns the next size to try after an xrun.
+  auto observe(int xrun_count, double seconds) -> std::optional<int>;
+
+  auto bufferSize() const -> int;
+  auto isSettled() const -> bool;
+
+private:
+  std::vector<int> candidates;
+  std::size_t current = 0;
+  int xruns_at_start = -1;
+  double started_at = 0.0;
+  bool settled = false;
+};
+
+// Measures the real round trip through a loopback cable: emits one click on
+// the output and counts samples until it comes back on the input. arm() and
+// the results are for the message thread; scanInput() and writeOutput() run
+// in the audio callback, before and after the graph, and never allocate.
+class LatencyProbe {
+public:
+  enum class State : std::uint8_t { kIdle, kArmed, kListening, kMeasured, kTimedOut };
+
+  void prepare(double sample_rate);
+  void arm();
+  auto state() const -> State;
+  // The last measurement in samples, when state() is kMeasured.
+  auto measuredSamples() const -> int;
+
+  // Audio thread.
+  void scanInput(std::span<const float> input);
+  void writeOutput(std::span<float> left, std::span<float> right);
+
+private:
+  static constexpr float kClickLevel = 0.5f;
+  static constexpr float kDetectLevel = 0.1f;
+
+  std::atomic<State> probe_state{State::kIdle};
+  std::atomic<int> measured{0};
+  // Audio thread only.
+  std::int64_t listened = 0;
+  std::int64_t timeout_samples = 0;
+};
+} // namespace limit
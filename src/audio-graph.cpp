@@ -0,0 +1,165 @@
+#include "audio-graph.h"
+
+#include <algorithm>
+
+namespace limit {
+AudioGraph::AudioGraph() {
+  const auto order = computeSignalOrder(kSignalEdges);
+  jassert(order.has_value());
+  node_order = order.value_or(SignalOrder{});
+}
+
+void AudioGraph::setNode(SignalNode node, AudioGraphNode *processor) {
+  nodes.at(signalNodeIndex(node)) = processor;
+  if (processor != nullptr && max_block_size > 0) {
+    processor->prepare(current_sample_rate, max_block_size);
+  }
+}
+
+void AudioGraph::setMeterQueue(MeterQueue *queue) {
+  meter_queue.store(queue, std::memory_order_release);
+}
+
+void AudioGraph::setProfiler(AudioProfiler *profiler) {
+  audio_profiler.store(profiler, std::memory_order_release);
+}
+
+void AudioGraph::prepare(double sample_rate, int max_block_size_expected) {
+  current_sample_rate = sample_rate;
+  max_block_size = std::max(max_block_size_expected, 1);
+
+  buses.instrument.setSize(kStereoChannelCount, max_block_size);
+  buses.tape.setSize(kStereoChannelCount * kTapeTrackCount, max_block_size);
+  buses.master.setSize(kStereoChannelCount, max_block_size);
+  buses.send1.setSize(kStereoChannelCount, max_block_size);
+  buses.send2.setSize(kStereoChannelCount, max_block_size);
+  slice_midi.ensureSize(kBlockMidiReserveBytes);
+
+  for (auto *node : nodes) {
+    if (node != nullptr) {
+      node->prepare(current_sample_rate, max_block_size);
+    }
+  }
+}
+
+void AudioGraph::release() {
+  buses = AudioGraphBuses{};
+  max_block_size = 0;
+}
+
+void AudioGraph::process(const juce::MidiBuffer &midi, juce::AudioBuffer<float> &output,
+                         int start_sample, int num_samples) {
+  if (max_block_size <= 0) {
+    output.clear(start_sample, num_samples);
+    return;
+  }
+
+  // Hosts may deliver blocks larger than announced; render those in slices
+  // rather than resizing buffers on the audio thread.
+  for (int offset = 0; offset < num_samples; offset += max_block_size) {
+    const auto slice_samples = std::min(max_block_size, num_samples - offset);
+    processSlice(midi, offset, slice_samples);
+
+    const auto output_channels = output.getNumChannels();
+    for (int channel = 0; channel < output_channels; ++channel) {
+      if (channel < kStereoChannelCount) {
+        output.copyFrom(channel, start_sample + offset, buses.master, channel, 0, slice_samples);
+      } else {
+        output.clear(channel, start_sample + offset, slice_samples);
+      }
+    }
+  }
+}
+
+auto AudioGraph::nodeOrder() const -> const SignalOrder & { return node_order; }
+
+auto AudioGraph::maxBlockSize() const -> int { return max_block_size; }
+
+auto AudioGraph::sampleRate() const -> double { return current_sample_rate; }
+
+void AudioGraph::processSlice(const juce::MidiBuffer &midi, int midi_offset, int num_samples) {
+  slice_midi.clear();
+  slice_midi.addEvents(midi, midi_offset, num_samples, -midi_offset);
+
+  AudioProfiler *profiler = nullptr;
+  if constexpr (AudioProfiler::kEnabled) {
+    profiler = audio_profiler.load(std::memory_order_acquire);
+  }
+  for (const auto node : node_order) {
+    const auto start_ticks = profiler != nullptr ? profilerTicks() : 0;
+    if (node == SignalNode::kMasterEq) {
+      sumSendReturns(num_samples);
+    }
+    auto *processor = nodes.at(signalNodeIndex(node));
+    if (processor != nullptr) {
+      processor->process(buses, slice_midi, num_samples);
+    } else {
+      processDefault(node, num_samples);
+    }
+    if (profiler != nullptr) {
+      profiler->endStage(node, start_ticks);
+    }
+  }
+  publishMeters(num_samples);
+}
+
+void AudioGraph::processDefault(SignalNode node, int num_samples) {
+  switch (node) {
+  case SignalNode::kInstrument:
+    buses.instrument.clear(0, num_samples);
+    break;
+  case SignalNode::kTapeTracks:
+    // Without a tape engine the armed track simply monitors the instrument.
+    buses.tape.clear(0, num_samples);
+    for (int channel = 0; channel < kStereoChannelCount; ++channel) {
+      buses.tape.copyFrom((kMonitorTrack * kStereoChannelCount) + channel, 0, buses.instrument,
+                          channel, 0, num_samples);
+    }
+    break;
+  case SignalNode::kTrackMix:
+    buses.master.clear(0, num_samples);
+    buses.send1.clear(0, num_samples);
+    buses.send2.clear(0, num_samples);
+    for (int track = 0; track < kTapeTrackCount; ++track) {
+      for (int channel = 0; channel < kStereoChannelCount; ++channel) {
+        buses.master.addFrom(channel, 0, buses.tape, (track * kStereoChannelCount) + channel, 0,
+                             num_samples);
+      }
+    }
+    break;
+  case SignalNode::kInsert:
+  case SignalNode::kSend1Effect:
+  case SignalNode::kSend2Effect:
+  case SignalNode::kMasterEq:
+  case SignalNode::kMasterEffect:
+    break;
+  }
+}
+
+void AudioGraph::sumSendReturns(int num_samples) {
+  for (int channel = 0; channel < kStereoChannelCount; ++channel) {
+    buses.master.addFrom(channel, 0, buses.send1, channel, 0, num_samples);
+    buses.master.addFrom(channel, 0, buses.send2, channel, 0, num_samples);
+  }
+}
+
+void AudioGraph::publishMeters(int num_samples) {
+  auto *queue = meter_queue.load(std::memory_order_acquire);
+  if (queue == nullptr) {
+    return;
+  }
+  const auto count = static_cast<std::size_t>(num_samples);
+  const auto channel = [count](const juce::AudioBuffer<float> &buffer, int index) {
+    return std::span<const float>(buffer.getReadPointer(index), count);
+  };
+  MeterFrame frame;
+  for (int track = 0; track < kTapeTrackCount; ++track) {
+    const auto left = track * kStereoChannelCount;
+    frame.levels.at(static_cast<std::size_t>(track)) =
+        measureStereo(channel(buses.tape, left), channel(buses.tape, left + 1));
+  }
+  frame.levels.at(kMasterMeterIndex) =
+      measureStereo(channel(buses.master, 0), channel(buses.master, 1));
+  queue->push(frame);
+}
+} // namespace limit
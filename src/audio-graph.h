@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include "audio-profiler.h"
+#include "level-meter.h"
+#include "midi-event-queue.h"
+#include "signal-flow.h"
+#include "step-sequencer.h"
+
+namespace limit {
+// MIDI room for one block: both input queues (controller MIDI and computer
+// keys) drained in full, plus the step sequencer's notes. Buffers reserved
+// this large never allocate while the audio thread fills them.
+constexpr int kBlockMidiReserveBytes =
+    ((2 * static_cast<int>(kMidiEventQueueCapacity)) + kMaxSequencerEventsPerBlock) *
+    kMidiBufferBytesPerEvent;
+
+// Preallocated buses shared by the graph stages. Every buffer is sized in
+// AudioGraph::prepare() and only ever cleared or written in place afterwards.
+struct AudioGraphBuses {
+  juce::AudioBuffer<float> instrument;
+  juce::AudioBuffer<float> tape;
+  juce::AudioBuffer<float> master;
+  juce::AudioBuffer<float> send1;
+  juce::AudioBuffer<float> send2;
+};
+
+// A processing stage. prepare() runs on the message thread and may allocate;
+// process() runs on the audio thread and must not allocate, lock or do I/O.
+class AudioGraphNode {
+public:
+  AudioGraphNode() = default;
+  virtual ~AudioGraphNode() = default;
+  AudioGraphNode(const AudioGraphNode &) = delete;
+  auto operator=(const AudioGraphNode &) -> AudioGraphNode & = delete;
+  AudioGraphNode(AudioGraphNode &&) = delete;
+  auto operator=(AudioGraphNode &&) -> AudioGraphNode & = delete;
+
+  virtual void prepare(double sample_rate, int max_block_size) = 0;
+  virtual void process(AudioGraphBuses &buses, const juce::MidiBuffer &midi, int num_samples) = 0;
+};
+
+// Fixed signal flow: instrument -> insert -> tape tracks -> level/pan/sends ->
+// send effects -> master EQ -> master effect. Stages without a node fall back
+// to a pass-through default so the graph is always complete.
+class AudioGraph {
+public:
+  AudioGraph();
+
+  void setNode(SignalNode node, AudioGraphNode *processor);
+  // Publishes tape track and master levels once per processed slice. The
+  // queue must outlive the graph or be detached first.
+  void setMeterQueue(MeterQueue *queue);
+  // Times every stage into the profiler's current callback. Ignored unless
+  // the profiler is compiled in (LIMIT_PROFILER).
+  void setProfiler(AudioProfiler *profiler);
+  void prepare(double sample_rate, int max_block_size);
+  void release();
+  void process(const juce::MidiBuffer &midi, juce::AudioBuffer<float> &output, int start_sample,
+               int num_samples);
+
+  auto nodeOrder() const -> const SignalOrder &;
+  auto maxBlockSize() const -> int;
+  auto sampleRate() const -> double;
+
+private:
+  void processSlice(const juce::MidiBuffer &midi, int midi_offset, int num_samples);
+  void processDefault(SignalNode node, int num_samples);
+  void sumSendReturns(int num_samples);
+  void publishMeters(int num_samples);
+
+  static constexpr int kMonitorTrack = 0;
+
+  std::array<AudioGraphNode *, kSignalNodeCount> nodes{};
+  SignalOrder node_order{};
+  AudioGraphBuses buses;
+  juce::MidiBuffer slice_midi;
+  std::atomic<MeterQueue *> meter_queue{nullptr};
+  std::atomic<AudioProfiler *> audio_profiler{nullptr};
+  double current_sample_rate = 0.0;
+  int max_block_size = 0;
+};
+} // namespace limit
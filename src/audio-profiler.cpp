@@ -0,0 +1,220 @@
+#include "audio-profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+namespace limit {
+namespace {
+constexpr double kNanosecondsPerSecond = 1.0e9;
+constexpr double kNanosecondsPerMicrosecond = 1000.0;
+constexpr std::uint64_t kPermille = 1000;
+constexpr std::uint64_t kBucketsPerBudget = 10;
+constexpr double kPercent = 100.0;
+constexpr int kStageNameWidth = 16;
+constexpr int kNumberWidth = 10;
+
+auto ticksToMicroseconds(std::uint64_t ticks, double ticks_per_us) -> double {
+  return ticks_per_us > 0.0 ? static_cast<double>(ticks) / ticks_per_us : 0.0;
+}
+} // namespace
+
+void AudioProfiler::prepare(double rate) {
+  sample_rate = rate;
+  ns_per_sample = rate > 0.0 ? kNanosecondsPerSecond / rate : 0.0;
+  reset_requested.store(false, std::memory_order_relaxed);
+  clearCounters();
+  trace_read.store(trace_write.load(std::memory_order_acquire), std::memory_order_release);
+  recent_traces.clear();
+  recent_traces.reserve(kProfilerTraceCapacity);
+}
+
+void AudioProfiler::requestReset() { reset_requested.store(true, std::memory_order_release); }
+
+void AudioProfiler::clearCounters() {
+  worst_duration_ns = 0;
+  for (auto *counter : {&callbacks, &xruns, &total_ns, &total_ticks, &max_ns, &max_load_permille,
+                        &dropped_traces}) {
+    counter->store(0, std::memory_order_relaxed);
+  }
+  for (auto &bucket : histogram) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  for (std::size_t node = 0; node < node_total_ticks.size(); ++node) {
+    node_total_ticks.at(node).store(0, std::memory_order_relaxed);
+    node_max_ticks.at(node).store(0, std::memory_order_relaxed);
+  }
+}
+
+void AudioProfiler::finishCallback(int num_samples, std::uint64_t end_ticks,
+                                   std::chrono::steady_clock::time_point end_time) {
+  const auto duration_ns = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - callback_start).count());
+  const auto budget_ns =
+      std::max<std::uint64_t>(static_cast<std::uint64_t>(num_samples * ns_per_sample), 1);
+  current.callback = callbacks.load(std::memory_order_relaxed);
+  current.num_samples = num_samples;
+  current.duration_ns = duration_ns;
+  current.budget_ns = budget_ns;
+  current.total_ticks = end_ticks - callback_start_ticks;
+
+  bump(callbacks);
+  bump(total_ns, duration_ns);
+  bump(total_ticks, current.total_ticks);
+  const auto load = duration_ns * kPermille / budget_ns;
+  bump(histogram[std::min<std::uint64_t>(load * kBucketsPerBudget / kPermille,
+                                         kProfilerHistogramBuckets - 1)]);
+  if (duration_ns > max_ns.load(std::memory_order_relaxed)) {
+    max_ns.store(duration_ns, std::memory_order_relaxed);
+  }
+  if (load > max_load_permille.load(std::memory_order_relaxed)) {
+    max_load_permille.store(load, std::memory_order_relaxed);
+  }
+  for (std::size_t node = 0; node < current.node_ticks.size(); ++node) {
+    const auto ticks = current.node_ticks[node];
+    bump(node_total_ticks[node], ticks);
+    if (ticks > node_max_ticks[node].load(std::memory_order_relaxed)) {
+      node_max_ticks[node].store(ticks, std::memory_order_relaxed);
+    }
+  }
+
+  const auto missed = duration_ns > budget_ns;
+  if (missed) {
+    bump(xruns);
+  }
+  if (missed || duration_ns > worst_duration_ns) {
+    worst_duration_ns = std::max(worst_duration_ns, duration_ns);
+    if (!pushTrace(current)) {
+      bump(dropped_traces);
+    }
+  }
+}
+
+auto AudioProfiler::pushTrace(const CallbackTrace &trace) -> bool {
+  const auto write = trace_write.load(std::memory_order_relaxed);
+  const auto read = trace_read.load(std::memory_order_acquire);
+  if (write - read >= kTraceQueueCapacity) {
+    return false;
+  }
+  trace_queue[write & kTraceIndexMask] = trace;
+  trace_write.store(write + 1, std::memory_order_release);
+  return true;
+}
+
+void AudioProfiler::setDeviceSummary(std::string summary) { device_summary = std::move(summary); }
+
+auto AudioProfiler::snapshot() -> ProfileSnapshot {
+  for (;;) {
+    const auto read = trace_read.load(std::memory_order_relaxed);
+    if (read == trace_write.load(std::memory_order_acquire)) {
+      break;
+    }
+    if (recent_traces.size() == kProfilerTraceCapacity) {
+      recent_traces.erase(recent_traces.begin());
+    }
+    recent_traces.push_back(trace_queue.at(read & kTraceIndexMask));
+    trace_read.store(read + 1, std::memory_order_release);
+  }
+
+  ProfileSnapshot snapshot;
+  snapshot.enabled = kEnabled;
+  snapshot.sample_rate = sample_rate;
+  snapshot.callbacks = callbacks.load(std::memory_order_relaxed);
+  snapshot.xruns = xruns.load(std::memory_order_relaxed);
+  snapshot.dropped_traces = dropped_traces.load(std::memory_order_relaxed);
+  const auto elapsed_ns = total_ns.load(std::memory_order_relaxed);
+  const auto elapsed_ticks = total_ticks.load(std::memory_order_relaxed);
+  const auto callback_count = static_cast<double>(std::max<std::uint64_t>(snapshot.callbacks, 1));
+  if (elapsed_ns > 0) {
+    snapshot.ticks_per_us = static_cast<double>(elapsed_ticks) * kNanosecondsPerMicrosecond /
+                            static_cast<double>(elapsed_ns);
+  }
+  snapshot.mean_callback_us =
+      static_cast<double>(elapsed_ns) / kNanosecondsPerMicrosecond / callback_count;
+  snapshot.max_callback_us =
+      static_cast<double>(max_ns.load(std::memory_order_relaxed)) / kNanosecondsPerMicrosecond;
+  snapshot.max_budget_percent =
+      static_cast<double>(max_load_permille.load(std::memory_order_relaxed)) * kPercent /
+      static_cast<double>(kPermille);
+  for (std::size_t bucket = 0; bucket < histogram.size(); ++bucket) {
+    snapshot.histogram.at(bucket) = histogram.at(bucket).load(std::memory_order_relaxed);
+  }
+  for (std::size_t node = 0; node < snapshot.stages.size(); ++node) {
+    auto &stage = snapshot.stages.at(node);
+    const auto total = node_total_ticks.at(node).load(std::memory_order_relaxed);
+    stage.mean_us = ticksToMicroseconds(total, snapshot.ticks_per_us) / callback_count;
+    stage.max_us = ticksToMicroseconds(node_max_ticks.at(node).load(std::memory_order_relaxed),
+                                       snapshot.ticks_per_us);
+  }
+  snapshot.traces = recent_traces;
+  snapshot.device = device_summary;
+  return snapshot;
+}
+
+auto AudioProfiler::writeReport(const std::filesystem::path &path) -> bool {
+  std::ofstream file(path, std::ios::trunc);
+  file << formatProfileReport(snapshot());
+  return static_cast<bool>(file);
+}
+
+auto formatProfileReport(const ProfileSnapshot &snapshot) -> std::string {
+  std::ostringstream out;
+  if (!snapshot.device.empty()) {
+    out << "device " << snapshot.device << "\n";
+  }
+  if (!snapshot.enabled) {
+    out << "Audio profiler not compiled in (configure with -DLIMIT_PROFILER=ON).\n";
+    return out.str();
+  }
+  out << std::fixed << std::setprecision(1);
+  out << "callbacks " << snapshot.callbacks << "  xruns " << snapshot.xruns << "  at "
+      << snapshot.sample_rate << " Hz\n";
+  out << "callback mean " << snapshot.mean_callback_us << " us  max " << snapshot.max_callback_us
+      << " us  worst load " << snapshot.max_budget_percent << "%\n";
+
+  out << "\nstage            mean us    max us\n";
+  for (std::size_t node = 0; node < snapshot.stages.size(); ++node) {
+    const auto &stage = snapshot.stages.at(node);
+    out << std::left << std::setw(kStageNameWidth)
+        << signalNodeName(static_cast<SignalNode>(node)) << std::right
+        << std::setw(kNumberWidth) << stage.mean_us << std::setw(kNumberWidth) << stage.max_us
+        << "\n";
+  }
+
+  out << "\nload (% of block)   callbacks\n";
+  for (std::size_t bucket = 0; bucket < snapshot.histogram.size(); ++bucket) {
+    const auto low = bucket * kBucketsPerBudget;
+    out << std::setw(3) << low;
+    if (bucket + 1 == snapshot.histogram.size()) {
+      out << "+     ";
+    } else {
+      out << "-" << std::left << std::setw(5) << (low + kBucketsPerBudget) << std::right;
+    }
+    out << std::setw(kNumberWidth + 2) << snapshot.histogram.at(bucket) << "\n";
+  }
+
+  out << "\nslow callbacks (most recent last), stage times in us\n";
+  for (const auto &trace : snapshot.traces) {
+    out << "#" << trace.callback << " " << trace.num_samples << " samples "
+        << static_cast<double>(trace.duration_ns) / kNanosecondsPerMicrosecond << " of "
+        << static_cast<double>(trace.budget_ns) / kNanosecondsPerMicrosecond << " us:";
+    std::uint64_t stage_ticks = 0;
+    for (std::size_t node = 0; node < trace.node_ticks.size(); ++node) {
+      const auto ticks = trace.node_ticks.at(node);
+      stage_ticks += ticks;
+      if (ticks > 0) {
+        out << " " << signalNodeName(static_cast<SignalNode>(node)) << " "
+            << ticksToMicroseconds(ticks, snapshot.ticks_per_us);
+      }
+    }
+    const auto outside = trace.total_ticks > stage_ticks ? trace.total_ticks - stage_ticks : 0;
+    out << " outside graph " << ticksToMicroseconds(outside, snapshot.ticks_per_us) << "\n";
+  }
+  if (snapshot.dropped_traces > 0) {
+    out << snapshot.dropped_traces << " traces dropped\n";
+  }
+  return out.str();
+}
+} // namespace limit
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "signal-flow.h"
+
+namespace limit {
+// Callback durations are binned in tenths of the block's real-time budget;
+// the last bucket holds everything at or above twice the budget.
+constexpr int kProfilerHistogramBuckets = 21;
+constexpr std::size_t kProfilerTraceCapacity = 16;
+
+// Cheapest monotonic counter on the platform: the TSC on x86, the virtual
+// counter on ARM64, otherwise steady_clock nanoseconds. Only differences are
+// used; AudioProfiler calibrates them against steady_clock.
+inline auto profilerTicks() -> std::uint64_t {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  std::uint64_t ticks = 0;
+  asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+  return ticks;
+#else
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now().time_since_epoch())
+                                        .count());
+#endif
+}
+
+// One callback that missed its deadline or was the slowest so far, with the
+// time each graph stage took in it. Time outside the graph (MIDI drain,
+// sequencer, parameter ramps) is total_ticks minus the stages.
+struct CallbackTrace {
+  std::uint64_t callback = 0;
+  int num_samples = 0;
+  std::uint64_t duration_ns = 0;
+  std::uint64_t budget_ns = 0;
+  std::uint64_t total_ticks = 0;
+  std::array<std::uint64_t, kSignalNodeCount> node_ticks{};
+};
+
+struct StageProfile {
+  double mean_us = 0.0;
+  double max_us = 0.0;
+};
+
+// A consistent-enough copy of the counters for display and dumps. Counters
+// are read one at a time, so totals may be a callback apart.
+struct ProfileSnapshot {
+  bool enabled = false;
+  double sample_rate = 0.0;
+  double ticks_per_us = 0.0;
+  std::uint64_t callbacks = 0;
+  std::uint64_t xruns = 0;
+  std::uint64_t dropped_traces = 0;
+  double mean_callback_us = 0.0;
+  double max_callback_us = 0.0;
+  double max_budget_percent = 0.0;
+  std::array<std::uint64_t, kProfilerHistogramBuckets> histogram{};
+  std::array<StageProfile, kSignalNodeCount> stages{};
+  std::vector<CallbackTrace> traces;
+  // The audio device as described by setDeviceSummary().
+  std::string device;
+};
+
+// Audio-thread instrumentation, compiled in with LIMIT_PROFILER. The audio
+// thread is the only writer: it times the callback with steady_clock and
+// each graph stage with profilerTicks(), and publishes plain relaxed stores,
+// so a callback costs two clock reads plus two counter reads per stage.
+// Slow callbacks go to a bounded single-producer/single-consumer queue that
+// snapshot() drains into a ring of the most recent traces. Without
+// LIMIT_PROFILER every audio-thread call is an empty inline function.
+class AudioProfiler {
+public:
+#if defined(LIMIT_PROFILER)
+  static constexpr bool kEnabled = true;
+#else
+  static constexpr bool kEnabled = false;
+#endif
+
+  AudioProfiler() = default;
+  ~AudioProfiler() = default;
+  AudioProfiler(const AudioProfiler &) = delete;
+  auto operator=(const AudioProfiler &) -> AudioProfiler & = delete;
+  AudioProfiler(AudioProfiler &&) = delete;
+  auto operator=(AudioProfiler &&) -> AudioProfiler & = delete;
+
+  // Message thread, with the audio callback stopped. Clears every counter.
+  void prepare(double sample_rate);
+  // Message thread. The audio thread clears the counters at its next callback.
+  void requestReset();
+
+  // Audio thread.
+  void beginCallback() {
+    if constexpr (kEnabled) {
+      if (reset_requested.exchange(false, std::memory_order_acquire)) {
+        clearCounters();
+      }
+      current = CallbackTrace{};
+      callback_start = std::chrono::steady_clock::now();
+      callback_start_ticks = profilerTicks();
+    }
+  }
+
+  void endStage(SignalNode node, std::uint64_t start_ticks) {
+    if constexpr (kEnabled) {
+      current.node_ticks[signalNodeIndex(node)] += profilerTicks() - start_ticks;
+    }
+  }
+
+  void endCallback(int num_samples) {
+    if constexpr (kEnabled) {
+      finishCallback(num_samples, profilerTicks(), std::chrono::steady_clock::now());
+    }
+  }
+
+  // Message thread.
+  void setDeviceSummary(std::string summary);
+  auto snapshot() -> ProfileSnapshot;
+  auto writeReport(const std::filesystem::path &path) -> bool;
+
+private:
+  void clearCounters();
+  void finishCallback(int num_samples, std::uint64_t end_ticks,
+                      std::chrono::steady_clock::time_point end_time);
+  auto pushTrace(const CallbackTrace &trace) -> bool;
+
+  static void bump(std::atomic<std::uint64_t> &counter, std::uint64_t amount = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+  }
+
+  static constexpr std::size_t kCacheLineSize = 64;
+  static constexpr std::size_t kTraceQueueCapacity = 64;
+  static constexpr std::size_t kTraceIndexMask = kTraceQueueCapacity - 1;
+  static_assert((kTraceQueueCapacity & kTraceIndexMask) == 0,
+                "Trace queue capacity must be a power of two");
+
+  // Audio thread only.
+  CallbackTrace current;
+  std::chrono::steady_clock::time_point callback_start;
+  std::uint64_t callback_start_ticks = 0;
+  std::uint64_t worst_duration_ns = 0;
+  double ns_per_sample = 0.0;
+
+  // Written by the audio thread, read by snapshot().
+  std::atomic<std::uint64_t> callbacks{0};
+  std::atomic<std::uint64_t> xruns{0};
+  std::atomic<std::uint64_t> total_ns{0};
+  std::atomic<std::uint64_t> total_ticks{0};
+  std::atomic<std::uint64_t> max_ns{0};
+  std::atomic<std::uint64_t> max_load_permille{0};
+  std::array<std::atomic<std::uint64_t>, kProfilerHistogramBuckets> histogram{};
+  std::array<std::atomic<std::uint64_t>, kSignalNodeCount> node_total_ticks{};
+  std::array<std::atomic<std::uint64_t>, kSignalNodeCount> node_max_ticks{};
+  std::atomic<std::uint64_t> dropped_traces{0};
+  std::atomic<bool> reset_requested{false};
+  double sample_rate = 0.0;
+
+  std::array<CallbackTrace, kTraceQueueCapacity> trace_queue{};
+  alignas(kCacheLineSize) std::atomic<std::size_t> trace_write{0};
+  alignas(kCacheLineSize) std::atomic<std::size_t> trace_read{0};
+
+  // Message thread only.
+  std::vector<CallbackTrace> recent_traces;
+  std::string device_summary;
+};
+
+// Plain-text report of a snapshot, as written by writeReport().
+auto formatProfileReport(const ProfileSnapshot &snapshot) -> std::string;
+} // namespace limit
@@ -0,0 +1,315 @@
+#include "convolution-reverb.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace limit {
+namespace {
+constexpr std::size_t kHeadLength = kReverbHeadLength;
+constexpr std::size_t kEarlyPartition = kReverbEarlyPartition;
+constexpr std::size_t kTailPartition = kReverbTailPartition;
+constexpr std::size_t kTailSlots = kReverbTailSlots;
+// -60 dB as a natural-log decay.
+constexpr double kSixtyDecibels = 6.907755278982137;
+constexpr double kRoomToHallLengthFactor = 1.25;
+constexpr std::array<std::uint32_t, kStereoChannelCount> kRoomToHallSeeds{0x5eed1U, 0x5eed2U};
+
+auto segment(std::span<const float> taps, std::size_t first, std::size_t last)
+    -> std::span<const float> {
+  first = std::min(first, taps.size());
+  return taps.subspan(first, std::min(last, taps.size()) - first);
+}
+} // namespace
+
+auto makeRoomToHallImpulse(double sample_rate) -> juce::AudioBuffer<float> {
+  const auto frames = static_cast<int>(sample_rate * kRoomToHallSeconds * kRoomToHallLengthFactor);
+  juce::AudioBuffer<float> impulse(kStereoChannelCount, frames);
+  const auto decay = kSixtyDecibels / (kRoomToHallSeconds * sample_rate);
+  for (int channel = 0; channel < kStereoChannelCount; ++channel) {
+    // Separate seeds decorrelate the channels, which is what makes it wide.
+    std::minstd_rand noise(kRoomToHallSeeds.at(static_cast<std::size_t>(channel)));
+    std::uniform_real_distribution<float> amplitude(-1.0f, 1.0f);
+    double energy = 0.0;
+    for (int frame = 0; frame < frames; ++frame) {
+      const auto sample =
+          amplitude(noise) * static_cast<float>(std::exp(-decay * static_cast<double>(frame)));
+      impulse.setSample(channel, frame, sample);
+      energy += static_cast<double>(sample) * static_cast<double>(sample);
+    }
+    // Unit energy, so a steady send comes back at about the same level.
+    impulse.applyGain(channel, 0, frames, static_cast<float>(1.0 / std::sqrt(energy)));
+  }
+  return impulse;
+}
+
+ConvolutionReverb::~ConvolutionReverb() { stop(); }
+
+void ConvolutionReverb::setImpulseResponse(const juce::AudioBuffer<float> &response,
+                                           double sample_rate) {
+  const auto frames = std::min(response.getNumSamples(),
+                               static_cast<int>(sample_rate * kReverbMaxSeconds));
+  for (int channel = 0; channel < kStereoChannelCount; ++channel) {
+    auto &taps = impulse.at(static_cast<std::size_t>(channel));
+    taps.clear();
+    if (response.getNumChannels() == 0 || frames <= 0) {
+      continue;
+    }
+    const auto *source = response.getReadPointer(std::min(channel, response.getNumChannels() - 1));
+    taps.assign(source, source + frames);
+  }
+}
+
+void ConvolutionReverb::start() {
+  if (tail_thread.joinable()) {
+    return;
+  }
+  stopping.store(false, std::memory_order_relaxed);
+  tail_threaded.store(true, std::memory_order_release);
+  tail_thread = std::thread([this] { runTail(); });
+}
+
+void ConvolutionReverb::stop() {
+  if (!tail_thread.joinable()) {
+    return;
+  }
+  stopping.store(true, std::memory_order_release);
+  tail_wake.fetch_add(1, std::memory_order_release);
+  tail_wake.notify_one();
+  tail_thread.join();
+  tail_threaded.store(false, std::memory_order_release);
+}
+
+void ConvolutionReverb::prepare(double /*sample_rate*/, int /*max_block_size*/) {
+  // The tail thread reads the convolvers, so it waits out the rebuild.
+  const auto was_running = tail_thread.joinable();
+  stop();
+
+  const auto length = impulse.front().size();
+  has_tail = length > static_cast<std::size_t>(kReverbTailOffset);
+  for (std::size_t index = 0; index < channels.size(); ++index) {
+    auto &channel = channels.at(index);
+    const std::span<const float> taps(impulse.at(index));
+    const auto head = segment(taps, 0, kHeadLength);
+    channel.head.assign(kHeadLength, 0.0f);
+    std::reverse_copy(head.begin(), head.end(),
+                      channel.head.end() - static_cast<std::ptrdiff_t>(head.size()));
+    channel.input.assign(kHeadLength - 1 + kEarlyPartition, 0.0f);
+    channel.early.prepare(segment(taps, kHeadLength, kReverbTailOffset), kReverbEarlyPartition);
+    channel.early_output.assign(kEarlyPartition, 0.0f);
+    channel.tail.prepare(segment(taps, kReverbTailOffset, taps.size()), kReverbTailPartition);
+  }
+
+  const auto ring_size = kTailSlots * channels.size() * kTailPartition;
+  tail_input.assign(has_tail ? ring_size : 0, 0.0f);
+  tail_output.assign(has_tail ? ring_size : 0, 0.0f);
+  input_block.fill(0);
+  for (auto &block : output_block) {
+    block.store(-1, std::memory_order_relaxed);
+  }
+  tail_submitted.store(0, std::memory_order_relaxed);
+  tail_consumed.store(0, std::memory_order_relaxed);
+  tail_misses.store(0, std::memory_order_relaxed);
+  due_block.store(-1, std::memory_order_relaxed);
+  last_tail_block = -1;
+  early_position = 0;
+  tail_position = 0;
+  tail_block = 0;
+  tail_writable = true;
+  tail_playing = false;
+
+  if (was_running) {
+    start();
+  }
+}
+
+void ConvolutionReverb::process(AudioGraphBuses &buses, const juce::MidiBuffer & /*midi*/,
+                                int num_samples) {
+  render(buses.send1, num_samples);
+}
+
+void ConvolutionReverb::render(juce::AudioBuffer<float> &buffer, int num_samples) {
+  if (buffer.getNumChannels() < kStereoChannelCount) {
+    return;
+  }
+  if (impulse.front().empty()) {
+    buffer.clear(0, num_samples);
+    return;
+  }
+  std::array<float *, kStereoChannelCount> data{};
+  for (std::size_t index = 0; index < data.size(); ++index) {
+    data.at(index) = buffer.getWritePointer(static_cast<int>(index));
+  }
+
+  // Chunks never cross an early block boundary, where the block's early
+  // output and, every kReverbTailPartition samples, the tail move on.
+  auto done = 0;
+  while (done < num_samples) {
+    const auto count = std::min(num_samples - done, kReverbEarlyPartition - early_position);
+    for (std::size_t index = 0; index < channels.size(); ++index) {
+      processChunk(channels.at(index), index,
+                   std::span(data.at(index) + done, static_cast<std::size_t>(count)));
+    }
+    done += count;
+    early_position += count;
+    if (early_position == kReverbEarlyPartition) {
+      finishEarlyBlock();
+      early_position = 0;
+    }
+  }
+}
+
+auto ConvolutionReverb::impulseLength() const -> int {
+  return static_cast<int>(impulse.front().size());
+}
+
+auto ConvolutionReverb::tailMissCount() const -> std::uint64_t {
+  return tail_misses.load(std::memory_order_relaxed);
+}
+
+auto ConvolutionReverb::pendingTailBlocks() const -> int {
+  return static_cast<int>(tail_submitted.load(std::memory_order_acquire) -
+                          tail_consumed.load(std::memory_order_acquire));
+}
+
+void ConvolutionReverb::holdTailForTesting(bool held) {
+  tail_held.store(held, std::memory_order_release);
+  tail_wake.fetch_add(1, std::memory_order_release);
+  tail_wake.notify_one();
+}
+
+void ConvolutionReverb::processChunk(Channel &channel, std::size_t channel_index,
+                                     std::span<float> samples) {
+  const auto position = static_cast<std::size_t>(early_position);
+  const std::span<float> input(channel.input);
+  const std::span<const float> head(channel.head);
+  const std::span<const float> early(channel.early_output);
+  std::span<const float> tail;
+  if (tail_playing) {
+    const auto played = static_cast<std::size_t>(tail_block - 2) % kTailSlots;
+    tail = tailSlot(tail_output, played, channel_index)
+               .subspan(static_cast<std::size_t>(tail_position) + position, samples.size());
+  }
+
+  for (std::size_t sample = 0; sample < samples.size(); ++sample) {
+    // input[position + sample + kHeadLength - 1] is the current sample, so
+    // the window ends on it.
+    input[position + sample + kHeadLength - 1] = samples[sample];
+    const auto window = input.subspan(position + sample, kHeadLength);
+    auto wet = early[position + sample];
+    for (std::size_t tap = 0; tap < kHeadLength; ++tap) {
+      wet += head[tap] * window[tap];
+    }
+    if (!tail.empty()) {
+      wet += tail[sample];
+    }
+    samples[sample] = wet;
+  }
+}
+
+void ConvolutionReverb::finishEarlyBlock() {
+  const auto slot = static_cast<std::size_t>(tail_submitted.load(std::memory_order_relaxed)) %
+                    kTailSlots;
+  for (std::size_t index = 0; index < channels.size(); ++index) {
+    auto &channel = channels.at(index);
+    const auto block = std::span<const float>(channel.input).subspan(kHeadLength - 1);
+    if (has_tail && tail_writable) {
+      const auto staged = tailSlot(tail_input, slot, index);
+      std::copy(block.begin(), block.end(),
+                staged.subspan(static_cast<std::size_t>(tail_position)).begin());
+    }
+    channel.early.processBlock(block, channel.early_output);
+    std::copy(channel.input.end() - static_cast<std::ptrdiff_t>(kHeadLength - 1),
+              channel.input.end(), channel.input.begin());
+  }
+
+  tail_position += kReverbEarlyPartition;
+  if (tail_position == kReverbTailPartition) {
+    tail_position = 0;
+    if (has_tail) {
+      finishTailBlock();
+    }
+  }
+}
+
+void ConvolutionReverb::finishTailBlock() {
+  const auto submitted = tail_submitted.load(std::memory_order_relaxed);
+  if (tail_writable) {
+    input_block.at(static_cast<std::size_t>(submitted % kTailSlots)) = tail_block;
+    tail_submitted.store(submitted + 1, std::memory_order_release);
+    if (tail_threaded.load(std::memory_order_acquire)) {
+      tail_wake.fetch_add(1, std::memory_order_release);
+      tail_wake.notify_one();
+    } else {
+      processTailBlocks();
+    }
+  }
+  ++tail_block;
+
+  // The block now starting is written only if its slot is free, and plays
+  // the output of the block finished one block ago, if it is ready.
+  const auto pending = tail_submitted.load(std::memory_order_relaxed) -
+                       tail_consumed.load(std::memory_order_acquire);
+  tail_writable = pending < kTailSlots;
+  const auto played = tail_block - 2;
+  due_block.store(played, std::memory_order_release);
+  tail_playing =
+      played >= 0 &&
+      output_block.at(static_cast<std::size_t>(played) % kTailSlots)
+              .load(std::memory_order_acquire) == played;
+  if (played >= 0 && !tail_playing) {
+    tail_misses.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void ConvolutionReverb::processTailBlocks() {
+  auto consumed = tail_consumed.load(std::memory_order_relaxed);
+  while (consumed < tail_submitted.load(std::memory_order_acquire)) {
+    const auto slot = static_cast<std::size_t>(consumed % kTailSlots);
+    const auto block = input_block.at(slot);
+    // A tail side that fell behind skips what can no longer play, so it
+    // catches up sooner and never writes an output slot for a block that is
+    // not going to be read.
+    if (block < due_block.load(std::memory_order_acquire)) {
+      tail_consumed.store(++consumed, std::memory_order_release);
+      continue;
+    }
+    // A dropped block breaks the history the partitions rely on.
+    if (block != last_tail_block + 1) {
+      for (auto &channel : channels) {
+        channel.tail.reset();
+      }
+    }
+    const auto output_slot = static_cast<std::size_t>(block) % kTailSlots;
+    for (std::size_t index = 0; index < channels.size(); ++index) {
+      channels.at(index).tail.processBlock(tailSlot(tail_input, slot, index),
+                                           tailSlot(tail_output, output_slot, index));
+    }
+    output_block.at(output_slot).store(block, std::memory_order_release);
+    last_tail_block = block;
+    tail_consumed.store(++consumed, std::memory_order_release);
+  }
+}
+
+void ConvolutionReverb::runTail() {
+  while (true) {
+    const auto epoch = tail_wake.load(std::memory_order_acquire);
+    if (stopping.load(std::memory_order_acquire)) {
+      return;
+    }
+    if (!tail_held.load(std::memory_order_acquire) &&
+        tail_consumed.load(std::memory_order_relaxed) <
+            tail_submitted.load(std::memory_order_acquire)) {
+      processTailBlocks();
+      continue;
+    }
+    tail_wake.wait(epoch, std::memory_order_acquire);
+  }
+}
+
+auto ConvolutionReverb::tailSlot(std::vector<float> &ring, std::size_t slot,
+                                 std::size_t channel_index) -> std::span<float> {
+  return std::span(ring).subspan(((slot * channels.size()) + channel_index) * kTailPartition,
+                                 kTailPartition);
+}
+} // namespace limit
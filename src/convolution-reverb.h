@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include "audio-graph.h"
+#include "partitioned-convolver.h"
+
+namespace limit {
+// The response is split into three segments. The head is convolved sample
+// by sample, the early segment in kReverbEarlyPartition blocks on the audio
+// thread and the rest in kReverbTailPartition blocks on a background
+// thread, which gets one whole tail block of time for each.
+constexpr int kReverbHeadLength = 64;
+constexpr int kReverbEarlyPartition = 64;
+constexpr int kReverbTailPartition = 1024;
+constexpr int kReverbTailOffset = 2 * kReverbTailPartition;
+constexpr int kReverbTailSlots = 4;
+constexpr double kReverbMaxSeconds = 8.0;
+constexpr double kRoomToHallSeconds = 2.2;
+
+static_assert(kReverbHeadLength >= kReverbEarlyPartition);
+static_assert((kReverbTailOffset - kReverbHeadLength) % kReverbEarlyPartition == 0);
+static_assert(kReverbTailPartition % kReverbEarlyPartition == 0);
+
+// The built-in response ("Room to hall"): stereo decaying noise with a
+// kRoomToHallSeconds RT60 at sample_rate, the same on every run.
+auto makeRoomToHallImpulse(double sample_rate) -> juce::AudioBuffer<float>;
+
+// Reverb for Send 1 that convolves the send bus with an impulse response
+// (non-uniform partitioned convolution). Short partitions near the start
+// keep the output sample-aligned with the input, so the reverb adds no
+// latency at any block size; long partitions for the tail keep the cost per
+// sample low however long the response is. The return is wet only.
+//
+// The background thread works through tail blocks in order. If it falls
+// behind, the late blocks play without their tail and count as misses, and
+// once it catches up it drops the blocks that are too late to play rather
+// than convolving them; the head and early reflections are never affected.
+// Without start() the tail is computed on the audio thread at each tail
+// block boundary, which is what the offline renderer uses so renders are
+// repeatable.
+class ConvolutionReverb final : public AudioGraphNode {
+public:
+  ConvolutionReverb() = default;
+  ~ConvolutionReverb() override;
+  ConvolutionReverb(const ConvolutionReverb &) = delete;
+  auto operator=(const ConvolutionReverb &) -> ConvolutionReverb & = delete;
+  ConvolutionReverb(ConvolutionReverb &&) = delete;
+  auto operator=(ConvolutionReverb &&) -> ConvolutionReverb & = delete;
+
+  // Message thread, while the audio is stopped. The response must already
+  // be at the rate the next prepare() uses; a mono response feeds both
+  // channels and anything past kReverbMaxSeconds is dropped.
+  void setImpulseResponse(const juce::AudioBuffer<float> &impulse, double sample_rate);
+  void start();
+  void stop();
+
+  void prepare(double sample_rate, int max_block_size) override;
+  void process(AudioGraphBuses &buses, const juce::MidiBuffer &midi, int num_samples) override;
+  // Replaces the first two channels of buffer with their reverb, or with
+  // silence when there is no response.
+  void render(juce::AudioBuffer<float> &buffer, int num_samples);
+
+  // Message thread.
+  auto impulseLength() const -> int;
+  // Any thread.
+  auto tailMissCount() const -> std::uint64_t;
+  auto pendingTailBlocks() const -> int;
+  // Keeps the tail thread from taking new blocks while held, as a stalled
+  // thread would.
+  void holdTailForTesting(bool held);
+
+private:
+  struct Channel {
+    // Head taps in reverse order, so the head is a dot product with the
+    // most recent input.
+    std::vector<float> head;
+    // kReverbHeadLength - 1 earlier samples followed by the current early
+    // block.
+    std::vector<float> input;
+    UniformConvolver early;
+    std::vector<float> early_output;
+    UniformConvolver tail;
+  };
+
+  void processChunk(Channel &channel, std::size_t channel_index, std::span<float> samples);
+  void finishEarlyBlock();
+  void finishTailBlock();
+  // Convolves every submitted tail block; the tail thread, or the audio
+  // thread when there is none.
+  void processTailBlocks();
+  void runTail();
+  auto tailSlot(std::vector<float> &ring, std::size_t slot, std::size_t channel_index)
+      -> std::span<float>;
+
+  std::array<std::vector<float>, kStereoChannelCount> impulse;
+  std::array<Channel, kStereoChannelCount> channels;
+  bool has_tail = false;
+
+  // Audio thread.
+  int early_position = 0;
+  int tail_position = 0;
+  std::int64_t tail_block = 0;
+  bool tail_writable = true;
+  bool tail_playing = false;
+
+  // Tail blocks pass through rings of kReverbTailSlots, slot-major then
+  // channel. An input slot is written only once the tail side has consumed
+  // it; an output slot is read only once output_block names the block
+  // being played.
+  std::vector<float> tail_input;
+  std::vector<float> tail_output;
+  std::array<std::int64_t, kReverbTailSlots> input_block{};
+  std::array<std::atomic<std::int64_t>, kReverbTailSlots> output_block{};
+  std::atomic<std::uint64_t> tail_submitted{0};
+  std::atomic<std::uint64_t> tail_consumed{0};
+  std::atomic<std::uint64_t> tail_misses{0};
+  // The block whose tail plays now; anything older is too late to play.
+  std::atomic<std::int64_t> due_block{-1};
+  // Tail side.
+  std::int64_t last_tail_block = -1;
+
+  std::thread tail_thread;
+  std::atomic<bool> tail_threaded{false};
+  std::atomic<bool> stopping{false};
+  std::atomic<std::uint32_t> tail_wake{0};
+  std::atomic<bool> tail_held{false};
+};
+} // namespace limit
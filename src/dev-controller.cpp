@@ -1,13 +1,53 @@
 #include "dev-controller.h"
 
 #include <algorithm>
+#include <cmath>
 
 namespace {
-constexpr int kMidiMin = 0;
 constexpr int kMidiMax = 127;
 constexpr int kMidiCenter = 64;
 constexpr int kDeltaDown = -1;
 constexpr int kDeltaUp = 1;
+constexpr float kFineScale = 0.125f;
+constexpr float kCoarseScale = 8.0f;
+constexpr double kAccelerationWindowSeconds = 0.12;
+constexpr double kMaxAcceleration = 8.0;
+
+auto speedScale(limit::DevEncoderSpeed speed) -> float {
+  switch (speed) {
+  case limit::DevEncoderSpeed::kFine:
+    return kFineScale;
+  case limit::DevEncoderSpeed::kCoarse:
+    return kCoarseScale;
+  case limit::DevEncoderSpeed::kNormal:
+    break;
+  }
+  return 1.0f;
+}
+
+// Inversely proportional to the gap since the previous turn in the same
+// direction: 1 at the edge of the window, kMaxAcceleration at an eighth of it.
+auto acceleration(double previous_seconds, double now_seconds, bool same_direction) -> double {
+  if (!same_direction || previous_seconds < 0.0 || now_seconds < previous_seconds) {
+    return 1.0;
+  }
+  const auto gap = now_seconds - previous_seconds;
+  if (gap >= kAccelerationWindowSeconds) {
+    return 1.0;
+  }
+  return kAccelerationWindowSeconds / std::max(gap, kAccelerationWindowSeconds / kMaxAcceleration);
+}
+
+auto makeEncoderEvent(int encoder_index, const limit::DevControllerState &state)
+    -> limit::DevEncoderEvent {
+  limit::DevEncoderEvent event;
+  event.bank = state.encoder_bank;
+  event.encoder_index = encoder_index;
+  event.position = state.encoders.at(static_cast<std::size_t>(encoder_index));
+  event.value = event.position / limit::kDevEncoderFineSteps;
+  event.cc = state.encoder_bank * limit::kDevEncoderCount + encoder_index;
+  return event;
+}
 } // namespace
 
 namespace limit {
@@ -34,28 +74,75 @@ auto handleDevEncoderAction(int encoder_index, DevEncoderAction action,
     return std::nullopt;
   }
 
-  const auto encoder_slot = static_cast<std::size_t>(encoder_index);
-  auto &value = state.encoders.at(encoder_slot);
   switch (action) {
   case DevEncoderAction::kDecrease:
-    value = std::clamp(value + kDeltaDown, kMidiMin, kMidiMax);
-    break;
+    return handleDevEncoderTurn(encoder_index, {.detents = kDeltaDown}, state);
   case DevEncoderAction::kIncrease:
-    value = std::clamp(value + kDeltaUp, kMidiMin, kMidiMax);
-    break;
+    return handleDevEncoderTurn(encoder_index, {.detents = kDeltaUp}, state);
   case DevEncoderAction::kReset:
-    value = kMidiCenter;
     break;
   }
 
-  DevEncoderEvent event;
-  event.bank = state.encoder_bank;
-  event.encoder_index = encoder_index;
-  event.value = value;
-  event.cc = state.encoder_bank * kDevEncoderCount + encoder_index;
+  state.encoders.at(static_cast<std::size_t>(encoder_index)) = kMidiCenter * kDevEncoderFineSteps;
+  auto event = makeEncoderEvent(encoder_index, state);
+  event.reset = true;
   return event;
 }
 
+auto handleDevEncoderTurn(int encoder_index, const DevEncoderTurn &turn,
+                          DevControllerState &state)
+    -> std::optional<DevEncoderEvent> {
+  if (encoder_index < 0 || encoder_index >= kDevEncoderCount || turn.detents == 0) {
+    return std::nullopt;
+  }
+
+  const auto encoder_slot = static_cast<std::size_t>(encoder_index);
+  const auto direction = turn.detents > 0 ? kDeltaUp : kDeltaDown;
+  auto multiplier = 1.0;
+  if (turn.speed != DevEncoderSpeed::kFine && turn.time_seconds >= 0.0) {
+    multiplier = acceleration(state.last_turn_seconds.at(encoder_slot), turn.time_seconds,
+                              state.last_turn_direction.at(encoder_slot) == direction);
+  }
+  state.last_turn_seconds.at(encoder_slot) = turn.time_seconds;
+  state.last_turn_direction.at(encoder_slot) = direction;
+
+  const auto steps = static_cast<float>(turn.detents) * speedScale(turn.speed) *
+                     static_cast<float>(multiplier);
+  auto &position = state.encoders.at(encoder_slot);
+  position = std::clamp(
+      position + static_cast<int>(std::lround(steps * static_cast<float>(kDevEncoderFineSteps))),
+      0, kDevEncoderMaxPosition);
+
+  auto event = makeEncoderEvent(encoder_index, state);
+  event.steps = steps;
+  return event;
+}
+
+auto decodeRelativeCc(int value, DevRelativeMode mode) -> int {
+  const auto data = std::clamp(value, 0, kMidiMax);
+  switch (mode) {
+  case DevRelativeMode::kTwosComplement:
+    return data < kMidiCenter ? data : data - (kMidiMax + 1);
+  case DevRelativeMode::kBinaryOffset:
+    return data - kMidiCenter;
+  case DevRelativeMode::kSignMagnitude:
+    return data < kMidiCenter ? data : kMidiCenter - data;
+  }
+  return 0;
+}
+
+auto handleDevEncoderCc(int cc, int value, double time_seconds, DevControllerState &state)
+    -> std::optional<DevEncoderEvent> {
+  if (cc < 0 || cc >= kDevBankCount * kDevEncoderCount) {
+    return std::nullopt;
+  }
+  state.encoder_bank = cc / kDevEncoderCount;
+  return handleDevEncoderTurn(cc % kDevEncoderCount,
+                              {.detents = decodeRelativeCc(value, state.relative_mode),
+                               .time_seconds = time_seconds},
+                              state);
+}
+
 auto handleDevPadPress(int pad_index, DevControllerState &state)
     -> std::optional<DevPadEvent> {
   if (pad_index < 0 || pad_index >= kDevPadCount) {
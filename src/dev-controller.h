@@ -8,18 +8,48 @@ namespace limit {
 constexpr int kDevEncoderCount = 6;
 constexpr int kDevBankCount = 3;
 constexpr int kDevPadCount = 16;
+constexpr int kDevEncoderFineSteps = 128;
+constexpr int kDevEncoderMaxPosition = (128 * kDevEncoderFineSteps) - 1;
+constexpr int kDevEncoderChannel = 16;
+
+// Scale of one detent: fine is an eighth of a step, coarse eight steps.
+enum class DevEncoderSpeed : std::uint8_t { kFine, kNormal, kCoarse };
+
+// Relative CC encodings the MPD218 can send. Two's complement: 1 is +1 and
+// 127 is -1; binary offset: 65 is +1 and 63 is -1; sign magnitude: 1 is +1
+// and 65 is -1.
+enum class DevRelativeMode : std::uint8_t { kTwosComplement, kBinaryOffset, kSignMagnitude };
+
+struct DevEncoderTurn {
+  int detents = 0;
+  DevEncoderSpeed speed = DevEncoderSpeed::kNormal;
+  // When the turn happened; negative when unknown, which disables
+  // acceleration.
+  double time_seconds = -1.0;
+};
 
 struct DevControllerState {
   int encoder_bank = 0;
   int pad_bank = 0;
+  DevRelativeMode relative_mode = DevRelativeMode::kTwosComplement;
+  // 14-bit positions: kDevEncoderFineSteps per 7-bit CC value.
   std::array<int, kDevEncoderCount> encoders{};
+  std::array<double, kDevEncoderCount> last_turn_seconds{};
+  std::array<int, kDevEncoderCount> last_turn_direction{};
 };
 
+// value is the 7-bit CC sent for the encoder and position its 14-bit
+// position. steps is the movement to apply to the bound parameter, in
+// 1/127ths of its range after speed and acceleration; reset events carry no
+// steps.
 struct DevEncoderEvent {
   int bank = 0;
   int encoder_index = 0;
   int value = 0;
   int cc = 0;
+  int position = 0;
+  float steps = 0.0f;
+  bool reset = false;
 };
 
 enum class DevEncoderAction : std::uint8_t { kDecrease, kReset, kIncrease };
@@ -34,6 +64,17 @@ auto setDevPadBank(int bank_index, DevControllerState &state) -> bool;
 auto handleDevEncoderAction(int encoder_index, DevEncoderAction action,
                             DevControllerState &state)
     -> std::optional<DevEncoderEvent>;
+// Turns spaced closer than the acceleration window in one direction move up
+// to eight times further, so a quick sweep crosses the range while slow
+// turns stay precise. Fine turns are never accelerated.
+auto handleDevEncoderTurn(int encoder_index, const DevEncoderTurn &turn,
+                          DevControllerState &state)
+    -> std::optional<DevEncoderEvent>;
+auto decodeRelativeCc(int value, DevRelativeMode mode) -> int;
+// A relative CC from the hardware: cc is bank * kDevEncoderCount + encoder,
+// matching the dev CCs, and selects that bank.
+auto handleDevEncoderCc(int cc, int value, double time_seconds, DevControllerState &state)
+    -> std::optional<DevEncoderEvent>;
 auto handleDevPadPress(int pad_index, DevControllerState &state)
     -> std::optional<DevPadEvent>;
 } // namespace limit
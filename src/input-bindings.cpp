@@ -0,0 +1,300 @@
+#include "input-bindings.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace {
+using limit::InputKind;
+using limit::NamedKey;
+
+constexpr std::size_t kMaxTokens = 7;
+constexpr int kEncoderDirections = 3;
+
+struct KeyName {
+  std::string_view name;
+  int code = -1;
+};
+
+constexpr auto named(std::string_view name, NamedKey key) -> KeyName {
+  return {.name = name, .code = limit::inputCode(key)};
+}
+
+constexpr std::array<KeyName, 42> kKeyNames{{
+    named("f1", NamedKey::kF1),
+    named("f2", NamedKey::kF2),
+    named("f3", NamedKey::kF3),
+    named("f4", NamedKey::kF4),
+    named("f5", NamedKey::kF5),
+    named("f6", NamedKey::kF6),
+    named("f7", NamedKey::kF7),
+    named("f8", NamedKey::kF8),
+    named("f9", NamedKey::kF9),
+    named("f10", NamedKey::kF10),
+    named("f11", NamedKey::kF11),
+    named("f12", NamedKey::kF12),
+    named("num0", NamedKey::kNum0),
+    named("num1", NamedKey::kNum1),
+    named("num2", NamedKey::kNum2),
+    named("num3", NamedKey::kNum3),
+    named("num4", NamedKey::kNum4),
+    named("num5", NamedKey::kNum5),
+    named("num6", NamedKey::kNum6),
+    named("num7", NamedKey::kNum7),
+    named("num8", NamedKey::kNum8),
+    named("num9", NamedKey::kNum9),
+    named("num.", NamedKey::kNumDecimal),
+    named("num+", NamedKey::kNumAdd),
+    named("num-", NamedKey::kNumSubtract),
+    named("num*", NamedKey::kNumMultiply),
+    named("num/", NamedKey::kNumDivide),
+    named("insert", NamedKey::kInsert),
+    named("delete", NamedKey::kDelete),
+    named("home", NamedKey::kHome),
+    named("end", NamedKey::kEnd),
+    named("pageup", NamedKey::kPageUp),
+    named("pagedown", NamedKey::kPageDown),
+    named("left", NamedKey::kLeft),
+    named("right", NamedKey::kRight),
+    named("up", NamedKey::kUp),
+    named("down", NamedKey::kDown),
+    named("tab", NamedKey::kTab),
+    named("backspace", NamedKey::kBackspace),
+    named("enter", NamedKey::kReturn),
+    named("escape", NamedKey::kEscape),
+    {.name = "space", .code = ' '},
+}};
+
+struct ActionName {
+  std::string_view name;
+  InputKind kind = InputKind::kNone;
+};
+
+// Actions that take no arguments.
+constexpr std::array<ActionName, 16> kActionNames{{
+    {.name = "none", .kind = InputKind::kNone},
+    {.name = "sub-view", .kind = InputKind::kSubView},
+    {.name = "pad-bank", .kind = InputKind::kPadBank},
+    {.name = "control-bank", .kind = InputKind::kControlBank},
+    {.name = "prog-select", .kind = InputKind::kProgSelect},
+    {.name = "mod", .kind = InputKind::kMod},
+    {.name = "sustain", .kind = InputKind::kSustain},
+    {.name = "octave-down", .kind = InputKind::kOctaveDown},
+    {.name = "octave-up", .kind = InputKind::kOctaveUp},
+    {.name = "pitch-down", .kind = InputKind::kPitchDown},
+    {.name = "pitch-up", .kind = InputKind::kPitchUp},
+    {.name = "transport", .kind = InputKind::kTransport},
+    {.name = "reload-mapping", .kind = InputKind::kReloadMapping},
+    {.name = "diagnostics", .kind = InputKind::kDiagnostics},
+    {.name = "dump-diagnostics", .kind = InputKind::kDumpDiagnostics},
+    {.name = "measure-latency", .kind = InputKind::kMeasureLatency},
+}};
+
+constexpr std::array<std::string_view, kEncoderDirections> kEncoderDirectionNames{"dec", "reset",
+                                                                                  "inc"};
+// In AppMode order.
+constexpr std::array<std::string_view, 4> kModeNames{"sound", "sequence", "tape", "mix"};
+
+// Splits on whitespace; returns nullopt when there are too many tokens.
+auto tokenize(std::string_view line)
+    -> std::optional<std::pair<std::array<std::string_view, kMaxTokens>, std::size_t>> {
+  std::array<std::string_view, kMaxTokens> tokens{};
+  std::size_t count = 0;
+  std::size_t position = 0;
+  while (position < line.size()) {
+    const auto start = line.find_first_not_of(" \t\r", position);
+    if (start == std::string_view::npos) {
+      break;
+    }
+    const auto end = std::min(line.find_first_of(" \t\r", start), line.size());
+    if (count == tokens.size()) {
+      return std::nullopt;
+    }
+    tokens.at(count++) = line.substr(start, end - start);
+    position = end;
+  }
+  return std::pair{tokens, count};
+}
+
+auto parseNumber(std::string_view token, int low, int high) -> std::optional<int> {
+  int value = 0;
+  const auto *const end = token.data() + token.size();
+  const auto [last, error] = std::from_chars(token.data(), end, value);
+  if (error != std::errc{} || last != end || value < low || value > high) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+auto parseAction(std::span<const std::string_view> tokens) -> std::optional<limit::InputAction> {
+  if (tokens.empty()) {
+    return std::nullopt;
+  }
+  const auto name = tokens.front();
+  const auto arguments = tokens.subspan(1);
+  if (arguments.empty()) {
+    const auto *const found =
+        std::find_if(kActionNames.begin(), kActionNames.end(),
+                     [name](const auto &entry) { return entry.name == name; });
+    if (found == kActionNames.end()) {
+      return std::nullopt;
+    }
+    return limit::InputAction{.kind = found->kind};
+  }
+  if (name == "pad" && arguments.size() == 1) {
+    const auto pad = parseNumber(arguments.front(), 1, limit::kDevPadCount);
+    if (!pad) {
+      return std::nullopt;
+    }
+    return limit::InputAction{.kind = InputKind::kPad, .index = static_cast<std::int8_t>(*pad - 1)};
+  }
+  if (name == "note" && arguments.size() == 1) {
+    const auto note = parseNumber(arguments.front(), 0, limit::kKeymapNoteCount - 1);
+    if (!note) {
+      return std::nullopt;
+    }
+    return limit::InputAction{.kind = InputKind::kNote, .index = static_cast<std::int8_t>(*note)};
+  }
+  if (name == "encoder" && arguments.size() == 2) {
+    const auto encoder = parseNumber(arguments.front(), 1, limit::kDevEncoderCount);
+    const auto *const direction =
+        std::find(kEncoderDirectionNames.begin(), kEncoderDirectionNames.end(), arguments.back());
+    if (!encoder || direction == kEncoderDirectionNames.end()) {
+      return std::nullopt;
+    }
+    return limit::InputAction{
+        .kind = InputKind::kEncoder,
+        .index = static_cast<std::int8_t>(*encoder - 1),
+        .encoder = static_cast<limit::DevEncoderAction>(
+            std::distance(kEncoderDirectionNames.begin(), direction))};
+  }
+  if (name == "mode" && arguments.size() == 1) {
+    const auto *const mode = std::find(kModeNames.begin(), kModeNames.end(), arguments.front());
+    if (mode == kModeNames.end()) {
+      return std::nullopt;
+    }
+    return limit::InputAction{
+        .kind = InputKind::kMode,
+        .index = static_cast<std::int8_t>(std::distance(kModeNames.begin(), mode))};
+  }
+  if (name == "relative-encoder" && arguments.size() == 2) {
+    const auto bank = parseNumber(arguments.front(), 1, limit::kDevBankCount);
+    const auto encoder = parseNumber(arguments.back(), 1, limit::kDevEncoderCount);
+    if (!bank || !encoder) {
+      return std::nullopt;
+    }
+    return limit::InputAction{.kind = InputKind::kRelativeEncoder,
+                              .index = static_cast<std::int8_t>(*encoder - 1),
+                              .bank = static_cast<std::int8_t>(*bank - 1)};
+  }
+  return std::nullopt;
+}
+} // namespace
+
+namespace limit {
+auto inputCodeForName(std::string_view name) -> int {
+  std::string lower(name);
+  std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char letter) {
+    return static_cast<char>(letter >= 'A' && letter <= 'Z' ? letter - 'A' + 'a' : letter);
+  });
+  const auto *const found =
+      std::find_if(kKeyNames.begin(), kKeyNames.end(),
+                   [&lower](const auto &entry) { return entry.name == lower; });
+  if (found != kKeyNames.end()) {
+    return found->code;
+  }
+  return name.size() == 1 ? inputCodeForChar(static_cast<unsigned char>(name.front())) : -1;
+}
+
+auto InputBindings::key(int code) const -> InputAction {
+  if (code < 0 || code >= kInputKeyCount) {
+    return {};
+  }
+  return keys.at(static_cast<std::size_t>(code));
+}
+
+auto InputBindings::midiNote(int channel, int note) const -> InputAction {
+  const auto index = midiBindingIndex(false, channel, note);
+  return index < 0 ? InputAction{} : midi.at(static_cast<std::size_t>(index));
+}
+
+auto InputBindings::midiController(int channel, int controller) const -> InputAction {
+  const auto index = midiBindingIndex(true, channel, controller);
+  return index < 0 ? InputAction{} : midi.at(static_cast<std::size_t>(index));
+}
+
+void InputBindings::reset() {
+  keys = kDefaultKeyBindings;
+  midi = kDefaultMidiBindings;
+}
+
+// A missing file leaves the defaults in place, so deleting the mapping file
+// and reloading restores the standard layout.
+auto InputBindings::load(const std::filesystem::path &path) -> InputMapReport {
+  reset();
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return {};
+  }
+  const std::string mapping{std::istreambuf_iterator<char>(file),
+                            std::istreambuf_iterator<char>()};
+  auto report = apply(mapping);
+  report.opened = true;
+  return report;
+}
+
+auto InputBindings::apply(std::string_view mapping) -> InputMapReport {
+  InputMapReport report;
+  int line_number = 0;
+  while (!mapping.empty()) {
+    const auto line_end = std::min(mapping.find('\n'), mapping.size());
+    const auto line = mapping.substr(0, line_end);
+    mapping.remove_prefix(std::min(line_end + 1, mapping.size()));
+    ++line_number;
+
+    const auto first = line.find_first_not_of(" \t\r");
+    if (first == std::string_view::npos || line.at(first) == '#') {
+      continue;
+    }
+    if (applyLine(line)) {
+      ++report.applied;
+    } else if (report.rejected++ == 0) {
+      report.first_rejected_line = line_number;
+    }
+  }
+  return report;
+}
+
+auto InputBindings::applyLine(std::string_view line) -> bool {
+  const auto tokenized = tokenize(line);
+  if (!tokenized) {
+    return false;
+  }
+  const auto tokens = std::span(tokenized->first).first(tokenized->second);
+  if (tokens.size() >= 4 && (tokens.front() == "midi-note" || tokens.front() == "midi-cc")) {
+    const auto channel = parseNumber(tokens[1], 1, kMidiChannelCount);
+    const auto number = parseNumber(tokens[2], 0, kMidiNumberCount - 1);
+    const auto action = parseAction(tokens.subspan(3));
+    if (!channel || !number || !action) {
+      return false;
+    }
+    const auto index = midiBindingIndex(tokens.front() == "midi-cc", *channel, *number);
+    midi.at(static_cast<std::size_t>(index)) = *action;
+    return true;
+  }
+  if (tokens.size() < 2) {
+    return false;
+  }
+  const auto code = inputCodeForName(tokens.front());
+  const auto action = parseAction(tokens.subspan(1));
+  if (code < 0 || !action) {
+    return false;
+  }
+  keys.at(static_cast<std::size_t>(code)) = *action;
+  return true;
+}
+} // namespace limit
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <utility>
+
+#include "dev-controller.h"
+
+namespace limit {
+// Keys are identified by a portable input code: printable ASCII characters
+// are their lower-case character, everything else a NamedKey. The JUCE key
+// code translation lives with the component that receives key presses.
+constexpr int kInputKeyCount = 256;
+constexpr int kFirstPrintableKey = 32;
+constexpr int kLastPrintableKey = 126;
+constexpr int kMidiChannelCount = 16;
+constexpr int kMidiNumberCount = 128;
+constexpr int kMidiBindingCount = 2 * kMidiChannelCount * kMidiNumberCount;
+constexpr int kKeymapNoteCount = 13;
+
+enum class NamedKey : std::uint8_t {
+  kF1 = 128,
+  kF2,
+  kF3,
+  kF4,
+  kF5,
+  kF6,
+  kF7,
+  kF8,
+  kF9,
+  kF10,
+  kF11,
+  kF12,
+  kNum0,
+  kNum1,
+  kNum2,
+  kNum3,
+  kNum4,
+  kNum5,
+  kNum6,
+  kNum7,
+  kNum8,
+  kNum9,
+  kNumDecimal,
+  kNumAdd,
+  kNumSubtract,
+  kNumMultiply,
+  kNumDivide,
+  kInsert,
+  kDelete,
+  kHome,
+  kEnd,
+  kPageUp,
+  kPageDown,
+  kLeft,
+  kRight,
+  kUp,
+  kDown,
+  kTab,
+  kBackspace,
+  kReturn,
+  kEscape,
+};
+
+enum class InputKind : std::uint8_t {
+  kNone,
+  kPad,
+  kNote,
+  kEncoder,
+  kRelativeEncoder,
+  kPadBank,
+  kControlBank,
+  kProgSelect,
+  kMod,
+  kSustain,
+  kOctaveDown,
+  kOctaveUp,
+  kPitchDown,
+  kPitchUp,
+  kTransport,
+  kReloadMapping,
+  kDiagnostics,
+  kDumpDiagnostics,
+  kMeasureLatency,
+  kMode,
+  kSubView,
+};
+
+// What an input does. index is the pad, the semitone above the keymap's
+// lowest note, the encoder or the mode (in AppMode order); bank is the
+// hardware bank a relative encoder CC belongs to.
+struct InputAction {
+  InputKind kind = InputKind::kNone;
+  std::int8_t index = 0;
+  std::int8_t bank = 0;
+  DevEncoderAction encoder = DevEncoderAction::kReset;
+
+  auto operator==(const InputAction &other) const -> bool = default;
+};
+
+using KeyBindingTable = std::array<InputAction, kInputKeyCount>;
+using MidiBindingTable = std::array<InputAction, kMidiBindingCount>;
+
+constexpr auto inputCode(NamedKey key) -> int { return static_cast<int>(key); }
+
+constexpr auto inputCodeForChar(int key_char) -> int {
+  if (key_char < kFirstPrintableKey || key_char > kLastPrintableKey) {
+    return -1;
+  }
+  return key_char >= 'A' && key_char <= 'Z' ? key_char - 'A' + 'a' : key_char;
+}
+
+// The layout in docs/control-scheme.md.
+constexpr auto makeDefaultKeyBindings() -> KeyBindingTable {
+  KeyBindingTable table{};
+  constexpr std::string_view kPadKeys = "1234qwerasdfzxcv";
+  for (std::size_t pad = 0; pad < kPadKeys.size(); ++pad) {
+    table.at(static_cast<std::size_t>(kPadKeys.at(pad))) = {
+        .kind = InputKind::kPad, .index = static_cast<std::int8_t>(pad)};
+  }
+  // Semitone order: white keys on the home row, black keys above them.
+  constexpr std::string_view kNoteKeys = "gyhujkolp;['\\";
+  static_assert(kNoteKeys.size() == kKeymapNoteCount);
+  for (std::size_t note = 0; note < kNoteKeys.size(); ++note) {
+    table.at(static_cast<std::size_t>(kNoteKeys.at(note))) = {
+        .kind = InputKind::kNote, .index = static_cast<std::int8_t>(note)};
+  }
+  constexpr std::array<std::array<NamedKey, 3>, kDevEncoderCount> kEncoderKeys{{
+      {NamedKey::kNum7, NamedKey::kNum8, NamedKey::kNum9},
+      {NamedKey::kNum4, NamedKey::kNum5, NamedKey::kNum6},
+      {NamedKey::kNum1, NamedKey::kNum2, NamedKey::kNum3},
+      {NamedKey::kInsert, NamedKey::kHome, NamedKey::kPageUp},
+      {NamedKey::kDelete, NamedKey::kEnd, NamedKey::kPageDown},
+      {NamedKey::kLeft, NamedKey::kDown, NamedKey::kRight},
+  }};
+  constexpr std::array<DevEncoderAction, 3> kEncoderActions{
+      DevEncoderAction::kDecrease, DevEncoderAction::kReset, DevEncoderAction::kIncrease};
+  for (std::size_t encoder = 0; encoder < kEncoderKeys.size(); ++encoder) {
+    for (std::size_t key = 0; key < kEncoderActions.size(); ++key) {
+      table.at(static_cast<std::size_t>(inputCode(kEncoderKeys.at(encoder).at(key)))) = {
+          .kind = InputKind::kEncoder,
+          .index = static_cast<std::int8_t>(encoder),
+          .encoder = kEncoderActions.at(key)};
+    }
+  }
+  constexpr std::array<std::pair<NamedKey, InputKind>, 13> kButtons{{
+      {NamedKey::kUp, InputKind::kControlBank},
+      {NamedKey::kF1, InputKind::kPadBank},
+      {NamedKey::kF2, InputKind::kProgSelect},
+      {NamedKey::kF3, InputKind::kMod},
+      {NamedKey::kF4, InputKind::kSustain},
+      {NamedKey::kF5, InputKind::kOctaveDown},
+      {NamedKey::kF6, InputKind::kOctaveUp},
+      {NamedKey::kF7, InputKind::kPitchDown},
+      {NamedKey::kF8, InputKind::kPitchUp},
+      {NamedKey::kF9, InputKind::kTransport},
+      {NamedKey::kF10, InputKind::kDumpDiagnostics},
+      {NamedKey::kF11, InputKind::kDiagnostics},
+      {NamedKey::kF12, InputKind::kReloadMapping},
+  }};
+  for (const auto &[key, kind] : kButtons) {
+    table.at(static_cast<std::size_t>(inputCode(key))) = {.kind = kind};
+  }
+  // Sound, Sequence, Tape and Mix, then the next sub-view of the mode.
+  constexpr std::string_view kModeKeys = "5678";
+  for (std::size_t mode = 0; mode < kModeKeys.size(); ++mode) {
+    table.at(static_cast<std::size_t>(kModeKeys.at(mode))) = {
+        .kind = InputKind::kMode, .index = static_cast<std::int8_t>(mode)};
+  }
+  table.at(static_cast<std::size_t>(inputCode(NamedKey::kTab))) = {.kind = InputKind::kSubView};
+  return table;
+}
+
+constexpr auto midiBindingIndex(bool controller, int channel, int number) -> int {
+  if (channel < 1 || channel > kMidiChannelCount || number < 0 || number >= kMidiNumberCount) {
+    return -1;
+  }
+  return ((((controller ? 1 : 0) * kMidiChannelCount) + channel - 1) * kMidiNumberCount) +
+         number;
+}
+
+// MPD218 encoders in relative mode on channel 16 (see dev-controller.h).
+constexpr auto makeDefaultMidiBindings() -> MidiBindingTable {
+  MidiBindingTable table{};
+  for (int cc = 0; cc < kDevBankCount * kDevEncoderCount; ++cc) {
+    table.at(static_cast<std::size_t>(midiBindingIndex(true, kDevEncoderChannel, cc))) = {
+        .kind = InputKind::kRelativeEncoder,
+        .index = static_cast<std::int8_t>(cc % kDevEncoderCount),
+        .bank = static_cast<std::int8_t>(cc / kDevEncoderCount)};
+  }
+  return table;
+}
+
+inline constexpr KeyBindingTable kDefaultKeyBindings = makeDefaultKeyBindings();
+inline constexpr MidiBindingTable kDefaultMidiBindings = makeDefaultMidiBindings();
+
+struct InputMapReport {
+  bool opened = false;
+  int applied = 0;
+  int rejected = 0;
+  int first_rejected_line = 0;
+};
+
+auto inputCodeForName(std::string_view name) -> int;
+
+// Key and MIDI bindings, looked up in O(1) by input code or by MIDI channel
+// and number. Starts with the default layout; a mapping file replaces
+// individual bindings on top of the defaults. One binding per line:
+//
+//   <key> <action>                  t transport
+//   midi-note <ch> <n> <action>     midi-note 10 36 pad 1
+//   midi-cc <ch> <n> <action>       midi-cc 1 64 sustain
+//
+// Keys are a printable character or a name (f1, num7, pageup, space, ...).
+// Actions: none, pad <1-16>, note <0-12>, encoder <1-6> dec|reset|inc,
+// relative-encoder <bank 1-3> <encoder 1-6>, mode sound|sequence|tape|mix,
+// sub-view, pad-bank, control-bank, prog-select, mod, sustain, octave-down,
+// octave-up, pitch-down, pitch-up, transport, reload-mapping, diagnostics,
+// dump-diagnostics, measure-latency.
+// Blank lines and lines starting with # are ignored; malformed lines are
+// skipped and counted.
+class InputBindings {
+public:
+  auto key(int code) const -> InputAction;
+  auto midiNote(int channel, int note) const -> InputAction;
+  auto midiController(int channel, int controller) const -> InputAction;
+
+  void reset();
+  auto load(const std::filesystem::path &path) -> InputMapReport;
+  auto apply(std::string_view mapping) -> InputMapReport;
+
+private:
+  auto applyLine(std::string_view line) -> bool;
+
+  KeyBindingTable keys = kDefaultKeyBindings;
+  MidiBindingTable midi = kDefaultMidiBindings;
+};
+} // namespace limit
@@ -0,0 +1,482 @@
+#include "kit-sampler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <utility>
+
+namespace limit {
+namespace {
+constexpr auto kServiceInterval = std::chrono::milliseconds(2);
+constexpr int kMaxVelocity = 127;
+constexpr std::size_t kRingMask = kKitStreamRingFrames - 1;
+constexpr std::int64_t kMaxStreamFrames = std::numeric_limits<std::uint32_t>::max();
+constexpr int kFrameShift = 32;
+
+static_assert((kKitStreamRingFrames & (kKitStreamRingFrames - 1)) == 0,
+              "Kit stream ring size must be a power of two");
+static_assert(kKitStreamChunkFrames <= kKitStreamRingFrames,
+              "Kit stream chunks must fit the ring");
+
+// Values shared between the audio and service threads carry the voice's
+// generation in the high word and a frame position (or flag) in the low word.
+auto makeStamp(std::uint32_t generation, std::int64_t frame) -> std::uint64_t {
+  return (static_cast<std::uint64_t>(generation) << kFrameShift) |
+         static_cast<std::uint32_t>(frame);
+}
+
+auto stampGeneration(std::uint64_t stamp) -> std::uint32_t {
+  return static_cast<std::uint32_t>(stamp >> kFrameShift);
+}
+
+auto stampFrame(std::uint64_t stamp) -> std::int64_t {
+  return static_cast<std::int64_t>(stamp & std::numeric_limits<std::uint32_t>::max());
+}
+
+// 4-point, 3rd-order Hermite interpolation between points.at(1) and
+// points.at(2).
+auto hermite(const std::array<float, 4> &points, float t) -> float {
+  const auto c1 = 0.5f * (points.at(2) - points.at(0));
+  const auto c2 = points.at(0) - (2.5f * points.at(1)) + (2.0f * points.at(2)) -
+                  (0.5f * points.at(3));
+  const auto c3 = (0.5f * (points.at(3) - points.at(0))) + (1.5f * (points.at(1) - points.at(2)));
+  return (((((c3 * t) + c2) * t) + c1) * t) + points.at(1);
+}
+} // namespace
+
+KitSampler::KitSampler(double attack_length_seconds)
+    : attack_seconds(std::max(attack_length_seconds, 0.0)),
+      stream_scratch(kStereoChannelCount, kKitStreamChunkFrames) {
+  formats.registerBasicFormats();
+  for (auto &voice : voices) {
+    voice.ring_left.resize(kKitStreamRingFrames);
+    voice.ring_right.resize(kKitStreamRingFrames);
+  }
+}
+
+KitSampler::~KitSampler() { stop(); }
+
+void KitSampler::loadKit(KitDefinition definition) {
+  {
+    const std::scoped_lock lock(service_mutex);
+    requested_kit = std::move(definition);
+    kit_loading.store(true, std::memory_order_relaxed);
+  }
+  service_wakeup.notify_all();
+}
+
+void KitSampler::start() {
+  if (service_thread.joinable()) {
+    return;
+  }
+  {
+    const std::scoped_lock lock(service_mutex);
+    service_stopping = false;
+  }
+  service_thread = std::thread([this] { runServiceLoop(); });
+}
+
+void KitSampler::stop() {
+  if (!service_thread.joinable()) {
+    return;
+  }
+  {
+    const std::scoped_lock lock(service_mutex);
+    service_stopping = true;
+  }
+  service_wakeup.notify_all();
+  service_thread.join();
+}
+
+void KitSampler::prepare(double sample_rate, int /*max_block_size*/) {
+  session_rate = sample_rate;
+  for (auto &voice : voices) {
+    if (voice.active) {
+      finishVoice(voice);
+    }
+  }
+  active_voices.store(0, std::memory_order_relaxed);
+}
+
+void KitSampler::process(AudioGraphBuses &buses, const juce::MidiBuffer &midi,
+                         int num_samples) {
+  buses.instrument.clear(0, num_samples);
+  render(buses.instrument, midi, num_samples);
+}
+
+void KitSampler::render(juce::AudioBuffer<float> &output, const juce::MidiBuffer &midi,
+                        int num_samples) {
+  if (const auto *kit = next_kit.exchange(nullptr, std::memory_order_acq_rel); kit != nullptr) {
+    current_kit = kit;
+  }
+
+  const auto render_voices = [this, &output](int start_sample, int count) {
+    if (count <= 0) {
+      return;
+    }
+    for (auto &voice : voices) {
+      if (voice.active) {
+        renderVoice(voice, output, start_sample, count);
+      }
+    }
+  };
+
+  int position = 0;
+  for (const auto metadata : midi) {
+    const auto event_position = std::clamp(metadata.samplePosition, position, num_samples);
+    render_voices(position, event_position - position);
+    position = event_position;
+    handleMessage(metadata.getMessage());
+  }
+  render_voices(position, num_samples - position);
+
+  active_voices.store(static_cast<int>(std::count_if(
+                          voices.begin(), voices.end(),
+                          [](const KitVoice &voice) { return voice.active; })),
+                      std::memory_order_relaxed);
+  publishOldestKit();
+}
+
+auto KitSampler::activeVoiceCount() const -> int {
+  return active_voices.load(std::memory_order_relaxed);
+}
+
+auto KitSampler::underrunCount() const -> std::uint32_t {
+  return underruns.load(std::memory_order_relaxed);
+}
+
+auto KitSampler::residentBytes() const -> std::size_t {
+  return resident_bytes.load(std::memory_order_relaxed);
+}
+
+auto KitSampler::isKitLoading() const -> bool {
+  return kit_loading.load(std::memory_order_relaxed);
+}
+
+auto KitSampler::loadedKitCount() const -> int {
+  return kit_count.load(std::memory_order_relaxed);
+}
+
+void KitSampler::service() {
+  continueLoading();
+  for (std::size_t voice = 0; voice < voices.size(); ++voice) {
+    streamVoice(voices.at(voice), cursors.at(voice));
+  }
+  freeRetiredKits();
+}
+
+void KitSampler::handleMessage(const juce::MidiMessage &message) {
+  if (message.isNoteOn()) {
+    const auto pad = message.getNoteNumber() - kKitBaseNote;
+    if (pad >= 0 && pad < kKitPadCount) {
+      trigger(pad, message.getVelocity());
+    }
+  } else if (message.isController() &&
+             message.getControllerNumber() == kAllNotesOffController) {
+    for (auto &voice : voices) {
+      if (voice.active) {
+        finishVoice(voice);
+      }
+    }
+  }
+  // Pads are one-shot: note-offs don't cut the sample.
+}
+
+void KitSampler::trigger(int pad, int velocity) {
+  if (current_kit == nullptr || session_rate <= 0.0) {
+    return;
+  }
+  const auto &zones = current_kit->pads.at(static_cast<std::size_t>(pad));
+  const auto covers = [velocity](const LoadedZone &zone) {
+    return velocity >= zone.velocity_low && velocity <= zone.velocity_high;
+  };
+  const auto first = std::find_if(zones.begin(), zones.end(), covers);
+  if (first == zones.end()) {
+    return;
+  }
+  const auto matches = static_cast<std::uint32_t>(std::count_if(first, zones.end(), covers));
+  auto pick = first->round_robin % matches;
+  ++first->round_robin;
+
+  const auto *zone = &*first;
+  for (const auto &candidate : zones) {
+    if (covers(candidate)) {
+      if (pick == 0) {
+        zone = &candidate;
+        break;
+      }
+      --pick;
+    }
+  }
+
+  auto *voice = &voices.front();
+  for (auto &candidate : voices) {
+    if (!candidate.active) {
+      voice = &candidate;
+      break;
+    }
+    if (candidate.start_order < voice->start_order) {
+      voice = &candidate;
+    }
+  }
+  startVoice(*voice, *zone, static_cast<float>(velocity) / static_cast<float>(kMaxVelocity));
+}
+
+void KitSampler::startVoice(KitVoice &voice, const LoadedZone &zone, float velocity_gain) {
+  if (voice.active) {
+    finishVoice(voice);
+  }
+  voice.zone = &zone;
+  voice.kit_serial = current_kit->serial;
+  voice.start_order = ++next_start_order;
+  voice.generation = voice.generation == std::numeric_limits<std::uint32_t>::max()
+                         ? 1
+                         : voice.generation + 1;
+  voice.position = 0.0;
+  voice.step = zone.source_rate / session_rate;
+  voice.gain = zone.gain * velocity_gain;
+  voice.active = true;
+  voice.stream_zone.store(&zone, std::memory_order_release);
+  voice.stream_request.store(makeStamp(voice.generation, 1), std::memory_order_release);
+}
+
+void KitSampler::finishVoice(KitVoice &voice) {
+  voice.active = false;
+  voice.stream_request.store(makeStamp(voice.generation, 0), std::memory_order_release);
+}
+
+// Frames before the end of the attack come from the resident segment, later
+// ones from the ring, which holds everything the service thread has
+// published for this generation.
+void KitSampler::renderVoice(KitVoice &voice, juce::AudioBuffer<float> &output, int start_sample,
+                             int num_samples) {
+  const auto &zone = *voice.zone;
+  const auto attack_frames = static_cast<std::int64_t>(zone.attack.getNumSamples());
+  const auto end_stamp = voice.stream_end.load(std::memory_order_acquire);
+  const auto available = stampGeneration(end_stamp) == voice.generation
+                             ? std::max(stampFrame(end_stamp), attack_frames)
+                             : attack_frames;
+  const std::array<std::span<const float>, kStereoChannelCount> attack = {
+      std::span(zone.attack.getReadPointer(0), static_cast<std::size_t>(attack_frames)),
+      std::span(zone.attack.getReadPointer(1), static_cast<std::size_t>(attack_frames))};
+  const std::array<std::span<const float>, kStereoChannelCount> ring = {
+      std::span<const float>(voice.ring_left), std::span<const float>(voice.ring_right)};
+  const auto frame_at = [&](std::size_t channel, std::int64_t frame) -> float {
+    if (frame < 0 || frame >= zone.total_frames) {
+      return 0.0f;
+    }
+    if (frame < attack_frames) {
+      return attack.at(channel)[static_cast<std::size_t>(frame)];
+    }
+    return ring.at(channel)[static_cast<std::size_t>(frame) & kRingMask];
+  };
+
+  const std::array<std::span<float>, kStereoChannelCount> out = {
+      std::span(output.getWritePointer(0, start_sample), static_cast<std::size_t>(num_samples)),
+      std::span(output.getWritePointer(1, start_sample), static_cast<std::size_t>(num_samples))};
+  for (std::size_t index = 0; index < out.front().size(); ++index) {
+    const auto frame = static_cast<std::int64_t>(voice.position);
+    if (frame >= zone.total_frames) {
+      finishVoice(voice);
+      break;
+    }
+    if (std::min(frame + 2, zone.total_frames - 1) >= available) {
+      underruns.fetch_add(1, std::memory_order_relaxed);
+      finishVoice(voice);
+      break;
+    }
+    const auto fraction = static_cast<float>(voice.position - static_cast<double>(frame));
+    for (std::size_t channel = 0; channel < out.size(); ++channel) {
+      const std::array<float, 4> points = {
+          frame_at(channel, frame - 1), frame_at(channel, frame), frame_at(channel, frame + 1),
+          frame_at(channel, frame + 2)};
+      out.at(channel)[index] += hermite(points, fraction) * voice.gain;
+    }
+    voice.position += voice.step;
+  }
+
+  if (voice.active) {
+    const auto oldest_needed =
+        std::max<std::int64_t>(static_cast<std::int64_t>(voice.position) - 1, 0);
+    voice.stream_read.store(makeStamp(voice.generation, oldest_needed),
+                            std::memory_order_release);
+  }
+}
+
+// Tells the service thread which kits may still be read: the current one
+// and any older kit a voice is still playing.
+void KitSampler::publishOldestKit() {
+  if (current_kit == nullptr) {
+    return;
+  }
+  auto oldest = current_kit->serial;
+  for (const auto &voice : voices) {
+    if (voice.active) {
+      oldest = std::min(oldest, voice.kit_serial);
+    }
+  }
+  oldest_kit_serial.store(oldest, std::memory_order_release);
+}
+
+// Decodes at most kZonesPerPass attack segments per pass so a kit change
+// never holds up streaming for the voices already playing.
+void KitSampler::continueLoading() {
+  {
+    const std::scoped_lock lock(service_mutex);
+    if (requested_kit.has_value()) {
+      loading_definition = std::move(requested_kit);
+      requested_kit.reset();
+      loading_kit = std::make_unique<LoadedKit>();
+      loading_pad = 0;
+      loading_zone = 0;
+    }
+  }
+  if (!loading_definition.has_value()) {
+    return;
+  }
+
+  int loaded = 0;
+  while (loading_pad < kKitPadCount && loaded < kZonesPerPass) {
+    const auto pad = static_cast<std::size_t>(loading_pad);
+    const auto &zones = loading_definition->pads.at(pad).zones;
+    if (loading_zone >= zones.size()) {
+      ++loading_pad;
+      loading_zone = 0;
+      continue;
+    }
+    if (auto zone = loadZone(zones.at(loading_zone))) {
+      loading_kit->resident_bytes += sizeof(float) * kStereoChannelCount *
+                                     static_cast<std::size_t>(zone->attack.getNumSamples());
+      loading_kit->pads.at(pad).push_back(std::move(*zone));
+    }
+    ++loading_zone;
+    ++loaded;
+  }
+  if (loading_pad < kKitPadCount) {
+    return;
+  }
+
+  loading_kit->serial = next_kit_serial++;
+  const auto *published = loading_kit.get();
+  kits.push_back(std::move(loading_kit));
+  loading_definition.reset();
+  // A kit the audio thread never picked up can go straight away.
+  if (const auto *superseded = next_kit.exchange(published, std::memory_order_acq_rel)) {
+    std::erase_if(kits, [superseded](const auto &kit) { return kit.get() == superseded; });
+  }
+  const std::scoped_lock lock(service_mutex);
+  kit_loading.store(requested_kit.has_value(), std::memory_order_relaxed);
+}
+
+auto KitSampler::loadZone(const KitZone &zone) -> std::optional<LoadedZone> {
+  const std::unique_ptr<juce::AudioFormatReader> reader(
+      formats.createReaderFor(juce::File(juce::String(zone.path.string()))));
+  if (reader == nullptr || reader->sampleRate <= 0.0 || reader->lengthInSamples <= 0 ||
+      reader->lengthInSamples > kMaxStreamFrames) {
+    return std::nullopt;
+  }
+  LoadedZone loaded;
+  loaded.path = zone.path;
+  loaded.total_frames = reader->lengthInSamples;
+  loaded.source_rate = reader->sampleRate;
+  loaded.gain = zone.gain;
+  loaded.velocity_low = std::clamp(zone.velocity_low, 1, kMaxVelocity);
+  loaded.velocity_high = std::clamp(zone.velocity_high, 1, kMaxVelocity);
+
+  const auto attack_frames = static_cast<int>(std::min<std::int64_t>(
+      loaded.total_frames,
+      static_cast<std::int64_t>(std::ceil(attack_seconds * reader->sampleRate))));
+  loaded.attack.setSize(kStereoChannelCount, attack_frames);
+  if (!reader->read(&loaded.attack, 0, attack_frames, 0, true, true)) {
+    return std::nullopt;
+  }
+  return loaded;
+}
+
+// Keeps the ring ahead of the voice's playhead without overwriting frames it
+// may still read. A retrigger while a chunk is being read makes the chunk
+// stale; it is dropped instead of published.
+void KitSampler::streamVoice(KitVoice &voice, StreamCursor &cursor) {
+  const auto request = voice.stream_request.load(std::memory_order_acquire);
+  if (stampFrame(request) == 0) {
+    cursor.reader.reset();
+    cursor.request = request;
+    return;
+  }
+  if (request != cursor.request) {
+    const auto *zone = voice.stream_zone.load(std::memory_order_acquire);
+    if (zone == nullptr || voice.stream_request.load(std::memory_order_acquire) != request) {
+      return;
+    }
+    cursor.request = request;
+    cursor.attack_frames = zone->attack.getNumSamples();
+    cursor.next_frame = cursor.attack_frames;
+    cursor.total_frames = zone->total_frames;
+    cursor.reader.reset(cursor.next_frame < cursor.total_frames
+                            ? formats.createReaderFor(juce::File(juce::String(zone->path.string())))
+                            : nullptr);
+  }
+  if (cursor.reader == nullptr) {
+    return;
+  }
+
+  const auto generation = stampGeneration(request);
+  while (cursor.next_frame < cursor.total_frames) {
+    const auto read_stamp = voice.stream_read.load(std::memory_order_acquire);
+    const auto consumed = stampGeneration(read_stamp) == generation ? stampFrame(read_stamp) : 0;
+    const auto limit = std::min(cursor.total_frames,
+                                std::max(consumed, cursor.attack_frames) + kKitStreamRingFrames);
+    const auto count = static_cast<int>(
+        std::min<std::int64_t>(limit - cursor.next_frame, kKitStreamChunkFrames));
+    if (count <= 0) {
+      return;
+    }
+    if (!cursor.reader->read(&stream_scratch, 0, count, cursor.next_frame, true, true)) {
+      cursor.reader.reset();
+      return;
+    }
+    const std::array<std::span<float>, kStereoChannelCount> ring = {
+        std::span<float>(voice.ring_left), std::span<float>(voice.ring_right)};
+    for (std::size_t channel = 0; channel < ring.size(); ++channel) {
+      const std::span<const float> source(
+          stream_scratch.getReadPointer(static_cast<int>(channel)),
+          static_cast<std::size_t>(count));
+      for (std::size_t index = 0; index < source.size(); ++index) {
+        ring.at(channel)[(static_cast<std::size_t>(cursor.next_frame) + index) & kRingMask] =
+            source[index];
+      }
+    }
+    if (voice.stream_request.load(std::memory_order_acquire) != request) {
+      return;
+    }
+    cursor.next_frame += count;
+    voice.stream_end.store(makeStamp(generation, cursor.next_frame), std::memory_order_release);
+  }
+  cursor.reader.reset();
+}
+
+void KitSampler::freeRetiredKits() {
+  const auto oldest = oldest_kit_serial.load(std::memory_order_acquire);
+  std::erase_if(kits, [oldest](const auto &kit) { return kit->serial < oldest; });
+  std::size_t bytes = 0;
+  for (const auto &kit : kits) {
+    bytes += kit->resident_bytes;
+  }
+  resident_bytes.store(bytes, std::memory_order_relaxed);
+  kit_count.store(static_cast<int>(kits.size()), std::memory_order_relaxed);
+}
+
+void KitSampler::runServiceLoop() {
+  std::unique_lock lock(service_mutex);
+  while (!service_stopping) {
+    lock.unlock();
+    service();
+    lock.lock();
+    service_wakeup.wait_for(lock, kServiceInterval, [this] {
+      return service_stopping || requested_kit.has_value();
+    });
+  }
+}
+} // namespace limit
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <juce_audio_formats/juce_audio_formats.h>
+
+#include "audio-graph.h"
+#include "dev-controller.h"
+
+namespace limit {
+constexpr int kKitPadCount = kDevBankCount * kDevPadCount;
+constexpr int kKitBaseNote = 36;
+constexpr int kKitVoiceCount = 16;
+constexpr double kKitAttackSeconds = 0.3;
+constexpr int kKitStreamRingFrames = 32768;
+constexpr int kKitStreamChunkFrames = 4096;
+
+// One sample on a pad. Zones of a pad whose velocity range covers the hit
+// velocity take turns (round-robin); disjoint ranges make velocity layers.
+struct KitZone {
+  std::filesystem::path path;
+  int velocity_low = 1;
+  int velocity_high = 127;
+  float gain = 1.0f;
+};
+
+struct KitPad {
+  std::vector<KitZone> zones;
+};
+
+// Pads are numbered bank-major: pad p of bank b is b * kDevPadCount + p and
+// plays on MIDI note kKitBaseNote + that index.
+struct KitDefinition {
+  std::array<KitPad, kKitPadCount> pads;
+};
+
+// Sampler (Kit Mode). Only the first attack_seconds of each zone is decoded
+// and kept in memory, so loading a kit costs the same however long its
+// samples are; the rest of a sample is streamed from disk into a fixed ring
+// per voice once the pad is hit. A hit starts on its exact sample position
+// from the resident attack, so pad-to-sound latency is within the block.
+// Memory is bounded by the attack segments plus kKitVoiceCount rings.
+//
+// A service thread loads kits a few zones at a time, keeps every playing
+// voice's ring ahead of its playhead and frees kits once no voice plays
+// them. The audio thread picks up a loaded kit at the next block, never
+// waits for the disk and reports an underrun (and stops the voice) if a ring
+// runs dry.
+class KitSampler final : public AudioGraphNode {
+public:
+  explicit KitSampler(double attack_seconds = kKitAttackSeconds);
+  ~KitSampler() override;
+  KitSampler(const KitSampler &) = delete;
+  auto operator=(const KitSampler &) -> KitSampler & = delete;
+  KitSampler(KitSampler &&) = delete;
+  auto operator=(KitSampler &&) -> KitSampler & = delete;
+
+  // Message thread. A kit loaded while another is still loading replaces it.
+  void loadKit(KitDefinition definition);
+  void start();
+  void stop();
+
+  void prepare(double sample_rate, int max_block_size) override;
+  void process(AudioGraphBuses &buses, const juce::MidiBuffer &midi, int num_samples) override;
+  void render(juce::AudioBuffer<float> &output, const juce::MidiBuffer &midi, int num_samples);
+
+  // Any thread.
+  auto activeVoiceCount() const -> int;
+  auto underrunCount() const -> std::uint32_t;
+  auto residentBytes() const -> std::size_t;
+  auto isKitLoading() const -> bool;
+  auto loadedKitCount() const -> int;
+
+  // Service thread (exposed so tests can drive it deterministically).
+  void service();
+
+private:
+  struct LoadedZone {
+    std::filesystem::path path;
+    juce::AudioBuffer<float> attack;
+    std::int64_t total_frames = 0;
+    double source_rate = 0.0;
+    float gain = 1.0f;
+    int velocity_low = 1;
+    int velocity_high = 127;
+    // Round-robin position of the zones matching the same velocities as
+    // this one, kept on the first of them. Audio thread only.
+    mutable std::uint32_t round_robin = 0;
+  };
+
+  struct LoadedKit {
+    std::uint64_t serial = 0;
+    std::array<std::vector<LoadedZone>, kKitPadCount> pads;
+    std::size_t resident_bytes = 0;
+  };
+
+  // Audio-thread playback state plus the hand-off with the service thread.
+  // Generations tag every published value so neither side acts on state
+  // left over from the voice's previous hit.
+  struct KitVoice {
+    const LoadedZone *zone = nullptr;
+    std::uint64_t kit_serial = 0;
+    std::uint64_t start_order = 0;
+    std::uint32_t generation = 0;
+    double position = 0.0;
+    double step = 1.0;
+    float gain = 0.0f;
+    bool active = false;
+
+    std::atomic<const LoadedZone *> stream_zone{nullptr};
+    std::atomic<std::uint64_t> stream_request{0};
+    std::atomic<std::uint64_t> stream_end{0};
+    std::atomic<std::uint64_t> stream_read{0};
+    std::vector<float> ring_left;
+    std::vector<float> ring_right;
+  };
+
+  // Service-thread side of one voice's stream.
+  struct StreamCursor {
+    std::uint64_t request = 0;
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    std::int64_t next_frame = 0;
+    std::int64_t attack_frames = 0;
+    std::int64_t total_frames = 0;
+  };
+
+  void handleMessage(const juce::MidiMessage &message);
+  void trigger(int pad, int velocity);
+  void startVoice(KitVoice &voice, const LoadedZone &zone, float velocity_gain);
+  void finishVoice(KitVoice &voice);
+  void renderVoice(KitVoice &voice, juce::AudioBuffer<float> &output, int start_sample,
+                   int num_samples);
+  void publishOldestKit();
+
+  void continueLoading();
+  auto loadZone(const KitZone &zone) -> std::optional<LoadedZone>;
+  void streamVoice(KitVoice &voice, StreamCursor &cursor);
+  void freeRetiredKits();
+  void runServiceLoop();
+
+  static constexpr int kAllNotesOffController = 123;
+  static constexpr int kZonesPerPass = 4;
+
+  double attack_seconds = kKitAttackSeconds;
+  double session_rate = 0.0;
+
+  // Audio thread.
+  const LoadedKit *current_kit = nullptr;
+  std::uint64_t next_start_order = 0;
+  std::array<KitVoice, kKitVoiceCount> voices;
+  std::atomic<int> active_voices{0};
+  std::atomic<std::uint32_t> underruns{0};
+
+  // Service thread to audio thread.
+  std::atomic<const LoadedKit *> next_kit{nullptr};
+  std::atomic<std::uint64_t> oldest_kit_serial{0};
+  std::atomic<std::size_t> resident_bytes{0};
+
+  // Service thread.
+  juce::AudioFormatManager formats;
+  std::vector<std::unique_ptr<LoadedKit>> kits;
+  std::unique_ptr<LoadedKit> loading_kit;
+  std::optional<KitDefinition> loading_definition;
+  int loading_pad = 0;
+  std::size_t loading_zone = 0;
+  std::uint64_t next_kit_serial = 1;
+  std::array<StreamCursor, kKitVoiceCount> cursors;
+  juce::AudioBuffer<float> stream_scratch;
+  std::atomic<int> kit_count{0};
+  std::atomic<bool> kit_loading{false};
+
+  std::thread service_thread;
+  std::mutex service_mutex;
+  std::condition_variable service_wakeup;
+  std::optional<KitDefinition> requested_kit;
+  bool service_stopping = false;
+};
+} // namespace limit
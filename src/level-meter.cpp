@@ -0,0 +1,78 @@
+#include "level-meter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace limit {
+auto measureStereo(std::span<const float> left, std::span<const float> right)
+    -> LevelSummary {
+  const auto count = std::min(left.size(), right.size());
+  if (count == 0) {
+    return {};
+  }
+  float peak = 0.0f;
+  double sum_squares = 0.0;
+  for (std::size_t index = 0; index < count; ++index) {
+    const auto left_sample = left[index];
+    const auto right_sample = right[index];
+    peak = std::max({peak, std::abs(left_sample), std::abs(right_sample)});
+    sum_squares += (static_cast<double>(left_sample) * left_sample) +
+                   (static_cast<double>(right_sample) * right_sample);
+  }
+  const auto mean = sum_squares / static_cast<double>(count * 2);
+  return {.peak = peak, .rms = static_cast<float>(std::sqrt(mean))};
+}
+
+auto MeterQueue::push(const MeterFrame &frame) -> bool {
+  const auto write = write_index.load(std::memory_order_relaxed);
+  const auto read = read_index.load(std::memory_order_acquire);
+  if (write - read >= kMeterQueueCapacity) {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  frames.at(write & kIndexMask) = frame;
+  write_index.store(write + 1, std::memory_order_release);
+  return true;
+}
+
+auto MeterQueue::pop() -> std::optional<MeterFrame> {
+  const auto read = read_index.load(std::memory_order_relaxed);
+  const auto write = write_index.load(std::memory_order_acquire);
+  if (read == write) {
+    return std::nullopt;
+  }
+  const auto frame = frames.at(read & kIndexMask);
+  read_index.store(read + 1, std::memory_order_release);
+  return frame;
+}
+
+auto MeterQueue::size() const -> std::size_t {
+  const auto read = read_index.load(std::memory_order_acquire);
+  const auto write = write_index.load(std::memory_order_acquire);
+  return write - read;
+}
+
+auto MeterQueue::droppedCount() const -> std::uint32_t {
+  return dropped.load(std::memory_order_relaxed);
+}
+
+void MeterBallistics::apply(const MeterFrame &frame) {
+  for (std::size_t source = 0; source < levels.size(); ++source) {
+    auto &held = levels.at(source);
+    const auto &incoming = frame.levels.at(source);
+    held.peak = std::max(held.peak, incoming.peak);
+    held.rms = std::max(held.rms, incoming.rms);
+  }
+}
+
+void MeterBallistics::decay(float amount) {
+  for (auto &held : levels) {
+    held.peak = std::max(held.peak - amount, 0.0f);
+    held.rms = std::max(held.rms - amount, 0.0f);
+  }
+}
+
+auto MeterBallistics::level(int source) const -> LevelSummary {
+  return levels.at(static_cast<std::size_t>(source));
+}
+} // namespace limit
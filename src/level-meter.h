@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include "signal-flow.h"
+
+namespace limit {
+constexpr int kMeterSourceCount = kTapeTrackCount + 1;
+constexpr int kMasterMeterIndex = kTapeTrackCount;
+constexpr std::size_t kMeterQueueCapacity = 64;
+
+struct LevelSummary {
+  float peak = 0.0f;
+  float rms = 0.0f;
+};
+
+// Levels of every tape track and the master bus for one processed block.
+struct MeterFrame {
+  std::array<LevelSummary, kMeterSourceCount> levels{};
+};
+
+// Peak and RMS over both channels of a stereo block.
+auto measureStereo(std::span<const float> left, std::span<const float> right) -> LevelSummary;
+
+// Bounded single-producer/single-consumer queue of meter frames, published by
+// the audio thread once per block and drained by the UI. Same wait-free,
+// allocation-free scheme as MidiEventQueue; when the UI falls behind, new
+// frames are dropped rather than blocking the audio thread.
+class MeterQueue {
+public:
+  auto push(const MeterFrame &frame) -> bool;
+  auto pop() -> std::optional<MeterFrame>;
+  auto size() const -> std::size_t;
+  auto droppedCount() const -> std::uint32_t;
+
+private:
+  static constexpr std::size_t kCacheLineSize = 64;
+  static constexpr std::size_t kIndexMask = kMeterQueueCapacity - 1;
+  static_assert((kMeterQueueCapacity & kIndexMask) == 0,
+                "Meter queue capacity must be a power of two");
+
+  std::array<MeterFrame, kMeterQueueCapacity> frames{};
+  alignas(kCacheLineSize) std::atomic<std::size_t> write_index{0};
+  alignas(kCacheLineSize) std::atomic<std::size_t> read_index{0};
+  std::atomic<std::uint32_t> dropped{0};
+};
+
+// UI-side meter state: keeps the loudest level seen since the last frame and
+// lets it fall back at a fixed rate so short peaks stay visible.
+class MeterBallistics {
+public:
+  void apply(const MeterFrame &frame);
+  void decay(float amount);
+  auto level(int source) const -> LevelSummary;
+
+private:
+  std::array<LevelSummary, kMeterSourceCount> levels{};
+};
+} // namespace limit
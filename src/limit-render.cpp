@@ -0,0 +1,148 @@
+// limit-render: renders a project and event script to WAV with no audio
+// device, for regression tests and profiling.
+//
+//   limit-render --script song.txt --output out.wav [--project dir]
+//                [--block 256] [--expect golden.wav]
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "offline-renderer.h"
+#include "signal-flow.h"
+
+namespace {
+constexpr int kExitFailure = 1;
+constexpr int kExitMismatch = 2;
+constexpr int kMaxBlockSize = 8192;
+constexpr double kMillisecondsPerSecond = 1000.0;
+
+struct Options {
+  std::filesystem::path project;
+  std::filesystem::path script;
+  std::filesystem::path output;
+  std::filesystem::path expect;
+  int block_size = limit::OfflineRenderConfig{}.block_size;
+};
+
+void printUsage() {
+  std::cerr << "usage: limit-render --script <file> --output <file.wav> [--project <dir>]\n"
+               "                    [--block <frames>] [--expect <golden.wav>]\n";
+}
+
+auto parseOptions(std::span<char *> arguments) -> std::optional<Options> {
+  Options options;
+  for (std::size_t index = 1; index < arguments.size(); ++index) {
+    const std::string_view name = arguments[index];
+    if (index + 1 == arguments.size()) {
+      return std::nullopt;
+    }
+    const std::string value = arguments[++index];
+    if (name == "--project") {
+      options.project = value;
+    } else if (name == "--script") {
+      options.script = value;
+    } else if (name == "--output") {
+      options.output = value;
+    } else if (name == "--expect") {
+      options.expect = value;
+    } else if (name == "--block") {
+      try {
+        options.block_size = std::stoi(value);
+      } catch (const std::exception &) {
+        return std::nullopt;
+      }
+      if (options.block_size <= 0 || options.block_size > kMaxBlockSize) {
+        return std::nullopt;
+      }
+    } else {
+      return std::nullopt;
+    }
+  }
+  if (options.script.empty() || options.output.empty()) {
+    return std::nullopt;
+  }
+  return options;
+}
+
+auto readBytes(const std::filesystem::path &path) -> std::optional<std::vector<char>> {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return std::nullopt;
+  }
+  return std::vector<char>{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+void printTiming(const limit::OfflineRenderResult &result) {
+  const auto milliseconds = [](double seconds) { return seconds * kMillisecondsPerSecond; };
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "rendered " << result.frames_rendered << " frames in "
+            << milliseconds(result.render_seconds) << " ms (" << result.realtime_factor
+            << "x realtime)\n";
+  if (result.tape_seconds > 0.0) {
+    std::cout << "  tape paging      " << milliseconds(result.tape_seconds)
+              << " ms (not counted)\n";
+  }
+  std::cout << "  graph total      " << milliseconds(result.graph_seconds) << " ms\n";
+  for (std::size_t node = 0; node < result.stage_seconds.size(); ++node) {
+    const auto seconds = result.stage_seconds.at(node);
+    if (seconds > 0.0) {
+      const auto name = limit::signalNodeName(static_cast<limit::SignalNode>(node));
+      std::cout << "  " << std::left << std::setw(16) << name << " " << milliseconds(seconds)
+                << " ms\n";
+    }
+  }
+  if (result.tape_underruns > 0) {
+    std::cout << "  tape underruns   " << result.tape_underruns << "\n";
+  }
+}
+} // namespace
+
+auto main(int argc, char *argv[]) -> int {
+  const auto options = parseOptions(std::span(argv, static_cast<std::size_t>(argc)));
+  if (!options) {
+    printUsage();
+    return kExitFailure;
+  }
+
+  const limit::OfflineRenderConfig config{.project = options->project,
+                                          .block_size = options->block_size};
+  const auto script = limit::loadRenderScript(options->script, config.sample_rate);
+  if (!script) {
+    std::cerr << "limit-render: cannot read script " << options->script << "\n";
+    return kExitFailure;
+  }
+  if (script->rejected > 0) {
+    std::cerr << "limit-render: skipped " << script->rejected
+              << " malformed line(s), first at line " << script->first_rejected_line << "\n";
+  }
+
+  auto renderer = limit::OfflineRenderer::open(config);
+  if (renderer == nullptr) {
+    std::cerr << "limit-render: cannot open project " << options->project << "\n";
+    return kExitFailure;
+  }
+  const auto result = renderer->renderToWav(*script, options->output);
+  if (!result.completed) {
+    std::cerr << "limit-render: render to " << options->output << " failed\n";
+    return kExitFailure;
+  }
+  printTiming(result);
+
+  if (!options->expect.empty()) {
+    const auto expected = readBytes(options->expect);
+    const auto rendered = readBytes(options->output);
+    if (!expected || !rendered || *expected != *rendered) {
+      std::cerr << "limit-render: output differs from " << options->expect << "\n";
+      return kExitMismatch;
+    }
+    std::cout << "matches " << options->expect << "\n";
+  }
+  return 0;
+}
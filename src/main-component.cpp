@@ -1,11 +1,26 @@
 #include "main-component.h"
 
 #include <algorithm>
+#include <cctype>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "BinaryData.h"
 #include "dev-controller.h"
 #include "keymap.h"
+#include "midi-event-queue.h"
+#include "realtime-guard.h"
 #include "ui-layout.h"
 #include "ui-theme.h"
 
@@ -20,16 +35,194 @@ auto getTopazTypeface() -> juce::Typeface::Ptr {
   return juce::Typeface::createSystemTypefaceFor(data, static_cast<std::size_t>(size));
 }
 
-auto makeTopazFontOptions(float height) -> juce::FontOptions {
+auto makeTopazFont(const juce::Typeface::Ptr &typeface, float height) -> juce::Font {
   auto options = juce::FontOptions{}.withHeight(height);
-  if (auto typeface = getTopazTypeface()) {
-    return options.withTypeface(typeface);
+  if (typeface != nullptr) {
+    return juce::Font(options.withTypeface(typeface));
   }
-  return options.withName(getUiTheme().font_name);
+  return juce::Font(options.withName(getUiTheme().font_name));
+}
+
+auto toMidiEvent(const juce::MidiMessage &message) -> std::optional<limit::MidiEvent> {
+  return limit::makeMidiEvent(message.getRawData(), message.getRawDataSize(),
+                              juce::Time::getHighResolutionTicks());
+}
+
+auto makePlaceholderVoice() -> std::unique_ptr<limit::VoiceEngine> {
+  return std::make_unique<limit::SineVoiceEngine>();
+}
+
+// JUCE key codes differ per platform, so named keys are translated into the
+// portable input codes the bindings use, and back for key-up polling.
+struct NamedKeyCodes {
+  std::unordered_map<int, int> to_input;
+  std::array<int, limit::kInputKeyCount> to_juce{};
+};
+
+auto namedKeyCodes() -> const NamedKeyCodes & {
+  static const NamedKeyCodes codes = [] {
+    using Key = juce::KeyPress;
+    using limit::NamedKey;
+    const std::array<std::pair<int, NamedKey>, 41> keys{{
+        {Key::F1Key, NamedKey::kF1},
+        {Key::F2Key, NamedKey::kF2},
+        {Key::F3Key, NamedKey::kF3},
+        {Key::F4Key, NamedKey::kF4},
+        {Key::F5Key, NamedKey::kF5},
+        {Key::F6Key, NamedKey::kF6},
+        {Key::F7Key, NamedKey::kF7},
+        {Key::F8Key, NamedKey::kF8},
+        {Key::F9Key, NamedKey::kF9},
+        {Key::F10Key, NamedKey::kF10},
+        {Key::F11Key, NamedKey::kF11},
+        {Key::F12Key, NamedKey::kF12},
+        {Key::numberPad0, NamedKey::kNum0},
+        {Key::numberPad1, NamedKey::kNum1},
+        {Key::numberPad2, NamedKey::kNum2},
+        {Key::numberPad3, NamedKey::kNum3},
+        {Key::numberPad4, NamedKey::kNum4},
+        {Key::numberPad5, NamedKey::kNum5},
+        {Key::numberPad6, NamedKey::kNum6},
+        {Key::numberPad7, NamedKey::kNum7},
+        {Key::numberPad8, NamedKey::kNum8},
+        {Key::numberPad9, NamedKey::kNum9},
+        {Key::numberPadDecimalPoint, NamedKey::kNumDecimal},
+        {Key::numberPadAdd, NamedKey::kNumAdd},
+        {Key::numberPadSubtract, NamedKey::kNumSubtract},
+        {Key::numberPadMultiply, NamedKey::kNumMultiply},
+        {Key::numberPadDivide, NamedKey::kNumDivide},
+        {Key::insertKey, NamedKey::kInsert},
+        {Key::deleteKey, NamedKey::kDelete},
+        {Key::homeKey, NamedKey::kHome},
+        {Key::endKey, NamedKey::kEnd},
+        {Key::pageUpKey, NamedKey::kPageUp},
+        {Key::pageDownKey, NamedKey::kPageDown},
+        {Key::leftKey, NamedKey::kLeft},
+        {Key::rightKey, NamedKey::kRight},
+        {Key::upKey, NamedKey::kUp},
+        {Key::downKey, NamedKey::kDown},
+        {Key::tabKey, NamedKey::kTab},
+        {Key::backspaceKey, NamedKey::kBackspace},
+        {Key::returnKey, NamedKey::kReturn},
+        {Key::escapeKey, NamedKey::kEscape},
+    }};
+    NamedKeyCodes result;
+    for (const auto &[juce_code, key] : keys) {
+      result.to_input.emplace(juce_code, limit::inputCode(key));
+      result.to_juce.at(static_cast<std::size_t>(limit::inputCode(key))) = juce_code;
+    }
+    return result;
+  }();
+  return codes;
+}
+
+auto toInputCode(const juce::KeyPress &key) -> int {
+  const auto &named = namedKeyCodes().to_input;
+  if (const auto found = named.find(key.getKeyCode()); found != named.end()) {
+    return found->second;
+  }
+  const auto text = static_cast<int>(key.getTextCharacter());
+  return limit::inputCodeForChar(text != 0 ? text : key.getKeyCode());
+}
+
+auto isInputKeyDown(int key_code) -> bool {
+  if (key_code >= limit::inputCode(limit::NamedKey::kF1)) {
+    const auto juce_code = namedKeyCodes().to_juce.at(static_cast<std::size_t>(key_code));
+    return juce_code != 0 && juce::KeyPress::isKeyCurrentlyDown(juce_code);
+  }
+  return juce::KeyPress::isKeyCurrentlyDown(key_code) ||
+         juce::KeyPress::isKeyCurrentlyDown(std::toupper(key_code));
+}
+
+constexpr double kNanosecondsPerMicrosecond = 1000.0;
+
+// Mode and sub-view names from docs/design.md, in AppMode and sub-view
+// order. Tape works through its operations rather than sub-views.
+struct ModeNames {
+  std::string_view mode;
+  std::array<std::string_view, limit::kMaxSubViews> sub_views;
+  int sub_view_count = 0;
+};
+
+constexpr std::array<ModeNames, limit::kAppModeCount> kModeNames{{
+    {.mode = "sound", .sub_views = {"engine", "envelope", "effect", "lfo"}, .sub_view_count = 4},
+    {.mode = "sequence",
+     .sub_views = {"steps", "settings", "sequencer", "phrase"},
+     .sub_view_count = 4},
+    {.mode = "tape", .sub_views = {}, .sub_view_count = 0},
+    {.mode = "mix", .sub_views = {"levels", "pan", "sends", "master"}, .sub_view_count = 4},
+}};
+
+auto audioDeviceProfileFile() -> std::filesystem::path {
+  return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+      .getChildFile("Limit")
+      .getChildFile("audio-device.cfg")
+      .getFullPathName()
+      .toStdString();
+}
+
+// The device manager's saved-state form of a profile, which
+// setAudioChannels() opens directly.
+auto makeDeviceState(const limit::AudioDeviceProfile &profile) -> juce::XmlElement {
+  juce::XmlElement state("DEVICESETUP");
+  state.setAttribute("deviceType", juce::String(profile.type));
+  state.setAttribute("audioOutputDeviceName", juce::String(profile.output_device));
+  state.setAttribute("audioInputDeviceName", juce::String(profile.input_device));
+  state.setAttribute("audioDeviceRate", profile.sample_rate);
+  state.setAttribute("audioDeviceBufferSize", profile.buffer_size);
+  return state;
+}
+
+auto toStdStrings(const juce::StringArray &names) -> std::vector<std::string> {
+  std::vector<std::string> result;
+  result.reserve(static_cast<std::size_t>(names.size()));
+  for (const auto &name : names) {
+    result.push_back(name.toStdString());
+  }
+  return result;
+}
+// Highest SCHED_FIFO priority for the render workers, so ordinary threads
+// cannot preempt one while the callback waits for it. The pool keeps them
+// below the audio callback's own priority, and on the normal scheduler when
+// the callback has none or the rtprio limit forbids it.
+constexpr int kWorkerRealtimePriority = 70;
+
+auto makeWorkerPoolConfig() -> limit::WorkerPoolConfig {
+  limit::WorkerPoolConfig config;
+  config.realtime_priority = kWorkerRealtimePriority;
+  return config;
+}
+
+// A few lines for the diagnostics page; F10 writes the full report.
+auto formatProfileSummary(const limit::ProfileSnapshot &snapshot) -> juce::String {
+  if (!snapshot.enabled) {
+    return "profiler off\nbuild with LIMIT_PROFILER=ON";
+  }
+  const auto us = [](double value) { return juce::String(value, 1) + " us"; };
+  auto text = "callbacks " + juce::String(snapshot.callbacks) + "  xruns " +
+              juce::String(snapshot.xruns) + "\nmean " + us(snapshot.mean_callback_us) +
+              "  max " + us(snapshot.max_callback_us) + " (" +
+              juce::String(juce::roundToInt(snapshot.max_budget_percent)) + "%)";
+  for (std::size_t node = 0; node < snapshot.stages.size(); ++node) {
+    const auto &stage = snapshot.stages.at(node);
+    const auto name = limit::signalNodeName(static_cast<limit::SignalNode>(node));
+    text << "\n" << juce::String(name.data(), name.size()) << " " << us(stage.mean_us) << " / "
+         << us(stage.max_us);
+  }
+  if (!snapshot.traces.empty()) {
+    const auto &last = snapshot.traces.back();
+    text << "\nlast slow #" << juce::String(last.callback) << " "
+         << us(static_cast<double>(last.duration_ns) / kNanosecondsPerMicrosecond);
+  }
+  return text;
 }
 } // namespace
 
-MainComponent::MainComponent(bool enable_audio) {
+MainComponent::MainComponent(bool enable_audio)
+    : topaz_typeface(getTopazTypeface()),
+      title_font(makeTopazFont(topaz_typeface, getUiTheme().title_font_size)),
+      body_font(makeTopazFont(topaz_typeface, getUiTheme().body_font_size)),
+      synth_instrument(makePlaceholderVoice), worker_pool(makeWorkerPoolConfig()) {
   const auto &theme = getUiTheme();
   setSize(theme.window_width, theme.window_height);
   setWantsKeyboardFocus(true);
@@ -41,81 +234,128 @@ MainComponent::MainComponent(bool enable_audio) {
     device_manager->addMidiInputDeviceCallback(device.identifier, this);
   }
 
+  held_key_notes.fill(-1);
+  audio_graph.setNode(limit::SignalNode::kInstrument, &synth_instrument);
+  audio_graph.setNode(limit::SignalNode::kTapeTracks, &tape_transport);
+  audio_graph.setNode(limit::SignalNode::kTrackMix, &tape_mixer);
+  audio_graph.setNode(limit::SignalNode::kSend1Effect, &send1_reverb);
+  audio_graph.setMeterQueue(&meter_queue);
+  audio_graph.setProfiler(&audio_profiler);
+  registerMixParameters();
+  registerTapeParameters();
+
   if (enable_audio) {
-    setAudioChannels(2, 2);
+    worker_pool.start();
+    tape_transport.setWorkerPool(&worker_pool);
+    send1_reverb.start();
+    openTapeStorage();
+    openPhraseStore();
+    reloadInputBindings();
+    openAudioDevice();
   }
 }
 
 MainComponent::~MainComponent() { shutdownAudio(); }
 
-void MainComponent::prepareToPlay(int /*samples_per_block_expected*/,
-                                  double /*sample_rate*/) {
+void MainComponent::prepareToPlay(int samples_per_block_expected, double sample_rate) {
   last_midi_message = "";
+  current_sample_rate = sample_rate;
+  block_midi.ensureSize(limit::kBlockMidiReserveBytes);
+  step_sequencer.prepare(sample_rate);
+  parameter_ramps.prepare(sample_rate);
+  audio_profiler.prepare(sample_rate);
+  latency_probe.prepare(sample_rate);
+  loadImpulseResponse(sample_rate);
+  audio_graph.prepare(sample_rate, samples_per_block_expected);
 }
 
 void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo &buffer_to_fill) {
-  buffer_to_fill.clearActiveBufferRegion();
+  const limit::ScopedRealtimeSection realtime_section;
+  audio_profiler.beginCallback();
+  drainMidiAudioQueue(buffer_to_fill.numSamples);
+  step_sequencer.process(block_midi, buffer_to_fill.numSamples);
+  applyMixParameters(buffer_to_fill.numSamples);
+  // The transport slews its own rate, so the block's end value is enough.
+  tape_transport.setSpeed(parameter_ramps.blockEnd(tape_speed_parameter) / kPercent);
+
+  // The buffer arrives holding the input, which the graph then overwrites.
+  auto &buffer = *buffer_to_fill.buffer;
+  const auto count = static_cast<std::size_t>(buffer_to_fill.numSamples);
+  const auto channel = [&buffer, &buffer_to_fill, count](int index) {
+    return index < buffer.getNumChannels()
+               ? std::span<float>(buffer.getWritePointer(index, buffer_to_fill.startSample), count)
+               : std::span<float>{};
+  };
+  latency_probe.scanInput(channel(0));
+  audio_graph.process(block_midi, buffer, buffer_to_fill.startSample, buffer_to_fill.numSamples);
+  latency_probe.writeOutput(channel(0), channel(1));
+  audio_profiler.endCallback(buffer_to_fill.numSamples);
 }
 
-void MainComponent::releaseResources() {}
+void MainComponent::releaseResources() { audio_graph.release(); }
 
 void MainComponent::paint(juce::Graphics &g) {
-  const auto &theme = getUiTheme();
-  g.fillAll(theme.background);
-
-  const auto bounds = getLocalBounds();
-  const auto layout = limit::computeUiLayout(
-      {.width = bounds.getWidth(),
-       .height = bounds.getHeight(),
-       .header_height = theme.header_height,
-       .visualization_ratio = theme.visualization_ratio,
-       .encoder_ratio = theme.encoder_ratio});
-  const auto header_area = toRectangle(layout.header);
-  const auto visualization_area = toRectangle(layout.visualization);
-  const auto encoder_area = toRectangle(layout.encoder);
-  const auto secondary_area = toRectangle(layout.secondary);
-
-  drawPanel(g, header_area);
-  drawPanel(g, visualization_area);
-  drawPanel(g, encoder_area);
-  drawPanel(g, secondary_area);
-
-  g.setColour(theme.accent_blue);
-  g.setFont(juce::Font(makeTopazFontOptions(theme.title_font_size)));
-  g.drawText("LIMIT", header_area, juce::Justification::centred);
-
-  g.setColour(theme.text);
-  g.setFont(juce::Font(makeTopazFontOptions(theme.body_font_size)));
-  auto secondary_content = secondary_area.reduced(theme.padding);
-  g.drawText("MIDI", secondary_content.removeFromTop(static_cast<int>(theme.body_font_size)),
-             juce::Justification::topLeft);
-  secondary_content.removeFromTop(theme.secondary_text_gap);
+  const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+  if (!chrome.isValid() || !juce::exactlyEqual(chrome_scale, scale)) {
+    renderChrome(scale);
+  }
+  g.drawImage(chrome, getLocalBounds().toFloat());
+  if (g.clipRegionIntersects(paint_areas.visualization)) {
+    drawVisualization(g);
+  }
 
-  auto status_box =
-      secondary_content.removeFromTop(static_cast<int>(theme.body_font_size *
-                                                       theme.status_box_line_count));
-  g.setColour(theme.background);
-  g.fillRect(status_box);
-  g.setColour(theme.border);
-  g.drawRect(status_box);
+  const auto &theme = getUiTheme();
   g.setColour(theme.text);
-
+  g.setFont(body_font);
+  if (diagnostics_visible) {
+    const auto max_lines = paint_areas.diagnostics.getHeight() /
+                           std::max(juce::roundToInt(theme.body_font_size), 1);
+    g.drawFittedText(diagnostics_text, paint_areas.diagnostics, juce::Justification::topLeft,
+                     max_lines, 1.0f);
+    return;
+  }
   const auto midi_text = last_midi_message.isEmpty() ? "NONE" : last_midi_message;
-  g.drawText(midi_text, status_box.reduced(theme.status_box_padding),
+  g.drawText(midi_text, paint_areas.status_box.reduced(theme.status_box_padding),
              juce::Justification::centredLeft);
 }
 
-void MainComponent::resized() {}
+void MainComponent::resized() {
+  updatePaintAreas();
+  chrome = juce::Image{};
+}
+
 void MainComponent::parentHierarchyChanged() { focusIfVisible(); }
 void MainComponent::visibilityChanged() { focusIfVisible(); }
 
+// Ctrl (Cmd on macOS) turns encoders fine and Alt coarse; Shift is avoided
+// because it turns the numpad into the nav cluster on some keyboards. Held
+// keys repeat fast enough to accelerate like a quickly spun encoder.
 auto MainComponent::keyPressed(const juce::KeyPress &key) -> bool {
-  if (handleDevPadBankCycle(key) || handleDevControlBankCycle(key) ||
-      handleDevUtilityButtons(key) || handleDevEncoder(key) || handleDevPad(key)) {
-    return true;
+  const auto modifiers = key.getModifiers();
+  InputTrigger trigger{
+      .key_code = toInputCode(key),
+      .time_seconds = juce::Time::getMillisecondCounterHiRes() / kMillisecondsPerSecond};
+  if (modifiers.isCommandDown()) {
+    trigger.speed = limit::DevEncoderSpeed::kFine;
+  } else if (modifiers.isAltDown()) {
+    trigger.speed = limit::DevEncoderSpeed::kCoarse;
   }
-  const auto key_char = static_cast<unsigned char>(key.getTextCharacter());
-  return processKeyChar(static_cast<int>(key_char));
+  return dispatchInput(input_bindings.key(trigger.key_code), trigger);
+}
+
+auto MainComponent::keyStateChanged(bool is_key_down) -> bool {
+  if (is_key_down) {
+    return false;
+  }
+  // JUCE reports key-up without saying which key, so poll every held note key.
+  bool released = false;
+  for (int key_code = 0; key_code < kKeyCharCount; ++key_code) {
+    if (held_key_notes.at(static_cast<std::size_t>(key_code)) >= 0 &&
+        !isInputKeyDown(key_code)) {
+      released = releaseNoteKey(key_code) || released;
+    }
+  }
+  return released;
 }
 
 auto MainComponent::getLastMidiMessageForTesting() const -> juce::String {
@@ -130,201 +370,550 @@ auto MainComponent::processKeyCharForTesting(int key_char) -> bool {
   return processKeyChar(key_char);
 }
 
+auto MainComponent::releaseKeyCharForTesting(int key_char) -> bool {
+  return releaseKeyChar(key_char);
+}
+
 void MainComponent::handleIncomingMidiMessageForTesting(const juce::MidiMessage &message) {
   handleIncomingMidiMessage(nullptr, message);
 }
 
+void MainComponent::flushPendingMidiForTesting() { drainMidiDisplayQueue(); }
+
+void MainComponent::flushPendingMetersForTesting() { drainMeterQueue(); }
+
+auto MainComponent::meterLevelForTesting(int source) const -> limit::LevelSummary {
+  return meter_ballistics.level(source);
+}
+
+auto MainComponent::getBlockMidiForTesting() const -> const juce::MidiBuffer & {
+  return block_midi;
+}
+
 auto MainComponent::processEncoderActionForTesting(int encoder_index,
                                                    limit::DevEncoderAction action) -> bool {
   const auto event = limit::handleDevEncoderAction(encoder_index, action, dev_state);
   if (!event) {
     return false;
   }
-  last_midi_message = "dev cc " + juce::String(event->cc) + " = " +
-                      juce::String(event->value) + " (bank " +
-                      juce::String(event->bank + 1) + ")";
-  repaint();
+  applyEncoderEvent(*event);
   return true;
 }
 
 auto MainComponent::processPadIndexForTesting(int pad_index) -> bool {
-  const auto event = limit::handleDevPadPress(pad_index, dev_state);
-  if (!event) {
-    return false;
-  }
-  last_midi_message = "dev pad " + juce::String(event->pad_index + 1) + " (bank " +
-                      juce::String(event->bank + 1) + ")";
-  repaint();
-  return true;
+  return pressPad(pad_index);
 }
 
 void MainComponent::setOctaveOffsetForTesting(int offset) { note_octave_offset = offset; }
 
 void MainComponent::handleIncomingMidiMessage(juce::MidiInput * /*source*/,
                                               const juce::MidiMessage &message) {
-  processMidiMessage(message);
+  const auto event = toMidiEvent(message);
+  if (!event) {
+    return;
+  }
+  midi_audio_queue.push(*event);
+  midi_display_queue.push(*event);
 }
 
-auto MainComponent::handleDevControlBankCycle(const juce::KeyPress &key) -> bool {
-  const auto key_code = key.getKeyCode();
-  if (key_code != juce::KeyPress::upKey) {
-    return false;
+// Runs once per display frame: coalesces queued MIDI and meter frames into
+// the display state, then repaints only the regions that changed since the
+// previous frame.
+void MainComponent::refreshUi() {
+  drainMidiDisplayQueue();
+  drainMeterQueue();
+  if (++device_check_frame >= kDeviceCheckFrames) {
+    device_check_frame = 0;
+    checkAudioDevice();
+  }
+  if (diagnostics_visible && ++diagnostics_frame >= kDiagnosticsRefreshFrames) {
+    diagnostics_frame = 0;
+    updateDiagnosticsText();
+  }
+  if (phrase_journal_pending) {
+    journalPhrase();
+  }
+  const auto dirty = dirty_regions.take();
+  for (int index = 0; index < limit::kUiRegionCount; ++index) {
+    const auto region = static_cast<limit::UiRegion>(index);
+    if (dirty.isDirty(region)) {
+      repaint(dirtyArea(region));
+    }
   }
-  const auto next_bank = (dev_state.encoder_bank + 1) % limit::kDevBankCount;
-  limit::setDevEncoderBank(next_bank, dev_state);
-  last_midi_message = "dev control bank " + juce::String(dev_state.encoder_bank + 1);
-  repaint();
-  return true;
 }
 
-auto MainComponent::handleDevPadBankCycle(const juce::KeyPress &key) -> bool {
-  const auto key_code = key.getKeyCode();
-  if (key_code != juce::KeyPress::F1Key) {
-    return false;
+// Bound MIDI inputs take the same dispatch as keys. Every event counts, so
+// they are applied here rather than coalesced with the display MIDI; the
+// message still reaches the audio graph.
+auto MainComponent::dispatchMidiInput(const limit::MidiEvent &event) -> bool {
+  const juce::MidiMessage message(event.bytes.data(), event.size);
+  const InputTrigger trigger{
+      .time_seconds = juce::Time::highResolutionTicksToSeconds(event.timestamp_ticks)};
+  if (message.isController()) {
+    const auto action =
+        input_bindings.midiController(message.getChannel(), message.getControllerNumber());
+    if (action.kind == limit::InputKind::kRelativeEncoder) {
+      const auto encoder_event = limit::handleDevEncoderCc(
+          (action.bank * limit::kDevEncoderCount) + action.index, message.getControllerValue(),
+          trigger.time_seconds, dev_state);
+      if (encoder_event) {
+        applyEncoderEvent(*encoder_event);
+      }
+      return true;
+    }
+    // Buttons act on press; a CC of zero is the release.
+    return message.getControllerValue() > 0 && dispatchInput(action, trigger);
   }
-  const auto next_bank = (dev_state.pad_bank + 1) % limit::kDevBankCount;
-  limit::setDevPadBank(next_bank, dev_state);
-  const auto bank_label =
-      juce::String::charToString(static_cast<juce::juce_wchar>('A' + dev_state.pad_bank));
-  last_midi_message = "dev pad bank " + bank_label;
-  repaint();
-  return true;
+  if (message.isNoteOn()) {
+    return dispatchInput(input_bindings.midiNote(message.getChannel(), message.getNoteNumber()),
+                         trigger);
+  }
+  return false;
 }
 
-auto MainComponent::handleDevUtilityButtons(const juce::KeyPress &key) -> bool {
-  const auto key_code = key.getKeyCode();
-  if (key_code == juce::KeyPress::F2Key) {
-    last_midi_message = "dev prog select";
-  } else if (key_code == juce::KeyPress::F3Key) {
-    mod_active = !mod_active;
-    last_midi_message = mod_active ? "dev mod on" : "dev mod off";
-  } else if (key_code == juce::KeyPress::F4Key) {
-    sustain_active = !sustain_active;
-    last_midi_message = sustain_active ? "dev sustain on" : "dev sustain off";
-  } else if (key_code == juce::KeyPress::F5Key) {
-    note_octave_offset = std::max(note_octave_offset - 1, minOctaveOffset());
-    last_midi_message = "dev octave " + juce::String(note_octave_offset);
-  } else if (key_code == juce::KeyPress::F6Key) {
-    note_octave_offset = std::min(note_octave_offset + 1, maxOctaveOffset());
-    last_midi_message = "dev octave " + juce::String(note_octave_offset);
-  } else if (key_code == juce::KeyPress::F7Key) {
-    pitch_offset = std::max(pitch_offset - 1, kPitchMin);
-    last_midi_message = "dev pitch " + juce::String(pitch_offset);
-  } else if (key_code == juce::KeyPress::F8Key) {
-    pitch_offset = std::min(pitch_offset + 1, kPitchMax);
-    last_midi_message = "dev pitch " + juce::String(pitch_offset);
-  } else {
-    return false;
+void MainComponent::drainMidiDisplayQueue() {
+  std::optional<limit::MidiEvent> latest;
+  while (const auto event = midi_display_queue.pop()) {
+    if (!dispatchMidiInput(*event)) {
+      latest = event;
+    }
+  }
+  if (latest) {
+    processMidiMessage(juce::MidiMessage(latest->bytes.data(), latest->size));
+  }
+}
+
+// Meters decay once per display frame, so the visualization keeps repainting
+// until every level has fallen back to zero and then goes quiet.
+void MainComponent::drainMeterQueue() {
+  bool changed = false;
+  meter_ballistics.decay(kMeterDecayPerFrame);
+  while (const auto frame = meter_queue.pop()) {
+    meter_ballistics.apply(*frame);
+    changed = true;
+  }
+  for (int source = 0; source < limit::kMeterSourceCount && !changed; ++source) {
+    changed = meter_ballistics.level(source).peak > 0.0f;
+  }
+  if (changed) {
+    markDirty(limit::UiRegion::kVisualization);
   }
-  repaint();
-  return true;
 }
 
-auto MainComponent::mapKeyToEncoderAction(const juce::KeyPress &key) const
-    -> std::optional<EncoderKeyAction> {
-  using Key = juce::KeyPress;
-  const auto key_code = key.getKeyCode();
-  if (key_code == Key::numberPad7) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex0,
-                            .action = limit::DevEncoderAction::kDecrease};
+void MainComponent::drainMidiAudioQueue(int num_samples) {
+  block_midi.clear();
+  const auto block_end_ticks = juce::Time::getHighResolutionTicks();
+  const auto ticks_per_second =
+      static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+  for (auto *queue : {&midi_audio_queue, &key_audio_queue}) {
+    while (const auto event = queue->pop()) {
+      const auto offset = limit::midiEventSampleOffset(event->timestamp_ticks, block_end_ticks,
+                                                       ticks_per_second, current_sample_rate,
+                                                       num_samples);
+      block_midi.addEvent(event->bytes.data(), event->size, offset);
+    }
   }
-  if (key_code == Key::numberPad8) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex0,
-                            .action = limit::DevEncoderAction::kReset};
+}
+
+auto MainComponent::dispatchInput(const limit::InputAction &action,
+                                  const InputTrigger &trigger) -> bool {
+  switch (action.kind) {
+  case limit::InputKind::kNone:
+  case limit::InputKind::kRelativeEncoder:
+    return false;
+  case limit::InputKind::kPad:
+    return pressPad(action.index);
+  case limit::InputKind::kNote:
+    return trigger.key_code >= 0 && pressNoteKey(trigger.key_code, action.index);
+  case limit::InputKind::kEncoder:
+    return turnEncoder(action.index, action.encoder, trigger);
+  case limit::InputKind::kPadBank:
+    cyclePadBank();
+    return true;
+  case limit::InputKind::kControlBank:
+    cycleControlBank();
+    return true;
+  case limit::InputKind::kTransport:
+    toggleTransport();
+    return true;
+  case limit::InputKind::kReloadMapping:
+    reloadInputBindings();
+    return true;
+  case limit::InputKind::kDiagnostics:
+    toggleDiagnostics();
+    return true;
+  case limit::InputKind::kDumpDiagnostics:
+    dumpDiagnostics();
+    return true;
+  case limit::InputKind::kMeasureLatency:
+    measureLatency();
+    return true;
+  case limit::InputKind::kMode:
+    if (action.index < 0 || action.index >= limit::kAppModeCount) {
+      return false;
+    }
+    selectMode(static_cast<limit::AppMode>(action.index));
+    return true;
+  case limit::InputKind::kSubView:
+    cycleSubView();
+    return true;
+  case limit::InputKind::kProgSelect:
+  case limit::InputKind::kMod:
+  case limit::InputKind::kSustain:
+  case limit::InputKind::kOctaveDown:
+  case limit::InputKind::kOctaveUp:
+  case limit::InputKind::kPitchDown:
+  case limit::InputKind::kPitchUp:
+    applyUtilityButton(action.kind);
+    return true;
   }
-  if (key_code == Key::numberPad9) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex0,
-                            .action = limit::DevEncoderAction::kIncrease};
+  return false;
+}
+
+// Replaces the current bindings with the defaults plus the user's mapping
+// file, if there is one; see InputBindings for the format.
+void MainComponent::reloadInputBindings() {
+  const auto path = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                        .getChildFile("Limit")
+                        .getChildFile("input.map");
+  const auto report = input_bindings.load(path.getFullPathName().toStdString());
+  if (!report.opened) {
+    last_midi_message = "dev mapping default";
+  } else {
+    last_midi_message = "dev mapping " + juce::String(report.applied) + " bound";
+    if (report.rejected > 0) {
+      last_midi_message += ", line " + juce::String(report.first_rejected_line) + " rejected";
+    }
+  }
+  markDirty(limit::UiRegion::kSecondary);
+}
+
+// The diagnostics page replaces the MIDI status in the secondary panel. It
+// is not part of the device's UI, so it has no hardware control.
+void MainComponent::toggleDiagnostics() {
+  diagnostics_visible = !diagnostics_visible;
+  diagnostics_frame = 0;
+  if (diagnostics_visible) {
+    updateDiagnosticsText();
   }
-  if (key_code == Key::numberPad4) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex1,
-                            .action = limit::DevEncoderAction::kDecrease};
+  chrome = juce::Image{};
+  repaint(paint_areas.secondary);
+}
+
+void MainComponent::updateDiagnosticsText() {
+  diagnostics_text = formatProfileSummary(audio_profiler.snapshot());
+  diagnostics_text << "\nworkers " << juce::String(worker_pool.workerCount()) << " ("
+                   << juce::String(worker_pool.pinnedCount()) << " pinned, priority "
+                   << juce::String(worker_pool.workerPriority()) << ")";
+  diagnostics_text << "\nreverb tail misses "
+                   << juce::String(static_cast<juce::int64>(send1_reverb.tailMissCount()));
+  diagnostics_text << "\n" << audioDeviceSummary();
+  markDirty(limit::UiRegion::kSecondary);
+}
+
+void MainComponent::dumpDiagnostics() {
+  const auto file = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                        .getChildFile("Limit")
+                        .getChildFile("profile-" +
+                                      juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") +
+                                      ".txt");
+  audio_profiler.setDeviceSummary(audioDeviceSummary().toStdString());
+  const auto written = file.getParentDirectory().createDirectory().wasOk() &&
+                       audio_profiler.writeReport(file.getFullPathName().toStdString());
+  last_midi_message =
+      written ? "profile saved " + file.getFileName() : juce::String("profile not saved");
+  markDirty(limit::UiRegion::kSecondary);
+}
+
+// A saved profile opens directly. Without one, or when its device is gone,
+// every device type is scanned for the lowest-latency route and the buffer
+// size is negotiated down; checkAudioDevice() saves the result once stable.
+// The choice is made before anything opens, so the device opens once,
+// already at its rate and buffer size.
+void MainComponent::openAudioDevice() {
+  const auto saved = limit::loadAudioDeviceProfile(audioDeviceProfileFile());
+  const auto usable = saved && isDeviceAvailable(*saved);
+  const auto profile = usable ? saved : chooseLowLatencyDevice();
+  if (!profile) {
+    setAudioChannels(2, 2);
+    return;
   }
-  if (key_code == Key::numberPad5) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex1,
-                            .action = limit::DevEncoderAction::kReset};
+  const auto state = makeDeviceState(*profile);
+  setAudioChannels(2, 2, &state);
+  auto *device = deviceManager.getCurrentAudioDevice();
+  if (usable && device != nullptr) {
+    if (device->getTypeName() == juce::String(profile->type) &&
+        deviceManager.getAudioDeviceSetup().outputDeviceName ==
+            juce::String(profile->output_device)) {
+      buffer_negotiator.settleAt(device->getCurrentBufferSizeSamples());
+      return;
+    }
+    // The saved device is listed but would not open, so the manager fell
+    // back to its default; negotiate that device's buffer instead.
+    const auto sizes = device->getAvailableBufferSizes();
+    auto setup = deviceManager.getAudioDeviceSetup();
+    setup.bufferSize = buffer_negotiator.begin(std::vector<int>(sizes.begin(), sizes.end()));
+    deviceManager.setAudioDeviceSetup(setup, true);
   }
-  if (key_code == Key::numberPad6) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex1,
-                            .action = limit::DevEncoderAction::kIncrease};
+  device_setup_seconds = juce::Time::getMillisecondCounterHiRes() / kMillisecondsPerSecond;
+  device_saved = false;
+}
+
+auto MainComponent::isDeviceAvailable(const limit::AudioDeviceProfile &profile) -> bool {
+  for (auto *type : deviceManager.getAvailableDeviceTypes()) {
+    if (type->getTypeName() == juce::String(profile.type)) {
+      type->scanForHardware();
+      return type->getDeviceNames(false).contains(juce::String(profile.output_device));
+    }
   }
-  if (key_code == Key::numberPad1) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex2,
-                            .action = limit::DevEncoderAction::kDecrease};
+  return false;
+}
+
+// Ranks every device without opening any, then asks the best one what it
+// offers; a device that is created but not opened does not start streaming.
+auto MainComponent::chooseLowLatencyDevice() -> std::optional<limit::AudioDeviceProfile> {
+  // Type rank first, then device rank, so JACK wins over any ALSA device.
+  std::pair<int, int> best_rank{-1, -1};
+  juce::AudioIODeviceType *best_type = nullptr;
+  limit::AudioDeviceProfile profile;
+  for (auto *type : deviceManager.getAvailableDeviceTypes()) {
+    type->scanForHardware();
+    const auto type_name = type->getTypeName().toStdString();
+    const auto outputs = toStdStrings(type->getDeviceNames(false));
+    const auto output = limit::pickDevice(type_name, outputs);
+    if (!output) {
+      continue;
+    }
+    const std::pair rank{limit::deviceTypeRank(type_name),
+                         limit::deviceRank(type_name, outputs.at(*output))};
+    if (rank <= best_rank) {
+      continue;
+    }
+    best_rank = rank;
+    best_type = type;
+    profile.type = type_name;
+    profile.output_device = outputs.at(*output);
+    // Same card in and out keeps both directions on one clock.
+    const auto inputs = toStdStrings(type->getDeviceNames(true));
+    const auto same = std::find(inputs.begin(), inputs.end(), outputs.at(*output));
+    const auto input = same != inputs.end()
+                           ? std::optional(static_cast<std::size_t>(same - inputs.begin()))
+                           : limit::pickDevice(type_name, inputs);
+    profile.input_device = input ? inputs.at(*input) : std::string();
   }
-  if (key_code == Key::numberPad2) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex2,
-                            .action = limit::DevEncoderAction::kReset};
+  if (best_type == nullptr) {
+    return std::nullopt;
   }
-  if (key_code == Key::numberPad3) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex2,
-                            .action = limit::DevEncoderAction::kIncrease};
+
+  const std::unique_ptr<juce::AudioIODevice> probe(best_type->createDevice(
+      juce::String(profile.output_device), juce::String(profile.input_device)));
+  if (probe == nullptr) {
+    return std::nullopt;
   }
-  if (key_code == Key::insertKey) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex3,
-                            .action = limit::DevEncoderAction::kDecrease};
+  const auto rates = probe->getAvailableSampleRates();
+  const auto sizes = probe->getAvailableBufferSizes();
+  const std::vector<double> rate_list(rates.begin(), rates.end());
+  const std::vector<int> size_list(sizes.begin(), sizes.end());
+  profile.sample_rate = limit::chooseSampleRate(rate_list);
+  profile.buffer_size = buffer_negotiator.begin(size_list);
+  return profile;
+}
+
+// Steps the buffer size up after xruns while negotiating, saves the device
+// once it settles and reports a finished latency measurement.
+void MainComponent::checkAudioDevice() {
+  auto *device = deviceManager.getCurrentAudioDevice();
+  if (device == nullptr) {
+    return;
   }
-  if (key_code == Key::homeKey) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex3,
-                            .action = limit::DevEncoderAction::kReset};
+  if (!buffer_negotiator.isSettled()) {
+    const auto seconds =
+        (juce::Time::getMillisecondCounterHiRes() / kMillisecondsPerSecond) - device_setup_seconds;
+    const auto next = buffer_negotiator.observe(device->getXRunCount(), seconds);
+    if (next) {
+      auto setup = deviceManager.getAudioDeviceSetup();
+      setup.bufferSize = *next;
+      deviceManager.setAudioDeviceSetup(setup, true);
+    }
+  } else if (!device_saved) {
+    saveAudioDevice();
   }
-  if (key_code == Key::pageUpKey) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex3,
-                            .action = limit::DevEncoderAction::kIncrease};
+
+  const auto probe = latency_probe.state();
+  if (!latency_reported && (probe == limit::LatencyProbe::State::kMeasured ||
+                            probe == limit::LatencyProbe::State::kTimedOut)) {
+    latency_reported = true;
+    last_midi_message = probe == limit::LatencyProbe::State::kMeasured
+                            ? "loopback " + juce::String(limit::samplesToMilliseconds(
+                                                             latency_probe.measuredSamples(),
+                                                             device->getCurrentSampleRate()),
+                                                         1) +
+                                  " ms"
+                            : juce::String("no loopback signal");
+    markDirty(limit::UiRegion::kSecondary);
   }
-  if (key_code == Key::deleteKey) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex4,
-                            .action = limit::DevEncoderAction::kDecrease};
+}
+
+void MainComponent::saveAudioDevice() {
+  auto *device = deviceManager.getCurrentAudioDevice();
+  if (device == nullptr) {
+    return;
   }
-  if (key_code == Key::endKey) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex4,
-                            .action = limit::DevEncoderAction::kReset};
+  const auto setup = deviceManager.getAudioDeviceSetup();
+  const limit::AudioDeviceProfile profile{
+      .type = device->getTypeName().toStdString(),
+      .output_device = setup.outputDeviceName.toStdString(),
+      .input_device = setup.inputDeviceName.toStdString(),
+      .sample_rate = device->getCurrentSampleRate(),
+      .buffer_size = device->getCurrentBufferSizeSamples()};
+  device_saved = limit::saveAudioDeviceProfile(audioDeviceProfileFile(), profile);
+  last_midi_message = audioDeviceSummary();
+  markDirty(limit::UiRegion::kSecondary);
+}
+
+// Sends one click and times its return; needs a cable from output 1 to
+// input 1. The result shows in the status line.
+void MainComponent::measureLatency() {
+  if (deviceManager.getCurrentAudioDevice() == nullptr) {
+    return;
   }
-  if (key_code == Key::pageDownKey) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex4,
-                            .action = limit::DevEncoderAction::kIncrease};
+  latency_probe.arm();
+  latency_reported = false;
+  last_midi_message = "measuring loopback";
+  markDirty(limit::UiRegion::kSecondary);
+}
+
+// Device, rate, buffer and the round trip the driver reports, plus the
+// loopback measurement when there is one.
+auto MainComponent::audioDeviceSummary() const -> juce::String {
+  auto *device = deviceManager.getCurrentAudioDevice();
+  if (device == nullptr) {
+    return "audio off";
   }
-  if (key_code == Key::leftKey) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex5,
-                            .action = limit::DevEncoderAction::kDecrease};
+  const limit::DeviceLatency latency{.sample_rate = device->getCurrentSampleRate(),
+                                     .buffer_size = device->getCurrentBufferSizeSamples(),
+                                     .input_samples = device->getInputLatencyInSamples(),
+                                     .output_samples = device->getOutputLatencyInSamples()};
+  const auto round_trip_ms =
+      limit::samplesToMilliseconds(limit::roundTripSamples(latency), latency.sample_rate);
+  auto text = device->getTypeName() + " " + juce::String(juce::roundToInt(latency.sample_rate)) +
+              " Hz " + juce::String(latency.buffer_size) + " smp " +
+              juce::String(round_trip_ms, 1) + " ms";
+  if (latency_probe.state() == limit::LatencyProbe::State::kMeasured) {
+    text << " (loop "
+         << juce::String(limit::samplesToMilliseconds(latency_probe.measuredSamples(),
+                                                      latency.sample_rate),
+                         1)
+         << " ms)";
   }
-  if (key_code == Key::downKey) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex5,
-                            .action = limit::DevEncoderAction::kReset};
+  if (!buffer_negotiator.isSettled()) {
+    text << " probing";
+  } else if (round_trip_ms > limit::kLatencyTargetMs) {
+    text << " over target";
   }
-  if (key_code == Key::rightKey) {
-    return EncoderKeyAction{.encoder_index = kEncoderIndex5,
-                            .action = limit::DevEncoderAction::kIncrease};
+  return text;
+}
+
+void MainComponent::cycleControlBank() {
+  const auto next_bank = (dev_state.encoder_bank + 1) % limit::kDevBankCount;
+  limit::setDevEncoderBank(next_bank, dev_state);
+  last_midi_message = "dev control bank " + juce::String(dev_state.encoder_bank + 1);
+  markDirty(limit::UiRegion::kSecondary);
+}
+
+void MainComponent::cyclePadBank() {
+  const auto next_bank = (dev_state.pad_bank + 1) % limit::kDevBankCount;
+  limit::setDevPadBank(next_bank, dev_state);
+  const auto bank_label =
+      juce::String::charToString(static_cast<juce::juce_wchar>('A' + dev_state.pad_bank));
+  last_midi_message = "dev pad bank " + bank_label;
+  markDirty(limit::UiRegion::kSecondary);
+}
+
+// Mode changes are deliberate, so a new mode always opens on its first
+// sub-view.
+void MainComponent::selectMode(limit::AppMode mode) {
+  app_mode = mode;
+  mode_sub_view = 0;
+  last_midi_message = modeLabel();
+  markDirty(limit::UiRegion::kSecondary);
+}
+
+void MainComponent::cycleSubView() {
+  const auto count = kModeNames.at(static_cast<std::size_t>(app_mode)).sub_view_count;
+  mode_sub_view = count > 0 ? (mode_sub_view + 1) % count : 0;
+  last_midi_message = modeLabel();
+  markDirty(limit::UiRegion::kSecondary);
+}
+
+auto MainComponent::modeLabel() const -> juce::String {
+  const auto &names = kModeNames.at(static_cast<std::size_t>(app_mode));
+  auto label = "dev " + juce::String(std::string(names.mode));
+  if (names.sub_view_count > 0) {
+    label << " "
+          << juce::String(
+                 std::string(names.sub_views.at(static_cast<std::size_t>(mode_sub_view))));
   }
-  return std::nullopt;
+  return label;
 }
 
-auto MainComponent::handleDevEncoder(const juce::KeyPress &key) -> bool {
-  const auto action = mapKeyToEncoderAction(key);
-  if (!action) {
-    return false;
+void MainComponent::applyUtilityButton(limit::InputKind kind) {
+  switch (kind) {
+  case limit::InputKind::kMod:
+    mod_active = !mod_active;
+    last_midi_message = mod_active ? "dev mod on" : "dev mod off";
+    break;
+  case limit::InputKind::kSustain:
+    sustain_active = !sustain_active;
+    last_midi_message = sustain_active ? "dev sustain on" : "dev sustain off";
+    break;
+  case limit::InputKind::kOctaveDown:
+    note_octave_offset = std::max(note_octave_offset - 1, minOctaveOffset());
+    last_midi_message = "dev octave " + juce::String(note_octave_offset);
+    break;
+  case limit::InputKind::kOctaveUp:
+    note_octave_offset = std::min(note_octave_offset + 1, maxOctaveOffset());
+    last_midi_message = "dev octave " + juce::String(note_octave_offset);
+    break;
+  case limit::InputKind::kPitchDown:
+    pitch_offset = std::max(pitch_offset - 1, kPitchMin);
+    last_midi_message = "dev pitch " + juce::String(pitch_offset);
+    break;
+  case limit::InputKind::kPitchUp:
+    pitch_offset = std::min(pitch_offset + 1, kPitchMax);
+    last_midi_message = "dev pitch " + juce::String(pitch_offset);
+    break;
+  case limit::InputKind::kProgSelect:
+    last_midi_message = "dev prog select";
+    break;
+  default:
+    return;
   }
+  markDirty(limit::UiRegion::kSecondary);
+}
 
-  const auto event =
-      limit::handleDevEncoderAction(action->encoder_index, action->action, dev_state);
+auto MainComponent::turnEncoder(int encoder_index, limit::DevEncoderAction action,
+                                const InputTrigger &trigger) -> bool {
+  std::optional<limit::DevEncoderEvent> event;
+  if (action == limit::DevEncoderAction::kReset) {
+    event = limit::handleDevEncoderAction(encoder_index, action, dev_state);
+  } else {
+    event = limit::handleDevEncoderTurn(
+        encoder_index,
+        {.detents = action == limit::DevEncoderAction::kIncrease ? 1 : -1,
+         .speed = trigger.speed,
+         .time_seconds = trigger.time_seconds},
+        dev_state);
+  }
   if (!event) {
     return false;
   }
 
-  last_midi_message = "dev cc " + juce::String(event->cc) + " = " +
-                      juce::String(event->value) + " (bank " +
-                      juce::String(event->bank + 1) + ")";
-  repaint();
+  applyEncoderEvent(*event);
   return true;
 }
 
-auto MainComponent::handleDevPad(const juce::KeyPress &key) -> bool {
-  const auto key_char = static_cast<unsigned char>(key.getTextCharacter());
-  const auto pad_index = mapKeyCharToPadIndex(static_cast<int>(key_char));
-  if (pad_index < 0) {
-    return false;
-  }
-
+auto MainComponent::pressPad(int pad_index) -> bool {
   const auto event = limit::handleDevPadPress(pad_index, dev_state);
   if (!event) {
     return false;
@@ -332,22 +921,107 @@ auto MainComponent::handleDevPad(const juce::KeyPress &key) -> bool {
 
   last_midi_message = "dev pad " + juce::String(event->pad_index + 1) + " (bank " +
                       juce::String(event->bank + 1) + ")";
-  repaint();
+  if (app_mode == limit::AppMode::kTape) {
+    toggleTapeTrick(event->pad_index);
+  } else {
+    toggleSequencerStep(*event);
+  }
+  markDirty(limit::UiRegion::kSecondary);
   return true;
 }
 
-auto MainComponent::mapKeyCharToPadIndex(int key_char) const -> int {
-  static const std::array<char, limit::kDevPadCount> kPadKeys = {
-      '1', '2', '3', '4', 'q', 'w', 'e', 'r',
-      'a', 's', 'd', 'f', 'z', 'x', 'c', 'v'};
+// In Tape mode pads 1-4 are Brake, Reverse, Loop (one bar from the
+// playhead) and Chop (one step), each held until pressed again. Loop and
+// Chop replace each other; lengths follow the sequencer tempo.
+void MainComponent::toggleTapeTrick(int pad_index) {
+  const auto state = [](bool on) { return juce::String(on ? " on" : " off"); };
+  switch (pad_index) {
+  case 0:
+    tape_braking = !tape_braking;
+    tape_transport.setBrake(tape_braking);
+    last_midi_message = "dev tape brake" + state(tape_braking);
+    break;
+  case 1:
+    tape_reversed = !tape_reversed;
+    tape_transport.setReverse(tape_reversed);
+    last_midi_message = "dev tape reverse" + state(tape_reversed);
+    break;
+  case 2:
+  case 3: {
+    const auto chop = pad_index == 3;
+    const auto was_on = chop ? tape_chopped : tape_looped;
+    tape_looped = !chop && !was_on;
+    tape_chopped = chop && !was_on;
+    if (was_on) {
+      tape_transport.clearLoop();
+    } else {
+      const auto beat_frames =
+          (kSecondsPerMinute / step_sequencer.tempo()) * limit::kTapeSampleRate;
+      const auto length = chop ? beat_frames / limit::kStepsPerBeat : beat_frames * kBeatsPerBar;
+      const auto start = tape_transport.position();
+      tape_transport.setLoop(start, start + std::max<std::int64_t>(std::llround(length), 1));
+    }
+    last_midi_message = juce::String(chop ? "dev tape chop" : "dev tape loop") + state(!was_on);
+    break;
+  }
+  default:
+    break;
+  }
+}
 
-  const auto normalized = static_cast<char>(std::tolower(key_char));
-  for (std::size_t index = 0; index < kPadKeys.size(); ++index) {
-    if (normalized == kPadKeys.at(index)) {
-      return static_cast<int>(index);
+void MainComponent::toggleTransport() {
+  if (app_mode == limit::AppMode::kTape) {
+    if (tape_transport.isPlaying()) {
+      tape_transport.stop();
+      last_midi_message = "dev tape stop";
+    } else {
+      tape_transport.play();
+      last_midi_message = "dev tape play";
     }
+  } else if (step_sequencer.isRunning()) {
+    step_sequencer.stop();
+    last_midi_message = "dev sequencer stop";
+  } else {
+    step_sequencer.start();
+    last_midi_message = "dev sequencer play";
   }
-  return -1;
+  markDirty(limit::UiRegion::kSecondary);
+}
+
+// Pads are the step grid: each pad bank addresses the next sixteen steps of
+// the phrase. Edits go to the audio thread as a whole pattern copy.
+void MainComponent::toggleSequencerStep(const limit::DevPadEvent &event) {
+  const auto step_index = (event.bank * limit::kDevPadCount) + event.pad_index;
+  if (step_index < 0 || step_index >= limit::kMaxPhraseSteps) {
+    return;
+  }
+  auto &step = sequence_pattern.steps.at(static_cast<std::size_t>(step_index));
+  if (step.velocity > 0) {
+    step.velocity = 0;
+  } else {
+    const auto note = limit::kDefaultStepNote + (note_octave_offset * kSemitone);
+    step.note = static_cast<std::uint8_t>(std::clamp(note, kMidiMin, kMidiMax));
+    step.velocity = kKeyVelocity;
+  }
+  step_sequencer.setPattern(sequence_pattern);
+  if (phrase_store != nullptr) {
+    limit::PhraseRecord record;
+    record.pattern = sequence_pattern;
+    phrase_store->save(phrase_slot, record);
+    journalPhrase();
+  }
+}
+
+// The phrase is already in the mapped store; the journal makes the change
+// durable in the background. A full queue is retried on the next frame.
+void MainComponent::journalPhrase() {
+  const auto *record = phrase_store != nullptr ? phrase_store->phrase(phrase_slot) : nullptr;
+  if (project_journal == nullptr || record == nullptr) {
+    phrase_journal_pending = false;
+    return;
+  }
+  phrase_journal_pending = !project_journal->append(limit::JournalKind::kPhrase, phrase_slot,
+                                                    std::as_bytes(std::span(record, 1)));
 }
 
 auto MainComponent::minOctaveOffset() const -> int {
@@ -364,6 +1038,134 @@ void MainComponent::focusIfVisible() {
   }
 }
 
+void MainComponent::openTapeStorage() {
+  const auto directory = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                             .getChildFile("Limit")
+                             .getChildFile("tape");
+  tape_storage = limit::TapeStorage::open(
+      {.directory = directory.getFullPathName().toStdString()});
+  if (tape_storage != nullptr) {
+    tape_storage->start();
+    tape_transport.setStorage(tape_storage.get());
+  }
+}
+
+// Mix mode sub-views follow docs/design.md: Levels, Pan, then Sends with
+// Send 1 for tracks 1-8 ahead of Send 2. Each sub-view fills six encoders
+// per bank, so track 7 lands on the first encoder of the second bank.
+void MainComponent::registerMixParameters() {
+  const auto bind = [this](MixSubView sub_view, int slot, int id) {
+    parameters.bind({.mode = limit::AppMode::kMix,
+                     .sub_view = static_cast<int>(sub_view),
+                     .bank = slot / limit::kDevEncoderCount,
+                     .encoder = slot % limit::kDevEncoderCount},
+                    id);
+  };
+  track_parameters = limit::addMixParameters(parameters);
+  for (int track = 0; track < limit::kTapeTrackCount; ++track) {
+    const auto &strip = track_parameters.at(static_cast<std::size_t>(track));
+    bind(MixSubView::kLevels, track, strip.level);
+    bind(MixSubView::kPan, track, strip.pan);
+    bind(MixSubView::kSends, track, strip.send1);
+    bind(MixSubView::kSends, limit::kTapeTrackCount + track, strip.send2);
+  }
+}
+
+// Tape mode has a single page: Speed on the first encoder, in percent of
+// normal speed.
+void MainComponent::registerTapeParameters() {
+  tape_speed_parameter = parameters.add({.label = "SPEED",
+                                         .min = limit::kTapeMinSpeed * kPercent,
+                                         .max = limit::kTapeMaxSpeed * kPercent,
+                                         .default_value = kPercent,
+                                         .unit = limit::ParameterUnit::kPercent});
+  parameters.bind({.mode = limit::AppMode::kTape}, tape_speed_parameter);
+}
+
+// Audio thread: ramps every strip toward its published value and hands the
+// block's start and end values to the mixer, which applies them as they are.
+void MainComponent::applyMixParameters(int num_samples) {
+  parameter_ramps.beginBlock(num_samples);
+  limit::applyMixRamps(parameter_ramps, track_parameters, tape_mixer);
+}
+
+// Shows the dev CC and moves the parameter under the encoder in the current
+// mode and sub-view; the CC is shown even when nothing is bound there.
+void MainComponent::applyEncoderEvent(const limit::DevEncoderEvent &event) {
+  last_midi_message = "dev cc " + juce::String(event.cc) + " = " + juce::String(event.value) +
+                      " (bank " + juce::String(event.bank + 1) + ")";
+  const auto id = parameters.lookup({.mode = app_mode,
+                                     .sub_view = mode_sub_view,
+                                     .bank = event.bank,
+                                     .encoder = event.encoder_index});
+  if (id >= 0) {
+    if (event.reset) {
+      parameters.resetToDefault(id);
+    } else {
+      parameters.nudge(id, event.steps);
+    }
+    last_midi_message += " " + juce::String(parameters.spec(id).label) + " " +
+                         juce::String(parameters.format(id));
+  }
+  markDirty(limit::UiRegion::kSecondary);
+}
+
+// Loads the Send 1 reverb's response before the device starts, so nothing
+// is decoded or resampled while audio runs: the first file in
+// Limit/impulses, resampled to the device rate, or else the built-in room
+// to hall. Only reloads when the rate changes.
+void MainComponent::loadImpulseResponse(double sample_rate) {
+  if (juce::exactlyEqual(sample_rate, impulse_rate)) {
+    return;
+  }
+  impulse_rate = sample_rate;
+  const auto directory = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                             .getChildFile("Limit")
+                             .getChildFile("impulses");
+  auto files = directory.findChildFiles(juce::File::findFiles, false, "*.wav;*.aif;*.aiff;*.flac");
+  files.sort();
+  for (const auto &file : files) {
+    const auto decoded = limit::decodeSampleFile(file.getFullPathName().toStdString(),
+                                                 juce::roundToInt(sample_rate));
+    if (decoded != nullptr) {
+      send1_reverb.setImpulseResponse(decoded->audio, sample_rate);
+      return;
+    }
+  }
+  send1_reverb.setImpulseResponse(limit::makeRoomToHallImpulse(sample_rate), sample_rate);
+}
+
+// Replays the autosave journal over the phrase file, so edits made before a
+// crash are restored, then recalls the current phrase.
+void MainComponent::openPhraseStore() {
+  const auto directory = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                             .getChildFile("Limit");
+  phrase_store = limit::PhraseStore::open(
+      directory.getChildFile("phrases.bin").getFullPathName().toStdString());
+  if (phrase_store == nullptr) {
+    return;
+  }
+  project_journal = limit::ProjectJournal::open(
+      {.path = directory.getChildFile("journal.log").getFullPathName().toStdString()});
+  if (project_journal != nullptr) {
+    project_journal->replay([this](const limit::JournalChange &change) {
+      limit::PhraseRecord record;
+      if (change.kind == limit::JournalKind::kPhrase && change.size == sizeof(record)) {
+        std::memcpy(&record, change.bytes().data(), sizeof(record));
+        phrase_store->save(change.slot, record);
+      }
+    });
+    project_journal->start([this] {
+      phrase_store->flush();
+      return true;
+    });
+  }
+  if (const auto *record = phrase_store->phrase(phrase_slot)) {
+    sequence_pattern = record->pattern;
+    step_sequencer.setPattern(sequence_pattern);
+  }
+}
+
 void MainComponent::processMidiMessage(const juce::MidiMessage &message) {
   if (message.isNoteOn()) {
     last_midi_message =
@@ -378,30 +1180,217 @@ void MainComponent::processMidiMessage(const juce::MidiMessage &message) {
     last_midi_message = "message";
   }
 
-  repaint();
+  markDirty(limit::UiRegion::kSecondary);
 }
 
 auto MainComponent::processKeyChar(int key_char) -> bool {
-  const auto normalized = static_cast<unsigned char>(std::tolower(key_char));
-  const auto note = limit::mapKeyToMidiNote(static_cast<int>(normalized));
-  if (note < 0) {
-    return false;
-  }
+  const auto key_code = limit::inputCodeForChar(key_char);
+  const auto action = input_bindings.key(key_code);
+  return action.kind == limit::InputKind::kNote && pressNoteKey(key_code, action.index);
+}
+
+auto MainComponent::releaseKeyChar(int key_char) -> bool {
+  const auto key_code = limit::inputCodeForChar(key_char);
+  return key_code >= 0 && releaseNoteKey(key_code);
+}
+
+auto MainComponent::pressNoteKey(int key_code, int semitone) -> bool {
   const auto octave_shift = note_octave_offset * kSemitone;
-  const auto shifted_note = note + octave_shift;
+  const auto shifted_note = limit::kKeymapMinNote + semitone + octave_shift;
   if (shifted_note < kMidiMin || shifted_note > kMidiMax) {
     return false;
   }
+  auto &held_note = held_key_notes.at(static_cast<std::size_t>(key_code));
+  if (held_note < 0) {
+    held_note = shifted_note;
+    pushKeyNote(juce::MidiMessage::noteOn(1, shifted_note, kKeyVelocity));
+  }
   last_midi_message =
       "note-on " + juce::MidiMessage::getMidiNoteName(shifted_note, true, true, 3);
-  repaint();
+  markDirty(limit::UiRegion::kSecondary);
+  return true;
+}
+
+auto MainComponent::releaseNoteKey(int key_code) -> bool {
+  auto &held_note = held_key_notes.at(static_cast<std::size_t>(key_code));
+  if (held_note < 0) {
+    return false;
+  }
+  // Release the note that was started, even if the octave changed since.
+  pushKeyNote(juce::MidiMessage::noteOff(1, held_note));
+  held_note = -1;
   return true;
 }
 
+void MainComponent::pushKeyNote(const juce::MidiMessage &message) {
+  if (const auto event = toMidiEvent(message)) {
+    key_audio_queue.push(*event);
+  }
+}
+
+auto MainComponent::chromeRenderCountForTesting() const -> int { return chrome_render_count; }
+
+auto MainComponent::dirtyRegionsForTesting() const -> limit::UiDirtyRegions {
+  return dirty_regions;
+}
+
+void MainComponent::refreshUiForTesting() { refreshUi(); }
+
+auto MainComponent::sequencerForTesting() const -> const limit::StepSequencer & {
+  return step_sequencer;
+}
+
+auto MainComponent::tapeTransportForTesting() const -> const limit::TapeTransport & {
+  return tape_transport;
+}
+
+void MainComponent::updatePaintAreas() {
+  const auto &theme = getUiTheme();
+  const auto bounds = getLocalBounds();
+  const auto layout = limit::computeUiLayout(
+      {.width = bounds.getWidth(),
+       .height = bounds.getHeight(),
+       .header_height = theme.header_height,
+       .visualization_ratio = theme.visualization_ratio,
+       .encoder_ratio = theme.encoder_ratio});
+  paint_areas.header = toRectangle(layout.header);
+  paint_areas.visualization = toRectangle(layout.visualization);
+  paint_areas.encoder = toRectangle(layout.encoder);
+  paint_areas.secondary = toRectangle(layout.secondary);
+
+  // One row per tape track plus the master meter; the overview strips take
+  // the width left of the meters and get one min/max column per pixel.
+  auto visualization_content = paint_areas.visualization.reduced(theme.padding);
+  paint_areas.meters = visualization_content.removeFromRight(kMeterWidth);
+  visualization_content.removeFromRight(kMeterGap);
+  paint_areas.overview = visualization_content;
+  overview_columns.resize(static_cast<std::size_t>(std::max(paint_areas.overview.getWidth(), 0)));
+
+  auto secondary_content = paint_areas.secondary.reduced(theme.padding);
+  paint_areas.secondary_label =
+      secondary_content.removeFromTop(static_cast<int>(theme.body_font_size));
+  secondary_content.removeFromTop(theme.secondary_text_gap);
+  paint_areas.diagnostics = secondary_content;
+  paint_areas.status_box = secondary_content.removeFromTop(
+      static_cast<int>(theme.body_font_size * theme.status_box_line_count));
+}
+
+// Everything except the status text is static, so it is drawn once per size
+// and display scale and blitted on every repaint.
+void MainComponent::renderChrome(float scale) {
+  const auto &theme = getUiTheme();
+  const auto width = std::max(juce::roundToInt(static_cast<float>(getWidth()) * scale), 1);
+  const auto height = std::max(juce::roundToInt(static_cast<float>(getHeight()) * scale), 1);
+  chrome = juce::Image(juce::Image::RGB, width, height, false);
+  chrome_scale = scale;
+  ++chrome_render_count;
+
+  juce::Graphics g(chrome);
+  g.addTransform(juce::AffineTransform::scale(scale));
+  g.fillAll(theme.background);
+
+  drawPanel(g, paint_areas.header);
+  drawPanel(g, paint_areas.visualization);
+  drawPanel(g, paint_areas.encoder);
+  drawPanel(g, paint_areas.secondary);
+
+  g.setColour(theme.accent_blue);
+  g.setFont(title_font);
+  g.drawText("LIMIT", paint_areas.header, juce::Justification::centred);
+
+  g.setColour(theme.text);
+  g.setFont(body_font);
+  g.drawText(diagnostics_visible ? "DIAGNOSTICS" : "MIDI", paint_areas.secondary_label,
+             juce::Justification::topLeft);
+  if (diagnostics_visible) {
+    return;
+  }
+
+  g.setColour(theme.background);
+  g.fillRect(paint_areas.status_box);
+  g.setColour(theme.border);
+  g.drawRect(paint_areas.status_box);
+}
+
+void MainComponent::markDirty(limit::UiRegion region) { dirty_regions.mark(region); }
+
+// The status text is the only live content in the secondary panel, so only
+// its box is invalidated there, unless the diagnostics page is showing.
+auto MainComponent::dirtyArea(limit::UiRegion region) const -> juce::Rectangle<int> {
+  switch (region) {
+  case limit::UiRegion::kHeader:
+    return paint_areas.header;
+  case limit::UiRegion::kVisualization:
+    return paint_areas.visualization;
+  case limit::UiRegion::kEncoder:
+    return paint_areas.encoder;
+  case limit::UiRegion::kSecondary:
+    return diagnostics_visible ? paint_areas.diagnostics : paint_areas.status_box;
+  }
+  return {};
+}
+
 auto MainComponent::toRectangle(const limit::LayoutRect &rect) -> juce::Rectangle<int> {
   return {rect.x, rect.y, rect.width, rect.height};
 }
 
+// Draws from the tape overview and the meter state only; raw tape audio is
+// never read on the message thread.
+void MainComponent::drawVisualization(juce::Graphics &g) {
+  const auto row_height = paint_areas.overview.getHeight() / limit::kMeterSourceCount;
+  if (row_height <= kMeterGap) {
+    return;
+  }
+  for (int source = 0; source < limit::kMeterSourceCount; ++source) {
+    const auto row_y = paint_areas.overview.getY() + (source * row_height);
+    const auto overview_row = paint_areas.overview.withY(row_y)
+                                  .withHeight(row_height)
+                                  .withTrimmedBottom(kMeterGap);
+    const auto meter_row =
+        paint_areas.meters.withY(row_y).withHeight(row_height).withTrimmedBottom(kMeterGap);
+    if (source != limit::kMasterMeterIndex) {
+      drawOverview(g, source, overview_row);
+    }
+    drawMeter(g, source, meter_row);
+  }
+}
+
+void MainComponent::drawOverview(juce::Graphics &g, int track, juce::Rectangle<int> row) {
+  const auto &theme = getUiTheme();
+  g.setColour(theme.background);
+  g.fillRect(row);
+  if (tape_storage == nullptr || overview_columns.empty()) {
+    return;
+  }
+  const auto columns = std::span(overview_columns).first(
+      std::min(overview_columns.size(), static_cast<std::size_t>(row.getWidth())));
+  tape_storage->overview().render(track, 0, tape_storage->frameCount(), columns);
+
+  g.setColour(theme.accent_blue);
+  const auto centre = static_cast<float>(row.getCentreY());
+  const auto half_height = static_cast<float>(row.getHeight()) / 2.0f;
+  for (std::size_t column = 0; column < columns.size(); ++column) {
+    const auto &bucket = columns[column];
+    const auto top = centre - (std::clamp(bucket.max, -1.0f, 1.0f) * half_height);
+    const auto bottom = centre - (std::clamp(bucket.min, -1.0f, 1.0f) * half_height);
+    g.drawVerticalLine(row.getX() + static_cast<int>(column), top, std::max(bottom, top + 1.0f));
+  }
+}
+
+void MainComponent::drawMeter(juce::Graphics &g, int source, juce::Rectangle<int> row) const {
+  const auto &theme = getUiTheme();
+  const auto level = meter_ballistics.level(source);
+  const auto width = static_cast<float>(row.getWidth());
+  g.setColour(theme.background);
+  g.fillRect(row);
+  g.setColour(theme.accent_blue);
+  g.fillRect(row.toFloat().withWidth(std::clamp(level.rms, 0.0f, 1.0f) * width));
+  g.setColour(theme.text);
+  const auto peak_x = static_cast<float>(row.getX()) + (std::clamp(level.peak, 0.0f, 1.0f) * width);
+  g.drawVerticalLine(juce::roundToInt(std::min(peak_x, static_cast<float>(row.getRight() - 1))),
+                     static_cast<float>(row.getY()), static_cast<float>(row.getBottom()));
+}
+
 void MainComponent::drawPanel(juce::Graphics &g, juce::Rectangle<int> area) const {
   const auto &theme = getUiTheme();
   g.setColour(theme.panel);
@@ -1,13 +1,36 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
 #include <juce_audio_utils/juce_audio_utils.h>
 #include <juce_gui_basics/juce_gui_basics.h>
 
+#include "audio-device-setup.h"
+#include "audio-graph.h"
+#include "audio-profiler.h"
+#include "convolution-reverb.h"
 #include "dev-controller.h"
+#include "input-bindings.h"
+#include "level-meter.h"
+#include "midi-event-queue.h"
+#include "mix-parameters.h"
+#include "parameter-registry.h"
+#include "phrase-store.h"
+#include "project-journal.h"
+#include "step-sequencer.h"
+#include "synth-instrument.h"
+#include "tape-mixer.h"
+#include "tape-storage.h"
+#include "tape-transport.h"
 #include "ui-layout.h"
+#include "worker-pool.h"
 
 namespace limit {
-class MainComponent final : public juce::AudioAppComponent, private juce::MidiInputCallback {
+class MainComponent final : public juce::AudioAppComponent,
+                            private juce::MidiInputCallback {
 public:
   explicit MainComponent(bool enable_audio = true);
   ~MainComponent() override;
@@ -24,59 +47,188 @@ public:
   void parentHierarchyChanged() override;
   void visibilityChanged() override;
   auto keyPressed(const juce::KeyPress &key) -> bool override;
+  auto keyStateChanged(bool is_key_down) -> bool override;
 
   auto getLastMidiMessageForTesting() const -> juce::String;
   void processMidiMessageForTesting(const juce::MidiMessage &message);
   auto processKeyCharForTesting(int key_char) -> bool;
+  auto releaseKeyCharForTesting(int key_char) -> bool;
   void handleIncomingMidiMessageForTesting(const juce::MidiMessage &message);
+  void flushPendingMidiForTesting();
+  void flushPendingMetersForTesting();
+  auto meterLevelForTesting(int source) const -> limit::LevelSummary;
+  auto getBlockMidiForTesting() const -> const juce::MidiBuffer &;
   auto processEncoderActionForTesting(int encoder_index, limit::DevEncoderAction action) -> bool;
   auto processPadIndexForTesting(int pad_index) -> bool;
   void setOctaveOffsetForTesting(int offset);
+  auto chromeRenderCountForTesting() const -> int;
+  auto dirtyRegionsForTesting() const -> limit::UiDirtyRegions;
+  auto sequencerForTesting() const -> const limit::StepSequencer &;
+  auto tapeTransportForTesting() const -> const limit::TapeTransport &;
+  void refreshUiForTesting();
 
 private:
   void handleIncomingMidiMessage(juce::MidiInput *source,
                                  const juce::MidiMessage &message) override;
+  void refreshUi();
+  void drainMidiDisplayQueue();
+  void drainMeterQueue();
+  void drainMidiAudioQueue(int num_samples);
+
+  // Where an input came from: the key's input code (or -1 for MIDI), the
+  // encoder speed its modifiers select and when it happened.
+  struct InputTrigger {
+    int key_code = -1;
+    limit::DevEncoderSpeed speed = limit::DevEncoderSpeed::kNormal;
+    double time_seconds = -1.0;
+  };
 
-  auto handleDevControlBankCycle(const juce::KeyPress &key) -> bool;
-  auto handleDevPadBankCycle(const juce::KeyPress &key) -> bool;
-  auto handleDevUtilityButtons(const juce::KeyPress &key) -> bool;
-  auto handleDevEncoder(const juce::KeyPress &key) -> bool;
-  auto handleDevPad(const juce::KeyPress &key) -> bool;
-  auto mapKeyCharToPadIndex(int key_char) const -> int;
+  auto dispatchInput(const limit::InputAction &action, const InputTrigger &trigger) -> bool;
+  auto dispatchMidiInput(const limit::MidiEvent &event) -> bool;
+  void reloadInputBindings();
+  void cycleControlBank();
+  void cyclePadBank();
+  void selectMode(limit::AppMode mode);
+  void cycleSubView();
+  auto modeLabel() const -> juce::String;
+  void applyUtilityButton(limit::InputKind kind);
+  auto turnEncoder(int encoder_index, limit::DevEncoderAction action,
+                   const InputTrigger &trigger) -> bool;
+  auto pressPad(int pad_index) -> bool;
+  void toggleTransport();
+  void toggleTapeTrick(int pad_index);
+  void toggleDiagnostics();
+  void dumpDiagnostics();
+  void updateDiagnosticsText();
+  void openAudioDevice();
+  auto isDeviceAvailable(const limit::AudioDeviceProfile &profile) -> bool;
+  auto chooseLowLatencyDevice() -> std::optional<limit::AudioDeviceProfile>;
+  void checkAudioDevice();
+  void saveAudioDevice();
+  void measureLatency();
+  auto audioDeviceSummary() const -> juce::String;
+  void toggleSequencerStep(const limit::DevPadEvent &event);
   auto minOctaveOffset() const -> int;
   auto maxOctaveOffset() const -> int;
   void focusIfVisible();
+  void openTapeStorage();
+  void openPhraseStore();
+  void loadImpulseResponse(double sample_rate);
+  void registerMixParameters();
+  void registerTapeParameters();
+  void applyMixParameters(int num_samples);
+  void applyEncoderEvent(const limit::DevEncoderEvent &event);
+  void journalPhrase();
   void processMidiMessage(const juce::MidiMessage &message);
   auto processKeyChar(int key_char) -> bool;
+  auto releaseKeyChar(int key_char) -> bool;
+  auto pressNoteKey(int key_code, int semitone) -> bool;
+  auto releaseNoteKey(int key_code) -> bool;
+  void pushKeyNote(const juce::MidiMessage &message);
 
-  struct EncoderKeyAction {
-    int encoder_index = 0;
-    limit::DevEncoderAction action = limit::DevEncoderAction::kReset;
-  };
+  enum class MixSubView : std::uint8_t { kLevels, kPan, kSends, kMaster };
 
-  auto mapKeyToEncoderAction(const juce::KeyPress &key) const
-      -> std::optional<EncoderKeyAction>;
+  struct PaintAreas {
+    juce::Rectangle<int> header;
+    juce::Rectangle<int> visualization;
+    juce::Rectangle<int> overview;
+    juce::Rectangle<int> meters;
+    juce::Rectangle<int> encoder;
+    juce::Rectangle<int> secondary;
+    juce::Rectangle<int> secondary_label;
+    juce::Rectangle<int> status_box;
+    juce::Rectangle<int> diagnostics;
+  };
 
   static auto toRectangle(const limit::LayoutRect &rect) -> juce::Rectangle<int>;
+  void updatePaintAreas();
+  void renderChrome(float scale);
+  void markDirty(limit::UiRegion region);
+  auto dirtyArea(limit::UiRegion region) const -> juce::Rectangle<int>;
   void drawPanel(juce::Graphics &g, juce::Rectangle<int> area) const;
+  void drawVisualization(juce::Graphics &g);
+  void drawOverview(juce::Graphics &g, int track, juce::Rectangle<int> row);
+  void drawMeter(juce::Graphics &g, int source, juce::Rectangle<int> row) const;
 
   static constexpr int kMidiMin = 0;
   static constexpr int kMidiMax = 127;
   static constexpr int kSemitone = 12;
-  static constexpr int kEncoderIndex0 = 0;
-  static constexpr int kEncoderIndex1 = 1;
-  static constexpr int kEncoderIndex2 = 2;
-  static constexpr int kEncoderIndex3 = 3;
-  static constexpr int kEncoderIndex4 = 4;
-  static constexpr int kEncoderIndex5 = 5;
+  static constexpr double kMillisecondsPerSecond = 1000.0;
+  static constexpr int kKeyCharCount = limit::kInputKeyCount;
+  static constexpr int kMeterWidth = 48;
+  static constexpr int kMeterGap = 2;
+  static constexpr float kMeterDecayPerFrame = 0.02f;
+  static constexpr int kDiagnosticsRefreshFrames = 15;
+  static constexpr int kDeviceCheckFrames = 30;
+  static constexpr auto kKeyVelocity = static_cast<juce::uint8>(100);
+  static constexpr float kPercent = 100.0f;
+  static constexpr double kSecondsPerMinute = 60.0;
+  static constexpr int kBeatsPerBar = 4;
 
   juce::String last_midi_message;
+  juce::Typeface::Ptr topaz_typeface;
+  juce::Font title_font;
+  juce::Font body_font;
+  PaintAreas paint_areas;
+  juce::Image chrome;
+  float chrome_scale = 0.0f;
+  int chrome_render_count = 0;
+  limit::UiDirtyRegions dirty_regions;
+  limit::MeterQueue meter_queue;
+  limit::MeterBallistics meter_ballistics;
+  std::vector<limit::OverviewBucket> overview_columns;
+  limit::MidiEventQueue midi_audio_queue;
+  limit::MidiEventQueue midi_display_queue;
+  limit::MidiEventQueue key_audio_queue;
+  std::array<int, kKeyCharCount> held_key_notes{};
+  juce::MidiBuffer block_midi;
+  limit::StepSequencer step_sequencer;
+  limit::StepPattern sequence_pattern;
+  limit::SynthInstrument synth_instrument;
+  // Declared before the transport and graph, which keep a pointer to it.
+  limit::RealtimeWorkerPool worker_pool;
+  limit::TapeTransport tape_transport;
+  limit::TapeMixer tape_mixer;
+  limit::ConvolutionReverb send1_reverb;
+  // Rate the reverb's impulse response was loaded at; 0 before the first.
+  double impulse_rate = 0.0;
+  limit::ParameterRegistry parameters;
+  limit::ParameterRamps parameter_ramps{parameters};
+  limit::MixParameters track_parameters{};
+  int tape_speed_parameter = -1;
+  bool tape_braking = false;
+  bool tape_reversed = false;
+  bool tape_looped = false;
+  bool tape_chopped = false;
+  limit::AppMode app_mode = limit::AppMode::kMix;
+  int mode_sub_view = 0;
+  // Declared before the graph, which keeps a pointer to it.
+  limit::AudioProfiler audio_profiler;
+  bool diagnostics_visible = false;
+  int diagnostics_frame = 0;
+  juce::String diagnostics_text;
+  limit::BufferSizeNegotiator buffer_negotiator;
+  limit::LatencyProbe latency_probe;
+  double device_setup_seconds = 0.0;
+  int device_check_frame = 0;
+  bool device_saved = true;
+  bool latency_reported = true;
+  limit::AudioGraph audio_graph;
+  std::unique_ptr<limit::TapeStorage> tape_storage;
+  std::unique_ptr<limit::PhraseStore> phrase_store;
+  std::unique_ptr<limit::ProjectJournal> project_journal;
+  int phrase_slot = 0;
+  bool phrase_journal_pending = false;
+  double current_sample_rate = 0.0;
   limit::DevControllerState dev_state{};
+  limit::InputBindings input_bindings;
   int note_octave_offset = 0;
   bool mod_active = false;
   bool sustain_active = false;
   int pitch_offset = 0;
   static constexpr int kPitchMin = -12;
   static constexpr int kPitchMax = 12;
+  // Last member so the refresh callback never sees a partly destroyed object.
+  juce::VBlankAttachment vblank_attachment{this, [this] { refreshUi(); }};
 };
 } // namespace limit
@@ -0,0 +1,68 @@
+#include "midi-event-queue.h"
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+
+namespace limit {
+auto MidiEventQueue::push(const MidiEvent &event) -> bool {
+  const auto write = write_index.load(std::memory_order_relaxed);
+  const auto read = read_index.load(std::memory_order_acquire);
+  if (write - read >= kMidiEventQueueCapacity) {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  events.at(write & kIndexMask) = event;
+  write_index.store(write + 1, std::memory_order_release);
+  return true;
+}
+
+auto MidiEventQueue::pop() -> std::optional<MidiEvent> {
+  const auto read = read_index.load(std::memory_order_relaxed);
+  const auto write = write_index.load(std::memory_order_acquire);
+  if (read == write) {
+    return std::nullopt;
+  }
+  const auto event = events.at(read & kIndexMask);
+  read_index.store(read + 1, std::memory_order_release);
+  return event;
+}
+
+auto MidiEventQueue::size() const -> std::size_t {
+  const auto read = read_index.load(std::memory_order_acquire);
+  const auto write = write_index.load(std::memory_order_acquire);
+  return write - read;
+}
+
+auto MidiEventQueue::droppedCount() const -> std::uint32_t {
+  return dropped.load(std::memory_order_relaxed);
+}
+
+auto makeMidiEvent(const std::uint8_t *data, int size, std::int64_t timestamp_ticks)
+    -> std::optional<MidiEvent> {
+  if (data == nullptr || size <= 0 || size > static_cast<int>(kMidiEventMaxBytes)) {
+    return std::nullopt;
+  }
+  const std::span<const std::uint8_t> source(data, static_cast<std::size_t>(size));
+  MidiEvent event;
+  event.timestamp_ticks = timestamp_ticks;
+  std::copy(source.begin(), source.end(), event.bytes.begin());
+  event.size = static_cast<std::uint8_t>(size);
+  return event;
+}
+
+auto midiEventSampleOffset(std::int64_t event_ticks, std::int64_t block_end_ticks,
+                           double ticks_per_second, double sample_rate, int num_samples)
+    -> int {
+  if (num_samples <= 0 || ticks_per_second <= 0.0 || sample_rate <= 0.0) {
+    return 0;
+  }
+  const auto block_ticks =
+      static_cast<double>(num_samples) / sample_rate * ticks_per_second;
+  const auto block_start_ticks = static_cast<double>(block_end_ticks) - block_ticks;
+  const auto offset_seconds =
+      (static_cast<double>(event_ticks) - block_start_ticks) / ticks_per_second;
+  const auto offset = static_cast<int>(std::floor(offset_seconds * sample_rate));
+  return std::clamp(offset, 0, num_samples - 1);
+}
+} // namespace limit
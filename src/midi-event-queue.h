@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace limit {
+constexpr std::size_t kMidiEventQueueCapacity = 1024;
+constexpr std::size_t kMidiEventMaxBytes = 3;
+// Bytes one short message takes in a juce::MidiBuffer: its sample position
+// (int32) and size (uint16) are stored ahead of the message bytes.
+constexpr int kMidiBufferBytesPerEvent =
+    static_cast<int>(sizeof(std::int32_t) + sizeof(std::uint16_t) + kMidiEventMaxBytes);
+
+// Fixed-size MIDI event. Only short messages (up to three bytes) are carried;
+// SysEx is not used by the target controllers and is dropped at the boundary.
+struct MidiEvent {
+  std::int64_t timestamp_ticks = 0;
+  std::array<std::uint8_t, kMidiEventMaxBytes> bytes{};
+  std::uint8_t size = 0;
+};
+
+// Bounded single-producer/single-consumer queue. push() and pop() are
+// wait-free and never allocate, so the MIDI thread can hand events to the
+// audio or UI thread without locks. Each producer/consumer pair needs its own
+// queue.
+class MidiEventQueue {
+public:
+  auto push(const MidiEvent &event) -> bool;
+  auto pop() -> std::optional<MidiEvent>;
+  auto size() const -> std::size_t;
+  auto droppedCount() const -> std::uint32_t;
+
+private:
+  static constexpr std::size_t kCacheLineSize = 64;
+  static constexpr std::size_t kIndexMask = kMidiEventQueueCapacity - 1;
+  static_assert((kMidiEventQueueCapacity & kIndexMask) == 0,
+                "MIDI event queue capacity must be a power of two");
+
+  std::array<MidiEvent, kMidiEventQueueCapacity> events{};
+  alignas(kCacheLineSize) std::atomic<std::size_t> write_index{0};
+  alignas(kCacheLineSize) std::atomic<std::size_t> read_index{0};
+  std::atomic<std::uint32_t> dropped{0};
+};
+
+auto makeMidiEvent(const std::uint8_t *data, int size, std::int64_t timestamp_ticks)
+    -> std::optional<MidiEvent>;
+
+// Maps an event's arrival time onto a sample offset within the block that ends
+// at block_end_ticks. Events are rendered one block late so their relative
+// spacing is preserved instead of collapsing onto sample zero.
+auto midiEventSampleOffset(std::int64_t event_ticks, std::int64_t block_end_ticks,
+                           double ticks_per_second, double sample_rate, int num_samples)
+    -> int;
+} // namespace limit
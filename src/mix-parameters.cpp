@@ -0,0 +1,51 @@
+#include "mix-parameters.h"
+
+#include <string>
+
+namespace limit {
+namespace {
+constexpr float kPercent = 100.0f;
+
+auto percentSpec(const std::string &label, float default_value) -> ParameterSpec {
+  return {.label = label,
+          .max = kPercent,
+          .default_value = default_value,
+          .unit = ParameterUnit::kPercent};
+}
+
+using RampPoint = float (ParameterRamps::*)(int) const;
+
+auto stripSettings(const ParameterRamps &ramps, const MixTrackParameters &strip, RampPoint point)
+    -> TrackMixSettings {
+  return {.level = (ramps.*point)(strip.level) / kPercent,
+          .pan = (ramps.*point)(strip.pan) / kPercent,
+          .send1 = (ramps.*point)(strip.send1) / kPercent,
+          .send2 = (ramps.*point)(strip.send2) / kPercent};
+}
+} // namespace
+
+auto addMixParameters(ParameterRegistry &registry) -> MixParameters {
+  MixParameters strips;
+  for (int track = 0; track < kTapeTrackCount; ++track) {
+    const auto number = std::to_string(track + 1);
+    auto &strip = strips.at(static_cast<std::size_t>(track));
+    strip.level = registry.add(percentSpec("LEVEL " + number, kPercent));
+    strip.pan = registry.add({.label = "PAN " + number,
+                              .min = -kPercent,
+                              .max = kPercent,
+                              .default_value = 0.0f,
+                              .unit = ParameterUnit::kNumber});
+    strip.send1 = registry.add(percentSpec("SEND1 " + number, 0.0f));
+    strip.send2 = registry.add(percentSpec("SEND2 " + number, 0.0f));
+  }
+  return strips;
+}
+
+void applyMixRamps(const ParameterRamps &ramps, const MixParameters &strips, TapeMixer &mixer) {
+  for (int track = 0; track < kTapeTrackCount; ++track) {
+    const auto &strip = strips.at(static_cast<std::size_t>(track));
+    mixer.setTrackRamp(track, stripSettings(ramps, strip, &ParameterRamps::blockStart),
+                       stripSettings(ramps, strip, &ParameterRamps::blockEnd));
+  }
+}
+} // namespace limit
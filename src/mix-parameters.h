@@ -0,0 +1,26 @@
+#pragma once
+
+#include <array>
+
+#include "parameter-registry.h"
+#include "tape-mixer.h"
+
+namespace limit {
+// Parameter ids of one tape track's mixer strip.
+struct MixTrackParameters {
+  int level = -1;
+  int pan = -1;
+  int send1 = -1;
+  int send2 = -1;
+};
+
+using MixParameters = std::array<MixTrackParameters, kTapeTrackCount>;
+
+// Message thread. Adds LEVEL, PAN, SEND1 and SEND2 for every tape track:
+// level and sends in percent, pan from -100 to 100.
+auto addMixParameters(ParameterRegistry &registry) -> MixParameters;
+
+// Audio thread, after ramps.beginBlock(): hands every strip's start and end
+// for the block to the mixer, which applies them without smoothing again.
+void applyMixRamps(const ParameterRamps &ramps, const MixParameters &strips, TapeMixer &mixer);
+} // namespace limit
@@ -0,0 +1,402 @@
+#include "offline-renderer.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace limit {
+namespace {
+constexpr int kMidiReserveBytes = 16384;
+constexpr std::uint16_t kWavFormatIeeeFloat = 3;
+constexpr std::uint16_t kBitsPerSample = 32;
+constexpr std::uint32_t kFmtChunkBytes = 16;
+constexpr std::uint32_t kRiffHeaderBytes = 36;
+
+using Clock = std::chrono::steady_clock;
+
+auto makePlaceholderVoice() -> std::unique_ptr<VoiceEngine> {
+  return std::make_unique<SineVoiceEngine>();
+}
+
+// Canonical 44-byte header for 32-bit float stereo.
+struct WavHeader {
+  std::array<char, 4> riff_tag{'R', 'I', 'F', 'F'};
+  std::uint32_t riff_bytes = kRiffHeaderBytes;
+  std::array<char, 4> wave_tag{'W', 'A', 'V', 'E'};
+  std::array<char, 4> fmt_tag{'f', 'm', 't', ' '};
+  std::uint32_t fmt_bytes = kFmtChunkBytes;
+  std::uint16_t format = kWavFormatIeeeFloat;
+  std::uint16_t channels = kStereoChannelCount;
+  std::uint32_t sample_rate = 0;
+  std::uint32_t byte_rate = 0;
+  std::uint16_t block_align = sizeof(float) * kStereoChannelCount;
+  std::uint16_t bits_per_sample = kBitsPerSample;
+  std::array<char, 4> data_tag{'d', 'a', 't', 'a'};
+  std::uint32_t data_bytes = 0;
+};
+
+static_assert(std::endian::native == std::endian::little,
+              "Render WAV headers are written in host byte order");
+static_assert(sizeof(WavHeader) == 44, "WAV header must be tightly packed");
+
+// Streams interleaved frames after a placeholder header and fills in the
+// sizes once the length is known.
+class WavFileWriter {
+public:
+  WavFileWriter(const std::filesystem::path &path, double sample_rate)
+      : file(path, std::ios::binary | std::ios::trunc) {
+    header.sample_rate = static_cast<std::uint32_t>(sample_rate);
+    header.byte_rate = header.sample_rate * header.block_align;
+    writeHeader();
+  }
+
+  auto write(std::span<const float> left, std::span<const float> right) -> bool {
+    interleaved.resize(left.size() * kStereoChannelCount);
+    for (std::size_t frame = 0; frame < left.size(); ++frame) {
+      interleaved[frame * kStereoChannelCount] = left[frame];
+      interleaved[(frame * kStereoChannelCount) + 1] = right[frame];
+    }
+    const auto bytes = std::as_bytes(std::span(interleaved));
+    file.write(reinterpret_cast<const char *>(bytes.data()), // NOLINT
+               static_cast<std::streamsize>(bytes.size()));
+    header.data_bytes += static_cast<std::uint32_t>(bytes.size());
+    return static_cast<bool>(file);
+  }
+
+  auto finish() -> bool {
+    header.riff_bytes = kRiffHeaderBytes + header.data_bytes;
+    file.seekp(0);
+    writeHeader();
+    file.close();
+    return !file.fail();
+  }
+
+  auto isOpen() const -> bool { return file.is_open() && static_cast<bool>(file); }
+
+private:
+  void writeHeader() {
+    std::array<char, sizeof(WavHeader)> bytes{};
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    file.write(bytes.data(), bytes.size());
+  }
+
+  std::ofstream file;
+  WavHeader header;
+  std::vector<float> interleaved;
+};
+} // namespace
+
+// Wraps a live node and accumulates the wall time spent in it.
+class OfflineRenderer::TimedStage final : public AudioGraphNode {
+public:
+  explicit TimedStage(AudioGraphNode &stage) : inner(&stage) {}
+
+  void prepare(double sample_rate, int max_block_size) override {
+    inner->prepare(sample_rate, max_block_size);
+  }
+
+  void process(AudioGraphBuses &buses, const juce::MidiBuffer &midi, int num_samples) override {
+    const auto started = Clock::now();
+    inner->process(buses, midi, num_samples);
+    elapsed += Clock::now() - started;
+  }
+
+  auto seconds() const -> double { return std::chrono::duration<double>(elapsed).count(); }
+  void resetTime() { elapsed = {}; }
+
+private:
+  AudioGraphNode *inner;
+  Clock::duration elapsed{};
+};
+
+auto OfflineRenderer::open(const OfflineRenderConfig &config)
+    -> std::unique_ptr<OfflineRenderer> {
+  if (config.sample_rate <= 0.0 || config.block_size <= 0) {
+    return nullptr;
+  }
+  auto renderer = std::unique_ptr<OfflineRenderer>(new OfflineRenderer(config));
+  if (config.project.empty()) {
+    return renderer;
+  }
+  renderer->phrase_store = PhraseStore::open(config.project / "phrases.bin");
+  const auto tape_directory = config.project / "tape";
+  std::error_code error;
+  if (!std::filesystem::is_directory(tape_directory, error)) {
+    return renderer;
+  }
+  // A tape directory with missing or short track files is a broken project,
+  // not one to fill with silence.
+  renderer->tape_storage =
+      TapeStorage::open({.directory = tape_directory,
+                         .sample_rate = static_cast<int>(config.sample_rate),
+                         .create_missing = false});
+  if (renderer->tape_storage == nullptr) {
+    return nullptr;
+  }
+  renderer->tape_transport.setStorage(renderer->tape_storage.get());
+  return renderer;
+}
+
+OfflineRenderer::OfflineRenderer(const OfflineRenderConfig &render_config)
+    : config(render_config), synth_instrument(makePlaceholderVoice),
+      output(kStereoChannelCount, render_config.block_size) {
+  install(SignalNode::kInstrument, synth_instrument);
+  install(SignalNode::kTapeTracks, tape_transport);
+  install(SignalNode::kTrackMix, tape_mixer);
+  install(SignalNode::kSend1Effect, send1_reverb);
+  mix_parameters = addMixParameters(parameters);
+  send1_reverb.setImpulseResponse(makeRoomToHallImpulse(render_config.sample_rate),
+                                  render_config.sample_rate);
+  block_midi.ensureSize(kMidiReserveBytes);
+}
+
+OfflineRenderer::~OfflineRenderer() {
+  tape_transport.setStorage(nullptr);
+  if (tape_storage != nullptr) {
+    tape_storage->flush();
+  }
+}
+
+auto OfflineRenderer::hasTape() const -> bool { return tape_storage != nullptr; }
+
+auto OfflineRenderer::hasPhrases() const -> bool { return phrase_store != nullptr; }
+
+void OfflineRenderer::install(SignalNode node, AudioGraphNode &processor) {
+  auto &stage = stages.at(signalNodeIndex(node));
+  stage = std::make_unique<TimedStage>(processor);
+  audio_graph.setNode(node, stage.get());
+}
+
+auto OfflineRenderer::render(const RenderScript &script, const BlockSink &sink)
+    -> OfflineRenderResult {
+  if (script.length_frames <= 0) {
+    return {};
+  }
+
+  const auto started = Clock::now();
+  reset();
+  OfflineRenderResult result;
+  const auto underruns_before = tape_transport.underrunCount();
+  Clock::duration graph_time{};
+  Clock::duration tape_time{};
+  std::size_t next_event = 0;
+  std::int64_t position = 0;
+  while (position < script.length_frames) {
+    // Controller events apply at block starts, so blocks are cut at them;
+    // MIDI events land on their exact frame inside a block.
+    auto end = std::min<std::int64_t>(position + config.block_size, script.length_frames);
+    for (auto index = next_event; index < script.events.size(); ++index) {
+      const auto &event = script.events[index];
+      if (event.frame >= end) {
+        break;
+      }
+      if (event.command != RenderCommand::kMidi && event.frame > position) {
+        end = event.frame;
+        break;
+      }
+    }
+
+    block_midi.clear();
+    for (; next_event < script.events.size() && script.events[next_event].frame < end;
+         ++next_event) {
+      const auto &event = script.events[next_event];
+      if (event.command == RenderCommand::kMidi) {
+        block_midi.addEvent(event.midi.data(), event.midi_size,
+                            static_cast<int>(std::max<std::int64_t>(event.frame - position, 0)));
+      } else {
+        applyEvent(event);
+      }
+    }
+
+    const auto num_samples = static_cast<int>(end - position);
+    step_sequencer.process(block_midi, num_samples);
+    parameter_ramps.beginBlock(num_samples);
+    applyMixRamps(parameter_ramps, mix_parameters, tape_mixer);
+    tape_time += serviceTape();
+    const auto block_started = Clock::now();
+    audio_graph.process(block_midi, output, 0, num_samples);
+    graph_time += Clock::now() - block_started;
+
+    const auto count = static_cast<std::size_t>(num_samples);
+    if (!sink(position, std::span<const float>(output.getReadPointer(0), count),
+              std::span<const float>(output.getReadPointer(1), count))) {
+      break;
+    }
+    position = end;
+  }
+
+  const std::chrono::duration<double> elapsed = Clock::now() - started - tape_time;
+  result.completed = position == script.length_frames;
+  result.frames_rendered = position;
+  result.render_seconds = elapsed.count();
+  if (result.render_seconds > 0.0) {
+    result.realtime_factor =
+        static_cast<double>(position) / config.sample_rate / result.render_seconds;
+  }
+  result.tape_seconds = std::chrono::duration<double>(tape_time).count();
+  result.graph_seconds = std::chrono::duration<double>(graph_time).count();
+  for (std::size_t node = 0; node < stages.size(); ++node) {
+    if (stages.at(node) != nullptr) {
+      result.stage_seconds.at(node) = stages.at(node)->seconds();
+    }
+  }
+  result.tape_underruns = tape_transport.underrunCount() - underruns_before;
+  return result;
+}
+
+auto OfflineRenderer::renderToWav(const RenderScript &script, const std::filesystem::path &path)
+    -> OfflineRenderResult {
+  WavFileWriter writer(path, config.sample_rate);
+  if (!writer.isOpen()) {
+    return {};
+  }
+  auto result = render(script, [&writer](std::int64_t /*offset*/, std::span<const float> left,
+                                         std::span<const float> right) {
+    return writer.write(left, right);
+  });
+  if (!writer.finish()) {
+    result.completed = false;
+  }
+  return result;
+}
+
+// Every render starts from the state the app has after prepareToPlay: no
+// voices, tape stopped at the start, sequencer stopped, mixer at defaults.
+void OfflineRenderer::reset() {
+  tape_transport.stop();
+  tape_transport.setSpeed(1.0f);
+  tape_transport.setReverse(false);
+  tape_transport.setBrake(false);
+  tape_transport.clearLoop();
+  tape_transport.locate(0);
+  if (tape_storage != nullptr) {
+    tape_storage->setPlayhead(0);
+    tape_storage->setLoop(0, 0);
+  }
+  serviced_chunk = -1;
+  step_sequencer.stop();
+  step_sequencer.setTempo(kDefaultTempoBpm);
+  step_sequencer.setPattern(StepPattern{});
+  for (int id = 0; id < parameters.count(); ++id) {
+    parameters.resetToDefault(id);
+  }
+
+  step_sequencer.prepare(config.sample_rate);
+  parameter_ramps.prepare(config.sample_rate);
+  audio_graph.prepare(config.sample_rate, config.block_size);
+  for (auto &stage : stages) {
+    if (stage != nullptr) {
+      stage->resetTime();
+    }
+  }
+}
+
+void OfflineRenderer::applyEvent(const RenderEvent &event) {
+  switch (event.command) {
+  case RenderCommand::kMidi:
+    break;
+  case RenderCommand::kTapePlay:
+    tape_transport.play();
+    break;
+  case RenderCommand::kTapeStop:
+    tape_transport.stop();
+    break;
+  case RenderCommand::kTapeLocate:
+    tape_transport.locate(static_cast<std::int64_t>(event.value));
+    if (tape_storage != nullptr) {
+      tape_storage->setPlayhead(static_cast<std::int64_t>(event.value));
+    }
+    break;
+  case RenderCommand::kTapeSpeed:
+    tape_transport.setSpeed(static_cast<float>(event.value));
+    break;
+  case RenderCommand::kTapeReverse:
+    tape_transport.setReverse(event.value > 0.0);
+    break;
+  case RenderCommand::kTapeBrake:
+    tape_transport.setBrake(event.value > 0.0);
+    break;
+  case RenderCommand::kTapeLoop:
+    tape_transport.setLoop(static_cast<std::int64_t>(event.value), event.end_frame);
+    // Page the loop start in now, since the playhead may reach the loop end
+    // without crossing into another chunk first.
+    if (tape_storage != nullptr) {
+      tape_storage->setLoop(static_cast<std::int64_t>(event.value), event.end_frame);
+      serviced_chunk = -1;
+    }
+    break;
+  case RenderCommand::kTapeLoopOff:
+    tape_transport.clearLoop();
+    if (tape_storage != nullptr) {
+      tape_storage->setLoop(0, 0);
+    }
+    break;
+  case RenderCommand::kMixLevel:
+  case RenderCommand::kMixPan:
+  case RenderCommand::kMixSend1:
+  case RenderCommand::kMixSend2:
+    setMix(event.track, event.command, event.value);
+    break;
+  case RenderCommand::kPhrase:
+    if (phrase_store != nullptr) {
+      if (const auto *record = phrase_store->phrase(static_cast<int>(event.value))) {
+        step_sequencer.setPattern(record->pattern);
+      }
+    }
+    break;
+  case RenderCommand::kSequencerPlay:
+    step_sequencer.start();
+    break;
+  case RenderCommand::kSequencerStop:
+    step_sequencer.stop();
+    break;
+  case RenderCommand::kTempo:
+    step_sequencer.setTempo(event.value);
+    break;
+  }
+}
+
+auto OfflineRenderer::serviceTape() -> Clock::duration {
+  if (tape_storage == nullptr) {
+    return {};
+  }
+  const auto chunk = tape_storage->playhead() / kTapeChunkFrames;
+  if (chunk == serviced_chunk) {
+    return {};
+  }
+  const auto started = Clock::now();
+  tape_storage->service();
+  serviced_chunk = chunk;
+  return Clock::now() - started;
+}
+
+// Script values are in the units the encoders show, so they land on the
+// same parameters and ramp exactly as an encoder move would.
+void OfflineRenderer::setMix(int track, RenderCommand command, double value) {
+  if (track < 0 || track >= kTapeTrackCount) {
+    return;
+  }
+  const auto &strip = mix_parameters.at(static_cast<std::size_t>(track));
+  auto id = -1;
+  switch (command) {
+  case RenderCommand::kMixLevel:
+    id = strip.level;
+    break;
+  case RenderCommand::kMixPan:
+    id = strip.pan;
+    break;
+  case RenderCommand::kMixSend1:
+    id = strip.send1;
+    break;
+  case RenderCommand::kMixSend2:
+    id = strip.send2;
+    break;
+  default:
+    return;
+  }
+  parameters.setNormalised(id, valueToNormalised(parameters.spec(id), static_cast<float>(value)));
+}
+} // namespace limit
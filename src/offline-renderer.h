@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+
+#include "audio-graph.h"
+#include "convolution-reverb.h"
+#include "mix-parameters.h"
+#include "parameter-registry.h"
+#include "phrase-store.h"
+#include "render-script.h"
+#include "step-sequencer.h"
+#include "synth-instrument.h"
+#include "tape-mixer.h"
+#include "tape-storage.h"
+#include "tape-transport.h"
+
+namespace limit {
+struct OfflineRenderConfig {
+  // Project directory holding tape/ and phrases.bin, as the app keeps them.
+  // Empty renders without tape or phrases, and so does a project without a
+  // tape/ directory; rendering never creates tape files.
+  std::filesystem::path project;
+  double sample_rate = kTapeSampleRate;
+  int block_size = 256;
+};
+
+struct OfflineRenderResult {
+  bool completed = false;
+  std::int64_t frames_rendered = 0;
+  double render_seconds = 0.0;
+  double realtime_factor = 0.0;
+  // Paging tape in on the rendering thread, which render_seconds and
+  // realtime_factor leave out since the app does it on the service thread.
+  double tape_seconds = 0.0;
+  // Whole graph, and the stages that have a node; pass-through stages only
+  // show up in the graph total.
+  double graph_seconds = 0.0;
+  std::array<double, kSignalNodeCount> stage_seconds{};
+  std::uint64_t tape_underruns = 0;
+};
+
+// Renders the full signal chain from a script, with no audio device, as fast
+// as the CPU allows. The renderer owns a graph and node instances built from
+// the same classes as the live app and runs the sequencer ahead of the graph
+// as the audio callback does, and mix changes go through the same parameter
+// ramps. Tape is paged in on the rendering thread whenever the playhead
+// enters another chunk instead of by the service thread, and the Send 1
+// reverb computes its tail inline with the built-in response, so the same
+// project, script and block size always produce the same samples.
+class OfflineRenderer {
+public:
+  using BlockSink = std::function<bool(std::int64_t offset, std::span<const float> left,
+                                       std::span<const float> right)>;
+
+  static auto open(const OfflineRenderConfig &config) -> std::unique_ptr<OfflineRenderer>;
+
+  ~OfflineRenderer();
+  OfflineRenderer(const OfflineRenderer &) = delete;
+  auto operator=(const OfflineRenderer &) -> OfflineRenderer & = delete;
+  OfflineRenderer(OfflineRenderer &&) = delete;
+  auto operator=(OfflineRenderer &&) -> OfflineRenderer & = delete;
+
+  auto render(const RenderScript &script, const BlockSink &sink) -> OfflineRenderResult;
+  // Writes 32-bit float stereo WAV with a fixed header and no metadata, so
+  // identical renders give identical files.
+  auto renderToWav(const RenderScript &script, const std::filesystem::path &path)
+      -> OfflineRenderResult;
+
+  auto hasTape() const -> bool;
+  auto hasPhrases() const -> bool;
+
+private:
+  class TimedStage;
+
+  explicit OfflineRenderer(const OfflineRenderConfig &config);
+
+  void reset();
+  // Pages in the window around the playhead when it has entered another
+  // chunk since the last call; returns the time spent.
+  auto serviceTape() -> std::chrono::steady_clock::duration;
+  void applyEvent(const RenderEvent &event);
+  void setMix(int track, RenderCommand command, double value);
+  void install(SignalNode node, AudioGraphNode &processor);
+
+  OfflineRenderConfig config;
+  std::unique_ptr<TapeStorage> tape_storage;
+  std::unique_ptr<PhraseStore> phrase_store;
+  SynthInstrument synth_instrument;
+  TapeTransport tape_transport;
+  TapeMixer tape_mixer;
+  ConvolutionReverb send1_reverb;
+  StepSequencer step_sequencer;
+  ParameterRegistry parameters;
+  ParameterRamps parameter_ramps{parameters};
+  MixParameters mix_parameters{};
+  std::int64_t serviced_chunk = -1;
+  std::array<std::unique_ptr<TimedStage>, kSignalNodeCount> stages;
+  AudioGraph audio_graph;
+  juce::AudioBuffer<float> output;
+  juce::MidiBuffer block_midi;
+};
+} // namespace limit
@@ -0,0 +1,127 @@
+#include "oscillator-bank.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace limit {
+namespace {
+// Two-sample table for idle lanes: phase stays at zero and reads silence.
+constexpr std::array<float, 2> kSilentLevel{};
+constexpr std::uint32_t kSilentSizeBits = 1;
+constexpr double kPhaseScale = 4294967296.0;
+constexpr float kFractionScale = 1.0f / 16777216.0f;
+
+auto isValidLane(int lane) -> bool { return lane >= 0 && lane < kMaxVoices; }
+} // namespace
+
+void OscillatorBank::prepare(double new_sample_rate, int new_max_block_size) {
+  sample_rate = new_sample_rate;
+  max_block_size = std::max(new_max_block_size, 1);
+  output.assign(static_cast<std::size_t>(max_block_size) * kMaxVoices, 0.0f);
+  for (int lane = 0; lane < kMaxVoices; ++lane) {
+    stopLane(lane);
+  }
+}
+
+void OscillatorBank::startLane(int lane, const Wavetable &table, double frequency_hz) {
+  if (!isValidLane(lane)) {
+    return;
+  }
+  const auto index = static_cast<std::size_t>(lane);
+  lane_tables.at(index) = &table;
+  phases.at(index) = 0;
+  setLaneFrequency(lane, frequency_hz);
+}
+
+void OscillatorBank::setLaneFrequency(int lane, double frequency_hz) {
+  if (!isValidLane(lane)) {
+    return;
+  }
+  const auto index = static_cast<std::size_t>(lane);
+  const auto cycles = sample_rate > 0.0 ? std::clamp(frequency_hz / sample_rate, 0.0, 0.5) : 0.0;
+  increments.at(index) = static_cast<std::uint32_t>(std::min(cycles * kPhaseScale,
+                                                             kPhaseScale - 1.0));
+  selectLevel(index);
+}
+
+void OscillatorBank::stopLane(int lane) {
+  if (!isValidLane(lane)) {
+    return;
+  }
+  const auto index = static_cast<std::size_t>(lane);
+  lane_tables.at(index) = nullptr;
+  increments.at(index) = 0;
+  phases.at(index) = 0;
+  selectLevel(index);
+}
+
+auto OscillatorBank::laneLevel(int lane) const -> int {
+  return isValidLane(lane) ? levels.at(static_cast<std::size_t>(lane)) : -1;
+}
+
+void OscillatorBank::selectLevel(std::size_t lane) {
+  const auto *table = lane_tables.at(lane);
+  if (table == nullptr) {
+    levels.at(lane) = -1;
+    lane_samples.at(lane) = kSilentLevel;
+    size_bits.at(lane) = kSilentSizeBits;
+    index_shifts.at(lane) = kPhaseBits - kSilentSizeBits;
+    return;
+  }
+  const auto level = table->levelForIncrement(static_cast<double>(increments.at(lane)) /
+                                              kPhaseScale);
+  const auto bits = static_cast<std::uint32_t>(
+      std::countr_zero(static_cast<unsigned>(Wavetable::levelSize(level))));
+  levels.at(lane) = level;
+  lane_samples.at(lane) = table->level(level);
+  size_bits.at(lane) = bits;
+  index_shifts.at(lane) = kPhaseBits - bits;
+}
+
+void OscillatorBank::render(int num_samples) {
+  const auto count = static_cast<std::size_t>(std::clamp(num_samples, 0, max_block_size));
+  const std::span<std::uint32_t, kMaxVoices> lane_phases(phases);
+  const std::span<const std::uint32_t, kMaxVoices> lane_increments(increments);
+  const std::span<const std::uint32_t, kMaxVoices> lane_shifts(index_shifts);
+  const std::span<const std::uint32_t, kMaxVoices> lane_bits(size_bits);
+  const std::span<const std::span<const float>, kMaxVoices> tables(lane_samples);
+  for (std::size_t sample = 0; sample < count; ++sample) {
+    const auto frame = std::span(output).subspan(sample * kMaxVoices, kMaxVoices);
+    for (std::size_t lane = 0; lane < kMaxVoices; ++lane) {
+      const auto phase = lane_phases[lane];
+      const auto index = phase >> lane_shifts[lane];
+      const auto fraction =
+          static_cast<float>((phase << lane_bits[lane]) >> (kPhaseBits - kFractionBits)) *
+          kFractionScale;
+      const auto current = tables[lane][index];
+      const auto next = tables[lane][index + 1];
+      frame[lane] = current + (fraction * (next - current));
+      lane_phases[lane] = phase + lane_increments[lane];
+    }
+  }
+}
+
+auto OscillatorBank::laneSample(int lane, int sample) const -> float {
+  if (!isValidLane(lane) || sample < 0 || sample >= max_block_size) {
+    return 0.0f;
+  }
+  return output.at((static_cast<std::size_t>(sample) * kMaxVoices) +
+                   static_cast<std::size_t>(lane));
+}
+
+void OscillatorBank::addLane(int lane, std::span<float> destination, float gain) const {
+  if (!isValidLane(lane)) {
+    return;
+  }
+  const auto count = std::min(destination.size(), static_cast<std::size_t>(max_block_size));
+  const auto source = std::span(output).subspan(static_cast<std::size_t>(lane));
+  for (std::size_t sample = 0; sample < count; ++sample) {
+    destination[sample] += gain * source[sample * kMaxVoices];
+  }
+}
+
+auto OscillatorBank::memoryBytes() const -> std::size_t {
+  return sizeof(*this) + (output.capacity() * sizeof(float));
+}
+} // namespace limit
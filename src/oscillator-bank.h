@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "voice-allocator.h"
+#include "wavetable.h"
+
+namespace limit {
+// Wavetable oscillators for every voice, rendered together. State is kept
+// structure-of-arrays with one lane per voice, and each sample is computed
+// for all lanes at once into a sample-major scratch buffer, so the phase,
+// index and interpolation maths vectorise across voices. Idle lanes read a
+// silent table, which keeps the cost flat regardless of how many notes sound.
+// Phases are 32-bit fixed point so wrapping is free. The mip level is chosen
+// when the frequency changes, never per sample.
+class OscillatorBank {
+public:
+  void prepare(double sample_rate, int max_block_size);
+
+  void startLane(int lane, const Wavetable &table, double frequency_hz);
+  void setLaneFrequency(int lane, double frequency_hz);
+  void stopLane(int lane);
+  auto laneLevel(int lane) const -> int;
+
+  void render(int num_samples);
+  auto laneSample(int lane, int sample) const -> float;
+  void addLane(int lane, std::span<float> destination, float gain) const;
+
+  auto memoryBytes() const -> std::size_t;
+
+private:
+  static constexpr std::uint32_t kPhaseBits = 32;
+  static constexpr std::uint32_t kFractionBits = 24;
+
+  void selectLevel(std::size_t lane);
+
+  double sample_rate = 0.0;
+  int max_block_size = 0;
+  std::array<const Wavetable *, kMaxVoices> lane_tables{};
+  std::array<std::span<const float>, kMaxVoices> lane_samples{};
+  std::array<std::uint32_t, kMaxVoices> phases{};
+  std::array<std::uint32_t, kMaxVoices> increments{};
+  std::array<std::uint32_t, kMaxVoices> index_shifts{};
+  std::array<std::uint32_t, kMaxVoices> size_bits{};
+  std::array<int, kMaxVoices> levels{};
+  std::vector<float> output;
+};
+} // namespace limit
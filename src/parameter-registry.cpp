@@ -0,0 +1,222 @@
+#include "parameter-registry.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+
+namespace limit {
+namespace {
+constexpr float kKiloHertz = 1000.0f;
+constexpr float kCompactHertzFrom = 10000.0f;
+constexpr int kMillisecondsPerSecond = 1000;
+constexpr std::size_t kFormatBufferBytes = 16;
+
+auto isLinear(const ParameterSpec &spec) -> bool {
+  return juce::exactlyEqual(spec.skew, 1.0f) || spec.skew <= 0.0f;
+}
+
+auto choiceIndex(const ParameterSpec &spec, float value) -> std::size_t {
+  const auto last = static_cast<long>(spec.choices.size()) - 1;
+  return static_cast<std::size_t>(std::clamp(std::lround(value), 0L, std::max(last, 0L)));
+}
+} // namespace
+
+auto normalisedToValue(const ParameterSpec &spec, float normalised) -> float {
+  auto proportion = std::clamp(normalised, 0.0f, 1.0f);
+  if (!isLinear(spec)) {
+    proportion = std::pow(proportion, 1.0f / spec.skew);
+  }
+  const auto value = spec.min + ((spec.max - spec.min) * proportion);
+  return spec.unit == ParameterUnit::kChoice ? std::round(value) : value;
+}
+
+auto valueToNormalised(const ParameterSpec &spec, float value) -> float {
+  if (!(spec.max > spec.min)) {
+    return 0.0f;
+  }
+  const auto proportion = std::clamp((value - spec.min) / (spec.max - spec.min), 0.0f, 1.0f);
+  return isLinear(spec) ? proportion : std::pow(proportion, spec.skew);
+}
+
+// Follows the value formatting standards in docs/visual-design.md: units are
+// implied, numbers are bare and enums are upper case.
+auto formatParameterValue(const ParameterSpec &spec, float value) -> std::string {
+  std::array<char, kFormatBufferBytes> text{};
+  const auto rounded = static_cast<int>(std::lround(value));
+  switch (spec.unit) {
+  case ParameterUnit::kHertz:
+    if (value >= kCompactHertzFrom) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+      std::snprintf(text.data(), text.size(), "%.1fK", static_cast<double>(value / kKiloHertz));
+      return text.data();
+    }
+    return std::to_string(rounded);
+  case ParameterUnit::kMilliseconds:
+    if (rounded >= kMillisecondsPerSecond) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+      std::snprintf(text.data(), text.size(), "%d:%03d", rounded / kMillisecondsPerSecond,
+                    rounded % kMillisecondsPerSecond);
+      return text.data();
+    }
+    return std::to_string(rounded);
+  case ParameterUnit::kSemitones:
+    return rounded > 0 ? "+" + std::to_string(rounded) : std::to_string(rounded);
+  case ParameterUnit::kChoice: {
+    if (spec.choices.empty()) {
+      return std::to_string(rounded);
+    }
+    std::string label(spec.choices[choiceIndex(spec, value)]);
+    std::transform(label.begin(), label.end(), label.begin(), [](unsigned char letter) {
+      return static_cast<char>(std::toupper(letter));
+    });
+    return label;
+  }
+  case ParameterUnit::kNumber:
+  case ParameterUnit::kPercent:
+    break;
+  }
+  return std::to_string(rounded);
+}
+
+ParameterRegistry::ParameterRegistry() { bindings.fill(-1); }
+
+auto ParameterRegistry::add(ParameterSpec spec) -> int {
+  const auto id = parameter_count.load(std::memory_order_relaxed);
+  if (id >= kMaxParameters) {
+    return -1;
+  }
+  if (spec.unit == ParameterUnit::kChoice) {
+    spec.min = 0.0f;
+    spec.max = static_cast<float>(std::max<std::size_t>(spec.choices.size(), 1) - 1);
+    spec.smoothing_seconds = 0.0;
+  }
+  const auto slot = static_cast<std::size_t>(id);
+  values.at(slot).store(valueToNormalised(spec, spec.default_value), std::memory_order_relaxed);
+  specs.at(slot) = std::move(spec);
+  parameter_count.store(id + 1, std::memory_order_release);
+  return id;
+}
+
+auto ParameterRegistry::bind(const ParameterAddress &address, int id) -> bool {
+  const auto index = bindingIndex(address);
+  if (index < 0 || !isValid(id)) {
+    return false;
+  }
+  bindings.at(static_cast<std::size_t>(index)) = id;
+  return true;
+}
+
+auto ParameterRegistry::lookup(const ParameterAddress &address) const -> int {
+  const auto index = bindingIndex(address);
+  return index < 0 ? -1 : bindings.at(static_cast<std::size_t>(index));
+}
+
+auto ParameterRegistry::count() const -> int {
+  return parameter_count.load(std::memory_order_acquire);
+}
+
+auto ParameterRegistry::spec(int id) const -> const ParameterSpec & {
+  return specs.at(static_cast<std::size_t>(id));
+}
+
+void ParameterRegistry::setNormalised(int id, float normalised) {
+  if (isValid(id)) {
+    values.at(static_cast<std::size_t>(id))
+        .store(std::clamp(normalised, 0.0f, 1.0f), std::memory_order_relaxed);
+  }
+}
+
+auto ParameterRegistry::normalised(int id) const -> float {
+  return isValid(id) ? values.at(static_cast<std::size_t>(id)).load(std::memory_order_relaxed)
+                     : 0.0f;
+}
+
+auto ParameterRegistry::value(int id) const -> float {
+  return isValid(id) ? normalisedToValue(spec(id), normalised(id)) : 0.0f;
+}
+
+auto ParameterRegistry::format(int id) const -> std::string {
+  return isValid(id) ? formatParameterValue(spec(id), value(id)) : std::string();
+}
+
+void ParameterRegistry::nudge(int id, float steps) {
+  if (!isValid(id)) {
+    return;
+  }
+  const auto &parameter = spec(id);
+  const auto step = parameter.unit == ParameterUnit::kChoice && parameter.max > 0.0f
+                        ? 1.0f / parameter.max
+                        : 1.0f / static_cast<float>(kEncoderSteps);
+  // A compare-exchange loop, so nudges from different threads all land.
+  auto &value = values.at(static_cast<std::size_t>(id));
+  auto current = value.load(std::memory_order_relaxed);
+  while (!value.compare_exchange_weak(current, std::clamp(current + (step * steps), 0.0f, 1.0f),
+                                      std::memory_order_relaxed)) {
+  }
+}
+
+void ParameterRegistry::resetToDefault(int id) {
+  if (isValid(id)) {
+    setNormalised(id, valueToNormalised(spec(id), spec(id).default_value));
+  }
+}
+
+auto ParameterRegistry::bindingIndex(const ParameterAddress &address) -> int {
+  const auto mode = static_cast<int>(address.mode);
+  if (mode >= kAppModeCount || address.sub_view < 0 || address.sub_view >= kMaxSubViews ||
+      address.bank < 0 || address.bank >= kDevBankCount || address.encoder < 0 ||
+      address.encoder >= kDevEncoderCount) {
+    return -1;
+  }
+  return (((((mode * kMaxSubViews) + address.sub_view) * kDevBankCount) + address.bank) *
+          kDevEncoderCount) +
+         address.encoder;
+}
+
+auto ParameterRegistry::isValid(int id) const -> bool { return id >= 0 && id < count(); }
+
+ParameterRamps::ParameterRamps(const ParameterRegistry &registry) : parameters(registry) {}
+
+void ParameterRamps::prepare(double sample_rate) {
+  for (int id = 0; id < parameters.count(); ++id) {
+    const auto slot = static_cast<std::size_t>(id);
+    const auto value = parameters.value(id);
+    auto &smoother = smoothers.at(slot);
+    smoother.reset(sample_rate, parameters.spec(id).smoothing_seconds);
+    smoother.setCurrentAndTargetValue(value);
+    starts.at(slot) = value;
+    ends.at(slot) = value;
+  }
+}
+
+void ParameterRamps::beginBlock(int num_samples) {
+  for (int id = 0; id < parameters.count(); ++id) {
+    const auto slot = static_cast<std::size_t>(id);
+    auto &smoother = smoothers.at(slot);
+    smoother.setTargetValue(parameters.value(id));
+    starts.at(slot) = smoother.getCurrentValue();
+    ends.at(slot) = smoother.skip(num_samples);
+  }
+}
+
+auto ParameterRamps::blockStart(int id) const -> float {
+  return starts.at(static_cast<std::size_t>(id));
+}
+
+auto ParameterRamps::blockEnd(int id) const -> float {
+  return ends.at(static_cast<std::size_t>(id));
+}
+
+// Linear from the block start to the block end, reaching the end on the
+// last sample, so consecutive blocks join without a step.
+void ParameterRamps::fill(int id, std::span<float> values) const {
+  const auto start = blockStart(id);
+  const auto delta = blockEnd(id) - start;
+  const auto count = static_cast<float>(values.size());
+  for (std::size_t index = 0; index < values.size(); ++index) {
+    values[index] = start + (delta * static_cast<float>(index + 1) / count);
+  }
+}
+} // namespace limit
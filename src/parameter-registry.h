@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include "dev-controller.h"
+
+namespace limit {
+constexpr int kMaxParameters = 256;
+constexpr int kAppModeCount = 4;
+constexpr int kMaxSubViews = 4;
+constexpr int kEncoderSteps = 127;
+constexpr double kDefaultSmoothingSeconds = 0.02;
+
+enum class AppMode : std::uint8_t { kSound, kSequence, kTape, kMix };
+
+// How a value is shown in an encoder cell (docs/visual-design.md).
+enum class ParameterUnit : std::uint8_t {
+  kNumber,
+  kPercent,
+  kHertz,
+  kMilliseconds,
+  kSemitones,
+  kChoice,
+};
+
+// Static description of one parameter. skew works like JUCE's
+// NormalisableRange: 1 is linear, below 1 gives the low end more of the
+// encoder travel (frequencies, times). Choice parameters step through
+// choices and are never smoothed.
+struct ParameterSpec {
+  std::string label;
+  float min = 0.0f;
+  float max = 1.0f;
+  float default_value = 0.0f;
+  float skew = 1.0f;
+  ParameterUnit unit = ParameterUnit::kNumber;
+  std::span<const std::string_view> choices{};
+  double smoothing_seconds = kDefaultSmoothingSeconds;
+};
+
+// Where a parameter sits on the controls: the mode and sub-view that show
+// it, then the encoder bank and encoder.
+struct ParameterAddress {
+  AppMode mode = AppMode::kSound;
+  int sub_view = 0;
+  int bank = 0;
+  int encoder = 0;
+};
+
+auto normalisedToValue(const ParameterSpec &spec, float normalised) -> float;
+auto valueToNormalised(const ParameterSpec &spec, float value) -> float;
+auto formatParameterValue(const ParameterSpec &spec, float value) -> std::string;
+
+// Every engine, effect and mix parameter, published as a normalised value in
+// [0, 1]. Parameters are added and bound to encoders on the message thread
+// before audio starts; after that any thread may set a value (a lock-free
+// atomic store, last writer wins) or nudge it (a compare-exchange, so
+// concurrent nudges add up) and the audio thread reads it through
+// ParameterRamps.
+class ParameterRegistry {
+public:
+  ParameterRegistry();
+
+  // Message thread. Returns the new parameter's id, or -1 when full.
+  auto add(ParameterSpec spec) -> int;
+  auto bind(const ParameterAddress &address, int id) -> bool;
+  auto lookup(const ParameterAddress &address) const -> int;
+
+  // Any thread.
+  auto count() const -> int;
+  auto spec(int id) const -> const ParameterSpec &;
+  void setNormalised(int id, float normalised);
+  auto normalised(int id) const -> float;
+  auto value(int id) const -> float;
+  auto format(int id) const -> std::string;
+
+  // Relative encoder moves: one step is 1 / kEncoderSteps of the range, or
+  // one choice. Fractional steps accumulate, so fine turns of a choice
+  // change it every few detents.
+  void nudge(int id, float steps);
+  void resetToDefault(int id);
+
+private:
+  static constexpr int kBindingCount = kAppModeCount * kMaxSubViews * kDevBankCount *
+                                       kDevEncoderCount;
+
+  static auto bindingIndex(const ParameterAddress &address) -> int;
+  auto isValid(int id) const -> bool;
+
+  std::array<ParameterSpec, kMaxParameters> specs;
+  std::array<std::atomic<float>, kMaxParameters> values{};
+  std::array<int, kBindingCount> bindings{};
+  std::atomic<int> parameter_count{0};
+};
+
+// Audio-thread view of the registry. Once per block, every parameter's
+// published value becomes the target of a linear ramp of its spec's
+// smoothing time; the block then runs from blockStart() to blockEnd(), and
+// fill() spreads that across the block sample by sample. Reading the
+// registry is a relaxed atomic load per parameter: no locks, no allocation.
+class ParameterRamps {
+public:
+  explicit ParameterRamps(const ParameterRegistry &registry);
+
+  // Message thread, with audio stopped. Jumps every ramp to its value.
+  void prepare(double sample_rate);
+
+  // Audio thread.
+  void beginBlock(int num_samples);
+  auto blockStart(int id) const -> float;
+  auto blockEnd(int id) const -> float;
+  void fill(int id, std::span<float> values) const;
+
+private:
+  const ParameterRegistry &parameters;
+  std::array<juce::SmoothedValue<float>, kMaxParameters> smoothers;
+  std::array<float, kMaxParameters> starts{};
+  std::array<float, kMaxParameters> ends{};
+};
+} // namespace limit
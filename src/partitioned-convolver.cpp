@@ -0,0 +1,181 @@
+#include "partitioned-convolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace limit {
+namespace {
+auto unitRoot(std::size_t index, std::size_t size) -> std::complex<float> {
+  const auto angle = -2.0 * std::numbers::pi * static_cast<double>(index) /
+                     static_cast<double>(size);
+  return {static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle))};
+}
+
+// Written out because std::complex multiplication checks for NaN and
+// infinity on every product, which costs more than the product itself.
+inline auto multiply(std::complex<float> left, std::complex<float> right)
+    -> std::complex<float> {
+  return {(left.real() * right.real()) - (left.imag() * right.imag()),
+          (left.real() * right.imag()) + (left.imag() * right.real())};
+}
+} // namespace
+
+RealFft::RealFft(int size) : fft_size(size) {
+  const auto half = static_cast<std::size_t>(size / 2);
+  auto bits = 0;
+  while ((std::size_t{1} << bits) < half) {
+    ++bits;
+  }
+  bit_reverse.resize(half);
+  for (std::size_t index = 0; index < half; ++index) {
+    std::size_t reversed = 0;
+    for (auto bit = 0; bit < bits; ++bit) {
+      reversed |= ((index >> bit) & 1U) << (bits - 1 - bit);
+    }
+    bit_reverse[index] = reversed;
+  }
+  twiddles.resize(half / 2);
+  for (std::size_t index = 0; index < twiddles.size(); ++index) {
+    twiddles[index] = unitRoot(index, half);
+  }
+  real_twiddles.resize(half);
+  for (std::size_t index = 0; index < half; ++index) {
+    real_twiddles[index] = unitRoot(index, static_cast<std::size_t>(size));
+  }
+  scratch.resize(half);
+}
+
+auto RealFft::size() const -> int { return fft_size; }
+
+auto RealFft::binCount() const -> int { return (fft_size / 2) + 1; }
+
+void RealFft::forward(std::span<const float> input, std::span<std::complex<float>> spectrum) {
+  const auto half = scratch.size();
+  for (std::size_t index = 0; index < half; ++index) {
+    scratch[index] = {input[2 * index], input[(2 * index) + 1]};
+  }
+  transform(scratch, false);
+
+  // The even samples went into the real parts and the odd samples into the
+  // imaginary parts; separate their spectra and combine them.
+  spectrum[0] = {scratch[0].real() + scratch[0].imag(), 0.0f};
+  spectrum[half] = {scratch[0].real() - scratch[0].imag(), 0.0f};
+  for (std::size_t bin = 1; bin < half; ++bin) {
+    const auto value = scratch[bin];
+    const auto mirror = std::conj(scratch[half - bin]);
+    const auto even = (value + mirror) * 0.5f;
+    const auto odd = multiply(value - mirror, {0.0f, -0.5f});
+    spectrum[bin] = even + multiply(real_twiddles[bin], odd);
+  }
+}
+
+void RealFft::inverse(std::span<const std::complex<float>> spectrum, std::span<float> output) {
+  const auto half = scratch.size();
+  for (std::size_t bin = 0; bin < half; ++bin) {
+    const auto value = spectrum[bin];
+    const auto mirror = std::conj(spectrum[half - bin]);
+    const auto even = value + mirror;
+    const auto odd = multiply(value - mirror, std::conj(real_twiddles[bin]));
+    scratch[bin] = even + multiply(odd, {0.0f, 1.0f});
+  }
+  transform(scratch, true);
+  for (std::size_t index = 0; index < half; ++index) {
+    output[2 * index] = scratch[index].real();
+    output[(2 * index) + 1] = scratch[index].imag();
+  }
+}
+
+// Iterative radix-2 decimation in time.
+void RealFft::transform(std::span<std::complex<float>> data, bool inverse_direction) const {
+  const auto count = data.size();
+  for (std::size_t index = 0; index < count; ++index) {
+    const auto reversed = bit_reverse[index];
+    if (index < reversed) {
+      std::swap(data[index], data[reversed]);
+    }
+  }
+  for (std::size_t length = 2; length <= count; length *= 2) {
+    const auto middle = length / 2;
+    const auto stride = count / length;
+    for (std::size_t start = 0; start < count; start += length) {
+      for (std::size_t offset = 0; offset < middle; ++offset) {
+        const auto twiddle = twiddles[offset * stride];
+        const auto rotated =
+            multiply(data[start + offset + middle],
+                     inverse_direction ? std::conj(twiddle) : twiddle);
+        data[start + offset + middle] = data[start + offset] - rotated;
+        data[start + offset] += rotated;
+      }
+    }
+  }
+}
+
+void UniformConvolver::prepare(std::span<const float> taps, int block_size) {
+  partition_size = block_size;
+  const auto size = static_cast<std::size_t>(block_size);
+  partition_count = static_cast<int>((taps.size() + size - 1) / size);
+  fft = RealFft(2 * block_size);
+  bin_count = static_cast<std::size_t>(fft.binCount());
+  const auto partitions = static_cast<std::size_t>(partition_count);
+  filters.assign(partitions * bin_count, {});
+  history.assign(partitions * bin_count, {});
+  sum.assign(bin_count, {});
+  window.assign(2 * size, 0.0f);
+  result.assign(2 * size, 0.0f);
+
+  // Each partition is zero-padded to the transform size, so its linear
+  // convolution with one block fits without wrapping into the kept half.
+  const auto scale = 1.0f / static_cast<float>(2 * size);
+  for (std::size_t partition = 0; partition < partitions; ++partition) {
+    std::fill(result.begin(), result.end(), 0.0f);
+    const auto first = partition * size;
+    const auto last = std::min(first + size, taps.size());
+    std::transform(taps.begin() + static_cast<std::ptrdiff_t>(first),
+                   taps.begin() + static_cast<std::ptrdiff_t>(last), result.begin(),
+                   [scale](float tap) { return tap * scale; });
+    fft.forward(result, std::span(filters).subspan(partition * bin_count, bin_count));
+  }
+  reset();
+}
+
+void UniformConvolver::reset() {
+  std::fill(history.begin(), history.end(), std::complex<float>{});
+  std::fill(window.begin(), window.end(), 0.0f);
+  newest = 0;
+}
+
+auto UniformConvolver::partitionSize() const -> int { return partition_size; }
+
+auto UniformConvolver::partitionCount() const -> int { return partition_count; }
+
+void UniformConvolver::processBlock(std::span<const float> input, std::span<float> output) {
+  const auto size = static_cast<std::size_t>(partition_size);
+  if (partition_count == 0) {
+    std::fill(output.begin(), output.end(), 0.0f);
+    return;
+  }
+
+  std::copy(input.begin(), input.end(), window.begin() + static_cast<std::ptrdiff_t>(size));
+  const auto partitions = static_cast<std::size_t>(partition_count);
+  newest = (newest + partitions - 1) % partitions;
+  const std::span<std::complex<float>> spectra(history);
+  fft.forward(window, spectra.subspan(newest * bin_count, bin_count));
+
+  std::fill(sum.begin(), sum.end(), std::complex<float>{});
+  const std::span<const std::complex<float>> filter(filters);
+  for (std::size_t partition = 0; partition < partitions; ++partition) {
+    const auto coefficients = filter.subspan(partition * bin_count, bin_count);
+    const auto block = spectra.subspan(((newest + partition) % partitions) * bin_count, bin_count);
+    for (std::size_t bin = 0; bin < bin_count; ++bin) {
+      sum[bin] += multiply(coefficients[bin], block[bin]);
+    }
+  }
+  fft.inverse(sum, result);
+
+  // The first half wrapped around the circular convolution; the second is
+  // the output for this block.
+  std::copy(result.begin() + static_cast<std::ptrdiff_t>(size), result.end(), output.begin());
+  std::copy(window.begin() + static_cast<std::ptrdiff_t>(size), window.end(), window.begin());
+}
+} // namespace limit
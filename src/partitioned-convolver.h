@@ -0,0 +1,74 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace limit {
+// Real FFT of a power-of-two size (at least 4), computed as a complex FFT of
+// half the size. The constructor builds every table; transforms never
+// allocate, but each plan has its own scratch, so one plan serves one thread.
+class RealFft {
+public:
+  RealFft() = default;
+  explicit RealFft(int size);
+
+  auto size() const -> int;
+  // size() / 2 + 1: DC up to and including Nyquist.
+  auto binCount() const -> int;
+
+  // input holds size() samples, spectrum binCount() bins.
+  void forward(std::span<const float> input, std::span<std::complex<float>> spectrum);
+  // Not normalised: forward() then inverse() scales by size().
+  void inverse(std::span<const std::complex<float>> spectrum, std::span<float> output);
+
+private:
+  void transform(std::span<std::complex<float>> data, bool inverse_direction) const;
+
+  int fft_size = 0;
+  std::vector<std::size_t> bit_reverse;
+  // exp(-2 pi i k / (size / 2)) for the half-size complex transform, and
+  // exp(-2 pi i k / size) to split its result into the real spectrum.
+  std::vector<std::complex<float>> twiddles;
+  std::vector<std::complex<float>> real_twiddles;
+  std::vector<std::complex<float>> scratch;
+};
+
+// Uniformly partitioned overlap-save convolution of one channel with one
+// segment of an impulse response. Every processBlock() takes the next
+// partitionSize() input samples and returns the segment's output for those
+// same samples. A segment that starts at least one partition into the
+// response therefore only needs input that has already arrived, and its
+// output can be computed at a block boundary and played during the next
+// block without adding latency.
+class UniformConvolver {
+public:
+  // Message thread. The partition size block_size is a power of two; taps
+  // may be empty.
+  void prepare(std::span<const float> taps, int block_size);
+  void reset();
+
+  auto partitionSize() const -> int;
+  auto partitionCount() const -> int;
+
+  // input and output hold partitionSize() samples. Never allocates.
+  void processBlock(std::span<const float> input, std::span<float> output);
+
+private:
+  RealFft fft;
+  int partition_size = 0;
+  int partition_count = 0;
+  std::size_t bin_count = 0;
+  // Partition-major spectra, already scaled for the unnormalised inverse.
+  std::vector<std::complex<float>> filters;
+  // Spectra of the most recent input blocks; partition k pairs with the
+  // block k blocks before the newest.
+  std::vector<std::complex<float>> history;
+  std::size_t newest = 0;
+  std::vector<std::complex<float>> sum;
+  // The previous and the current input block, and the inverse transform.
+  std::vector<float> window;
+  std::vector<float> result;
+};
+} // namespace limit
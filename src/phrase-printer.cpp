@@ -0,0 +1,139 @@
+#include "phrase-printer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace limit {
+namespace {
+constexpr int kMidiReserveBytes = 16384;
+} // namespace
+
+PhrasePrinter::PhrasePrinter(std::unique_ptr<AudioGraphNode> instrument,
+                             std::unique_ptr<AudioGraphNode> insert)
+    : instrument_node(std::move(instrument)), insert_node(std::move(insert)) {}
+
+PhrasePrinter::~PhrasePrinter() {
+  if (pending.valid()) {
+    pending.wait();
+  }
+}
+
+void PhrasePrinter::prepare(double new_sample_rate, int new_block_size) {
+  sample_rate = new_sample_rate;
+  block_size = std::max(new_block_size, 1);
+  buses.instrument.setSize(kStereoChannelCount, block_size);
+  buses.tape.setSize(kStereoChannelCount * kTapeTrackCount, block_size);
+  buses.master.setSize(kStereoChannelCount, block_size);
+  buses.send1.setSize(kStereoChannelCount, block_size);
+  buses.send2.setSize(kStereoChannelCount, block_size);
+  block_midi.ensureSize(kMidiReserveBytes);
+  resetNodes();
+}
+
+auto PhrasePrinter::print(const PhrasePrintJob &job, TapeStorage &tape) -> PrintResult {
+  return render(job, [&tape, &job](std::int64_t offset, std::span<const float> left,
+                                   std::span<const float> right) {
+    return tape.writeFramesOffline(job.track, job.start_frame + offset, left, right);
+  });
+}
+
+auto PhrasePrinter::render(const PhrasePrintJob &job, const BlockSink &sink) -> PrintResult {
+  if (instrument_node == nullptr || block_size <= 0 || sample_rate <= 0.0 ||
+      job.length_frames <= 0 || job.loop_count <= 0 || job.tail_frames < 0) {
+    return {};
+  }
+
+  const auto started = std::chrono::steady_clock::now();
+  resetNodes();
+  const auto phrase_frames = job.length_frames * job.loop_count;
+  const auto total_frames = phrase_frames + job.tail_frames;
+  PrintResult result;
+  std::int64_t position = 0;
+  while (position < total_frames) {
+    // Blocks never straddle a loop boundary, so every loop sees its events at
+    // the same offsets and no event is split across two iterations.
+    auto frames = std::min<std::int64_t>(block_size, total_frames - position);
+    std::int64_t loop_position = -1;
+    if (position < phrase_frames) {
+      loop_position = position % job.length_frames;
+      frames = std::min(frames, job.length_frames - loop_position);
+    }
+    const auto num_samples = static_cast<int>(frames);
+    renderBlock(job, loop_position, num_samples);
+
+    const auto count = static_cast<std::size_t>(num_samples);
+    const std::span<const float> left(buses.instrument.getReadPointer(0), count);
+    const std::span<const float> right(buses.instrument.getReadPointer(1), count);
+    if (!sink(position, left, right)) {
+      break;
+    }
+    position += frames;
+  }
+
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+  result.completed = position == total_frames;
+  result.frames_rendered = position;
+  result.render_seconds = elapsed.count();
+  if (result.render_seconds > 0.0) {
+    result.realtime_factor =
+        static_cast<double>(position) / sample_rate / result.render_seconds;
+  }
+  return result;
+}
+
+auto PhrasePrinter::startPrint(PhrasePrintJob job, TapeStorage &tape) -> bool {
+  if (isPrinting()) {
+    return false;
+  }
+  pending = std::async(std::launch::async, [this, print_job = std::move(job), &tape] {
+    return print(print_job, tape);
+  });
+  return true;
+}
+
+auto PhrasePrinter::isPrinting() const -> bool {
+  return pending.valid() &&
+         pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+auto PhrasePrinter::waitForPrint() -> PrintResult {
+  if (!pending.valid()) {
+    return {};
+  }
+  return pending.get();
+}
+
+void PhrasePrinter::resetNodes() {
+  // Every print starts from silence with no held voices, as the live graph
+  // does after prepareToPlay.
+  if (instrument_node != nullptr) {
+    instrument_node->prepare(sample_rate, block_size);
+  }
+  if (insert_node != nullptr) {
+    insert_node->prepare(sample_rate, block_size);
+  }
+}
+
+void PhrasePrinter::renderBlock(const PhrasePrintJob &job, std::int64_t loop_position,
+                                int num_samples) {
+  block_midi.clear();
+  if (loop_position >= 0) {
+    const auto block_end = loop_position + num_samples;
+    for (const auto metadata : job.midi) {
+      const auto event_position = static_cast<std::int64_t>(metadata.samplePosition);
+      if (event_position >= loop_position && event_position < block_end) {
+        block_midi.addEvent(metadata.data, metadata.numBytes,
+                            static_cast<int>(event_position - loop_position));
+      }
+    }
+  }
+
+  // Same stage order as AudioGraph: the instrument writes the bus, the insert
+  // processes it in place.
+  instrument_node->process(buses, block_midi, num_samples);
+  if (insert_node != nullptr) {
+    insert_node->process(buses, block_midi, num_samples);
+  }
+}
+} // namespace limit
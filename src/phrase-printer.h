@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <span>
+
+#include "audio-graph.h"
+#include "tape-storage.h"
+
+namespace limit {
+// One phrase print. MIDI positions are samples from the start of the phrase;
+// the phrase is looped loop_count times and followed by tail_frames of
+// release with no new events.
+struct PhrasePrintJob {
+  juce::MidiBuffer midi;
+  std::int64_t length_frames = 0;
+  int loop_count = 1;
+  std::int64_t tail_frames = 0;
+  int track = 0;
+  std::int64_t start_frame = 0;
+};
+
+struct PrintResult {
+  bool completed = false;
+  std::int64_t frames_rendered = 0;
+  double render_seconds = 0.0;
+  double realtime_factor = 0.0;
+};
+
+// Renders a phrase through the instrument and insert stages offline, as fast
+// as the CPU allows, and writes the result to tape. The printer owns its own
+// node instances (built from the same classes as the live graph) so it never
+// shares state with the audio thread, and it drives them exactly as
+// AudioGraph does, so the printed audio is bit-identical to what the live
+// path would play.
+class PhrasePrinter {
+public:
+  using BlockSink = std::function<bool(std::int64_t offset, std::span<const float> left,
+                                       std::span<const float> right)>;
+
+  explicit PhrasePrinter(std::unique_ptr<AudioGraphNode> instrument,
+                         std::unique_ptr<AudioGraphNode> insert = nullptr);
+  ~PhrasePrinter();
+  PhrasePrinter(const PhrasePrinter &) = delete;
+  auto operator=(const PhrasePrinter &) -> PhrasePrinter & = delete;
+  PhrasePrinter(PhrasePrinter &&) = delete;
+  auto operator=(PhrasePrinter &&) -> PhrasePrinter & = delete;
+
+  void prepare(double sample_rate, int block_size = kDefaultBlockSize);
+
+  // Blocking renders on the calling thread.
+  auto print(const PhrasePrintJob &job, TapeStorage &tape) -> PrintResult;
+  auto render(const PhrasePrintJob &job, const BlockSink &sink) -> PrintResult;
+
+  // Runs print() on a worker thread. Returns false if a print is already
+  // running; the tape must outlive the print.
+  auto startPrint(PhrasePrintJob job, TapeStorage &tape) -> bool;
+  auto isPrinting() const -> bool;
+  auto waitForPrint() -> PrintResult;
+
+  static constexpr int kDefaultBlockSize = 1024;
+
+private:
+  void resetNodes();
+  void renderBlock(const PhrasePrintJob &job, std::int64_t loop_position, int num_samples);
+
+  std::unique_ptr<AudioGraphNode> instrument_node;
+  std::unique_ptr<AudioGraphNode> insert_node;
+  AudioGraphBuses buses;
+  juce::MidiBuffer block_midi;
+  double sample_rate = 0.0;
+  int block_size = 0;
+  std::future<PrintResult> pending;
+};
+} // namespace limit
@@ -0,0 +1,165 @@
+#include "phrase-store.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <new>
+#include <span>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace limit {
+namespace {
+constexpr std::size_t kHeaderBytes = 4096;
+constexpr std::size_t kFileBytes =
+    kHeaderBytes + (static_cast<std::size_t>(kPhraseSlotCount) * kPhraseRecordBytes);
+constexpr mode_t kStoreFileMode = 0644;
+
+// The header records the layout the file was written with, so a store from an
+// incompatible build is rejected instead of misread.
+struct PhraseStoreHeader {
+  std::array<char, 8> magic{'L', 'I', 'M', 'I', 'T', 'P', 'H', 'R'};
+  std::uint32_t version = kPhraseStoreVersion;
+  std::uint32_t slot_count = kPhraseSlotCount;
+  std::uint32_t record_bytes = kPhraseRecordBytes;
+  std::uint32_t payload_bytes = sizeof(PhraseRecord);
+  std::uint32_t step_count = kMaxPhraseSteps;
+  std::uint32_t parameter_count = kSoundParameterCount;
+};
+
+static_assert(std::endian::native == std::endian::little,
+              "Phrase store is written in host byte order");
+static_assert(sizeof(PhraseStoreHeader) <= kHeaderBytes, "Phrase store header must fit a page");
+
+using HeaderPage = std::array<std::byte, kHeaderBytes>;
+
+auto makeHeaderPage() -> HeaderPage {
+  const PhraseStoreHeader header;
+  HeaderPage page{};
+  std::memcpy(page.data(), &header, sizeof(header));
+  return page;
+}
+} // namespace
+
+auto PhraseStore::open(const std::filesystem::path &path) -> std::unique_ptr<PhraseStore> {
+  std::error_code error;
+  if (path.has_parent_path()) {
+    std::filesystem::create_directories(path.parent_path(), error);
+    if (error) {
+      return nullptr;
+    }
+  }
+  auto store = std::unique_ptr<PhraseStore>(new PhraseStore());
+  if (!store->map(path)) {
+    return nullptr;
+  }
+  return store;
+}
+
+PhraseStore::~PhraseStore() {
+  if (address != nullptr) {
+    ::msync(address, mapped_bytes, MS_SYNC);
+    ::munmap(address, mapped_bytes);
+  }
+  if (fd >= 0) {
+    ::close(fd);
+  }
+}
+
+auto PhraseStore::slotCount() const -> int { return kPhraseSlotCount; }
+
+auto PhraseStore::isOccupied(int slot) const -> bool { return phrase(slot) != nullptr; }
+
+auto PhraseStore::phrase(int slot) const -> const PhraseRecord * {
+  const auto *entry = record(slot);
+  if (entry == nullptr || (entry->flags & kPhraseOccupied) == 0) {
+    return nullptr;
+  }
+  return entry;
+}
+
+auto PhraseStore::save(int slot, const PhraseRecord &record_to_save) -> bool {
+  auto *entry = record(slot);
+  if (entry == nullptr) {
+    return false;
+  }
+  auto stored = record_to_save;
+  stored.flags |= kPhraseOccupied;
+  stored.revision = entry->revision + 1;
+  stored.pattern.length = std::clamp(stored.pattern.length, 1, kMaxPhraseSteps);
+  std::memcpy(entry, &stored, sizeof(stored));
+  return true;
+}
+
+auto PhraseStore::clear(int slot) -> bool {
+  auto *entry = record(slot);
+  if (entry == nullptr) {
+    return false;
+  }
+  const auto revision = entry->revision + 1;
+  *entry = PhraseRecord{};
+  entry->revision = revision;
+  return true;
+}
+
+void PhraseStore::flush() {
+  if (address != nullptr) {
+    ::msync(address, mapped_bytes, MS_SYNC);
+  }
+}
+
+auto PhraseStore::map(const std::filesystem::path &path) -> bool {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+  fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, kStoreFileMode);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat info {};
+  if (::fstat(fd, &info) != 0) {
+    return false;
+  }
+
+  // A new store is a sparse file of empty slots; only the header is written.
+  const auto expected_header = makeHeaderPage();
+  if (info.st_size == 0) {
+    if (::ftruncate(fd, static_cast<off_t>(kFileBytes)) != 0 ||
+        ::pwrite(fd, expected_header.data(), expected_header.size(), 0) !=
+            static_cast<ssize_t>(expected_header.size())) {
+      return false;
+    }
+  } else {
+    HeaderPage existing_header{};
+    if (static_cast<std::size_t>(info.st_size) != kFileBytes ||
+        ::pread(fd, existing_header.data(), existing_header.size(), 0) !=
+            static_cast<ssize_t>(existing_header.size()) ||
+        existing_header != expected_header) {
+      return false;
+    }
+  }
+
+  void *mapping = ::mmap(nullptr, kFileBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+  address = mapping;
+  mapped_bytes = kFileBytes;
+  return true;
+}
+
+auto PhraseStore::record(int slot) const -> PhraseRecord * {
+  if (address == nullptr || slot < 0 || slot >= kPhraseSlotCount) {
+    return nullptr;
+  }
+  const auto bytes = std::span(static_cast<std::byte *>(address), mapped_bytes);
+  auto *slot_bytes =
+      bytes.subspan(kHeaderBytes + (static_cast<std::size_t>(slot) * kPhraseRecordBytes)).data();
+  // Records are plain data at fixed, aligned offsets of the mapping.
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return std::launder(reinterpret_cast<PhraseRecord *>(slot_bytes));
+}
+} // namespace limit
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <type_traits>
+
+#include "step-sequencer.h"
+
+namespace limit {
+constexpr int kPhraseSlotCount = 512;
+constexpr int kSoundParameterCount = 64;
+constexpr std::size_t kPhraseRecordBytes = 1024;
+constexpr std::uint32_t kPhraseStoreVersion = 1;
+constexpr std::uint32_t kPhraseOccupied = 1U;
+
+// Everything needed to make a phrase sound as it did when it was stored.
+struct SoundSnapshot {
+  std::uint32_t engine = 0;
+  std::array<float, kSoundParameterCount> parameters{};
+};
+
+// One phrase slot: step data plus the sound it was written with. Plain data
+// with a fixed layout so it can live directly in the mapped store file.
+struct PhraseRecord {
+  std::uint32_t flags = 0;
+  std::uint32_t revision = 0;
+  StepPattern pattern;
+  SoundSnapshot sound;
+};
+
+static_assert(std::is_trivially_copyable_v<PhraseRecord>,
+              "Phrase records are stored as raw bytes");
+static_assert(sizeof(PhraseRecord) <= kPhraseRecordBytes,
+              "Phrase record must fit its fixed slot");
+
+// All phrases of a project in one memory-mapped file: a versioned header page
+// followed by kPhraseSlotCount fixed-size records. Opening maps the file and
+// checks the header only, so project load does no parsing and touches no
+// phrase until it is recalled. Recall returns a pointer into the mapping
+// (no copy, O(1) in the slot number).
+//
+// Not thread-safe: save, clear and recall all belong to the message thread.
+// The audio thread never reads the mapping; recalled patterns reach it
+// through StepSequencer::setPattern.
+class PhraseStore {
+public:
+  static auto open(const std::filesystem::path &path) -> std::unique_ptr<PhraseStore>;
+
+  ~PhraseStore();
+  PhraseStore(const PhraseStore &) = delete;
+  auto operator=(const PhraseStore &) -> PhraseStore & = delete;
+  PhraseStore(PhraseStore &&) = delete;
+  auto operator=(PhraseStore &&) -> PhraseStore & = delete;
+
+  auto slotCount() const -> int;
+  auto isOccupied(int slot) const -> bool;
+
+  // Zero-copy view of a stored phrase; nullptr for an empty or invalid slot.
+  // Stays valid until the slot is saved or cleared again.
+  auto phrase(int slot) const -> const PhraseRecord *;
+
+  auto save(int slot, const PhraseRecord &record) -> bool;
+  auto clear(int slot) -> bool;
+
+  // Writes dirty pages back to disk.
+  void flush();
+
+private:
+  PhraseStore() = default;
+
+  auto map(const std::filesystem::path &path) -> bool;
+  auto record(int slot) const -> PhraseRecord *;
+
+  int fd = -1;
+  void *address = nullptr;
+  std::size_t mapped_bytes = 0;
+};
+} // namespace limit
@@ -0,0 +1,268 @@
+#include "project-journal.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace limit {
+namespace {
+constexpr std::uint32_t kRecordMagic = 0x4c4e4a4cU;
+constexpr std::uint32_t kFnvOffsetBasis = 2166136261U;
+constexpr std::uint32_t kFnvPrime = 16777619U;
+constexpr mode_t kJournalFileMode = 0644;
+constexpr auto kWriterInterval = std::chrono::milliseconds(20);
+
+struct RecordHeader {
+  std::uint32_t magic = kRecordMagic;
+  std::uint32_t checksum = 0;
+  std::uint64_t sequence = 0;
+  std::uint16_t kind = 0;
+  std::uint16_t slot = 0;
+  std::uint32_t size = 0;
+};
+
+static_assert(sizeof(RecordHeader) == 24, "Journal record header must be tightly packed");
+
+auto fnv1a(std::span<const std::byte> bytes, std::uint32_t hash) -> std::uint32_t {
+  for (const auto byte : bytes) {
+    hash ^= std::to_integer<std::uint32_t>(byte);
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+// Covers every header field except the checksum itself, then the payload.
+auto recordChecksum(RecordHeader header, std::span<const std::byte> payload) -> std::uint32_t {
+  header.checksum = 0;
+  const auto hash = fnv1a(std::as_bytes(std::span(&header, 1)), kFnvOffsetBasis);
+  return fnv1a(payload, hash);
+}
+
+auto writeAll(int fd, std::span<const std::byte> bytes) -> bool {
+  while (!bytes.empty()) {
+    const auto written = ::write(fd, bytes.data(), bytes.size());
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    bytes = bytes.subspan(static_cast<std::size_t>(written));
+  }
+  return true;
+}
+} // namespace
+
+auto JournalChange::bytes() const -> std::span<const std::byte> {
+  return std::span(payload).first(std::min<std::size_t>(size, payload.size()));
+}
+
+auto ProjectJournal::open(const ProjectJournalConfig &config)
+    -> std::unique_ptr<ProjectJournal> {
+  std::error_code error;
+  if (config.path.has_parent_path()) {
+    std::filesystem::create_directories(config.path.parent_path(), error);
+    if (error) {
+      return nullptr;
+    }
+  }
+  auto journal = std::unique_ptr<ProjectJournal>(new ProjectJournal(config));
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+  journal->fd = ::open(config.path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC,
+                       kJournalFileMode);
+  if (journal->fd < 0) {
+    return nullptr;
+  }
+  return journal;
+}
+
+ProjectJournal::ProjectJournal(const ProjectJournalConfig &journal_config)
+    : config(journal_config) {}
+
+ProjectJournal::~ProjectJournal() {
+  stop();
+  if (fd >= 0) {
+    ::close(fd);
+  }
+}
+
+auto ProjectJournal::replay(const ReplayHandler &handler) -> int {
+  struct stat info {};
+  if (::fstat(fd, &info) != 0) {
+    return 0;
+  }
+  std::vector<std::byte> data(static_cast<std::size_t>(info.st_size));
+  if (!data.empty() &&
+      ::pread(fd, data.data(), data.size(), 0) != static_cast<ssize_t>(data.size())) {
+    return 0;
+  }
+
+  const std::span<const std::byte> log(data);
+  std::size_t offset = 0;
+  int count = 0;
+  while (log.size() - offset >= sizeof(RecordHeader)) {
+    RecordHeader header;
+    std::memcpy(&header, log.subspan(offset, sizeof(header)).data(), sizeof(header));
+    const auto record_bytes = sizeof(header) + header.size;
+    if (header.magic != kRecordMagic || header.size > kJournalMaxPayloadBytes ||
+        record_bytes > log.size() - offset || header.sequence < next_sequence) {
+      break;
+    }
+    const auto payload = log.subspan(offset + sizeof(header), header.size);
+    if (recordChecksum(header, payload) != header.checksum) {
+      break;
+    }
+
+    JournalChange change;
+    change.kind = static_cast<JournalKind>(header.kind);
+    change.slot = header.slot;
+    change.size = header.size;
+    std::copy(payload.begin(), payload.end(), change.payload.begin());
+    handler(change);
+
+    next_sequence = header.sequence + 1;
+    offset += record_bytes;
+    ++count;
+  }
+
+  // Anything after the last intact record is a write the crash interrupted.
+  if (offset != log.size() && ::ftruncate(fd, static_cast<off_t>(offset)) == 0) {
+    ::fdatasync(fd);
+  }
+  log_bytes.store(offset, std::memory_order_relaxed);
+  needs_compaction = count > 0;
+  return count;
+}
+
+void ProjectJournal::start(Compactor new_compactor) {
+  if (writer_thread.joinable()) {
+    return;
+  }
+  compactor = std::move(new_compactor);
+  {
+    const std::scoped_lock lock(writer_mutex);
+    writer_stopping = false;
+  }
+  writer_thread = std::thread([this] { runWriterLoop(); });
+}
+
+void ProjectJournal::stop() {
+  if (writer_thread.joinable()) {
+    {
+      const std::scoped_lock lock(writer_mutex);
+      writer_stopping = true;
+    }
+    writer_wakeup.notify_all();
+    writer_thread.join();
+  }
+  writeBatch();
+  compact();
+}
+
+auto ProjectJournal::append(JournalKind kind, int slot, std::span<const std::byte> payload)
+    -> bool {
+  const auto write = write_index.load(std::memory_order_relaxed);
+  const auto read = read_index.load(std::memory_order_acquire);
+  if (payload.size() > kJournalMaxPayloadBytes || slot < 0 ||
+      slot > std::numeric_limits<std::uint16_t>::max() ||
+      write - read >= kJournalQueueCapacity) {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  auto &change = changes.at(write & kIndexMask);
+  change.kind = kind;
+  change.slot = static_cast<std::uint16_t>(slot);
+  change.size = static_cast<std::uint32_t>(payload.size());
+  std::copy(payload.begin(), payload.end(), change.payload.begin());
+  write_index.store(write + 1, std::memory_order_release);
+  return true;
+}
+
+auto ProjectJournal::droppedCount() const -> std::uint32_t {
+  return dropped.load(std::memory_order_relaxed);
+}
+
+void ProjectJournal::service() {
+  writeBatch();
+  if (needs_compaction || logBytes() >= config.compact_bytes) {
+    compact();
+  }
+}
+
+// The snapshot already holds every change that reached the log (the owner
+// writes it before appending), so once the compactor has made it durable the
+// log can be emptied. Changes still queued are written afterwards; replaying
+// them later is harmless.
+auto ProjectJournal::compact() -> bool {
+  if (!compactor || !compactor()) {
+    return false;
+  }
+  if (::ftruncate(fd, 0) != 0) {
+    return false;
+  }
+  ::fdatasync(fd);
+  log_bytes.store(0, std::memory_order_relaxed);
+  needs_compaction = false;
+  return true;
+}
+
+auto ProjectJournal::logBytes() const -> std::size_t {
+  return log_bytes.load(std::memory_order_relaxed);
+}
+
+auto ProjectJournal::popChange(JournalChange &change) -> bool {
+  const auto read = read_index.load(std::memory_order_relaxed);
+  const auto write = write_index.load(std::memory_order_acquire);
+  if (read == write) {
+    return false;
+  }
+  change = changes.at(read & kIndexMask);
+  read_index.store(read + 1, std::memory_order_release);
+  return true;
+}
+
+// Everything queued since the last pass goes out as one write and one sync.
+void ProjectJournal::writeBatch() {
+  batch.clear();
+  JournalChange change;
+  while (popChange(change)) {
+    RecordHeader header;
+    header.sequence = next_sequence++;
+    header.kind = static_cast<std::uint16_t>(change.kind);
+    header.slot = change.slot;
+    header.size = change.size;
+    header.checksum = recordChecksum(header, change.bytes());
+    const auto header_bytes = std::as_bytes(std::span(&header, 1));
+    batch.insert(batch.end(), header_bytes.begin(), header_bytes.end());
+    batch.insert(batch.end(), change.bytes().begin(), change.bytes().end());
+  }
+  if (batch.empty()) {
+    return;
+  }
+  if (!writeAll(fd, batch) || ::fdatasync(fd) != 0) {
+    // The log may now end in a partial record; the snapshot still has the
+    // changes, so compacting restores a clean state.
+    needs_compaction = true;
+    return;
+  }
+  log_bytes.fetch_add(batch.size(), std::memory_order_relaxed);
+}
+
+void ProjectJournal::runWriterLoop() {
+  std::unique_lock lock(writer_mutex);
+  while (!writer_stopping) {
+    lock.unlock();
+    service();
+    lock.lock();
+    writer_wakeup.wait_for(lock, kWriterInterval, [this] { return writer_stopping; });
+  }
+}
+} // namespace limit
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace limit {
+constexpr std::size_t kJournalQueueCapacity = 64;
+constexpr std::size_t kJournalMaxPayloadBytes = 1024;
+constexpr std::size_t kJournalCompactBytes = 256 * 1024;
+
+enum class JournalKind : std::uint16_t {
+  kPhrase = 1,
+};
+
+// One state change: the new value of one object (a phrase slot, for now),
+// identified by kind and slot.
+struct JournalChange {
+  JournalKind kind = JournalKind::kPhrase;
+  std::uint16_t slot = 0;
+  std::uint32_t size = 0;
+  std::array<std::byte, kJournalMaxPayloadBytes> payload{};
+
+  auto bytes() const -> std::span<const std::byte>;
+};
+
+struct ProjectJournalConfig {
+  std::filesystem::path path;
+  std::size_t compact_bytes = kJournalCompactBytes;
+};
+
+// Crash-safe autosave log. The owner writes a change into its snapshot store
+// (the mapped phrase file) first and then appends the new value here; a
+// background writer batches appended changes into checksummed records,
+// syncs them, and once the log grows past compact_bytes asks the owner to
+// make the snapshot durable and truncates the log. After a crash, replaying
+// the intact records over the snapshot restores the last synced state; a torn
+// tail record is detected by its checksum and dropped.
+//
+// append() is a wait-free single-producer push and never touches the disk,
+// so the UI never waits on I/O; the audio thread is not involved at all.
+class ProjectJournal {
+public:
+  using Compactor = std::function<bool()>;
+  using ReplayHandler = std::function<void(const JournalChange &)>;
+
+  static auto open(const ProjectJournalConfig &config) -> std::unique_ptr<ProjectJournal>;
+
+  ~ProjectJournal();
+  ProjectJournal(const ProjectJournal &) = delete;
+  auto operator=(const ProjectJournal &) -> ProjectJournal & = delete;
+  ProjectJournal(ProjectJournal &&) = delete;
+  auto operator=(ProjectJournal &&) -> ProjectJournal & = delete;
+
+  // Before start(): feeds every intact record to the handler in order and
+  // cuts the log after the last one. Returns the number of records replayed.
+  auto replay(const ReplayHandler &handler) -> int;
+
+  // The compactor runs on the writer thread and must make every change
+  // already applied to the snapshot durable. stop() drains and compacts.
+  void start(Compactor compactor);
+  void stop();
+
+  // Producer thread. Returns false (and counts a drop) when the queue is full
+  // or the payload is too large; the caller keeps the change and retries.
+  auto append(JournalKind kind, int slot, std::span<const std::byte> payload) -> bool;
+  auto droppedCount() const -> std::uint32_t;
+
+  // Writer thread (exposed so tests can drive it deterministically).
+  void service();
+  auto compact() -> bool;
+  auto logBytes() const -> std::size_t;
+
+private:
+  explicit ProjectJournal(const ProjectJournalConfig &config);
+
+  auto popChange(JournalChange &change) -> bool;
+  void writeBatch();
+  void runWriterLoop();
+
+  static constexpr std::size_t kCacheLineSize = 64;
+  static constexpr std::size_t kIndexMask = kJournalQueueCapacity - 1;
+  static_assert((kJournalQueueCapacity & kIndexMask) == 0,
+                "Journal queue capacity must be a power of two");
+
+  ProjectJournalConfig config;
+  int fd = -1;
+  std::atomic<std::size_t> log_bytes{0};
+  std::uint64_t next_sequence = 1;
+  bool needs_compaction = false;
+  Compactor compactor;
+  std::vector<std::byte> batch;
+
+  std::array<JournalChange, kJournalQueueCapacity> changes{};
+  alignas(kCacheLineSize) std::atomic<std::size_t> write_index{0};
+  alignas(kCacheLineSize) std::atomic<std::size_t> read_index{0};
+  std::atomic<std::uint32_t> dropped{0};
+
+  std::thread writer_thread;
+  std::mutex writer_mutex;
+  std::condition_variable writer_wakeup;
+  bool writer_stopping = false;
+};
+} // namespace limit
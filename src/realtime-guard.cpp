@@ -0,0 +1,32 @@
+#include "realtime-guard.h"
+
+#include <atomic>
+
+namespace limit {
+namespace {
+thread_local bool realtime_thread = false;
+std::atomic<std::uint64_t> realtime_allocations{0};
+} // namespace
+
+ScopedRealtimeSection::ScopedRealtimeSection() : was_realtime(realtime_thread) {
+  realtime_thread = true;
+}
+
+ScopedRealtimeSection::~ScopedRealtimeSection() { realtime_thread = was_realtime; }
+
+auto isInRealtimeSection() -> bool { return realtime_thread; }
+
+auto isAllocationTrapEnabled() -> bool {
+#if defined(LIMIT_ALLOCATION_TRAP)
+  return true;
+#else
+  return false;
+#endif
+}
+
+void noteRealtimeAllocation() { realtime_allocations.fetch_add(1, std::memory_order_relaxed); }
+
+auto realtimeAllocationCount() -> std::uint64_t {
+  return realtime_allocations.load(std::memory_order_relaxed);
+}
+} // namespace limit
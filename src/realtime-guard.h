@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+namespace limit {
+// Marks the current thread as running realtime audio code for the lifetime of
+// the object. When the allocation trap is compiled in (LIMIT_ALLOCATION_TRAP),
+// every heap allocation made inside a realtime section is counted so tests can
+// assert that the audio path stays allocation-free.
+class ScopedRealtimeSection {
+public:
+  ScopedRealtimeSection();
+  ~ScopedRealtimeSection();
+  ScopedRealtimeSection(const ScopedRealtimeSection &) = delete;
+  auto operator=(const ScopedRealtimeSection &) -> ScopedRealtimeSection & = delete;
+  ScopedRealtimeSection(ScopedRealtimeSection &&) = delete;
+  auto operator=(ScopedRealtimeSection &&) -> ScopedRealtimeSection & = delete;
+
+private:
+  bool was_realtime = false;
+};
+
+auto isInRealtimeSection() -> bool;
+auto isAllocationTrapEnabled() -> bool;
+void noteRealtimeAllocation();
+auto realtimeAllocationCount() -> std::uint64_t;
+} // namespace limit
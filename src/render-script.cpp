@@ -0,0 +1,288 @@
+#include "render-script.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <string>
+
+#include "phrase-store.h"
+#include "signal-flow.h"
+#include "tape-transport.h"
+
+namespace {
+using limit::RenderCommand;
+using limit::RenderEvent;
+
+constexpr std::size_t kMaxTokens = 6;
+constexpr int kMidiChannelCount = 16;
+constexpr int kMidiDataMax = 127;
+constexpr std::uint8_t kNoteOffStatus = 0x80;
+constexpr std::uint8_t kNoteOnStatus = 0x90;
+constexpr std::uint8_t kControllerStatus = 0xB0;
+constexpr double kMaxPercent = 100.0;
+constexpr int kMidiMessageBytes = 3;
+
+using Tokens = std::span<const std::string_view>;
+
+// Splits on whitespace; returns nullopt when there are too many tokens.
+auto tokenize(std::string_view line)
+    -> std::optional<std::pair<std::array<std::string_view, kMaxTokens>, std::size_t>> {
+  std::array<std::string_view, kMaxTokens> tokens{};
+  std::size_t count = 0;
+  std::size_t position = 0;
+  while (position < line.size()) {
+    const auto start = line.find_first_not_of(" \t\r", position);
+    if (start == std::string_view::npos) {
+      break;
+    }
+    const auto end = std::min(line.find_first_of(" \t\r", start), line.size());
+    if (count == tokens.size()) {
+      return std::nullopt;
+    }
+    tokens.at(count++) = line.substr(start, end - start);
+    position = end;
+  }
+  return std::pair{tokens, count};
+}
+
+auto parseReal(std::string_view token) -> std::optional<double> {
+  double value = 0.0;
+  const auto *const end = token.data() + token.size();
+  const auto [last, error] = std::from_chars(token.data(), end, value);
+  if (error != std::errc{} || last != end || !std::isfinite(value)) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+auto parseNumber(std::string_view token, int low, int high) -> std::optional<int> {
+  int value = 0;
+  const auto *const end = token.data() + token.size();
+  const auto [last, error] = std::from_chars(token.data(), end, value);
+  if (error != std::errc{} || last != end || value < low || value > high) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+// Frames, or seconds with an s suffix.
+auto parseTime(std::string_view token, double sample_rate) -> std::optional<std::int64_t> {
+  const auto seconds = !token.empty() && token.back() == 's';
+  const auto value = parseReal(seconds ? token.substr(0, token.size() - 1) : token);
+  if (!value || *value < 0.0) {
+    return std::nullopt;
+  }
+  return static_cast<std::int64_t>(std::llround(seconds ? *value * sample_rate : *value));
+}
+
+auto parseSwitch(std::string_view token) -> std::optional<double> {
+  if (token == "on") {
+    return 1.0;
+  }
+  if (token == "off") {
+    return 0.0;
+  }
+  return std::nullopt;
+}
+
+auto midiEvent(std::uint8_t status, int channel, int first, int second) -> RenderEvent {
+  return {.command = RenderCommand::kMidi,
+          .midi = {static_cast<std::uint8_t>(status | (channel - 1)),
+                   static_cast<std::uint8_t>(first), static_cast<std::uint8_t>(second)},
+          .midi_size = kMidiMessageBytes};
+}
+
+auto parseMidi(Tokens tokens) -> std::optional<RenderEvent> {
+  const auto &name = tokens.front();
+  const auto arguments = tokens.subspan(1);
+  const auto note_off = name == "note-off";
+  if (arguments.size() != (note_off ? 2U : 3U)) {
+    return std::nullopt;
+  }
+  const auto channel = parseNumber(arguments[0], 1, kMidiChannelCount);
+  const auto first = parseNumber(arguments[1], 0, kMidiDataMax);
+  const auto second = note_off ? std::optional<int>(0) : parseNumber(arguments[2], 0, kMidiDataMax);
+  if (!channel || !first || !second) {
+    return std::nullopt;
+  }
+  if (name == "note-on") {
+    return midiEvent(kNoteOnStatus, *channel, *first, *second);
+  }
+  if (note_off) {
+    return midiEvent(kNoteOffStatus, *channel, *first, 0);
+  }
+  return midiEvent(kControllerStatus, *channel, *first, *second);
+}
+
+auto parseTape(Tokens arguments, double sample_rate) -> std::optional<RenderEvent> {
+  if (arguments.empty()) {
+    return std::nullopt;
+  }
+  const auto &action = arguments.front();
+  if (arguments.size() == 1 && (action == "play" || action == "stop")) {
+    return RenderEvent{.command =
+                           action == "play" ? RenderCommand::kTapePlay : RenderCommand::kTapeStop};
+  }
+  if (arguments.size() == 2 && action == "locate") {
+    const auto frame = parseTime(arguments[1], sample_rate);
+    if (!frame) {
+      return std::nullopt;
+    }
+    return RenderEvent{.command = RenderCommand::kTapeLocate, .value = static_cast<double>(*frame)};
+  }
+  if (arguments.size() == 2 && action == "speed") {
+    const auto speed = parseReal(arguments[1]);
+    if (!speed || *speed < limit::kTapeMinSpeed || *speed > limit::kTapeMaxSpeed) {
+      return std::nullopt;
+    }
+    return RenderEvent{.command = RenderCommand::kTapeSpeed, .value = *speed};
+  }
+  if (arguments.size() == 2 && (action == "reverse" || action == "brake")) {
+    const auto state = parseSwitch(arguments[1]);
+    if (!state) {
+      return std::nullopt;
+    }
+    return RenderEvent{.command = action == "reverse" ? RenderCommand::kTapeReverse
+                                                      : RenderCommand::kTapeBrake,
+                       .value = *state};
+  }
+  if (arguments.size() == 2 && action == "loop" && arguments[1] == "off") {
+    return RenderEvent{.command = RenderCommand::kTapeLoopOff};
+  }
+  if (arguments.size() == 3 && action == "loop") {
+    const auto start = parseTime(arguments[1], sample_rate);
+    const auto end = parseTime(arguments[2], sample_rate);
+    if (!start || !end || *end <= *start) {
+      return std::nullopt;
+    }
+    return RenderEvent{.command = RenderCommand::kTapeLoop,
+                       .value = static_cast<double>(*start),
+                       .end_frame = *end};
+  }
+  return std::nullopt;
+}
+
+auto parseMix(Tokens arguments) -> std::optional<RenderEvent> {
+  constexpr std::array<std::pair<std::string_view, RenderCommand>, 4> kControls{{
+      {"level", RenderCommand::kMixLevel},
+      {"pan", RenderCommand::kMixPan},
+      {"send1", RenderCommand::kMixSend1},
+      {"send2", RenderCommand::kMixSend2},
+  }};
+  if (arguments.size() != 3) {
+    return std::nullopt;
+  }
+  const auto track = parseNumber(arguments[0], 1, limit::kTapeTrackCount);
+  const auto *const control =
+      std::find_if(kControls.begin(), kControls.end(),
+                   [&arguments](const auto &entry) { return entry.first == arguments[1]; });
+  const auto percent = parseReal(arguments[2]);
+  if (!track || control == kControls.end() || !percent) {
+    return std::nullopt;
+  }
+  const auto low = control->second == RenderCommand::kMixPan ? -kMaxPercent : 0.0;
+  if (*percent < low || *percent > kMaxPercent) {
+    return std::nullopt;
+  }
+  return RenderEvent{.command = control->second, .track = *track - 1, .value = *percent};
+}
+
+auto parseEvent(Tokens tokens, double sample_rate) -> std::optional<RenderEvent> {
+  const auto &name = tokens.front();
+  const auto arguments = tokens.subspan(1);
+  if (name == "note-on" || name == "note-off" || name == "cc") {
+    return parseMidi(tokens);
+  }
+  if (name == "tape") {
+    return parseTape(arguments, sample_rate);
+  }
+  if (name == "mix") {
+    return parseMix(arguments);
+  }
+  if (name == "phrase" && arguments.size() == 1) {
+    const auto slot = parseNumber(arguments[0], 1, limit::kPhraseSlotCount);
+    if (!slot) {
+      return std::nullopt;
+    }
+    return RenderEvent{.command = RenderCommand::kPhrase, .value = static_cast<double>(*slot - 1)};
+  }
+  if (name == "sequencer" && arguments.size() == 1 &&
+      (arguments[0] == "play" || arguments[0] == "stop")) {
+    return RenderEvent{.command = arguments[0] == "play" ? RenderCommand::kSequencerPlay
+                                                         : RenderCommand::kSequencerStop};
+  }
+  if (name == "tempo" && arguments.size() == 1) {
+    const auto bpm = parseReal(arguments[0]);
+    if (!bpm || *bpm < limit::kMinTempoBpm || *bpm > limit::kMaxTempoBpm) {
+      return std::nullopt;
+    }
+    return RenderEvent{.command = RenderCommand::kTempo, .value = *bpm};
+  }
+  return std::nullopt;
+}
+
+auto applyLine(std::string_view line, double sample_rate, limit::RenderScript &script) -> bool {
+  const auto tokenized = tokenize(line);
+  if (!tokenized || tokenized->second < 2) {
+    return false;
+  }
+  const auto tokens = std::span(tokenized->first).first(tokenized->second);
+  if (tokens.front() == "length") {
+    const auto length = tokens.size() == 2 ? parseTime(tokens[1], sample_rate) : std::nullopt;
+    if (!length) {
+      return false;
+    }
+    script.length_frames = *length;
+    return true;
+  }
+  const auto frame = parseTime(tokens.front(), sample_rate);
+  auto event = frame ? parseEvent(tokens.subspan(1), sample_rate) : std::nullopt;
+  if (!event) {
+    return false;
+  }
+  event->frame = *frame;
+  script.events.push_back(*event);
+  return true;
+}
+} // namespace
+
+namespace limit {
+auto parseRenderScript(std::string_view text, double sample_rate) -> RenderScript {
+  RenderScript script;
+  int line_number = 0;
+  while (!text.empty()) {
+    const auto line_end = std::min(text.find('\n'), text.size());
+    const auto line = text.substr(0, line_end);
+    text.remove_prefix(std::min(line_end + 1, text.size()));
+    ++line_number;
+
+    const auto first = line.find_first_not_of(" \t\r");
+    if (first == std::string_view::npos || line.at(first) == '#') {
+      continue;
+    }
+    if (applyLine(line, sample_rate, script)) {
+      ++script.applied;
+    } else if (script.rejected++ == 0) {
+      script.first_rejected_line = line_number;
+    }
+  }
+  std::stable_sort(script.events.begin(), script.events.end(),
+                   [](const RenderEvent &left, const RenderEvent &right) {
+                     return left.frame < right.frame;
+                   });
+  return script;
+}
+
+auto loadRenderScript(const std::filesystem::path &path, double sample_rate)
+    -> std::optional<RenderScript> {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return std::nullopt;
+  }
+  const std::string text{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+  return parseRenderScript(text, sample_rate);
+}
+} // namespace limit
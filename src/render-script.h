@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace limit {
+enum class RenderCommand : std::uint8_t {
+  kMidi,
+  kTapePlay,
+  kTapeStop,
+  kTapeLocate,
+  kTapeSpeed,
+  kTapeReverse,
+  kTapeBrake,
+  kTapeLoop,
+  kTapeLoopOff,
+  kMixLevel,
+  kMixPan,
+  kMixSend1,
+  kMixSend2,
+  kPhrase,
+  kSequencerPlay,
+  kSequencerStop,
+  kTempo,
+};
+
+// One scripted event. midi holds the raw message for kMidi; value is the
+// speed, tempo, percentage, on/off (0 or 1), phrase slot or locate/loop start
+// frame; end_frame is the loop end.
+struct RenderEvent {
+  std::int64_t frame = 0;
+  RenderCommand command = RenderCommand::kMidi;
+  std::array<std::uint8_t, 3> midi{};
+  int midi_size = 0;
+  int track = 0;
+  double value = 0.0;
+  std::int64_t end_frame = 0;
+};
+
+// A parsed script: events sorted by frame (ties keep file order) and the
+// number of frames to render.
+struct RenderScript {
+  std::vector<RenderEvent> events;
+  std::int64_t length_frames = 0;
+  int applied = 0;
+  int rejected = 0;
+  int first_rejected_line = 0;
+};
+
+// Scripts drive the headless renderer. One event per line, each starting
+// with its time in frames, or in seconds with an s suffix:
+//
+//   length <time>                         length 8s
+//   <time> note-on <ch> <note> <vel>      0 note-on 1 60 100
+//   <time> note-off <ch> <note>           1.5s note-off 1 60
+//   <time> cc <ch> <cc> <value>           0 cc 1 74 64
+//   <time> tape play|stop                 0 tape play
+//   <time> tape locate <frame>            0 tape locate 48000
+//   <time> tape speed <0.25-2>            2s tape speed 0.5
+//   <time> tape reverse|brake on|off      3s tape brake on
+//   <time> tape loop <start> <end>|off    4s tape loop 1s 2s
+//   <time> mix <track> level|pan|send1|send2 <percent>
+//   <time> phrase <slot>                  recalls a phrase into the sequencer
+//   <time> sequencer play|stop
+//   <time> tempo <bpm>
+//
+// Tracks, channels and phrase slots count from 1. Blank lines and lines
+// starting with # are ignored; malformed lines are skipped and counted.
+auto parseRenderScript(std::string_view text, double sample_rate) -> RenderScript;
+auto loadRenderScript(const std::filesystem::path &path, double sample_rate)
+    -> std::optional<RenderScript>;
+} // namespace limit
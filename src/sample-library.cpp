@@ -0,0 +1,274 @@
+#include "sample-library.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <limits>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <utility>
+
+#include <juce_audio_formats/juce_audio_formats.h>
+
+namespace limit {
+namespace {
+constexpr int kMaxSampleChannels = 2;
+// Zero frames appended to the source so the interpolator's look-ahead stays
+// inside the buffer at the end of the sample.
+constexpr int kInterpolatorPadding = 8;
+constexpr std::array<std::string_view, 3> kSampleExtensions = {".wav", ".aif", ".aiff"};
+
+auto isSampleFile(const std::filesystem::path &path) -> bool {
+  auto extension = path.extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char letter) {
+    return static_cast<char>(std::tolower(letter));
+  });
+  return std::find(kSampleExtensions.begin(), kSampleExtensions.end(), extension) !=
+         kSampleExtensions.end();
+}
+
+auto resample(const juce::AudioBuffer<float> &source, double ratio) -> juce::AudioBuffer<float> {
+  const auto source_frames = source.getNumSamples() - kInterpolatorPadding;
+  const auto frames = static_cast<int>(std::floor(static_cast<double>(source_frames) / ratio));
+  juce::AudioBuffer<float> resampled(source.getNumChannels(), frames);
+  for (int channel = 0; channel < source.getNumChannels(); ++channel) {
+    juce::LagrangeInterpolator interpolator;
+    interpolator.process(ratio, source.getReadPointer(channel), resampled.getWritePointer(channel),
+                         frames);
+  }
+  return resampled;
+}
+} // namespace
+
+auto DecodedSample::bytes() const -> std::size_t {
+  return sizeof(float) * static_cast<std::size_t>(audio.getNumChannels()) *
+         static_cast<std::size_t>(audio.getNumSamples());
+}
+
+auto decodeSampleFile(const std::filesystem::path &path, int sample_rate)
+    -> std::shared_ptr<const DecodedSample> {
+  juce::AudioFormatManager formats;
+  formats.registerBasicFormats();
+  const std::unique_ptr<juce::AudioFormatReader> reader(
+      formats.createReaderFor(juce::File(juce::String(path.string()))));
+  if (reader == nullptr || reader->numChannels == 0 || reader->sampleRate <= 0.0 ||
+      reader->lengthInSamples <= 0 ||
+      reader->lengthInSamples > std::numeric_limits<int>::max() - kInterpolatorPadding) {
+    return nullptr;
+  }
+
+  const auto channels = std::min(static_cast<int>(reader->numChannels), kMaxSampleChannels);
+  const auto frames = static_cast<int>(reader->lengthInSamples);
+  const auto needs_resampling = !juce::exactlyEqual(reader->sampleRate,
+                                                    static_cast<double>(sample_rate));
+  juce::AudioBuffer<float> audio(channels, frames + (needs_resampling ? kInterpolatorPadding : 0));
+  audio.clear();
+  if (!reader->read(&audio, 0, frames, 0, true, channels > 1)) {
+    return nullptr;
+  }
+
+  auto decoded = std::make_shared<DecodedSample>();
+  decoded->source_rate = reader->sampleRate;
+  decoded->audio = needs_resampling
+                       ? resample(audio, reader->sampleRate / static_cast<double>(sample_rate))
+                       : std::move(audio);
+  return decoded;
+}
+
+auto SampleLibrary::open(const SampleLibraryConfig &config) -> std::unique_ptr<SampleLibrary> {
+  if (config.sample_rate <= 0 || config.worker_count <= 0) {
+    return nullptr;
+  }
+  std::error_code error;
+  if (!std::filesystem::is_directory(config.directory, error)) {
+    return nullptr;
+  }
+
+  auto library = std::unique_ptr<SampleLibrary>(new SampleLibrary(config));
+  library->scan();
+  for (int worker = 0; worker < config.worker_count; ++worker) {
+    library->workers.emplace_back([raw = library.get()] { raw->runWorkerLoop(); });
+  }
+  return library;
+}
+
+SampleLibrary::SampleLibrary(const SampleLibraryConfig &library_config)
+    : config(library_config) {}
+
+SampleLibrary::~SampleLibrary() {
+  {
+    const std::scoped_lock lock(cache_mutex);
+    stopping = true;
+    decode_queue.clear();
+  }
+  work_available.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+auto SampleLibrary::sampleCount() const -> int { return static_cast<int>(samples.size()); }
+
+auto SampleLibrary::info(int id) const -> const SampleInfo & {
+  return samples.at(static_cast<std::size_t>(id));
+}
+
+auto SampleLibrary::find(const std::string &category, const std::string &name) const -> int {
+  const auto match = std::find_if(samples.begin(), samples.end(), [&](const SampleInfo &sample) {
+    return sample.category == category && sample.name == name;
+  });
+  return match == samples.end() ? -1 : static_cast<int>(match - samples.begin());
+}
+
+void SampleLibrary::request(int id) {
+  if (id < 0 || id >= sampleCount()) {
+    return;
+  }
+  {
+    const std::scoped_lock lock(cache_mutex);
+    queueDecode(id);
+  }
+  work_available.notify_one();
+}
+
+auto SampleLibrary::acquire(int id) -> SampleHandle {
+  if (id < 0 || id >= sampleCount()) {
+    return nullptr;
+  }
+  {
+    const std::scoped_lock lock(cache_mutex);
+    auto &entry = entries.at(static_cast<std::size_t>(id));
+    if (entry.sample != nullptr) {
+      entry.last_used = ++use_clock;
+      return entry.sample;
+    }
+    queueDecode(id);
+  }
+  work_available.notify_one();
+  return nullptr;
+}
+
+auto SampleLibrary::isCached(int id) const -> bool {
+  const std::scoped_lock lock(cache_mutex);
+  return id >= 0 && id < sampleCount() &&
+         entries.at(static_cast<std::size_t>(id)).sample != nullptr;
+}
+
+auto SampleLibrary::cachedBytes() const -> std::size_t {
+  const std::scoped_lock lock(cache_mutex);
+  return cached_bytes;
+}
+
+auto SampleLibrary::pendingCount() const -> int {
+  const std::scoped_lock lock(cache_mutex);
+  return static_cast<int>(decode_queue.size()) + decoding;
+}
+
+auto SampleLibrary::failedCount() const -> int {
+  const std::scoped_lock lock(cache_mutex);
+  return failed;
+}
+
+void SampleLibrary::waitUntilIdle() {
+  std::unique_lock lock(cache_mutex);
+  work_finished.wait(lock, [this] { return decode_queue.empty() && decoding == 0; });
+}
+
+// Sorted so sample ids are stable for a given set of files.
+void SampleLibrary::scan() {
+  std::error_code error;
+  for (std::filesystem::recursive_directory_iterator it(config.directory, error), end;
+       !error && it != end; it.increment(error)) {
+    if (!it->is_regular_file(error) || !isSampleFile(it->path())) {
+      continue;
+    }
+    SampleInfo sample;
+    sample.path = it->path();
+    sample.name = it->path().stem().string();
+    sample.category =
+        it->path().parent_path().lexically_relative(config.directory).generic_string();
+    if (sample.category == ".") {
+      sample.category.clear();
+    }
+    sample.file_bytes = it->file_size(error);
+    samples.push_back(std::move(sample));
+  }
+  std::sort(samples.begin(), samples.end(), [](const SampleInfo &a, const SampleInfo &b) {
+    return std::tie(a.category, a.name) < std::tie(b.category, b.name);
+  });
+  entries.resize(samples.size());
+}
+
+void SampleLibrary::queueDecode(int id) {
+  auto &entry = entries.at(static_cast<std::size_t>(id));
+  if (entry.sample != nullptr || entry.queued || entry.failed) {
+    return;
+  }
+  entry.queued = true;
+  decode_queue.push_back(id);
+}
+
+void SampleLibrary::storeDecoded(int id, SampleHandle sample) {
+  auto &entry = entries.at(static_cast<std::size_t>(id));
+  entry.queued = false;
+  if (sample == nullptr) {
+    entry.failed = true;
+    ++failed;
+    return;
+  }
+  cached_bytes += sample->bytes();
+  entry.sample = std::move(sample);
+  entry.last_used = ++use_clock;
+  evictUnpinned(id);
+}
+
+// Drops least recently used samples until the cache fits its budget. A
+// sample with a handle outside the cache is pinned and never dropped, so a
+// sample's memory is only ever released here, off the audio thread.
+void SampleLibrary::evictUnpinned(int keep_id) {
+  while (cached_bytes > config.cache_bytes) {
+    CacheEntry *oldest = nullptr;
+    for (std::size_t id = 0; id < entries.size(); ++id) {
+      auto &entry = entries.at(id);
+      if (static_cast<int>(id) == keep_id || entry.sample == nullptr ||
+          entry.sample.use_count() > 1) {
+        continue;
+      }
+      if (oldest == nullptr || entry.last_used < oldest->last_used) {
+        oldest = &entry;
+      }
+    }
+    if (oldest == nullptr) {
+      return;
+    }
+    cached_bytes -= oldest->sample->bytes();
+    oldest->sample.reset();
+  }
+}
+
+void SampleLibrary::runWorkerLoop() {
+  std::unique_lock lock(cache_mutex);
+  while (true) {
+    work_available.wait(lock, [this] { return stopping || !decode_queue.empty(); });
+    if (stopping) {
+      return;
+    }
+    const auto id = decode_queue.front();
+    decode_queue.pop_front();
+    ++decoding;
+    const auto path = samples.at(static_cast<std::size_t>(id)).path;
+
+    lock.unlock();
+    auto sample = decodeSampleFile(path, config.sample_rate);
+    lock.lock();
+
+    storeDecoded(id, std::move(sample));
+    --decoding;
+    if (decode_queue.empty() && decoding == 0) {
+      work_finished.notify_all();
+    }
+  }
+}
+} // namespace limit
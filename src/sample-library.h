@@ -0,0 +1,123 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+namespace limit {
+constexpr int kSampleLibraryRate = 48000;
+constexpr std::size_t kSampleCacheBytes = 128 * 1024 * 1024;
+constexpr int kSampleDecodeWorkers = 2;
+
+// What a scan learns about a sample file: nothing is opened or decoded.
+// The category is the sample's folder relative to the library root
+// ("drums/kick", "synth"), empty for files at the root.
+struct SampleInfo {
+  std::filesystem::path path;
+  std::string name;
+  std::string category;
+  std::uintmax_t file_bytes = 0;
+};
+
+// A sample decoded and resampled to the library rate. Immutable once
+// published, so any number of readers can share it without locking.
+struct DecodedSample {
+  juce::AudioBuffer<float> audio;
+  double source_rate = 0.0;
+
+  auto bytes() const -> std::size_t;
+};
+
+struct SampleLibraryConfig {
+  std::filesystem::path directory;
+  int sample_rate = kSampleLibraryRate;
+  std::size_t cache_bytes = kSampleCacheBytes;
+  int worker_count = kSampleDecodeWorkers;
+};
+
+// Index of the sample files under a directory plus a cache of decoded audio.
+// Opening only walks the directory, so cold start costs one stat per file.
+// Samples are decoded on first request by a small worker pool, resampled
+// once to the session rate, and kept in a cache bounded by cache_bytes that
+// drops the least recently used samples nobody holds.
+//
+// acquire() never waits: it returns the cached sample or nullptr and queues
+// the decode. Callers keep the returned handle for as long as they play the
+// sample, which pins it in the cache; an audio thread given only raw
+// pointers into pinned samples never waits for a decode or a free.
+// KitSampler does not go through the library: it decodes only the attack
+// of each zone and streams the rest from disk.
+class SampleLibrary {
+public:
+  using SampleHandle = std::shared_ptr<const DecodedSample>;
+
+  static auto open(const SampleLibraryConfig &config) -> std::unique_ptr<SampleLibrary>;
+
+  ~SampleLibrary();
+  SampleLibrary(const SampleLibrary &) = delete;
+  auto operator=(const SampleLibrary &) -> SampleLibrary & = delete;
+  SampleLibrary(SampleLibrary &&) = delete;
+  auto operator=(SampleLibrary &&) -> SampleLibrary & = delete;
+
+  // Any thread but the audio thread.
+  auto sampleCount() const -> int;
+  auto info(int id) const -> const SampleInfo &;
+  auto find(const std::string &category, const std::string &name) const -> int;
+
+  void request(int id);
+  auto acquire(int id) -> SampleHandle;
+  auto isCached(int id) const -> bool;
+  auto cachedBytes() const -> std::size_t;
+  auto pendingCount() const -> int;
+  auto failedCount() const -> int;
+
+  // Blocks until every queued decode has finished. For tests and offline use.
+  void waitUntilIdle();
+
+private:
+  struct CacheEntry {
+    SampleHandle sample;
+    std::uint64_t last_used = 0;
+    bool queued = false;
+    bool failed = false;
+  };
+
+  explicit SampleLibrary(const SampleLibraryConfig &config);
+
+  void scan();
+  void queueDecode(int id);
+  void storeDecoded(int id, SampleHandle sample);
+  void evictUnpinned(int keep_id);
+  void runWorkerLoop();
+
+  SampleLibraryConfig config;
+  std::vector<SampleInfo> samples;
+
+  mutable std::mutex cache_mutex;
+  std::condition_variable work_available;
+  std::condition_variable work_finished;
+  std::vector<CacheEntry> entries;
+  std::deque<int> decode_queue;
+  std::size_t cached_bytes = 0;
+  std::uint64_t use_clock = 0;
+  int decoding = 0;
+  int failed = 0;
+  bool stopping = false;
+
+  std::vector<std::thread> workers;
+};
+
+// Decodes a sample file with the basic JUCE formats and resamples it to
+// sample_rate. Returns nullptr when the file can't be read.
+auto decodeSampleFile(const std::filesystem::path &path, int sample_rate)
+    -> std::shared_ptr<const DecodedSample>;
+} // namespace limit
@@ -0,0 +1,35 @@
+#include "signal-flow.h"
+
+namespace limit {
+auto computeSignalOrder(std::span<const SignalEdge> edges) -> std::optional<SignalOrder> {
+  std::array<int, kSignalNodeCount> pending_inputs{};
+  for (const auto &edge : edges) {
+    ++pending_inputs.at(signalNodeIndex(edge.to));
+  }
+
+  std::array<bool, kSignalNodeCount> emitted{};
+  SignalOrder order{};
+  for (std::size_t position = 0; position < kSignalNodeCount; ++position) {
+    std::optional<std::size_t> ready;
+    for (std::size_t index = 0; index < kSignalNodeCount; ++index) {
+      if (!emitted.at(index) && pending_inputs.at(index) == 0) {
+        ready = index;
+        break;
+      }
+    }
+    if (!ready) {
+      return std::nullopt;
+    }
+
+    emitted.at(*ready) = true;
+    const auto node = static_cast<SignalNode>(*ready);
+    order.at(position) = node;
+    for (const auto &edge : edges) {
+      if (edge.from == node) {
+        --pending_inputs.at(signalNodeIndex(edge.to));
+      }
+    }
+  }
+  return order;
+}
+} // namespace limit
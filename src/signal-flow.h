@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace limit {
+constexpr int kStereoChannelCount = 2;
+constexpr int kTapeTrackCount = 8;
+constexpr std::size_t kSignalNodeCount = 8;
+
+// Fixed processing stages from the signal flow in docs/design.md.
+enum class SignalNode : std::uint8_t {
+  kInstrument,
+  kInsert,
+  kTapeTracks,
+  kTrackMix,
+  kSend1Effect,
+  kSend2Effect,
+  kMasterEq,
+  kMasterEffect,
+};
+
+struct SignalEdge {
+  SignalNode from = SignalNode::kInstrument;
+  SignalNode to = SignalNode::kInstrument;
+};
+
+using SignalOrder = std::array<SignalNode, kSignalNodeCount>;
+
+constexpr std::array<SignalEdge, 9> kSignalEdges = {{
+    {.from = SignalNode::kInstrument, .to = SignalNode::kInsert},
+    {.from = SignalNode::kInsert, .to = SignalNode::kTapeTracks},
+    {.from = SignalNode::kTapeTracks, .to = SignalNode::kTrackMix},
+    {.from = SignalNode::kTrackMix, .to = SignalNode::kSend1Effect},
+    {.from = SignalNode::kTrackMix, .to = SignalNode::kSend2Effect},
+    {.from = SignalNode::kTrackMix, .to = SignalNode::kMasterEq},
+    {.from = SignalNode::kSend1Effect, .to = SignalNode::kMasterEq},
+    {.from = SignalNode::kSend2Effect, .to = SignalNode::kMasterEq},
+    {.from = SignalNode::kMasterEq, .to = SignalNode::kMasterEffect},
+}};
+
+constexpr auto signalNodeIndex(SignalNode node) -> std::size_t {
+  return static_cast<std::size_t>(node);
+}
+
+constexpr auto signalNodeName(SignalNode node) -> std::string_view {
+  switch (node) {
+  case SignalNode::kInstrument:
+    return "instrument";
+  case SignalNode::kInsert:
+    return "insert";
+  case SignalNode::kTapeTracks:
+    return "tape tracks";
+  case SignalNode::kTrackMix:
+    return "track mix";
+  case SignalNode::kSend1Effect:
+    return "send 1 effect";
+  case SignalNode::kSend2Effect:
+    return "send 2 effect";
+  case SignalNode::kMasterEq:
+    return "master eq";
+  case SignalNode::kMasterEffect:
+    return "master effect";
+  }
+  return "unknown";
+}
+
+// Topologically sorts the nodes so every stage runs after its inputs. Ties are
+// broken by enum order so the result is deterministic. Returns nullopt when the
+// edges contain a cycle.
+auto computeSignalOrder(std::span<const SignalEdge> edges) -> std::optional<SignalOrder>;
+} // namespace limit
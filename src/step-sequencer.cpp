@@ -0,0 +1,180 @@
+#include "step-sequencer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace limit {
+namespace {
+constexpr double kSecondsPerMinute = 60.0;
+} // namespace
+
+void StepSequencer::prepare(double new_sample_rate) {
+  sample_rate = new_sample_rate;
+  note_offs.fill({});
+  next_step_time = 0.0;
+  block_start = 0;
+  next_step = 0;
+  playing = false;
+  current_step.store(-1, std::memory_order_relaxed);
+}
+
+// Single writer. The audio thread only holds the slot for the length of one
+// pattern copy, so the wait here is short and never happens on its side.
+void StepSequencer::setPattern(const StepPattern &pattern) {
+  auto state = pattern_slot.load(std::memory_order_acquire);
+  while (true) {
+    if (state == PatternSlot::kReading) {
+      std::this_thread::yield();
+      state = pattern_slot.load(std::memory_order_acquire);
+    } else if (pattern_slot.compare_exchange_weak(state, PatternSlot::kWriting,
+                                                  std::memory_order_acquire)) {
+      break;
+    }
+  }
+  pending_pattern = pattern;
+  pending_pattern.length = std::clamp(pattern.length, 1, kMaxPhraseSteps);
+  pattern_slot.store(PatternSlot::kReady, std::memory_order_release);
+}
+
+void StepSequencer::setTempo(double bpm) {
+  tempo_bpm.store(std::clamp(bpm, kMinTempoBpm, kMaxTempoBpm), std::memory_order_relaxed);
+}
+
+void StepSequencer::setSwing(float swing) {
+  swing_amount.store(std::clamp(swing, 0.0f, kMaxSwing), std::memory_order_relaxed);
+}
+
+void StepSequencer::start() { run_requested.store(true, std::memory_order_release); }
+
+void StepSequencer::stop() { run_requested.store(false, std::memory_order_release); }
+
+auto StepSequencer::isRunning() const -> bool {
+  return run_requested.load(std::memory_order_acquire);
+}
+
+auto StepSequencer::tempo() const -> double { return tempo_bpm.load(std::memory_order_relaxed); }
+
+auto StepSequencer::swing() const -> float {
+  return swing_amount.load(std::memory_order_relaxed);
+}
+
+auto StepSequencer::currentStep() const -> int {
+  return current_step.load(std::memory_order_relaxed);
+}
+
+void StepSequencer::process(juce::MidiBuffer &midi, int num_samples) {
+  if (sample_rate <= 0.0 || num_samples <= 0) {
+    return;
+  }
+  acceptPendingPattern();
+  const auto requested = run_requested.load(std::memory_order_acquire);
+  if (requested && !playing) {
+    playing = true;
+    next_step = 0;
+    next_step_time = 0.0;
+    block_start = 0;
+  } else if (!requested && playing) {
+    releaseAll(midi);
+    playing = false;
+    current_step.store(-1, std::memory_order_relaxed);
+  }
+  if (!playing) {
+    return;
+  }
+
+  // Step times are absolute sample positions since start, advanced one step
+  // at a time, so where a step lands never depends on the block size. A step
+  // starts on the first sample at or after its boundary.
+  samples_per_step = samplesPerStep(sample_rate, tempo_bpm.load(std::memory_order_relaxed));
+  const auto swing = static_cast<double>(swing_amount.load(std::memory_order_relaxed));
+  const auto block_end = block_start + num_samples;
+  while (true) {
+    const auto is_swung = (next_step % 2) == 1;
+    const auto boundary = next_step_time + (is_swung ? swing * samples_per_step : 0.0);
+    const auto sample = static_cast<std::int64_t>(std::ceil(boundary));
+    if (sample >= block_end) {
+      break;
+    }
+    flushNoteOffs(midi, sample + 1);
+    startStep(midi, sample);
+    next_step_time += samples_per_step;
+    next_step = (next_step + 1) % active_pattern.length;
+  }
+  flushNoteOffs(midi, block_end);
+  block_start = block_end;
+}
+
+auto StepSequencer::samplesPerStep(double rate, double bpm) -> double {
+  const auto clamped = std::clamp(bpm, kMinTempoBpm, kMaxTempoBpm);
+  return rate * kSecondsPerMinute / (clamped * kStepsPerBeat);
+}
+
+void StepSequencer::acceptPendingPattern() {
+  auto expected = PatternSlot::kReady;
+  if (!pattern_slot.compare_exchange_strong(expected, PatternSlot::kReading,
+                                            std::memory_order_acquire)) {
+    return;
+  }
+  active_pattern = pending_pattern;
+  pattern_slot.store(PatternSlot::kEmpty, std::memory_order_release);
+  if (next_step >= active_pattern.length) {
+    next_step = 0;
+  }
+}
+
+void StepSequencer::startStep(juce::MidiBuffer &midi, std::int64_t sample) {
+  const auto &step = active_pattern.steps.at(static_cast<std::size_t>(next_step));
+  current_step.store(next_step, std::memory_order_relaxed);
+  if (step.velocity == 0) {
+    return;
+  }
+
+  // A retriggered note is cut first so its pending note-off cannot end the
+  // new note early; with no free slot the oldest note is cut instead.
+  const auto note = static_cast<int>(step.note);
+  auto *slot = &note_offs.front();
+  for (auto &note_off : note_offs) {
+    if (note_off.note == note) {
+      slot = &note_off;
+      break;
+    }
+    if (note_off.note < 0 || (slot->note >= 0 && note_off.sample < slot->sample)) {
+      slot = &note_off;
+    }
+  }
+  if (slot->note >= 0) {
+    addNoteOff(midi, slot->note, sample);
+  }
+
+  const auto on = juce::MidiMessage::noteOn(active_pattern.channel, note, step.velocity);
+  midi.addEvent(on, static_cast<int>(sample - block_start));
+  const auto gate = static_cast<double>(std::clamp(step.gate, 0.0f, 1.0f));
+  slot->note = note;
+  slot->sample = sample + std::max<std::int64_t>(std::llround(gate * samples_per_step), 1);
+}
+
+// Emits every pending note-off that falls before the given sample.
+void StepSequencer::flushNoteOffs(juce::MidiBuffer &midi, std::int64_t before) {
+  for (auto &note_off : note_offs) {
+    if (note_off.note >= 0 && note_off.sample < before) {
+      addNoteOff(midi, note_off.note, note_off.sample);
+      note_off.note = -1;
+    }
+  }
+}
+
+void StepSequencer::releaseAll(juce::MidiBuffer &midi) {
+  for (auto &note_off : note_offs) {
+    if (note_off.note >= 0) {
+      addNoteOff(midi, note_off.note, block_start);
+      note_off.note = -1;
+    }
+  }
+}
+
+void StepSequencer::addNoteOff(juce::MidiBuffer &midi, int note, std::int64_t sample) const {
+  midi.addEvent(juce::MidiMessage::noteOff(active_pattern.channel, note),
+                static_cast<int>(sample - block_start));
+}
+} // namespace limit
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+namespace limit {
+constexpr int kMaxPhraseSteps = 64;
+constexpr int kDefaultPhraseSteps = 16;
+constexpr int kStepsPerBeat = 4;
+constexpr double kDefaultTempoBpm = 120.0;
+constexpr double kMinTempoBpm = 20.0;
+constexpr double kMaxTempoBpm = 300.0;
+constexpr float kMaxSwing = 0.75f;
+constexpr std::uint8_t kDefaultStepNote = 60;
+constexpr float kDefaultStepGate = 0.5f;
+// The most events process() adds to one block: a note on and a note off per
+// step, for any block shorter than a full phrase at the fastest tempo.
+constexpr int kMaxSequencerEventsPerBlock = 2 * kMaxPhraseSteps;
+
+// One step of a phrase. A velocity of zero is a rest; gate is the note length
+// as a fraction of a step.
+struct SequencerStep {
+  std::uint8_t note = kDefaultStepNote;
+  std::uint8_t velocity = 0;
+  float gate = kDefaultStepGate;
+};
+
+// Flat step array for one phrase, copied by value so the audio thread reads
+// one contiguous block with no indirection.
+struct StepPattern {
+  std::array<SequencerStep, kMaxPhraseSteps> steps{};
+  int length = kDefaultPhraseSteps;
+  int channel = 1;
+};
+
+// Step sequencer clock that runs inside the audio callback. Step boundaries
+// are computed from tempo, swing and phrase length to the sample and written
+// straight into the block's MIDI buffer, so timing never depends on message
+// or MIDI thread load. Odd steps are delayed by swing (a fraction of a step).
+//
+// The message thread edits patterns and transport through the setters; the
+// audio thread picks changes up at the next block boundary without waiting.
+class StepSequencer {
+public:
+  // Message thread, while the audio callback is stopped.
+  void prepare(double sample_rate);
+
+  // Message thread.
+  void setPattern(const StepPattern &pattern);
+  void setTempo(double bpm);
+  void setSwing(float swing);
+  void start();
+  void stop();
+  auto isRunning() const -> bool;
+  auto tempo() const -> double;
+  auto swing() const -> float;
+
+  // Any thread: the step most recently started, or -1 when stopped.
+  auto currentStep() const -> int;
+
+  // Audio thread: adds this block's note events at their sample offsets. The
+  // buffer must have room reserved; nothing here allocates.
+  void process(juce::MidiBuffer &midi, int num_samples);
+
+  static auto samplesPerStep(double rate, double bpm) -> double;
+
+private:
+  struct PendingNoteOff {
+    std::int64_t sample = 0;
+    int note = -1;
+  };
+
+  // Hand-off states for the pending pattern slot.
+  enum class PatternSlot : std::uint8_t { kEmpty, kWriting, kReady, kReading };
+
+  void acceptPendingPattern();
+  void startStep(juce::MidiBuffer &midi, std::int64_t sample);
+  void flushNoteOffs(juce::MidiBuffer &midi, std::int64_t before);
+  void releaseAll(juce::MidiBuffer &midi);
+  void addNoteOff(juce::MidiBuffer &midi, int note, std::int64_t sample) const;
+
+  static constexpr int kMaxPendingNoteOffs = 8;
+
+  // Audio thread state.
+  StepPattern active_pattern;
+  std::array<PendingNoteOff, kMaxPendingNoteOffs> note_offs{};
+  double sample_rate = 0.0;
+  double samples_per_step = 0.0;
+  double next_step_time = 0.0;
+  std::int64_t block_start = 0;
+  int next_step = 0;
+  bool playing = false;
+
+  // Message thread to audio thread.
+  StepPattern pending_pattern;
+  std::atomic<PatternSlot> pattern_slot{PatternSlot::kEmpty};
+  std::atomic<double> tempo_bpm{kDefaultTempoBpm};
+  std::atomic<float> swing_amount{0.0f};
+  std::atomic<bool> run_requested{false};
+  std::atomic<int> current_step{-1};
+};
+} // namespace limit
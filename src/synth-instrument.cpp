@@ -0,0 +1,99 @@
+#include "synth-instrument.h"
+
+#include <algorithm>
+
+namespace limit {
+SynthInstrument::SynthInstrument(const VoiceEngineFactory &factory, int voice_count,
+                                 VoiceStealPolicy policy)
+    : voice_allocator(voice_count, policy) {
+  for (int voice = 0; voice < voice_allocator.voiceCount(); ++voice) {
+    engines.at(static_cast<std::size_t>(voice)) = factory();
+  }
+}
+
+void SynthInstrument::prepare(double sample_rate, int max_block_size) {
+  voice_allocator.reset();
+  for (auto &engine : engines) {
+    if (engine != nullptr) {
+      engine->prepare(sample_rate, max_block_size);
+    }
+  }
+}
+
+void SynthInstrument::process(AudioGraphBuses &buses, const juce::MidiBuffer &midi,
+                              int num_samples) {
+  buses.instrument.clear(0, num_samples);
+  render(buses.instrument, midi, num_samples);
+}
+
+void SynthInstrument::render(juce::AudioBuffer<float> &output, const juce::MidiBuffer &midi,
+                             int num_samples) {
+  int position = 0;
+  for (const auto metadata : midi) {
+    const auto event_position = std::clamp(metadata.samplePosition, position, num_samples);
+    renderVoices(output, position, event_position - position);
+    position = event_position;
+    handleMessage(metadata.getMessage());
+  }
+  renderVoices(output, position, num_samples - position);
+}
+
+auto SynthInstrument::activeVoiceCount() const -> int {
+  return voice_allocator.activeVoiceCount();
+}
+
+auto SynthInstrument::allocator() const -> const VoiceAllocator & { return voice_allocator; }
+
+void SynthInstrument::handleMessage(const juce::MidiMessage &message) {
+  if (message.isNoteOn()) {
+    const auto start = voice_allocator.noteOn(message.getNoteNumber());
+    if (start.voice >= 0) {
+      auto &engine = engines.at(static_cast<std::size_t>(start.voice));
+      if (engine != nullptr) {
+        engine->start(message.getNoteNumber(), message.getFloatVelocity());
+      }
+    }
+  } else if (message.isNoteOff()) {
+    const auto voice = voice_allocator.noteOff(message.getNoteNumber());
+    if (voice >= 0) {
+      auto &engine = engines.at(static_cast<std::size_t>(voice));
+      if (engine != nullptr) {
+        engine->release();
+      }
+    }
+  } else if (message.isController() &&
+             message.getControllerNumber() == kAllNotesOffController) {
+    releaseAll();
+  }
+}
+
+void SynthInstrument::renderVoices(juce::AudioBuffer<float> &output, int start_sample,
+                                   int num_samples) {
+  if (num_samples <= 0) {
+    return;
+  }
+  for (int voice = 0; voice < voice_allocator.voiceCount(); ++voice) {
+    if (!voice_allocator.isVoiceActive(voice)) {
+      continue;
+    }
+    auto &engine = engines.at(static_cast<std::size_t>(voice));
+    const auto sounding =
+        engine != nullptr && engine->render(output.getWritePointer(0, start_sample),
+                                            output.getWritePointer(1, start_sample), num_samples);
+    if (sounding) {
+      voice_allocator.setVoiceLevel(voice, engine->level());
+    } else {
+      voice_allocator.voiceFinished(voice);
+    }
+  }
+}
+
+void SynthInstrument::releaseAll() {
+  for (int note = 0; note < kMidiNoteCount; ++note) {
+    const auto voice = voice_allocator.noteOff(note);
+    if (voice >= 0 && engines.at(static_cast<std::size_t>(voice)) != nullptr) {
+      engines.at(static_cast<std::size_t>(voice))->release();
+    }
+  }
+}
+} // namespace limit
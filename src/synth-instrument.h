@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <memory>
+
+#include "audio-graph.h"
+#include "voice-allocator.h"
+#include "voice-engine.h"
+
+namespace limit {
+// Instrument stage for Sound mode. Owns a fixed pool of voice engines created
+// up front on the message thread; the audio thread only starts, releases and
+// renders them. Each block is split at MIDI event positions so notes start and
+// stop on the exact sample, and voices render in sub-blocks between events.
+class SynthInstrument final : public AudioGraphNode {
+public:
+  explicit SynthInstrument(const VoiceEngineFactory &factory,
+                           int voice_count = kMaxVoices,
+                           VoiceStealPolicy policy = VoiceStealPolicy::kQuietest);
+
+  void prepare(double sample_rate, int max_block_size) override;
+  void process(AudioGraphBuses &buses, const juce::MidiBuffer &midi, int num_samples) override;
+
+  void render(juce::AudioBuffer<float> &output, const juce::MidiBuffer &midi, int num_samples);
+  auto activeVoiceCount() const -> int;
+  auto allocator() const -> const VoiceAllocator &;
+
+private:
+  void handleMessage(const juce::MidiMessage &message);
+  void renderVoices(juce::AudioBuffer<float> &output, int start_sample, int num_samples);
+  void releaseAll();
+
+  static constexpr int kAllNotesOffController = 123;
+
+  VoiceAllocator voice_allocator;
+  std::array<std::unique_ptr<VoiceEngine>, kMaxVoices> engines;
+};
+} // namespace limit
@@ -0,0 +1,136 @@
+#include "tape-mixer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace limit {
+auto computeTrackGains(const TrackMixSettings &settings) -> TrackGains {
+  const auto level = std::max(settings.level, 0.0f);
+  const auto pan = std::clamp(settings.pan, -1.0f, 1.0f);
+  const auto half_pi = juce::MathConstants<float>::halfPi;
+
+  TrackGains gains;
+  gains.master_left = level * (pan <= 0.0f ? 1.0f : std::cos(pan * half_pi));
+  gains.master_right = level * (pan >= 0.0f ? 1.0f : std::cos(-pan * half_pi));
+  gains.send1 = level * std::clamp(settings.send1, 0.0f, 1.0f);
+  gains.send2 = level * std::clamp(settings.send2, 0.0f, 1.0f);
+  return gains;
+}
+
+void TapeMixer::setTrackSettings(int track, const TrackMixSettings &settings) {
+  setTrackRamp(track, settings, settings);
+}
+
+void TapeMixer::setTrackRamp(int track, const TrackMixSettings &start,
+                             const TrackMixSettings &end) {
+  if (track < 0 || track >= kTapeTrackCount) {
+    return;
+  }
+  store(starts.at(static_cast<std::size_t>(track)), start);
+  store(targets.at(static_cast<std::size_t>(track)), end);
+}
+
+auto TapeMixer::trackSettings(int track) const -> TrackMixSettings {
+  if (track < 0 || track >= kTapeTrackCount) {
+    return {};
+  }
+  return load(targets.at(static_cast<std::size_t>(track)));
+}
+
+void TapeMixer::prepare(double /*sample_rate*/, int max_block_size) {
+  const auto size = static_cast<std::size_t>(std::max(max_block_size, 1));
+  ramp.assign(size, 0.0f);
+  ramped_source.assign(size, 0.0f);
+  ramp_length = 0;
+  for (int track = 0; track < kTapeTrackCount; ++track) {
+    store(starts.at(static_cast<std::size_t>(track)), trackSettings(track));
+  }
+}
+
+void TapeMixer::process(AudioGraphBuses &buses, const juce::MidiBuffer & /*midi*/,
+                        int num_samples) {
+  buses.master.clear(0, num_samples);
+  buses.send1.clear(0, num_samples);
+  buses.send2.clear(0, num_samples);
+  mix(buses.tape, buses.master, buses.send1, buses.send2, num_samples);
+}
+
+void TapeMixer::mix(const juce::AudioBuffer<float> &tape, juce::AudioBuffer<float> &master,
+                    juce::AudioBuffer<float> &send1, juce::AudioBuffer<float> &send2,
+                    int num_samples) {
+  num_samples = std::min(num_samples, static_cast<int>(ramp.size()));
+  if (num_samples <= 0) {
+    return;
+  }
+  updateRamp(num_samples);
+
+  for (int track = 0; track < kTapeTrackCount; ++track) {
+    auto &start = starts.at(static_cast<std::size_t>(track));
+    const auto end = trackSettings(track);
+    const auto current = computeTrackGains(load(start));
+    const auto target = computeTrackGains(end);
+
+    for (int channel = 0; channel < kStereoChannelCount; ++channel) {
+      const auto *source = tape.getReadPointer((track * kStereoChannelCount) + channel);
+      const auto master_from = channel == 0 ? current.master_left : current.master_right;
+      const auto master_to = channel == 0 ? target.master_left : target.master_right;
+      const auto ramping = !juce::exactlyEqual(master_from, master_to) ||
+                           !juce::exactlyEqual(current.send1, target.send1) ||
+                           !juce::exactlyEqual(current.send2, target.send2);
+      if (ramping) {
+        juce::FloatVectorOperations::multiply(ramped_source.data(), source, ramp.data(),
+                                              num_samples);
+      }
+
+      accumulate(master.getWritePointer(channel), source, master_from, master_to, num_samples);
+      accumulate(send1.getWritePointer(channel), source, current.send1, target.send1,
+                 num_samples);
+      accumulate(send2.getWritePointer(channel), source, current.send2, target.send2,
+                 num_samples);
+    }
+    store(start, end);
+  }
+}
+
+void TapeMixer::store(AtomicTrackSettings &target, const TrackMixSettings &settings) {
+  target.level.store(settings.level, std::memory_order_relaxed);
+  target.pan.store(settings.pan, std::memory_order_relaxed);
+  target.send1.store(settings.send1, std::memory_order_relaxed);
+  target.send2.store(settings.send2, std::memory_order_relaxed);
+}
+
+auto TapeMixer::load(const AtomicTrackSettings &source) -> TrackMixSettings {
+  return {.level = source.level.load(std::memory_order_relaxed),
+          .pan = source.pan.load(std::memory_order_relaxed),
+          .send1 = source.send1.load(std::memory_order_relaxed),
+          .send2 = source.send2.load(std::memory_order_relaxed)};
+}
+
+void TapeMixer::updateRamp(int num_samples) {
+  if (num_samples == ramp_length) {
+    return;
+  }
+  const auto step = 1.0f / static_cast<float>(num_samples);
+  for (int index = 0; index < num_samples; ++index) {
+    ramp.at(static_cast<std::size_t>(index)) = static_cast<float>(index + 1) * step;
+  }
+  ramp_length = num_samples;
+}
+
+void TapeMixer::accumulate(float *destination, const float *source, float from_gain,
+                           float to_gain, int num_samples) const {
+  // destination += source * (from + (to - from) * ramp), split into two
+  // vector passes; the second reuses the pre-ramped source.
+  if (juce::exactlyEqual(from_gain, to_gain)) {
+    if (!juce::exactlyEqual(to_gain, 0.0f)) {
+      juce::FloatVectorOperations::addWithMultiply(destination, source, to_gain, num_samples);
+    }
+    return;
+  }
+  if (!juce::exactlyEqual(from_gain, 0.0f)) {
+    juce::FloatVectorOperations::addWithMultiply(destination, source, from_gain, num_samples);
+  }
+  juce::FloatVectorOperations::addWithMultiply(destination, ramped_source.data(),
+                                               to_gain - from_gain, num_samples);
+}
+} // namespace limit
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include "audio-graph.h"
+
+namespace limit {
+struct TrackMixSettings {
+  float level = 1.0f;
+  float pan = 0.0f;
+  float send1 = 0.0f;
+  float send2 = 0.0f;
+};
+
+// Gains applied to one stereo tape track. Pan is a balance law that leaves
+// both channels at unity in the centre; sends are post-fader and pre-pan.
+struct TrackGains {
+  float master_left = 1.0f;
+  float master_right = 1.0f;
+  float send1 = 0.0f;
+  float send2 = 0.0f;
+};
+
+auto computeTrackGains(const TrackMixSettings &settings) -> TrackGains;
+
+// Mix mode kernel: sums the eight stereo tape tracks into the master and send
+// buses. Tracks are stored structure-of-arrays (one contiguous buffer per
+// channel) so each destination is a vectorised multiply-accumulate.
+//
+// The mixer does not smooth settings itself. Each block ramps the gains
+// linearly from the settings given for its start to those for its end, as
+// ParameterRamps hands them over; the ramped copy of a source channel is
+// computed once and shared by all of its destinations.
+class TapeMixer final : public AudioGraphNode {
+public:
+  // Any thread. Holds the settings from the next block on, without a ramp.
+  void setTrackSettings(int track, const TrackMixSettings &settings);
+  // Audio thread, before process(). Ramps the next block from start to end,
+  // then holds end.
+  void setTrackRamp(int track, const TrackMixSettings &start, const TrackMixSettings &end);
+  auto trackSettings(int track) const -> TrackMixSettings;
+
+  void prepare(double sample_rate, int max_block_size) override;
+  void process(AudioGraphBuses &buses, const juce::MidiBuffer &midi, int num_samples) override;
+  void mix(const juce::AudioBuffer<float> &tape, juce::AudioBuffer<float> &master,
+           juce::AudioBuffer<float> &send1, juce::AudioBuffer<float> &send2, int num_samples);
+
+private:
+  struct AtomicTrackSettings {
+    std::atomic<float> level{1.0f};
+    std::atomic<float> pan{0.0f};
+    std::atomic<float> send1{0.0f};
+    std::atomic<float> send2{0.0f};
+  };
+
+  static void store(AtomicTrackSettings &target, const TrackMixSettings &settings);
+  static auto load(const AtomicTrackSettings &source) -> TrackMixSettings;
+  void updateRamp(int num_samples);
+  void accumulate(float *destination, const float *source, float from_gain, float to_gain,
+                  int num_samples) const;
+
+  // Settings at the start and the end of the next block.
+  std::array<AtomicTrackSettings, kTapeTrackCount> starts;
+  std::array<AtomicTrackSettings, kTapeTrackCount> targets;
+  std::vector<float> ramp;
+  std::vector<float> ramped_source;
+  int ramp_length = 0;
+};
+} // namespace limit
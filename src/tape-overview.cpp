@@ -0,0 +1,221 @@
+#include "tape-overview.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace limit {
+namespace {
+constexpr float kQuantiseScale = 32767.0f;
+constexpr unsigned kMaxShift = 16U;
+constexpr std::uint32_t kHalfMask = 0xffffU;
+
+auto quantise(float value) -> std::uint32_t {
+  const auto clamped = std::clamp(value, -1.0f, 1.0f);
+  const auto level = static_cast<std::int16_t>(std::lround(clamped * kQuantiseScale));
+  return static_cast<std::uint16_t>(level);
+}
+
+auto dequantise(std::uint32_t bits) -> float {
+  const auto level = static_cast<std::int16_t>(static_cast<std::uint16_t>(bits & kHalfMask));
+  return static_cast<float>(level) / kQuantiseScale;
+}
+
+auto pack(OverviewBucket value) -> std::uint32_t {
+  return quantise(value.min) | (quantise(value.max) << kMaxShift);
+}
+
+auto unpack(std::uint32_t bits) -> OverviewBucket {
+  return {.min = dequantise(bits), .max = dequantise(bits >> kMaxShift)};
+}
+
+auto merge(OverviewBucket first, OverviewBucket second) -> OverviewBucket {
+  return {.min = std::min(first.min, second.min), .max = std::max(first.max, second.max)};
+}
+
+auto emptyRange() -> OverviewBucket {
+  return {.min = std::numeric_limits<float>::max(), .max = std::numeric_limits<float>::lowest()};
+}
+} // namespace
+
+TapeOverview::TapeOverview(int tracks, std::int64_t frames, int frames_per_bucket)
+    : track_count(std::max(tracks, 0)), frame_count(std::max<std::int64_t>(frames, 0)),
+      bucket_frames(std::max(frames_per_bucket, 1)) {
+  auto count = std::max<std::int64_t>((frame_count + bucket_frames - 1) / bucket_frames, 1);
+  std::size_t offset = 0;
+  while (true) {
+    level_counts.push_back(count);
+    level_offsets.push_back(offset);
+    offset += static_cast<std::size_t>(count);
+    if (count == 1) {
+      break;
+    }
+    count = (count + 1) / 2;
+  }
+  buckets_per_track = offset;
+  buckets = std::vector<std::atomic<std::uint32_t>>(buckets_per_track *
+                                                    static_cast<std::size_t>(track_count));
+}
+
+template <typename Measure>
+void TapeOverview::writeRange(int track, std::int64_t start_frame, std::int64_t count,
+                              Measure measure) {
+  if (track < 0 || track >= track_count || count <= 0 || start_frame < 0 ||
+      start_frame + count > frame_count) {
+    return;
+  }
+  const auto end_frame = start_frame + count;
+  const auto first = start_frame / bucket_frames;
+  const auto last = (end_frame - 1) / bucket_frames;
+  for (auto index = first; index <= last; ++index) {
+    const auto bucket_start = index * bucket_frames;
+    const auto from = std::max(start_frame, bucket_start);
+    const auto to = std::min(end_frame, bucket_start + bucket_frames);
+    const auto value = measure(static_cast<std::size_t>(from - start_frame),
+                               static_cast<std::size_t>(to - start_frame));
+    storeBucket(track, index, value, from == bucket_start);
+  }
+  updateParents(track, first, last);
+}
+
+void TapeOverview::write(int track, std::int64_t start_frame, std::span<const float> left,
+                         std::span<const float> right) {
+  if (right.size() != left.size()) {
+    return;
+  }
+  writeRange(track, start_frame, static_cast<std::int64_t>(left.size()),
+             [left, right](std::size_t from, std::size_t to) {
+               auto range = emptyRange();
+               for (auto frame = from; frame < to; ++frame) {
+                 range = merge(range, {.min = std::min(left[frame], right[frame]),
+                                       .max = std::max(left[frame], right[frame])});
+               }
+               return range;
+             });
+}
+
+void TapeOverview::writeInterleaved(int track, std::int64_t start_frame,
+                                    std::span<const float> frames) {
+  writeRange(track, start_frame, static_cast<std::int64_t>(frames.size() / 2),
+             [frames](std::size_t from, std::size_t to) {
+               const auto samples = frames.subspan(from * 2, (to - from) * 2);
+               const auto [low, high] = std::minmax_element(samples.begin(), samples.end());
+               return OverviewBucket{.min = *low, .max = *high};
+             });
+}
+
+auto TapeOverview::levelCount() const -> int { return static_cast<int>(level_counts.size()); }
+
+auto TapeOverview::bucketFrames(int level) const -> std::int64_t {
+  const auto clamped = std::clamp(level, 0, levelCount() - 1);
+  return static_cast<std::int64_t>(bucket_frames) << clamped;
+}
+
+auto TapeOverview::bucketCount(int level) const -> std::int64_t {
+  if (level < 0 || level >= levelCount()) {
+    return 0;
+  }
+  return level_counts.at(static_cast<std::size_t>(level));
+}
+
+auto TapeOverview::bucket(int track, int level, std::int64_t index) const -> OverviewBucket {
+  if (track < 0 || track >= track_count || index < 0 || index >= bucketCount(level)) {
+    return {};
+  }
+  const auto position = (static_cast<std::size_t>(track) * buckets_per_track) +
+                        levelOffset(level) + static_cast<std::size_t>(index);
+  return unpack(buckets.at(position).load(std::memory_order_relaxed));
+}
+
+void TapeOverview::render(int track, std::int64_t start_frame, std::int64_t end_frame,
+                          std::span<OverviewBucket> columns) const {
+  std::fill(columns.begin(), columns.end(), OverviewBucket{});
+  const auto range = end_frame - start_frame;
+  if (columns.empty() || range <= 0) {
+    return;
+  }
+  // Coarsest level whose buckets are no wider than a column, so each column
+  // merges at most a few buckets whatever the zoom.
+  const auto column_count = static_cast<std::int64_t>(columns.size());
+  const auto frames_per_column = std::max<std::int64_t>(range / column_count, 1);
+  int level = 0;
+  while (level + 1 < levelCount() && bucketFrames(level + 1) <= frames_per_column) {
+    ++level;
+  }
+  const auto level_frames = bucketFrames(level);
+  for (std::int64_t column = 0; column < column_count; ++column) {
+    const auto from = start_frame + (range * column / column_count);
+    const auto to = std::max(start_frame + (range * (column + 1) / column_count), from + 1);
+    if (from < 0 || from >= frame_count) {
+      continue;
+    }
+    const auto first = from / level_frames;
+    const auto last = std::min((to - 1) / level_frames, bucketCount(level) - 1);
+    auto value = bucket(track, level, first);
+    for (auto index = first + 1; index <= last; ++index) {
+      value = merge(value, bucket(track, level, index));
+    }
+    columns[static_cast<std::size_t>(column)] = value;
+  }
+}
+
+auto TapeOverview::memoryBytes() const -> std::size_t {
+  return buckets.size() * sizeof(std::uint32_t);
+}
+
+auto TapeOverview::levelOffset(int level) const -> std::size_t {
+  return level_offsets.at(static_cast<std::size_t>(level));
+}
+
+void TapeOverview::storeBucket(int track, std::int64_t index, OverviewBucket value,
+                               bool replace) {
+  const auto position = (static_cast<std::size_t>(track) * buckets_per_track) +
+                        static_cast<std::size_t>(index);
+  auto &slot = buckets.at(position);
+  if (replace) {
+    slot.store(pack(value), std::memory_order_seq_cst);
+    return;
+  }
+  auto expected = slot.load(std::memory_order_seq_cst);
+  while (!slot.compare_exchange_weak(expected, pack(merge(value, unpack(expected))),
+                                     std::memory_order_seq_cst)) {
+  }
+}
+
+void TapeOverview::updateParents(int track, std::int64_t first, std::int64_t last) {
+  const auto track_base = static_cast<std::size_t>(track) * buckets_per_track;
+  for (int level = 1; level < levelCount(); ++level) {
+    first /= 2;
+    last /= 2;
+    for (auto index = first; index <= last; ++index) {
+      refreshParent(track_base, level, index);
+    }
+  }
+}
+
+// Stores the merge of the two children until the parent matches them. A
+// writer whose children went stale while it merged either fails its
+// exchange or sees the change on the next check, so the last writer to
+// touch a child always leaves the parent covering it.
+void TapeOverview::refreshParent(std::size_t track_base, int level, std::int64_t index) {
+  const auto children = track_base + levelOffset(level - 1);
+  const auto left_child = static_cast<std::size_t>(index * 2);
+  const auto has_right = (index * 2) + 1 < bucketCount(level - 1);
+  auto &slot = buckets.at(track_base + levelOffset(level) + static_cast<std::size_t>(index));
+  auto expected = slot.load(std::memory_order_seq_cst);
+  while (true) {
+    auto value = unpack(buckets.at(children + left_child).load(std::memory_order_seq_cst));
+    if (has_right) {
+      value = merge(value,
+                    unpack(buckets.at(children + left_child + 1).load(std::memory_order_seq_cst)));
+    }
+    const auto packed = pack(value);
+    if (packed == expected) {
+      return;
+    }
+    if (slot.compare_exchange_weak(expected, packed, std::memory_order_seq_cst)) {
+      expected = packed;
+    }
+  }
+}
+} // namespace limit
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace limit {
+constexpr int kOverviewBucketFrames = 1024;
+
+struct OverviewBucket {
+  float min = 0.0f;
+  float max = 0.0f;
+};
+
+// Multi-resolution min/max summary of every tape track. Level 0 holds one
+// bucket per kOverviewBucketFrames; each level above halves the bucket count
+// by merging pairs, up to a single bucket for the whole tape. Writers update
+// the buckets they touch and their parents, so the pyramid follows recording
+// incrementally. Drawing any span of tape at any zoom reads a fixed number of
+// buckets per pixel column and never touches audio.
+//
+// Buckets are packed 16-bit min/max pairs in atomics, with no locks. A
+// track can have several writers at once (recording, the storage scan and
+// offline printing), so widening a bucket and refreshing a parent are
+// compare-exchange loops that never drop another writer's update. Readers
+// load relaxed.
+class TapeOverview {
+public:
+  TapeOverview(int track_count, std::int64_t frame_count,
+               int bucket_frames = kOverviewBucketFrames);
+
+  // Sequential writes replace a bucket when they cover its first frame and
+  // widen it otherwise, so a recording pass leaves exact buckets behind.
+  void write(int track, std::int64_t start_frame, std::span<const float> left,
+             std::span<const float> right);
+  void writeInterleaved(int track, std::int64_t start_frame, std::span<const float> frames);
+
+  auto levelCount() const -> int;
+  auto bucketFrames(int level) const -> std::int64_t;
+  auto bucketCount(int level) const -> std::int64_t;
+  auto bucket(int track, int level, std::int64_t index) const -> OverviewBucket;
+
+  // Fills one min/max column per element of columns for [start, end) frames.
+  void render(int track, std::int64_t start_frame, std::int64_t end_frame,
+              std::span<OverviewBucket> columns) const;
+
+  auto memoryBytes() const -> std::size_t;
+
+private:
+  template <typename Measure>
+  void writeRange(int track, std::int64_t start_frame, std::int64_t count, Measure measure);
+  auto levelOffset(int level) const -> std::size_t;
+  void storeBucket(int track, std::int64_t index, OverviewBucket value, bool replace);
+  void updateParents(int track, std::int64_t first, std::int64_t last);
+  void refreshParent(std::size_t track_base, int level, std::int64_t index);
+
+  int track_count = 0;
+  std::int64_t frame_count = 0;
+  int bucket_frames = kOverviewBucketFrames;
+  std::vector<std::int64_t> level_counts;
+  std::vector<std::size_t> level_offsets;
+  std::size_t buckets_per_track = 0;
+  std::vector<std::atomic<std::uint32_t>> buckets;
+};
+} // namespace limit
@@ -0,0 +1,598 @@
+#include "tape-storage.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace limit {
+namespace {
+constexpr std::size_t kWavDataOffset = 4096;
+constexpr std::size_t kFrameBytes = sizeof(float) * kStereoChannelCount;
+constexpr std::uint32_t kChunkHeaderBytes = 8;
+constexpr std::uint32_t kFmtChunkBytes = 16;
+constexpr std::uint16_t kWavFormatIeeeFloat = 3;
+constexpr std::uint16_t kBitsPerSample = 32;
+constexpr mode_t kTrackFileMode = 0644;
+constexpr auto kServiceInterval = std::chrono::milliseconds(5);
+constexpr int kLoopWordBits = 32;
+constexpr std::uint64_t kLoopWordMask = 0xFFFFFFFFU;
+
+using ChunkTag = std::array<char, 4>;
+
+// RIFF/fmt preamble followed by a JUNK chunk that pads the header so sample
+// data starts on a page boundary; chunks can then be mapped, advised and
+// synced independently.
+struct WavPreamble {
+  ChunkTag riff_tag{'R', 'I', 'F', 'F'};
+  std::uint32_t riff_bytes = 0;
+  ChunkTag wave_tag{'W', 'A', 'V', 'E'};
+  ChunkTag fmt_tag{'f', 'm', 't', ' '};
+  std::uint32_t fmt_bytes = kFmtChunkBytes;
+  std::uint16_t format = kWavFormatIeeeFloat;
+  std::uint16_t channels = kStereoChannelCount;
+  std::uint32_t sample_rate = 0;
+  std::uint32_t byte_rate = 0;
+  std::uint16_t block_align = kFrameBytes;
+  std::uint16_t bits_per_sample = kBitsPerSample;
+  ChunkTag junk_tag{'J', 'U', 'N', 'K'};
+  std::uint32_t junk_bytes = 0;
+};
+
+struct WavDataChunkHeader {
+  ChunkTag data_tag{'d', 'a', 't', 'a'};
+  std::uint32_t data_bytes = 0;
+};
+
+static_assert(std::endian::native == std::endian::little,
+              "Tape WAV headers are written in host byte order");
+static_assert(sizeof(WavPreamble) == 44, "WAV preamble must be tightly packed");
+static_assert(sizeof(WavDataChunkHeader) == kChunkHeaderBytes,
+              "WAV data chunk header must be tightly packed");
+
+using WavHeader = std::array<std::byte, kWavDataOffset>;
+
+auto makeWavHeader(int sample_rate, std::size_t data_bytes) -> WavHeader {
+  constexpr auto kDataChunkOffset = kWavDataOffset - sizeof(WavDataChunkHeader);
+
+  WavPreamble preamble;
+  preamble.riff_bytes = static_cast<std::uint32_t>(kWavDataOffset + data_bytes - kChunkHeaderBytes);
+  preamble.sample_rate = static_cast<std::uint32_t>(sample_rate);
+  preamble.byte_rate = preamble.sample_rate * static_cast<std::uint32_t>(kFrameBytes);
+  preamble.junk_bytes = static_cast<std::uint32_t>(kDataChunkOffset - sizeof(WavPreamble));
+
+  WavDataChunkHeader data_header;
+  data_header.data_bytes = static_cast<std::uint32_t>(data_bytes);
+
+  WavHeader header{};
+  std::memcpy(header.data(), &preamble, sizeof(preamble));
+  std::memcpy(std::span(header).subspan(kDataChunkOffset).data(), &data_header,
+              sizeof(data_header));
+  return header;
+}
+
+auto pageSize() -> std::size_t { return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)); }
+
+auto trackFileName(int track) -> std::string {
+  return "track-" + std::to_string(track + 1) + ".wav";
+}
+} // namespace
+
+auto TapeStorage::open(const TapeStorageConfig &config) -> std::unique_ptr<TapeStorage> {
+  const auto page = pageSize();
+  if (config.track_count <= 0 || config.sample_rate <= 0 || config.length_seconds <= 0 ||
+      config.chunk_frames <= 0 || config.prefetch_chunks < 0 || config.retain_chunks < 0 ||
+      (static_cast<std::size_t>(config.chunk_frames) * kFrameBytes) % page != 0 ||
+      kWavDataOffset % page != 0) {
+    return nullptr;
+  }
+
+  if (config.create_missing) {
+    std::error_code error;
+    std::filesystem::create_directories(config.directory, error);
+    if (error) {
+      return nullptr;
+    }
+  }
+
+  auto storage = std::unique_ptr<TapeStorage>(new TapeStorage(config));
+  for (int track = 0; track < config.track_count; ++track) {
+    if (!storage->mapTrack(track)) {
+      return nullptr;
+    }
+  }
+  return storage;
+}
+
+TapeStorage::TapeStorage(const TapeStorageConfig &storage_config)
+    : config(storage_config),
+      frame_count(static_cast<std::int64_t>(storage_config.sample_rate) *
+                  storage_config.length_seconds),
+      chunk_count((frame_count + storage_config.chunk_frames - 1) / storage_config.chunk_frames),
+      tracks(static_cast<std::size_t>(storage_config.track_count)),
+      chunk_states(static_cast<std::size_t>(chunk_count * storage_config.track_count)),
+      tape_overview(storage_config.track_count, frame_count) {}
+
+TapeStorage::~TapeStorage() {
+  stop();
+  flush();
+  unmapTracks();
+}
+
+void TapeStorage::start() {
+  if (service_thread.joinable()) {
+    return;
+  }
+  {
+    const std::scoped_lock lock(service_mutex);
+    service_stopping = false;
+  }
+  service_thread = std::thread([this] { runServiceLoop(); });
+}
+
+void TapeStorage::stop() {
+  if (!service_thread.joinable()) {
+    return;
+  }
+  {
+    const std::scoped_lock lock(service_mutex);
+    service_stopping = true;
+  }
+  service_wakeup.notify_all();
+  service_thread.join();
+}
+
+void TapeStorage::beginAudioBlock() { audio_epoch.fetch_add(1, std::memory_order_seq_cst); }
+
+void TapeStorage::endAudioBlock() { audio_epoch.fetch_add(1, std::memory_order_release); }
+
+void TapeStorage::setPlayhead(std::int64_t frame) {
+  playhead_frame.store(std::clamp<std::int64_t>(frame, 0, frame_count),
+                       std::memory_order_release);
+}
+
+void TapeStorage::setLoop(std::int64_t start_frame, std::int64_t end_frame) {
+  const auto start = static_cast<std::uint64_t>(std::clamp<std::int64_t>(start_frame, 0,
+                                                                          frame_count));
+  const auto end = static_cast<std::uint64_t>(std::clamp<std::int64_t>(end_frame, 0,
+                                                                        frame_count));
+  loop_range.store((start << kLoopWordBits) | end, std::memory_order_release);
+}
+
+void TapeStorage::setRecordTrack(int track) {
+  record_track.store(track, std::memory_order_release);
+}
+
+auto TapeStorage::readFrames(int track, std::int64_t start_frame, std::span<float> left,
+                             std::span<float> right) const -> bool {
+  const auto count = static_cast<std::int64_t>(left.size());
+  if (track < 0 || track >= config.track_count || right.size() != left.size() ||
+      start_frame < 0 || start_frame + count > frame_count ||
+      !chunkRangeResident(track, start_frame, count)) {
+    std::fill(left.begin(), left.end(), 0.0f);
+    std::fill(right.begin(), right.end(), 0.0f);
+    return false;
+  }
+
+  const auto source = tracks.at(static_cast<std::size_t>(track))
+                          .samples.subspan(static_cast<std::size_t>(start_frame) * 2,
+                                           static_cast<std::size_t>(count) * 2);
+  for (std::size_t frame = 0; frame < left.size(); ++frame) {
+    left[frame] = source[frame * 2];
+    right[frame] = source[(frame * 2) + 1];
+  }
+  return true;
+}
+
+auto TapeStorage::residentFrames(int track, std::int64_t start_frame, std::int64_t count) const
+    -> std::span<const float> {
+  if (track < 0 || track >= config.track_count || count <= 0 || start_frame < 0 ||
+      start_frame + count > frame_count || !chunkRangeResident(track, start_frame, count)) {
+    return {};
+  }
+  return tracks.at(static_cast<std::size_t>(track))
+      .samples.subspan(static_cast<std::size_t>(start_frame) * 2,
+                       static_cast<std::size_t>(count) * 2);
+}
+
+auto TapeStorage::writeFrames(int track, std::int64_t start_frame, std::span<const float> left,
+                              std::span<const float> right) -> bool {
+  if (!isValidRange(track, start_frame, left, right) ||
+      !chunkRangeResident(track, start_frame, static_cast<std::int64_t>(left.size()))) {
+    return false;
+  }
+  copyFrames(track, start_frame, left, right);
+  return true;
+}
+
+auto TapeStorage::writeFramesOffline(int track, std::int64_t start_frame,
+                                     std::span<const float> left, std::span<const float> right)
+    -> bool {
+  if (!isValidRange(track, start_frame, left, right)) {
+    return false;
+  }
+  // The mapping is shared, so pages written outside the resident window stay
+  // in the page cache. The service pass only visits the window, so chunks
+  // outside it are written back here; the rest are left to the pass.
+  copyFrames(track, start_frame, left, right);
+  const auto count = static_cast<std::int64_t>(left.size());
+  if (count > 0) {
+    const auto last_chunk = (start_frame + count - 1) / config.chunk_frames;
+    for (auto chunk = start_frame / config.chunk_frames; chunk <= last_chunk; ++chunk) {
+      if (!isChunkResident(track, chunk)) {
+        writeBack(track, chunk, false);
+      }
+    }
+  }
+  return true;
+}
+
+auto TapeStorage::isValidRange(int track, std::int64_t start_frame, std::span<const float> left,
+                               std::span<const float> right) const -> bool {
+  const auto count = static_cast<std::int64_t>(left.size());
+  return track >= 0 && track < config.track_count && right.size() == left.size() &&
+         start_frame >= 0 && start_frame + count <= frame_count;
+}
+
+void TapeStorage::copyFrames(int track, std::int64_t start_frame, std::span<const float> left,
+                             std::span<const float> right) {
+  const auto count = static_cast<std::int64_t>(left.size());
+  if (count == 0) {
+    return;
+  }
+  auto destination = tracks.at(static_cast<std::size_t>(track))
+                         .samples.subspan(static_cast<std::size_t>(start_frame) * 2,
+                                          static_cast<std::size_t>(count) * 2);
+  for (std::size_t frame = 0; frame < left.size(); ++frame) {
+    destination[frame * 2] = left[frame];
+    destination[(frame * 2) + 1] = right[frame];
+  }
+  markDirty(track, start_frame, count);
+  tape_overview.write(track, start_frame, left, right);
+}
+
+auto TapeStorage::playhead() const -> std::int64_t {
+  return playhead_frame.load(std::memory_order_acquire);
+}
+
+auto TapeStorage::frameCount() const -> std::int64_t { return frame_count; }
+
+auto TapeStorage::chunkCount() const -> std::int64_t { return chunk_count; }
+
+auto TapeStorage::trackCount() const -> int { return config.track_count; }
+
+auto TapeStorage::isChunkResident(int track, std::int64_t chunk) const -> bool {
+  return (chunkState(track, chunk) & kChunkResident) != 0;
+}
+
+auto TapeStorage::isChunkDirty(int track, std::int64_t chunk) const -> bool {
+  return (chunkState(track, chunk) & kChunkDirty) != 0;
+}
+
+auto TapeStorage::residentChunkCount() const -> int {
+  return static_cast<int>(std::count_if(chunk_states.begin(), chunk_states.end(),
+                                        [](const std::atomic<std::uint8_t> &state) {
+                                          return (state.load(std::memory_order_acquire) &
+                                                  kChunkResident) != 0;
+                                        }));
+}
+
+auto TapeStorage::overview() const -> const TapeOverview & { return tape_overview; }
+
+auto TapeStorage::isOverviewScanComplete() const -> bool {
+  return overview_scan_complete.load(std::memory_order_acquire);
+}
+
+auto TapeStorage::residentBytes() const -> std::size_t {
+  return static_cast<std::size_t>(residentChunkCount()) *
+         static_cast<std::size_t>(config.chunk_frames) * kFrameBytes;
+}
+
+void TapeStorage::service() {
+  releasePendingEvictions();
+
+  const auto window = serviceWindow();
+  const auto in_window = [&window](std::int64_t chunk) {
+    return std::ranges::any_of(window, [chunk](const ChunkRange &range) {
+      return chunk >= range.first && chunk <= range.last;
+    });
+  };
+  const auto armed_track = record_track.load(std::memory_order_acquire);
+
+  // Only chunks of the previous window can be resident outside this one.
+  for (int track = 0; track < config.track_count; ++track) {
+    for (const auto &range : serviced_window) {
+      for (auto chunk = range.first; chunk <= range.last; ++chunk) {
+        if (!in_window(chunk) && isChunkResident(track, chunk)) {
+          evict(track, chunk);
+        }
+      }
+    }
+    const auto for_write = track == armed_track;
+    for (const auto &range : window) {
+      for (auto chunk = range.first; chunk <= range.last; ++chunk) {
+        const auto state = chunkState(track, chunk);
+        if ((state & kChunkResident) == 0) {
+          pageIn(track, chunk, for_write);
+        } else if ((state & kChunkDirty) != 0) {
+          writeBack(track, chunk, false);
+        }
+      }
+    }
+  }
+  serviced_window = window;
+  scanOverviewChunk();
+}
+
+// The chunks around the playhead, and while it is inside a loop whose end
+// the prefetch reaches, as many chunks from the loop start as the prefetch
+// runs past the end. The two ranges never overlap.
+auto TapeStorage::serviceWindow() const -> ServiceWindow {
+  const auto frame = playhead();
+  const auto current_chunk = frame / config.chunk_frames;
+  const auto prefetch_end = current_chunk + config.prefetch_chunks;
+  ServiceWindow window{};
+  auto &ahead = window.at(0);
+  ahead.first = std::max<std::int64_t>(current_chunk - config.retain_chunks, 0);
+  ahead.last = std::min<std::int64_t>(prefetch_end, chunk_count - 1);
+
+  const auto loop = loop_range.load(std::memory_order_acquire);
+  const auto loop_start = static_cast<std::int64_t>(loop >> kLoopWordBits);
+  const auto loop_end = static_cast<std::int64_t>(loop & kLoopWordMask);
+  if (loop_end <= loop_start || frame < loop_start || frame >= loop_end) {
+    return window;
+  }
+  const auto start_chunk = loop_start / config.chunk_frames;
+  const auto end_chunk = (loop_end - 1) / config.chunk_frames;
+  const auto overrun = prefetch_end - end_chunk;
+  if (overrun <= 0) {
+    return window;
+  }
+  const ChunkRange wrapped{
+      .first = std::max<std::int64_t>(start_chunk - config.retain_chunks, 0),
+      .last = std::min(start_chunk + overrun - 1, end_chunk)};
+  if (wrapped.first <= ahead.last + 1 && ahead.first <= wrapped.last + 1) {
+    ahead.first = std::min(ahead.first, wrapped.first);
+    ahead.last = std::max(ahead.last, wrapped.last);
+  } else {
+    window.at(1) = wrapped;
+  }
+  return window;
+}
+
+void TapeStorage::flush() {
+  for (int track = 0; track < config.track_count; ++track) {
+    for (std::int64_t chunk = 0; chunk < chunk_count; ++chunk) {
+      if (isChunkDirty(track, chunk)) {
+        writeBack(track, chunk, true);
+      }
+    }
+  }
+}
+
+auto TapeStorage::mapTrack(int track) -> bool {
+  const auto path = config.directory / trackFileName(track);
+  const auto data_bytes = static_cast<std::size_t>(frame_count) * kFrameBytes;
+  const auto file_bytes = kWavDataOffset + data_bytes;
+
+  const auto flags = O_RDWR | O_CLOEXEC | (config.create_missing ? O_CREAT : 0);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+  const int fd = ::open(path.c_str(), flags, kTrackFileMode);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat info {};
+  if (::fstat(fd, &info) != 0) {
+    ::close(fd);
+    return false;
+  }
+
+  const auto expected_header = makeWavHeader(config.sample_rate, data_bytes);
+  if (info.st_size == 0 && config.create_missing) {
+    if (::ftruncate(fd, static_cast<off_t>(file_bytes)) != 0 ||
+        ::pwrite(fd, expected_header.data(), expected_header.size(), 0) !=
+            static_cast<ssize_t>(expected_header.size())) {
+      ::close(fd);
+      return false;
+    }
+  } else {
+    WavHeader existing_header{};
+    if (static_cast<std::size_t>(info.st_size) != file_bytes ||
+        ::pread(fd, existing_header.data(), existing_header.size(), 0) !=
+            static_cast<ssize_t>(existing_header.size()) ||
+        existing_header != expected_header) {
+      ::close(fd);
+      return false;
+    }
+  }
+
+  void *address = ::mmap(nullptr, file_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (address == MAP_FAILED) {
+    ::close(fd);
+    return false;
+  }
+
+  auto &mapping = tracks.at(static_cast<std::size_t>(track));
+  mapping.fd = fd;
+  mapping.address = address;
+  mapping.mapped_bytes = file_bytes;
+  mapping.samples = std::span<float>(static_cast<float *>(address), file_bytes / sizeof(float))
+                        .subspan(kWavDataOffset / sizeof(float));
+  return true;
+}
+
+void TapeStorage::unmapTracks() {
+  for (auto &mapping : tracks) {
+    if (mapping.address != nullptr) {
+      ::msync(mapping.address, mapping.mapped_bytes, MS_SYNC);
+      ::munmap(mapping.address, mapping.mapped_bytes);
+    }
+    if (mapping.fd >= 0) {
+      ::close(mapping.fd);
+    }
+    mapping = TrackMapping{};
+  }
+}
+
+auto TapeStorage::chunkState(int track, std::int64_t chunk) const -> std::uint8_t {
+  if (track < 0 || track >= config.track_count || chunk < 0 || chunk >= chunk_count) {
+    return 0;
+  }
+  const auto index = static_cast<std::size_t>((track * chunk_count) + chunk);
+  // Sequentially consistent so a block that starts after an eviction sees it;
+  // see releasePendingEvictions().
+  return chunk_states[index].load(std::memory_order_seq_cst);
+}
+
+auto TapeStorage::chunkRangeResident(int track, std::int64_t start_frame,
+                                     std::int64_t frame_count_to_check) const -> bool {
+  if (frame_count_to_check <= 0) {
+    return true;
+  }
+  const auto first_chunk = start_frame / config.chunk_frames;
+  const auto last_chunk = (start_frame + frame_count_to_check - 1) / config.chunk_frames;
+  for (auto chunk = first_chunk; chunk <= last_chunk; ++chunk) {
+    if (!isChunkResident(track, chunk)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void TapeStorage::markDirty(int track, std::int64_t start_frame, std::int64_t count) {
+  const auto first_chunk = start_frame / config.chunk_frames;
+  const auto last_chunk = (start_frame + count - 1) / config.chunk_frames;
+  for (auto chunk = first_chunk; chunk <= last_chunk; ++chunk) {
+    const auto index = static_cast<std::size_t>((track * chunk_count) + chunk);
+    chunk_states[index].fetch_or(kChunkDirty, std::memory_order_acq_rel);
+  }
+}
+
+void TapeStorage::pageIn(int track, std::int64_t chunk, bool for_write) {
+  auto bytes = chunkBytes(track, chunk);
+  ::madvise(bytes.data(), bytes.size(), MADV_WILLNEED);
+
+  // The armed track is write-faulted so the first recorded write does not
+  // have to allocate file blocks on the audio thread. The kernel does that
+  // without storing anything: writing back what was read could undo an
+  // offline write landing in the same page meanwhile. Kernels before 5.14
+  // only get the read touch below.
+  bool populated = false;
+#if defined(MADV_POPULATE_WRITE)
+  populated = for_write && (::madvise(bytes.data(), bytes.size(), MADV_POPULATE_WRITE) == 0);
+#else
+  static_cast<void>(for_write);
+#endif
+
+  // Touch every page so the audio thread never takes a major fault.
+  const auto page = pageSize();
+  for (std::size_t offset = 0; !populated && offset < bytes.size(); offset += page) {
+    const volatile std::byte *location = &bytes[offset];
+    static_cast<void>(*location);
+  }
+
+  const auto index = static_cast<std::size_t>((track * chunk_count) + chunk);
+  chunk_states[index].fetch_or(kChunkResident, std::memory_order_acq_rel);
+}
+
+void TapeStorage::writeBack(int track, std::int64_t chunk, bool synchronous) {
+  const auto index = static_cast<std::size_t>((track * chunk_count) + chunk);
+  chunk_states[index].fetch_and(static_cast<std::uint8_t>(~kChunkDirty),
+                                std::memory_order_acq_rel);
+  auto bytes = chunkBytes(track, chunk);
+  ::msync(bytes.data(), bytes.size(), synchronous ? MS_SYNC : MS_ASYNC);
+}
+
+void TapeStorage::evict(int track, std::int64_t chunk) {
+  const auto index = static_cast<std::size_t>((track * chunk_count) + chunk);
+  const auto previous = chunk_states[index].fetch_and(
+      static_cast<std::uint8_t>(~kChunkResident), std::memory_order_seq_cst);
+  if ((previous & kChunkDirty) != 0) {
+    writeBack(track, chunk, true);
+  }
+  dropPages(track, chunk);
+}
+
+void TapeStorage::dropPages(int track, std::int64_t chunk) {
+  pending_evictions.push_back(
+      {.track = track, .chunk = chunk, .epoch = audio_epoch.load(std::memory_order_seq_cst)});
+  releasePendingEvictions();
+}
+
+// The resident mark was cleared before the epoch was read, and a block bumps
+// the epoch before it checks residency. So an even epoch means no block was
+// running, and any block that starts later sees the chunk as gone; an epoch
+// that has moved on means the block that was running has finished.
+void TapeStorage::releasePendingEvictions() {
+  const auto epoch = audio_epoch.load(std::memory_order_seq_cst);
+  std::erase_if(pending_evictions, [this, epoch](const PendingEviction &pending) {
+    if ((pending.epoch & 1U) != 0 && pending.epoch == epoch) {
+      return false;
+    }
+    // A chunk paged back in since is in use again.
+    if (!isChunkResident(pending.track, pending.chunk)) {
+      auto bytes = chunkBytes(pending.track, pending.chunk);
+      ::madvise(bytes.data(), bytes.size(), MADV_DONTNEED);
+    }
+    return true;
+  });
+}
+
+auto TapeStorage::chunkBytes(int track, std::int64_t chunk) const -> std::span<std::byte> {
+  const auto &mapping = tracks.at(static_cast<std::size_t>(track));
+  const auto chunk_bytes = static_cast<std::size_t>(config.chunk_frames) * kFrameBytes;
+  const auto offset = static_cast<std::size_t>(chunk) * chunk_bytes;
+  const auto data_bytes = mapping.samples.size_bytes();
+  return std::as_writable_bytes(mapping.samples)
+      .subspan(offset, std::min(chunk_bytes, data_bytes - offset));
+}
+
+void TapeStorage::scanOverviewChunk() {
+  const auto total = chunk_count * config.track_count;
+  if (overview_scan_next >= total) {
+    return;
+  }
+  const auto track = static_cast<int>(overview_scan_next / chunk_count);
+  const auto chunk = overview_scan_next % chunk_count;
+  const auto resident = isChunkResident(track, chunk);
+  const auto start_frame = chunk * config.chunk_frames;
+  const auto frames = std::min<std::int64_t>(config.chunk_frames, frame_count - start_frame);
+  tape_overview.writeInterleaved(track, start_frame,
+                                 tracks.at(static_cast<std::size_t>(track))
+                                     .samples.subspan(static_cast<std::size_t>(start_frame) * 2,
+                                                      static_cast<std::size_t>(frames) * 2));
+  if (!resident) {
+    // It may have been evicted moments ago, under a block still reading it.
+    dropPages(track, chunk);
+  }
+  // Dirty bits were just cleared by write-back, so a dirty chunk here was
+  // written while it was being scanned; summarise it again on the next pass.
+  if (isChunkDirty(track, chunk)) {
+    return;
+  }
+  ++overview_scan_next;
+  if (overview_scan_next == total) {
+    overview_scan_complete.store(true, std::memory_order_release);
+  }
+}
+
+void TapeStorage::runServiceLoop() {
+  std::unique_lock lock(service_mutex);
+  while (!service_stopping) {
+    lock.unlock();
+    service();
+    lock.lock();
+    service_wakeup.wait_for(lock, kServiceInterval, [this] { return service_stopping; });
+  }
+}
+} // namespace limit
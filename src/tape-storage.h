@@ -0,0 +1,178 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "signal-flow.h"
+#include "tape-overview.h"
+
+namespace limit {
+constexpr int kTapeSampleRate = 48000;
+constexpr int kTapeLengthSeconds = 600;
+constexpr int kTapeChunkFrames = 32768;
+
+struct TapeStorageConfig {
+  std::filesystem::path directory;
+  int track_count = kTapeTrackCount;
+  int sample_rate = kTapeSampleRate;
+  int length_seconds = kTapeLengthSeconds;
+  int chunk_frames = kTapeChunkFrames;
+  int prefetch_chunks = 8;
+  int retain_chunks = 2;
+  // When false, open() fails unless the directory already holds every track
+  // file at full length, instead of creating them as sparse files.
+  bool create_missing = true;
+};
+
+// Tape audio backed by one memory-mapped stereo float WAV file per track.
+// Nothing is read at open time: a service thread pages chunks in ahead of the
+// playhead, writes dirty chunks back asynchronously and drops chunks that fall
+// out of the window, so the resident set follows the playback window rather
+// than the tape length. The audio thread only touches chunks already marked
+// resident and gets silence (and a false return) otherwise. Each pass only
+// visits the chunks of the current window and of the one before it. While
+// the playhead is inside a loop, the part of the window that would run past
+// the loop end covers the loop start instead, where playback goes next.
+//
+// An evicted chunk loses its resident mark at once, but its pages are only
+// advised away once no audio block that could have seen the mark is still
+// running, so a reader never faults on a chunk it found resident.
+//
+// Every write also updates a min/max overview of the track, and the service
+// thread summarises existing tape content one chunk per pass in the
+// background, so the UI can draw the whole tape without reading audio.
+class TapeStorage {
+public:
+  static auto open(const TapeStorageConfig &config) -> std::unique_ptr<TapeStorage>;
+
+  ~TapeStorage();
+  TapeStorage(const TapeStorage &) = delete;
+  auto operator=(const TapeStorage &) -> TapeStorage & = delete;
+  TapeStorage(TapeStorage &&) = delete;
+  auto operator=(TapeStorage &&) -> TapeStorage & = delete;
+
+  void start();
+  void stop();
+
+  // Audio thread. Reads and writes happen between beginAudioBlock() and
+  // endAudioBlock(); spans returned by residentFrames() stay valid until the
+  // block ends.
+  void beginAudioBlock();
+  void endAudioBlock();
+  void setPlayhead(std::int64_t frame);
+  // The loop the playhead wraps in; an empty range means no loop.
+  void setLoop(std::int64_t start_frame, std::int64_t end_frame);
+  void setRecordTrack(int track);
+  auto readFrames(int track, std::int64_t start_frame, std::span<float> left,
+                  std::span<float> right) const -> bool;
+  // Interleaved stereo samples of a frame range, or an empty span unless every
+  // chunk the range touches is resident. Lets a reader check residency once
+  // and then index the window directly.
+  auto residentFrames(int track, std::int64_t start_frame, std::int64_t count) const
+      -> std::span<const float>;
+  auto writeFrames(int track, std::int64_t start_frame, std::span<const float> left,
+                   std::span<const float> right) -> bool;
+
+  // Any thread but the audio thread: writes regardless of residency and may
+  // block on page faults. Used by offline printing.
+  auto writeFramesOffline(int track, std::int64_t start_frame, std::span<const float> left,
+                          std::span<const float> right) -> bool;
+
+  // Any thread.
+  auto playhead() const -> std::int64_t;
+  auto frameCount() const -> std::int64_t;
+  auto chunkCount() const -> std::int64_t;
+  auto trackCount() const -> int;
+  auto isChunkResident(int track, std::int64_t chunk) const -> bool;
+  auto isChunkDirty(int track, std::int64_t chunk) const -> bool;
+  auto residentChunkCount() const -> int;
+  auto residentBytes() const -> std::size_t;
+  auto overview() const -> const TapeOverview &;
+  auto isOverviewScanComplete() const -> bool;
+
+  // Service thread (exposed so tests can drive it deterministically).
+  void service();
+  void flush();
+
+private:
+  struct TrackMapping {
+    int fd = -1;
+    void *address = nullptr;
+    std::size_t mapped_bytes = 0;
+    std::span<float> samples;
+  };
+
+  struct PendingEviction {
+    int track = 0;
+    std::int64_t chunk = 0;
+    // audio_epoch when the chunk stopped being resident.
+    std::uint64_t epoch = 0;
+  };
+
+  // Inclusive; empty when last < first.
+  struct ChunkRange {
+    std::int64_t first = 0;
+    std::int64_t last = -1;
+  };
+  using ServiceWindow = std::array<ChunkRange, 2>;
+
+  explicit TapeStorage(const TapeStorageConfig &config);
+
+  auto mapTrack(int track) -> bool;
+  void unmapTracks();
+  auto chunkState(int track, std::int64_t chunk) const -> std::uint8_t;
+  auto isValidRange(int track, std::int64_t start_frame, std::span<const float> left,
+                    std::span<const float> right) const -> bool;
+  void copyFrames(int track, std::int64_t start_frame, std::span<const float> left,
+                  std::span<const float> right);
+  auto chunkRangeResident(int track, std::int64_t start_frame, std::int64_t frame_count) const
+      -> bool;
+  void markDirty(int track, std::int64_t start_frame, std::int64_t frame_count);
+  auto serviceWindow() const -> ServiceWindow;
+  void pageIn(int track, std::int64_t chunk, bool for_write);
+  void writeBack(int track, std::int64_t chunk, bool synchronous);
+  void evict(int track, std::int64_t chunk);
+  // Advises a chunk's pages away once no running block can be reading them.
+  void dropPages(int track, std::int64_t chunk);
+  void releasePendingEvictions();
+  auto chunkBytes(int track, std::int64_t chunk) const -> std::span<std::byte>;
+  void scanOverviewChunk();
+  void runServiceLoop();
+
+  static constexpr std::uint8_t kChunkResident = 1U;
+  static constexpr std::uint8_t kChunkDirty = 2U;
+
+  TapeStorageConfig config;
+  std::int64_t frame_count = 0;
+  std::int64_t chunk_count = 0;
+  std::vector<TrackMapping> tracks;
+  std::vector<std::atomic<std::uint8_t>> chunk_states;
+  std::atomic<std::int64_t> playhead_frame{0};
+  // Loop start in the high word and end in the low word, as TapeTransport
+  // keeps them.
+  std::atomic<std::uint64_t> loop_range{0};
+  std::atomic<int> record_track{-1};
+  // Odd while an audio block is running.
+  std::atomic<std::uint64_t> audio_epoch{0};
+  // Service thread.
+  std::vector<PendingEviction> pending_evictions;
+  ServiceWindow serviced_window{};
+  TapeOverview tape_overview;
+  std::int64_t overview_scan_next = 0;
+  std::atomic<bool> overview_scan_complete{false};
+
+  std::thread service_thread;
+  std::mutex service_mutex;
+  std::condition_variable service_wakeup;
+  bool service_stopping = false;
+};
+} // namespace limit
@@ -0,0 +1,411 @@
+#include "tape-transport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace limit {
+namespace {
+constexpr int kHalfTaps = kTapeInterpolationTaps / 2;
+// The window runs from kHalfTaps - 1 frames before the read position to
+// kHalfTaps frames after it.
+constexpr int kLeadingTaps = kHalfTaps - 1;
+constexpr int kRowsPerBank = kTapeInterpolationPhases + 1;
+constexpr std::size_t kDotLanes = 8;
+constexpr double kRateSlewPerSecond = 50.0;
+// Below this rate the output fades out, so a brake ends in silence rather
+// than a held sample.
+constexpr double kFadeRate = 0.05;
+constexpr int kLoopWordBits = 32;
+constexpr std::uint64_t kLoopWordMask = 0xFFFFFFFFU;
+constexpr double kBlackmanA0 = 0.42;
+constexpr double kBlackmanA1 = 0.5;
+constexpr double kBlackmanA2 = 0.08;
+
+static_assert(static_cast<std::size_t>(kTapeKernelWidth) % kDotLanes == 0,
+              "Kernel rows must split evenly into dot-product lanes");
+static_assert(kDotLanes % kStereoChannelCount == 0, "Lanes must hold whole stereo frames");
+
+// Fastest rate each bank is designed for; bank 0 covers everything up to unity.
+auto bankTopRate(int bank) -> double {
+  return 1.0 + (static_cast<double>(bank) * static_cast<double>(kTapeMaxSpeed - 1.0f) /
+                static_cast<double>(kTapeKernelBankCount - 1));
+}
+
+auto blackman(double position) -> double {
+  const auto angle = 2.0 * juce::MathConstants<double>::pi * position;
+  return kBlackmanA0 - (kBlackmanA1 * std::cos(angle)) + (kBlackmanA2 * std::cos(2.0 * angle));
+}
+
+auto approach(double value, double target, double step) -> double {
+  return value < target ? std::min(value + step, target) : std::max(value - step, target);
+}
+} // namespace
+
+TapeKernels::TapeKernels()
+    : coefficients(static_cast<std::size_t>(kTapeKernelBankCount) * kRowsPerBank *
+                   kTapeKernelWidth) {
+  const auto pi = juce::MathConstants<double>::pi;
+  std::array<double, kTapeInterpolationTaps> taps{};
+  for (int bank = 0; bank < kTapeKernelBankCount; ++bank) {
+    const auto cutoff = 1.0 / bankTopRate(bank);
+    for (int phase = 0; phase < kRowsPerBank; ++phase) {
+      const auto fraction = static_cast<double>(phase) / kTapeInterpolationPhases;
+      auto sum = 0.0;
+      for (int tap = 0; tap < kTapeInterpolationTaps; ++tap) {
+        const auto x = static_cast<double>(tap - kLeadingTaps) - fraction;
+        const auto argument = pi * cutoff * x;
+        const auto sinc = std::abs(argument) < std::numeric_limits<double>::epsilon()
+                              ? 1.0
+                              : std::sin(argument) / argument;
+        const auto value = sinc * blackman((x + kHalfTaps) / kTapeInterpolationTaps);
+        taps.at(static_cast<std::size_t>(tap)) = value;
+        sum += value;
+      }
+
+      // Unity gain at DC for every phase, so slow sweeps do not ripple.
+      const auto offset =
+          static_cast<std::size_t>((bank * kRowsPerBank) + phase) * kTapeKernelWidth;
+      auto destination = std::span(coefficients).subspan(offset, kTapeKernelWidth);
+      for (std::size_t tap = 0; tap < taps.size(); ++tap) {
+        const auto value = static_cast<float>(taps.at(tap) / sum);
+        destination[tap * kStereoChannelCount] = value;
+        destination[(tap * kStereoChannelCount) + 1] = value;
+      }
+    }
+  }
+}
+
+auto TapeKernels::bankForRate(double rate) -> int {
+  const auto magnitude = std::abs(rate);
+  for (int bank = 0; bank < kTapeKernelBankCount; ++bank) {
+    if (magnitude <= bankTopRate(bank)) {
+      return bank;
+    }
+  }
+  return kTapeKernelBankCount - 1;
+}
+
+auto TapeKernels::row(int bank, int phase) const -> std::span<const float, kTapeKernelWidth> {
+  const auto offset = static_cast<std::size_t>((bank * kRowsPerBank) + phase) * kTapeKernelWidth;
+  return std::span(coefficients).subspan(offset).first<kTapeKernelWidth>();
+}
+
+auto tapeKernels() -> const TapeKernels & {
+  static const TapeKernels kernels;
+  return kernels;
+}
+
+void TapeTransport::setStorage(TapeStorage *storage) {
+  tape_storage.store(storage, std::memory_order_release);
+}
+
+void TapeTransport::setWorkerPool(RealtimeWorkerPool *pool) {
+  worker_pool.store(pool, std::memory_order_release);
+}
+
+void TapeTransport::play() { playing.store(true, std::memory_order_relaxed); }
+
+void TapeTransport::stop() { playing.store(false, std::memory_order_relaxed); }
+
+void TapeTransport::locate(std::int64_t frame) {
+  pending_locate.store(std::max<std::int64_t>(frame, 0), std::memory_order_release);
+}
+
+void TapeTransport::setSpeed(float new_speed) {
+  speed.store(std::clamp(new_speed, kTapeMinSpeed, kTapeMaxSpeed), std::memory_order_relaxed);
+}
+
+void TapeTransport::setReverse(bool reverse) {
+  reversed.store(reverse, std::memory_order_relaxed);
+}
+
+void TapeTransport::setBrake(bool brake) { braking.store(brake, std::memory_order_relaxed); }
+
+void TapeTransport::setBrakeSeconds(float seconds) {
+  brake_seconds.store(std::max(seconds, 0.0f), std::memory_order_relaxed);
+}
+
+void TapeTransport::setLoop(std::int64_t start_frame, std::int64_t end_frame) {
+  const auto start = static_cast<std::uint64_t>(std::max<std::int64_t>(start_frame, 0)) &
+                     kLoopWordMask;
+  const auto end = static_cast<std::uint64_t>(std::max<std::int64_t>(end_frame, 0)) &
+                   kLoopWordMask;
+  loop_range.store((start << kLoopWordBits) | end, std::memory_order_relaxed);
+}
+
+void TapeTransport::clearLoop() { loop_range.store(0, std::memory_order_relaxed); }
+
+void TapeTransport::setMonitorTrack(int track) {
+  monitor_track.store(track, std::memory_order_relaxed);
+}
+
+auto TapeTransport::isPlaying() const -> bool { return playing.load(std::memory_order_relaxed); }
+
+auto TapeTransport::position() const -> std::int64_t {
+  return position_frame.load(std::memory_order_relaxed);
+}
+
+auto TapeTransport::underrunCount() const -> std::uint64_t {
+  return underruns.load(std::memory_order_relaxed);
+}
+
+void TapeTransport::prepare(double new_sample_rate, int max_block_size) {
+  kernels = &tapeKernels();
+  sample_rate = new_sample_rate;
+  const auto size = static_cast<std::size_t>(std::max(max_block_size, 1));
+  frames.assign(size, 0);
+  block_kernels.assign(size * kTapeKernelWidth, 0.0f);
+  rate = 0.0;
+}
+
+void TapeTransport::process(AudioGraphBuses &buses, const juce::MidiBuffer & /*midi*/,
+                            int num_samples) {
+  buses.tape.clear(0, num_samples);
+  auto *storage = tape_storage.load(std::memory_order_acquire);
+  if (storage != nullptr) {
+    render(*storage, buses.tape, num_samples);
+  }
+
+  const auto track = monitor_track.load(std::memory_order_relaxed);
+  if (track >= 0 && track < kTapeTrackCount) {
+    for (int channel = 0; channel < kStereoChannelCount; ++channel) {
+      buses.tape.addFrom((track * kStereoChannelCount) + channel, 0, buses.instrument, channel, 0,
+                         num_samples);
+    }
+  }
+}
+
+void TapeTransport::render(TapeStorage &storage, juce::AudioBuffer<float> &tape,
+                           int num_samples) {
+  num_samples = std::min(num_samples, static_cast<int>(frames.size()));
+  if (num_samples <= 0 || kernels == nullptr || storage.frameCount() <= 0) {
+    return;
+  }
+  if (advance(num_samples, storage.frameCount())) {
+    const auto track_count = std::min({storage.trackCount(), kTapeTrackCount,
+                                       tape.getNumChannels() / kStereoChannelCount});
+    TrackJob job{.transport = this, .storage = &storage, .num_samples = num_samples};
+    for (int channel = 0; channel < track_count * kStereoChannelCount; ++channel) {
+      job.channels.at(static_cast<std::size_t>(channel)) = tape.getWritePointer(channel);
+    }
+    auto *pool = worker_pool.load(std::memory_order_acquire);
+    storage.beginAudioBlock();
+    if (pool != nullptr) {
+      pool->parallelFor(track_count, &TapeTransport::renderTrackTask, &job);
+    } else {
+      for (int track = 0; track < track_count; ++track) {
+        renderTrackTask(&job, track);
+      }
+    }
+    storage.endAudioBlock();
+  }
+  const auto frame = static_cast<std::int64_t>(position_exact);
+  position_frame.store(frame, std::memory_order_relaxed);
+  storage.setPlayhead(frame);
+  const auto loop = loop_range.load(std::memory_order_relaxed);
+  storage.setLoop(static_cast<std::int64_t>(loop >> kLoopWordBits),
+                  static_cast<std::int64_t>(loop & kLoopWordMask));
+}
+
+// Steps the shared position through the block and records, per output
+// sample, the tape frame it starts from and the blended, gain-scaled kernel
+// row for its fractional part, and the windows of tape those frames read.
+// Returns false when the block is silent.
+auto TapeTransport::advance(int num_samples, std::int64_t tape_frames) -> bool {
+  const auto last_frame = static_cast<double>(tape_frames - 1);
+  const auto locate_to = pending_locate.exchange(kNoLocate, std::memory_order_acq_rel);
+  if (locate_to != kNoLocate) {
+    position_exact = static_cast<double>(locate_to);
+  }
+  position_exact = std::clamp(position_exact, 0.0, last_frame);
+
+  const auto is_playing = playing.load(std::memory_order_relaxed);
+  const auto is_braking = braking.load(std::memory_order_relaxed);
+  const auto play_speed = static_cast<double>(speed.load(std::memory_order_relaxed));
+  const auto direction = reversed.load(std::memory_order_relaxed) ? -1.0 : 1.0;
+  const auto target = is_playing && !is_braking ? direction * play_speed : 0.0;
+  if (juce::exactlyEqual(rate, 0.0) && juce::exactlyEqual(target, 0.0)) {
+    return false;
+  }
+  const auto brake_samples =
+      std::max(static_cast<double>(brake_seconds.load(std::memory_order_relaxed)) * sample_rate,
+               1.0);
+  const auto slew = is_braking ? play_speed / brake_samples : kRateSlewPerSecond / sample_rate;
+
+  const auto loop = loop_range.load(std::memory_order_relaxed);
+  const auto loop_start = static_cast<double>(loop >> kLoopWordBits);
+  const auto loop_end = static_cast<double>(loop & kLoopWordMask);
+  const auto loop_length = loop_end - loop_start;
+  const auto looping =
+      loop_length > 0.0 && position_exact >= loop_start && position_exact < loop_end;
+
+  // At exactly unity speed on a whole frame every position is a whole frame,
+  // so the block is a straight copy.
+  unity = juce::exactlyEqual(rate, 1.0) && juce::exactlyEqual(target, 1.0) &&
+          juce::exactlyEqual(position_exact, std::floor(position_exact));
+  // The rate only moves toward the target, so its peak is at one end.
+  const auto bank = TapeKernels::bankForRate(std::max(std::abs(rate), std::abs(target)));
+
+  const auto count = static_cast<std::size_t>(num_samples);
+  const std::span<std::int64_t> block_frames(frames);
+  const std::span<float> block_rows(block_kernels);
+  // Frames read before the first wrap of a loop, and after it.
+  std::array<std::int64_t, kMaxReadWindows> first{};
+  std::array<std::int64_t, kMaxReadWindows> last{};
+  first.fill(std::numeric_limits<std::int64_t>::max());
+  last.fill(std::numeric_limits<std::int64_t>::min());
+  std::size_t segment = 0;
+  auto wrap_sample = count;
+  for (std::size_t sample = 0; sample < count; ++sample) {
+    const auto whole = std::floor(position_exact);
+    const auto frame = static_cast<std::int64_t>(whole);
+    block_frames[sample] = frame;
+    first.at(segment) = std::min(first.at(segment), frame);
+    last.at(segment) = std::max(last.at(segment), frame);
+
+    if (!unity) {
+      const auto scaled = (position_exact - whole) * kTapeInterpolationPhases;
+      const auto phase = std::min(static_cast<int>(scaled), kTapeInterpolationPhases - 1);
+      const auto blend = static_cast<float>(scaled - phase);
+      const auto gain = static_cast<float>(std::min(std::abs(rate) / kFadeRate, 1.0));
+      const auto from = kernels->row(bank, phase);
+      const auto to = kernels->row(bank, phase + 1);
+      const auto destination = block_rows.subspan(sample * kTapeKernelWidth, kTapeKernelWidth);
+      for (std::size_t tap = 0; tap < destination.size(); ++tap) {
+        destination[tap] = gain * (from[tap] + (blend * (to[tap] - from[tap])));
+      }
+    }
+
+    rate = approach(rate, target, slew);
+    position_exact += rate;
+    if (looping && (position_exact >= loop_end || position_exact < loop_start)) {
+      position_exact += position_exact >= loop_end ? -loop_length : loop_length;
+      if (segment == 0 && sample + 1 < count) {
+        segment = 1;
+        wrap_sample = sample + 1;
+      }
+    }
+    if (position_exact < 0.0 || position_exact > last_frame) {
+      // Ran off either end of the tape: the transport stops there.
+      position_exact = std::clamp(position_exact, 0.0, last_frame);
+      rate = 0.0;
+      playing.store(false, std::memory_order_relaxed);
+    }
+  }
+
+  // A loop longer than the storage window cannot be resident all at once,
+  // so a block that wraps reads each side of the loop point separately. The
+  // two only merge when they overlap, as in a loop shorter than the block.
+  for (std::size_t index = 0; index <= segment; ++index) {
+    auto &window = read_windows.at(index);
+    window.first = std::max<std::int64_t>(first.at(index) - kLeadingTaps, 0);
+    window.count =
+        std::min<std::int64_t>(last.at(index) + kHalfTaps + 1, tape_frames) - window.first;
+  }
+  read_windows.at(0).end_sample = segment == 0 ? count : wrap_sample;
+  read_windows.at(1).end_sample = count;
+  read_window_count = segment + 1;
+  auto &before = read_windows.at(0);
+  const auto &after = read_windows.at(1);
+  if (segment == 1 && after.first <= before.first + before.count &&
+      before.first <= after.first + after.count) {
+    const auto end = std::max(before.first + before.count, after.first + after.count);
+    before.first = std::min(before.first, after.first);
+    before.count = end - before.first;
+    before.end_sample = count;
+    read_window_count = 1;
+  }
+  return true;
+}
+
+void TapeTransport::renderTrackTask(void *context, int track) {
+  const auto &job = *static_cast<const TrackJob *>(context);
+  const auto left = static_cast<std::size_t>(track) * kStereoChannelCount;
+  job.transport->renderTrack(*job.storage, track, job.channels[left], job.channels[left + 1],
+                             job.num_samples);
+}
+
+void TapeTransport::renderTrack(const TapeStorage &storage, int track, float *left_channel,
+                                float *right_channel, int num_samples) {
+  std::array<std::span<const float>, kMaxReadWindows> windows{};
+  for (std::size_t index = 0; index < read_window_count; ++index) {
+    const auto &range = read_windows.at(index);
+    windows.at(index) = storage.residentFrames(track, range.first, range.count);
+    if (windows.at(index).empty()) {
+      underruns.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+
+  const auto count = static_cast<std::size_t>(num_samples);
+  const std::span left(left_channel, count);
+  const std::span right(right_channel, count);
+  std::size_t begin_sample = 0;
+  for (std::size_t index = 0; index < read_window_count; ++index) {
+    const auto &range = read_windows.at(index);
+    renderWindow(windows.at(index), range, begin_sample, left, right);
+    begin_sample = range.end_sample;
+  }
+}
+
+// Renders the output samples from begin_sample up to the end of range, all
+// of which read from window.
+void TapeTransport::renderWindow(std::span<const float> window, const ReadWindow &range,
+                                 std::size_t begin_sample, std::span<float> left,
+                                 std::span<float> right) const {
+  const std::span<const std::int64_t> block_frames(frames);
+  if (unity) {
+    for (auto sample = begin_sample; sample < range.end_sample; ++sample) {
+      const auto offset =
+          static_cast<std::size_t>(block_frames[sample] - range.first) * kStereoChannelCount;
+      left[sample] = window[offset];
+      right[sample] = window[offset + 1];
+    }
+    return;
+  }
+
+  const std::span<const float> block_rows(block_kernels);
+  std::array<float, kTapeKernelWidth> padded{};
+  std::array<float, kDotLanes> sums{};
+  const std::span<float, kDotLanes> lanes(sums);
+  for (auto sample = begin_sample; sample < range.end_sample; ++sample) {
+    const auto start = block_frames[sample] - kLeadingTaps - range.first;
+    std::span<const float> source;
+    if (start >= 0 && start + kTapeInterpolationTaps <= range.count) {
+      source = window.subspan(static_cast<std::size_t>(start) * kStereoChannelCount,
+                              kTapeKernelWidth);
+    } else {
+      // Near either end of the tape some taps fall outside it and read silence.
+      const std::span<float> gathered(padded);
+      for (int tap = 0; tap < kTapeInterpolationTaps; ++tap) {
+        const auto frame = start + tap;
+        const auto inside = frame >= 0 && frame < range.count;
+        const auto offset = static_cast<std::size_t>(tap) * kStereoChannelCount;
+        const auto source_offset = static_cast<std::size_t>(inside ? frame : 0) *
+                                   kStereoChannelCount;
+        gathered[offset] = inside ? window[source_offset] : 0.0f;
+        gathered[offset + 1] = inside ? window[source_offset + 1] : 0.0f;
+      }
+      source = gathered;
+    }
+
+    // Lanes alternate left/right, so one pass convolves both channels.
+    const auto kernel = block_rows.subspan(sample * kTapeKernelWidth, kTapeKernelWidth);
+    std::fill(lanes.begin(), lanes.end(), 0.0f);
+    for (std::size_t tap = 0; tap < kernel.size(); tap += kDotLanes) {
+      for (std::size_t lane = 0; lane < kDotLanes; ++lane) {
+        lanes[lane] += source[tap + lane] * kernel[tap + lane];
+      }
+    }
+    auto left_sum = 0.0f;
+    auto right_sum = 0.0f;
+    for (std::size_t lane = 0; lane < kDotLanes; lane += kStereoChannelCount) {
+      left_sum += lanes[lane];
+      right_sum += lanes[lane + 1];
+    }
+    left[sample] = left_sum;
+    right[sample] = right_sum;
+  }
+}
+} // namespace limit
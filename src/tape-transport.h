@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "audio-graph.h"
+#include "tape-storage.h"
+#include "worker-pool.h"
+
+namespace limit {
+constexpr int kTapeInterpolationTaps = 16;
+constexpr int kTapeInterpolationPhases = 256;
+constexpr int kTapeKernelWidth = kTapeInterpolationTaps * kStereoChannelCount;
+constexpr int kTapeKernelBankCount = 4;
+constexpr float kTapeMinSpeed = 0.25f;
+constexpr float kTapeMaxSpeed = 2.0f;
+constexpr float kTapeDefaultBrakeSeconds = 0.8f;
+
+// Windowed-sinc interpolation kernels for the tape read head. Each bank is
+// one polyphase filter with kTapeInterpolationPhases + 1 rows, so a row and
+// its successor can always be blended. Bank 0 has its cutoff at Nyquist;
+// higher banks lower the cutoff for playback faster than unity so speed-ups
+// do not alias. Taps are stored twice in a row (one per channel) so a row
+// lines up with interleaved stereo tape samples.
+class TapeKernels {
+public:
+  TapeKernels();
+
+  static auto bankForRate(double rate) -> int;
+  auto row(int bank, int phase) const -> std::span<const float, kTapeKernelWidth>;
+
+private:
+  std::vector<float> coefficients;
+};
+
+// Shared kernels, built on first use. Call from the message thread first.
+auto tapeKernels() -> const TapeKernels &;
+
+// The tape read head: renders all eight tracks from one shared position that
+// moves at a fractional, possibly negative rate. Tape tricks are states of
+// that rate: Speed scales it, Reverse flips it, Brake ramps it to a stop and
+// back, and Loop (or a short loop for Chop) wraps the position. The rate
+// slews per sample, so none of them click.
+//
+// Positions and interpolation kernels are worked out once per block and
+// shared by every track; each track then reads one window of interleaved tape
+// (two when the block wraps a loop, one each side of the loop point) and
+// convolves both channels in the same pass. Tracks share nothing but that
+// read-only block state, so they can render on separate cores. A track whose
+// windows are not resident in TapeStorage plays silence for the block and
+// counts an underrun.
+class TapeTransport final : public AudioGraphNode {
+public:
+  // The storage must outlive the transport or be detached first.
+  void setStorage(TapeStorage *storage);
+  // Spreads the tracks of each block across the pool's workers. The pool
+  // must outlive the transport or be detached first; nullptr renders them
+  // in turn on the calling thread.
+  void setWorkerPool(RealtimeWorkerPool *pool);
+
+  // Message thread.
+  void play();
+  void stop();
+  void locate(std::int64_t frame);
+  void setSpeed(float speed);
+  void setReverse(bool reverse);
+  void setBrake(bool brake);
+  void setBrakeSeconds(float seconds);
+  void setLoop(std::int64_t start_frame, std::int64_t end_frame);
+  void clearLoop();
+  // The armed track also carries the instrument so it can be monitored.
+  void setMonitorTrack(int track);
+
+  // Any thread.
+  auto isPlaying() const -> bool;
+  auto position() const -> std::int64_t;
+  auto underrunCount() const -> std::uint64_t;
+
+  void prepare(double sample_rate, int max_block_size) override;
+  void process(AudioGraphBuses &buses, const juce::MidiBuffer &midi, int num_samples) override;
+  void render(TapeStorage &storage, juce::AudioBuffer<float> &tape, int num_samples);
+
+private:
+  static constexpr int kNoLocate = -1;
+  static constexpr std::size_t kMaxReadWindows = 2;
+
+  // A frame range of tape read by the current block, and the end of the run
+  // of output samples that read from it.
+  struct ReadWindow {
+    std::int64_t first = 0;
+    std::int64_t count = 0;
+    std::size_t end_sample = 0;
+  };
+
+  // What a pool worker needs to render one track of the current block.
+  // Channel pointers are taken once on the calling thread, since
+  // AudioBuffer::getWritePointer() also marks the buffer as not clear.
+  struct TrackJob {
+    TapeTransport *transport = nullptr;
+    const TapeStorage *storage = nullptr;
+    std::array<float *, kStereoChannelCount * kTapeTrackCount> channels{};
+    int num_samples = 0;
+  };
+
+  auto advance(int num_samples, std::int64_t tape_frames) -> bool;
+  static void renderTrackTask(void *context, int track);
+  void renderTrack(const TapeStorage &storage, int track, float *left_channel,
+                   float *right_channel, int num_samples);
+  void renderWindow(std::span<const float> window, const ReadWindow &range,
+                    std::size_t begin_sample, std::span<float> left,
+                    std::span<float> right) const;
+
+  const TapeKernels *kernels = nullptr;
+  std::atomic<TapeStorage *> tape_storage{nullptr};
+  std::atomic<RealtimeWorkerPool *> worker_pool{nullptr};
+  std::atomic<bool> playing{false};
+  std::atomic<bool> reversed{false};
+  std::atomic<bool> braking{false};
+  std::atomic<float> speed{1.0f};
+  std::atomic<float> brake_seconds{kTapeDefaultBrakeSeconds};
+  // Loop start in the high word and end in the low word, so both change
+  // together; tape frames always fit in 32 bits.
+  std::atomic<std::uint64_t> loop_range{0};
+  std::atomic<std::int64_t> pending_locate{kNoLocate};
+  std::atomic<int> monitor_track{0};
+  std::atomic<std::int64_t> position_frame{0};
+  std::atomic<std::uint64_t> underruns{0};
+
+  double sample_rate = 0.0;
+  double position_exact = 0.0;
+  double rate = 0.0;
+  // Windows and shape of the current block, shared by every track.
+  std::array<ReadWindow, kMaxReadWindows> read_windows{};
+  std::size_t read_window_count = 0;
+  bool unity = false;
+  std::vector<std::int64_t> frames;
+  std::vector<float> block_kernels;
+};
+} // namespace limit
@@ -30,4 +30,40 @@ auto computeUiLayout(UiLayoutParams params) -> UiLayout {
 
   return layout;
 }
+
+auto layoutRegion(const UiLayout &layout, UiRegion region) -> LayoutRect {
+  switch (region) {
+  case UiRegion::kHeader:
+    return layout.header;
+  case UiRegion::kVisualization:
+    return layout.visualization;
+  case UiRegion::kEncoder:
+    return layout.encoder;
+  case UiRegion::kSecondary:
+    return layout.secondary;
+  }
+  return {};
+}
+
+void UiDirtyRegions::mark(UiRegion region) { mask |= bit(region); }
+
+void UiDirtyRegions::markAll() {
+  for (int region = 0; region < kUiRegionCount; ++region) {
+    mark(static_cast<UiRegion>(region));
+  }
+}
+
+auto UiDirtyRegions::isDirty(UiRegion region) const -> bool { return (mask & bit(region)) != 0; }
+
+auto UiDirtyRegions::any() const -> bool { return mask != 0; }
+
+auto UiDirtyRegions::take() -> UiDirtyRegions {
+  const auto taken = *this;
+  mask = 0;
+  return taken;
+}
+
+auto UiDirtyRegions::bit(UiRegion region) -> std::uint8_t {
+  return static_cast<std::uint8_t>(1U << static_cast<unsigned>(region));
+}
 } // namespace limit
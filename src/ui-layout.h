@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace limit {
 struct LayoutRect {
   int x = 0;
@@ -24,4 +26,26 @@ struct UiLayoutParams {
 };
 
 auto computeUiLayout(UiLayoutParams params) -> UiLayout;
+
+enum class UiRegion : std::uint8_t { kHeader, kVisualization, kEncoder, kSecondary };
+constexpr int kUiRegionCount = 4;
+
+auto layoutRegion(const UiLayout &layout, UiRegion region) -> LayoutRect;
+
+// Regions whose displayed state changed since the last refresh. Input
+// handlers only mark regions; the display-rate refresh takes the set and
+// repaints each dirty region once, however many updates arrived in between.
+class UiDirtyRegions {
+public:
+  void mark(UiRegion region);
+  void markAll();
+  auto isDirty(UiRegion region) const -> bool;
+  auto any() const -> bool;
+  auto take() -> UiDirtyRegions;
+
+private:
+  static auto bit(UiRegion region) -> std::uint8_t;
+
+  std::uint8_t mask = 0;
+};
 } // namespace limit
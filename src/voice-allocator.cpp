@@ -0,0 +1,141 @@
+#include "voice-allocator.h"
+
+#include <algorithm>
+
+namespace limit {
+VoiceAllocator::VoiceAllocator(int voice_count_limit, VoiceStealPolicy policy)
+    : voice_count(std::clamp(voice_count_limit, 1, kMaxVoices)), steal_policy(policy) {
+  reset();
+}
+
+void VoiceAllocator::reset() {
+  voices.fill(VoiceSlot{});
+  note_to_voice.fill(-1);
+  // Stack order hands out voice 0 first.
+  free_count = voice_count;
+  for (int index = 0; index < voice_count; ++index) {
+    free_voices.at(static_cast<std::size_t>(index)) =
+        static_cast<std::int8_t>(voice_count - 1 - index);
+  }
+  next_start = 0;
+}
+
+auto VoiceAllocator::noteOn(int note) -> VoiceStart {
+  if (note < 0 || note >= kMidiNoteCount) {
+    return {};
+  }
+
+  VoiceStart start;
+  auto &mapped = note_to_voice.at(static_cast<std::size_t>(note));
+  if (mapped >= 0) {
+    start.voice = mapped;
+  } else if (free_count > 0) {
+    --free_count;
+    start.voice = free_voices.at(static_cast<std::size_t>(free_count));
+  } else {
+    start.voice = chooseVictim();
+    auto &victim = voices.at(static_cast<std::size_t>(start.voice));
+    start.stolen_note = victim.note;
+    if (victim.note >= 0 &&
+        note_to_voice.at(static_cast<std::size_t>(victim.note)) == start.voice) {
+      note_to_voice.at(static_cast<std::size_t>(victim.note)) = -1;
+    }
+  }
+
+  auto &slot = voices.at(static_cast<std::size_t>(start.voice));
+  slot.note = note;
+  slot.started = next_start++;
+  slot.level = 0.0f;
+  slot.active = true;
+  slot.releasing = false;
+  mapped = static_cast<std::int8_t>(start.voice);
+  return start;
+}
+
+auto VoiceAllocator::noteOff(int note) -> int {
+  if (note < 0 || note >= kMidiNoteCount) {
+    return -1;
+  }
+  auto &mapped = note_to_voice.at(static_cast<std::size_t>(note));
+  const int voice = mapped;
+  if (voice < 0) {
+    return -1;
+  }
+  mapped = -1;
+  voices.at(static_cast<std::size_t>(voice)).releasing = true;
+  return voice;
+}
+
+void VoiceAllocator::voiceFinished(int voice) {
+  if (!isValidVoice(voice)) {
+    return;
+  }
+  auto &slot = voices.at(static_cast<std::size_t>(voice));
+  if (!slot.active) {
+    return;
+  }
+  if (slot.note >= 0 && note_to_voice.at(static_cast<std::size_t>(slot.note)) == voice) {
+    note_to_voice.at(static_cast<std::size_t>(slot.note)) = -1;
+  }
+  slot = VoiceSlot{};
+  free_voices.at(static_cast<std::size_t>(free_count)) = static_cast<std::int8_t>(voice);
+  ++free_count;
+}
+
+void VoiceAllocator::setVoiceLevel(int voice, float level) {
+  if (isValidVoice(voice)) {
+    voices.at(static_cast<std::size_t>(voice)).level = level;
+  }
+}
+
+auto VoiceAllocator::voiceForNote(int note) const -> int {
+  if (note < 0 || note >= kMidiNoteCount) {
+    return -1;
+  }
+  return note_to_voice.at(static_cast<std::size_t>(note));
+}
+
+auto VoiceAllocator::noteForVoice(int voice) const -> int {
+  return isValidVoice(voice) ? voices.at(static_cast<std::size_t>(voice)).note : -1;
+}
+
+auto VoiceAllocator::isVoiceActive(int voice) const -> bool {
+  return isValidVoice(voice) && voices.at(static_cast<std::size_t>(voice)).active;
+}
+
+auto VoiceAllocator::isVoiceReleasing(int voice) const -> bool {
+  return isValidVoice(voice) && voices.at(static_cast<std::size_t>(voice)).releasing;
+}
+
+auto VoiceAllocator::activeVoiceCount() const -> int { return voice_count - free_count; }
+
+auto VoiceAllocator::voiceCount() const -> int { return voice_count; }
+
+auto VoiceAllocator::chooseVictim() const -> int {
+  auto better = [this](const VoiceSlot &candidate, const VoiceSlot &current) {
+    if (candidate.releasing != current.releasing) {
+      return candidate.releasing;
+    }
+    if (steal_policy == VoiceStealPolicy::kQuietest && candidate.level < current.level) {
+      return true;
+    }
+    if (steal_policy == VoiceStealPolicy::kQuietest && current.level < candidate.level) {
+      return false;
+    }
+    return candidate.started < current.started;
+  };
+
+  int victim = 0;
+  for (int index = 1; index < voice_count; ++index) {
+    if (better(voices.at(static_cast<std::size_t>(index)),
+               voices.at(static_cast<std::size_t>(victim)))) {
+      victim = index;
+    }
+  }
+  return victim;
+}
+
+auto VoiceAllocator::isValidVoice(int voice) const -> bool {
+  return voice >= 0 && voice < voice_count;
+}
+} // namespace limit
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace limit {
+constexpr int kMaxVoices = 16;
+constexpr int kMidiNoteCount = 128;
+
+enum class VoiceStealPolicy : std::uint8_t { kOldest, kQuietest };
+
+struct VoiceStart {
+  int voice = -1;
+  int stolen_note = -1;
+};
+
+// Fixed voice pool bookkeeping. Note-on and note-off resolve through a
+// note->voice table and a free-voice stack, so both are O(1). When the pool is
+// full a voice is stolen deterministically: releasing voices go first, then
+// the oldest (or quietest, ties broken by age) sounding voice.
+class VoiceAllocator {
+public:
+  explicit VoiceAllocator(int voice_count = kMaxVoices,
+                          VoiceStealPolicy policy = VoiceStealPolicy::kQuietest);
+
+  void reset();
+  auto noteOn(int note) -> VoiceStart;
+  auto noteOff(int note) -> int;
+  void voiceFinished(int voice);
+  void setVoiceLevel(int voice, float level);
+
+  auto voiceForNote(int note) const -> int;
+  auto noteForVoice(int voice) const -> int;
+  auto isVoiceActive(int voice) const -> bool;
+  auto isVoiceReleasing(int voice) const -> bool;
+  auto activeVoiceCount() const -> int;
+  auto voiceCount() const -> int;
+
+private:
+  struct VoiceSlot {
+    int note = -1;
+    std::uint64_t started = 0;
+    float level = 0.0f;
+    bool active = false;
+    bool releasing = false;
+  };
+
+  auto chooseVictim() const -> int;
+  auto isValidVoice(int voice) const -> bool;
+
+  std::array<VoiceSlot, kMaxVoices> voices{};
+  std::array<std::int8_t, kMidiNoteCount> note_to_voice{};
+  std::array<std::int8_t, kMaxVoices> free_voices{};
+  int free_count = 0;
+  std::uint64_t next_start = 0;
+  int voice_count = kMaxVoices;
+  VoiceStealPolicy steal_policy = VoiceStealPolicy::kQuietest;
+};
+} // namespace limit
@@ -0,0 +1,66 @@
+#include "voice-engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <span>
+
+namespace limit {
+namespace {
+constexpr double kConcertPitchHz = 440.0;
+constexpr int kConcertPitchNote = 69;
+constexpr double kSemitonesPerOctave = 12.0;
+
+auto noteToHz(int note) -> double {
+  return kConcertPitchHz *
+         std::pow(2.0, static_cast<double>(note - kConcertPitchNote) / kSemitonesPerOctave);
+}
+} // namespace
+
+void SineVoiceEngine::prepare(double new_sample_rate, int /*max_block_size*/) {
+  sample_rate = new_sample_rate;
+  attack_step = sample_rate > 0.0 ? static_cast<float>(1.0 / (kAttackSeconds * sample_rate))
+                                  : 1.0f;
+  release_step = sample_rate > 0.0 ? static_cast<float>(1.0 / (kReleaseSeconds * sample_rate))
+                                   : 1.0f;
+  sounding = false;
+}
+
+void SineVoiceEngine::start(int note, float velocity) {
+  const auto omega =
+      sample_rate > 0.0 ? 2.0 * std::numbers::pi * noteToHz(note) / sample_rate : 0.0;
+  // y[n] = 2cos(w) y[n-1] - y[n-2] produces sin(w n) without calling sin per sample.
+  sine_coefficient = 2.0 * std::cos(omega);
+  previous = std::sin(-omega);
+  before_previous = std::sin(-2.0 * omega);
+  gain = kPeakGain * std::clamp(velocity, 0.0f, 1.0f);
+  envelope = 0.0f;
+  releasing = false;
+  sounding = true;
+}
+
+void SineVoiceEngine::release() { releasing = true; }
+
+auto SineVoiceEngine::render(float *left, float *right, int num_samples) -> bool {
+  if (!sounding) {
+    return false;
+  }
+  const std::span<float> left_out(left, static_cast<std::size_t>(num_samples));
+  const std::span<float> right_out(right, static_cast<std::size_t>(num_samples));
+  for (std::size_t index = 0; index < left_out.size(); ++index) {
+    const auto current = (sine_coefficient * previous) - before_previous;
+    before_previous = previous;
+    previous = current;
+
+    envelope = releasing ? std::max(envelope - release_step, 0.0f)
+                         : std::min(envelope + attack_step, 1.0f);
+    const auto sample = static_cast<float>(current) * envelope * gain;
+    left_out[index] += sample;
+    right_out[index] += sample;
+  }
+  sounding = !(releasing && envelope <= 0.0f);
+  return sounding;
+}
+
+auto SineVoiceEngine::level() const -> float { return sounding ? envelope * gain : 0.0f; }
+} // namespace limit
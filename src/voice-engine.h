@@ -0,0 +1,57 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+namespace limit {
+// Per-voice DSP hosted by the synth voice pool. Every engine (Analog, FM,
+// Wavetable, Karplus-Strong, Sampler) implements this. prepare() runs on the
+// message thread; everything else runs on the audio thread and must not
+// allocate.
+class VoiceEngine {
+public:
+  VoiceEngine() = default;
+  virtual ~VoiceEngine() = default;
+  VoiceEngine(const VoiceEngine &) = delete;
+  auto operator=(const VoiceEngine &) -> VoiceEngine & = delete;
+  VoiceEngine(VoiceEngine &&) = delete;
+  auto operator=(VoiceEngine &&) -> VoiceEngine & = delete;
+
+  virtual void prepare(double sample_rate, int max_block_size) = 0;
+  virtual void start(int note, float velocity) = 0;
+  virtual void release() = 0;
+  // Adds the next num_samples of output into left/right. Returns false once
+  // the voice has fallen silent and can be returned to the pool.
+  virtual auto render(float *left, float *right, int num_samples) -> bool = 0;
+  virtual auto level() const -> float = 0;
+};
+
+using VoiceEngineFactory = std::function<std::unique_ptr<VoiceEngine>()>;
+
+// Placeholder engine until the synthesis engines land: a recursive sine
+// oscillator with a linear attack/release envelope.
+class SineVoiceEngine final : public VoiceEngine {
+public:
+  void prepare(double sample_rate, int max_block_size) override;
+  void start(int note, float velocity) override;
+  void release() override;
+  auto render(float *left, float *right, int num_samples) -> bool override;
+  auto level() const -> float override;
+
+private:
+  static constexpr double kAttackSeconds = 0.005;
+  static constexpr double kReleaseSeconds = 0.1;
+  static constexpr float kPeakGain = 0.2f;
+
+  double sample_rate = 0.0;
+  double sine_coefficient = 0.0;
+  double previous = 0.0;
+  double before_previous = 0.0;
+  float gain = 0.0f;
+  float envelope = 0.0f;
+  float attack_step = 0.0f;
+  float release_step = 0.0f;
+  bool releasing = false;
+  bool sounding = false;
+};
+} // namespace limit
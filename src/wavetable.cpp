@@ -0,0 +1,143 @@
+#include "wavetable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace limit {
+namespace {
+constexpr double kNyquistCycles = 0.5;
+
+auto makeSineCycle() -> std::vector<float> {
+  std::vector<float> cycle(static_cast<std::size_t>(kWavetableTopSize));
+  for (std::size_t index = 0; index < cycle.size(); ++index) {
+    cycle.at(index) = static_cast<float>(std::sin(2.0 * std::numbers::pi *
+                                                  static_cast<double>(index) /
+                                                  static_cast<double>(kWavetableTopSize)));
+  }
+  return cycle;
+}
+} // namespace
+
+auto makeShapeHarmonics(WavetableShape shape) -> std::vector<float> {
+  std::vector<float> amplitudes(static_cast<std::size_t>(kWavetableMaxHarmonics), 0.0f);
+  for (std::size_t index = 0; index < amplitudes.size(); ++index) {
+    const auto harmonic = static_cast<float>(index + 1);
+    const auto odd = index % 2 == 0;
+    switch (shape) {
+    case WavetableShape::kSine:
+      amplitudes.at(index) = index == 0 ? 1.0f : 0.0f;
+      break;
+    case WavetableShape::kSaw:
+      amplitudes.at(index) = 1.0f / harmonic;
+      break;
+    case WavetableShape::kSquare:
+      amplitudes.at(index) = odd ? 1.0f / harmonic : 0.0f;
+      break;
+    case WavetableShape::kTriangle: {
+      const auto sign = index % 4 == 0 ? 1.0f : -1.0f;
+      amplitudes.at(index) = odd ? sign / (harmonic * harmonic) : 0.0f;
+      break;
+    }
+    }
+  }
+  return amplitudes;
+}
+
+Wavetable::Wavetable(std::span<const float> harmonic_amplitudes) {
+  std::size_t total = 0;
+  for (int index = 0; index < kWavetableLevelCount; ++index) {
+    offsets.at(static_cast<std::size_t>(index)) = total;
+    total += static_cast<std::size_t>(levelSize(index)) + 1;
+  }
+  samples.assign(total, 0.0f);
+
+  // Every level size divides the top size, so sin(2 pi h n / size) is a
+  // lookup into one precomputed cycle at index h * n * (top / size).
+  const auto sine = makeSineCycle();
+  constexpr auto kSineMask = static_cast<std::size_t>(kWavetableTopSize - 1);
+  float peak = 0.0f;
+  for (int index = 0; index < kWavetableLevelCount; ++index) {
+    const auto size = static_cast<std::size_t>(levelSize(index));
+    const auto stride = static_cast<std::size_t>(kWavetableTopSize) / size;
+    const auto harmonics = std::min(static_cast<std::size_t>(levelHarmonics(index)),
+                                    harmonic_amplitudes.size());
+    const auto destination = std::span(samples).subspan(
+        offsets.at(static_cast<std::size_t>(index)), size + 1);
+    for (std::size_t harmonic = 1; harmonic <= harmonics; ++harmonic) {
+      const auto amplitude = harmonic_amplitudes[harmonic - 1];
+      for (std::size_t sample = 0; sample < size; ++sample) {
+        destination[sample] += amplitude * sine.at((harmonic * sample * stride) & kSineMask);
+      }
+    }
+    destination[size] = destination[0];
+    for (const auto value : destination) {
+      peak = std::max(peak, std::abs(value));
+    }
+  }
+
+  // One gain for all levels so switching level while a note glides does not
+  // change its loudness.
+  if (peak > 0.0f) {
+    const auto gain = 1.0f / peak;
+    for (auto &value : samples) {
+      value *= gain;
+    }
+  }
+}
+
+auto Wavetable::levelForIncrement(double cycles_per_sample) const -> int {
+  const auto increment = std::abs(cycles_per_sample);
+  for (int index = 0; index < kWavetableLevelCount; ++index) {
+    if (static_cast<double>(levelHarmonics(index)) * increment < kNyquistCycles) {
+      return index;
+    }
+  }
+  return kWavetableLevelCount - 1;
+}
+
+auto Wavetable::level(int index) const -> std::span<const float> {
+  const auto clamped = static_cast<std::size_t>(std::clamp(index, 0, kWavetableLevelCount - 1));
+  return std::span(samples).subspan(offsets.at(clamped),
+                                    static_cast<std::size_t>(levelSize(index)) + 1);
+}
+
+auto Wavetable::levelSize(int index) -> int {
+  const auto clamped = std::clamp(index, 0, kWavetableLevelCount - 1);
+  return std::max(kWavetableTopSize >> clamped, kWavetableMinSize);
+}
+
+auto Wavetable::levelHarmonics(int index) -> int {
+  const auto clamped = std::clamp(index, 0, kWavetableLevelCount - 1);
+  return std::max(kWavetableMaxHarmonics >> clamped, 1);
+}
+
+auto Wavetable::memoryBytes() const -> std::size_t { return samples.size() * sizeof(float); }
+
+auto WavetableCache::get(WavetableShape shape) -> const Wavetable & {
+  const std::scoped_lock lock(mutex);
+  auto &table = tables.at(static_cast<std::size_t>(shape));
+  if (table == nullptr) {
+    const auto harmonics = makeShapeHarmonics(shape);
+    table = std::make_unique<Wavetable>(harmonics);
+  }
+  return *table;
+}
+
+void WavetableCache::prebuild() {
+  for (int shape = 0; shape < kWavetableShapeCount; ++shape) {
+    get(static_cast<WavetableShape>(shape));
+  }
+}
+
+auto WavetableCache::memoryBytes() const -> std::size_t {
+  const std::scoped_lock lock(mutex);
+  std::size_t total = 0;
+  for (const auto &table : tables) {
+    if (table != nullptr) {
+      total += table->memoryBytes();
+    }
+  }
+  return total;
+}
+} // namespace limit
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace limit {
+constexpr int kWavetableTopSize = 2048;
+constexpr int kWavetableMinSize = 256;
+constexpr int kWavetableMaxHarmonics = 512;
+constexpr int kWavetableLevelCount = 10;
+
+enum class WavetableShape : std::uint8_t { kSine, kSaw, kSquare, kTriangle };
+constexpr int kWavetableShapeCount = 4;
+
+// Harmonic amplitudes for a basic shape; index 0 is the fundamental.
+auto makeShapeHarmonics(WavetableShape shape) -> std::vector<float>;
+
+// One single-cycle waveform stored as a chain of band-limited mip levels.
+// Level k keeps kWavetableMaxHarmonics >> k harmonics and halves its table
+// size (down to kWavetableMinSize), so every level stays at least four times
+// oversampled. Each level carries one guard sample equal to its first sample
+// so interpolation never wraps. Built on the message thread, immutable after.
+class Wavetable {
+public:
+  explicit Wavetable(std::span<const float> harmonic_amplitudes);
+
+  // Richest level whose top harmonic stays below Nyquist at this phase
+  // increment (cycles per sample).
+  auto levelForIncrement(double cycles_per_sample) const -> int;
+  auto level(int index) const -> std::span<const float>;
+  static auto levelSize(int index) -> int;
+  static auto levelHarmonics(int index) -> int;
+  auto memoryBytes() const -> std::size_t;
+
+private:
+  std::vector<float> samples;
+  std::array<std::size_t, kWavetableLevelCount> offsets{};
+};
+
+// Shared store of built tables. Tables are generated lazily on first use, or
+// up front with prebuild(), and live as long as the cache, so the audio thread
+// can hold plain pointers to them. Never call get() from the audio thread.
+class WavetableCache {
+public:
+  auto get(WavetableShape shape) -> const Wavetable &;
+  void prebuild();
+  auto memoryBytes() const -> std::size_t;
+
+private:
+  mutable std::mutex mutex;
+  std::array<std::unique_ptr<Wavetable>, kWavetableShapeCount> tables;
+};
+} // namespace limit
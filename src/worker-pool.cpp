@@ -0,0 +1,223 @@
+#include "worker-pool.h"
+
+#include <algorithm>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace limit {
+namespace {
+// Tells the core we are spinning so a sibling hyperthread gets the pipeline.
+inline void cpuRelax() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+auto resolveWorkerCount(int requested) -> int {
+  if (requested >= 0) {
+    return std::min(requested, kMaxPoolWorkers);
+  }
+  const auto cores = static_cast<int>(std::thread::hardware_concurrency());
+  return std::clamp(cores - 1, 0, kMaxPoolWorkers);
+}
+
+// SCHED_FIFO or SCHED_RR priority of the calling thread, 0 on the normal
+// scheduler.
+auto callerRealtimePriority() -> int {
+#if defined(__linux__)
+  auto policy = 0;
+  sched_param parameters{};
+  if (pthread_getschedparam(pthread_self(), &policy, &parameters) == 0 &&
+      (policy == SCHED_FIFO || policy == SCHED_RR)) {
+    return parameters.sched_priority;
+  }
+#endif
+  return 0;
+}
+
+void setRealtimePriority(int priority) {
+#if defined(__linux__)
+  sched_param parameters{};
+  parameters.sched_priority = priority;
+  // Without the rtprio limit this fails and the worker stays on the normal
+  // scheduler, which is still correct, just less punctual.
+  pthread_setschedparam(pthread_self(), priority > 0 ? SCHED_FIFO : SCHED_OTHER, &parameters);
+#else
+  static_cast<void>(priority);
+#endif
+}
+} // namespace
+
+RealtimeWorkerPool::RealtimeWorkerPool(const WorkerPoolConfig &pool_config)
+    : config(pool_config), worker_count(resolveWorkerCount(pool_config.worker_count)) {}
+
+RealtimeWorkerPool::~RealtimeWorkerPool() { stop(); }
+
+void RealtimeWorkerPool::start() {
+  if (!workers.empty() || worker_count == 0) {
+    return;
+  }
+  stopping.store(false, std::memory_order_relaxed);
+  pinned.store(0, std::memory_order_relaxed);
+  worker_priority.store(0, std::memory_order_relaxed);
+  priority_limited = false;
+  workers.reserve(static_cast<std::size_t>(worker_count));
+  for (int worker = 0; worker < worker_count; ++worker) {
+    workers.emplace_back([this, worker] { runWorker(worker); });
+  }
+}
+
+void RealtimeWorkerPool::stop() {
+  if (workers.empty()) {
+    return;
+  }
+  stopping.store(true, std::memory_order_seq_cst);
+  wake_epoch.fetch_add(1, std::memory_order_seq_cst);
+  wake_epoch.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+}
+
+void RealtimeWorkerPool::parallelFor(int count, WorkerTask task, void *context) {
+  if (count <= 0) {
+    return;
+  }
+  if (workers.empty() || count == 1) {
+    for (int index = 0; index < count; ++index) {
+      task(context, index);
+    }
+    return;
+  }
+  count = std::min(count, static_cast<int>(kIndexMask));
+  if (!priority_limited) {
+    limitPriority();
+  }
+
+  job_task = task;
+  job_context = context;
+  completed.store(0, std::memory_order_relaxed);
+  const auto serial = jobSerial(job.load(std::memory_order_relaxed)) + 1;
+  const auto word = (serial << kSerialShift) | (static_cast<std::uint64_t>(count) << kCountShift);
+  job.store(word, std::memory_order_seq_cst);
+  if (parked.load(std::memory_order_seq_cst) > 0) {
+    wake_epoch.fetch_add(1, std::memory_order_seq_cst);
+    wake_epoch.notify_all();
+  }
+
+  drain(word);
+  while (completed.load(std::memory_order_acquire) < count) {
+    cpuRelax();
+  }
+}
+
+auto RealtimeWorkerPool::workerCount() const -> int { return worker_count; }
+
+auto RealtimeWorkerPool::pinnedCount() const -> int {
+  return pinned.load(std::memory_order_relaxed);
+}
+
+auto RealtimeWorkerPool::workerPriority() const -> int {
+  return worker_priority.load(std::memory_order_relaxed);
+}
+
+void RealtimeWorkerPool::runWorker(int worker) {
+  pinThread(worker);
+  auto priority = 0;
+  auto seen = job.load(std::memory_order_acquire);
+  while (true) {
+    const auto word = waitForJob(jobSerial(seen));
+    if (stopping.load(std::memory_order_relaxed)) {
+      return;
+    }
+    // Published before the job word, so this is the limit for this job.
+    if (const auto wanted = worker_priority.load(std::memory_order_relaxed); wanted != priority) {
+      priority = wanted;
+      setRealtimePriority(priority);
+    }
+    seen = word;
+    drain(word);
+  }
+}
+
+auto RealtimeWorkerPool::waitForJob(std::uint64_t seen_serial) -> std::uint64_t {
+  while (true) {
+    for (int spin = 0; spin < config.spin_iterations; ++spin) {
+      const auto word = job.load(std::memory_order_acquire);
+      if (jobSerial(word) != seen_serial || stopping.load(std::memory_order_relaxed)) {
+        return word;
+      }
+      cpuRelax();
+    }
+
+    // Announce the park before the final check; parallelFor() publishes
+    // the job before reading parked, so one side always sees the other.
+    parked.fetch_add(1, std::memory_order_seq_cst);
+    const auto epoch = wake_epoch.load(std::memory_order_seq_cst);
+    const auto word = job.load(std::memory_order_seq_cst);
+    const auto ready = jobSerial(word) != seen_serial || stopping.load(std::memory_order_seq_cst);
+    if (!ready) {
+      wake_epoch.wait(epoch, std::memory_order_seq_cst);
+    }
+    parked.fetch_sub(1, std::memory_order_seq_cst);
+    if (ready) {
+      return word;
+    }
+  }
+}
+
+void RealtimeWorkerPool::drain(std::uint64_t job_word) {
+  auto current = job_word;
+  while (jobSerial(current) == jobSerial(job_word) && jobIndex(current) < jobCount(current)) {
+    if (job.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel,
+                                  std::memory_order_acquire)) {
+      // The job cannot be replaced until this item is counted, so the task
+      // and context still belong to it.
+      job_task(job_context, static_cast<int>(jobIndex(current)));
+      completed.fetch_add(1, std::memory_order_release);
+      ++current;
+    }
+  }
+}
+
+// Runs once per start(), on the first job, since only then is the
+// submitting thread known. One scheduler query, nothing allocated.
+void RealtimeWorkerPool::limitPriority() {
+  priority_limited = true;
+  if (config.realtime_priority > 0) {
+    const auto ceiling = callerRealtimePriority() - 1;
+    worker_priority.store(std::max(std::min(config.realtime_priority, ceiling), 0),
+                          std::memory_order_relaxed);
+  }
+}
+
+void RealtimeWorkerPool::pinThread(int worker) {
+#if defined(__linux__)
+  const auto cores = static_cast<int>(std::thread::hardware_concurrency());
+  if (config.pin_threads && cores > 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(static_cast<std::size_t>((config.first_core + worker) % cores), &cpus);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0) {
+      pinned.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+#else
+  static_cast<void>(worker);
+#endif
+}
+} // namespace limit
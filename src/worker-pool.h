@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace limit {
+constexpr int kMaxPoolWorkers = 7;
+constexpr int kDefaultPoolSpinIterations = 1000;
+
+// One item of a parallel job; index runs from 0 to the job's count - 1.
+using WorkerTask = void (*)(void *context, int index);
+
+struct WorkerPoolConfig {
+  // Threads besides the caller. -1 uses every core but the caller's, up to
+  // kMaxPoolWorkers.
+  int worker_count = -1;
+  // Workers stay on one core each from first_core on, which keeps their
+  // caches warm. The submitting thread is not pinned and may share a core
+  // with a worker.
+  bool pin_threads = true;
+  int first_core = 1;
+  // Ask for SCHED_FIFO at up to this priority where permitted, but always
+  // below the submitting thread's, so a worker on the submitter's core can
+  // never hold it off. The first job after start() reads the submitter's
+  // scheduling; workers of a submitter without a realtime priority stay on
+  // the normal scheduler. 0 leaves the scheduler alone.
+  int realtime_priority = 0;
+  // How long an idle worker polls before parking, in pause instructions:
+  // long enough to catch a job that follows straight after the last one,
+  // far shorter than a block, so between blocks workers sleep instead of
+  // competing with the submitter for a core.
+  int spin_iterations = kDefaultPoolSpinIterations;
+};
+
+// Fork-join pool for the audio thread. parallelFor() hands out the items of
+// one job to the workers and the calling thread alike and returns when all
+// of them have run. Submitting a job publishes one atomic word and, only if
+// a worker is parked, a futex wake; nothing is allocated or locked, so it
+// may be called from the audio callback. Jobs are not nested and only one
+// thread submits.
+class RealtimeWorkerPool {
+public:
+  explicit RealtimeWorkerPool(const WorkerPoolConfig &config = {});
+  ~RealtimeWorkerPool();
+  RealtimeWorkerPool(const RealtimeWorkerPool &) = delete;
+  auto operator=(const RealtimeWorkerPool &) -> RealtimeWorkerPool & = delete;
+  RealtimeWorkerPool(RealtimeWorkerPool &&) = delete;
+  auto operator=(RealtimeWorkerPool &&) -> RealtimeWorkerPool & = delete;
+
+  // Message thread. Without start() parallelFor() runs every item inline.
+  void start();
+  void stop();
+
+  // Submitting thread.
+  void parallelFor(int count, WorkerTask task, void *context);
+
+  auto workerCount() const -> int;
+  // Number of workers that pinned successfully, and the SCHED_FIFO
+  // priority they were given (0 for none), for diagnostics.
+  auto pinnedCount() const -> int;
+  auto workerPriority() const -> int;
+
+private:
+  void runWorker(int worker);
+  auto waitForJob(std::uint64_t seen) -> std::uint64_t;
+  // Claims and runs items of the job published as job_word until none are
+  // left.
+  void drain(std::uint64_t job_word);
+  void pinThread(int worker);
+  // Picks the workers' priority from the submitter's; submitting thread.
+  void limitPriority();
+
+  // The job word packs the job's serial number, its item count and the next
+  // unclaimed item, so a worker can only claim items of the job it read the
+  // task for.
+  static constexpr int kIndexBits = 16;
+  static constexpr std::uint64_t kIndexMask = (std::uint64_t{1} << kIndexBits) - 1;
+  static constexpr int kCountShift = kIndexBits;
+  static constexpr int kSerialShift = 2 * kIndexBits;
+  static constexpr std::size_t kCacheLineSize = 64;
+
+  static constexpr auto jobSerial(std::uint64_t word) -> std::uint64_t {
+    return word >> kSerialShift;
+  }
+  static constexpr auto jobCount(std::uint64_t word) -> std::uint64_t {
+    return (word >> kCountShift) & kIndexMask;
+  }
+  static constexpr auto jobIndex(std::uint64_t word) -> std::uint64_t {
+    return word & kIndexMask;
+  }
+
+  WorkerPoolConfig config;
+  int worker_count = 0;
+  std::vector<std::thread> workers;
+  std::atomic<int> pinned{0};
+  std::atomic<int> worker_priority{0};
+  // Submitting thread.
+  bool priority_limited = false;
+
+  // Written by the submitter before the job word is published.
+  WorkerTask job_task = nullptr;
+  void *job_context = nullptr;
+
+  alignas(kCacheLineSize) std::atomic<std::uint64_t> job{0};
+  alignas(kCacheLineSize) std::atomic<int> completed{0};
+  alignas(kCacheLineSize) std::atomic<int> parked{0};
+  std::atomic<std::uint32_t> wake_epoch{0};
+  std::atomic<bool> stopping{false};
+};
+} // namespace limit
@@ -0,0 +1,164 @@
+#include "audio-device-setup.h"
+#include "test-files.h"
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+using limit::test::TempDirectory;
+
+constexpr double kSampleRate = 48000.0;
+
+// Plays blocks through a loopback that delays by a fixed number of samples,
+// the way a cable from output to input would. A device cannot return a
+// block's output within the same block, so the delay is at least one block.
+auto measureLoopback(limit::LatencyProbe &probe, int delay, int block_size)
+    -> limit::LatencyProbe::State {
+  std::deque<float> cable(static_cast<std::size_t>(delay), 0.0f);
+  std::vector<float> input(static_cast<std::size_t>(block_size));
+  std::vector<float> left(input.size());
+  std::vector<float> right(input.size());
+  probe.arm();
+  for (int block = 0; block < 100; ++block) {
+    for (auto &sample : input) {
+      sample = cable.front();
+      cable.pop_front();
+    }
+    probe.scanInput(input);
+    std::fill(left.begin(), left.end(), 0.0f);
+    std::fill(right.begin(), right.end(), 0.0f);
+    probe.writeOutput(left, right);
+    cable.insert(cable.end(), left.begin(), left.end());
+    const auto state = probe.state();
+    if (state == limit::LatencyProbe::State::kMeasured ||
+        state == limit::LatencyProbe::State::kTimedOut) {
+      return state;
+    }
+  }
+  return probe.state();
+}
+} // namespace
+
+TEST_CASE("Audio device profile round-trips through its file", "[audio-device]") {
+  const TempDirectory directory("device-test-profile");
+  const limit::AudioDeviceProfile profile{
+      .type = "ALSA",
+      .output_device = "USB Audio; Direct hardware device without any conversions",
+      .input_device = "USB Audio; Direct hardware device without any conversions",
+      .sample_rate = kSampleRate,
+      .buffer_size = 64};
+  const auto path = directory.get() / "Limit" / "audio-device.cfg";
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE_FALSE(limit::loadAudioDeviceProfile(path).has_value());
+  REQUIRE(limit::saveAudioDeviceProfile(path, profile));
+  const auto loaded = limit::loadAudioDeviceProfile(path);
+  REQUIRE(loaded.has_value());
+  REQUIRE(*loaded == profile);
+
+  REQUIRE(limit::parseAudioDeviceProfile("# saved\ntype JACK\noutput system\n"
+                                         "buffer-size 128\nfuture-key 1\n")
+              .has_value());
+  REQUIRE_FALSE(limit::parseAudioDeviceProfile("type JACK\nbuffer-size 128\n").has_value());
+  REQUIRE_FALSE(
+      limit::parseAudioDeviceProfile("type JACK\noutput system\nbuffer-size 0\n").has_value());
+  REQUIRE_FALSE(limit::parseAudioDeviceProfile("type JACK\noutput system\nbuffer-size 64\n"
+                                               "sample-rate fast\n")
+                    .has_value());
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Device ranking prefers JACK and direct ALSA hardware", "[audio-device]") {
+  const std::vector<std::string> alsa_names{
+      "default", "pulse", "HDA Intel PCH; Hardware device with all software conversions",
+      "HDA Intel PCH; Direct hardware device without any conversions", "hw:CARD=USB,DEV=0"};
+  const std::vector<std::string> plug_names{"default", "plughw:CARD=PCH,DEV=0"};
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(limit::deviceTypeRank("JACK") > limit::deviceTypeRank("ALSA"));
+  REQUIRE(limit::deviceTypeRank("ALSA") > limit::deviceTypeRank("CoreAudio"));
+  REQUIRE(limit::pickDevice("ALSA", alsa_names) == 3);
+  REQUIRE(limit::pickDevice("ALSA", plug_names) == 1);
+  REQUIRE(limit::pickDevice("JACK", plug_names) == 0);
+  REQUIRE_FALSE(limit::pickDevice("ALSA", {}).has_value());
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Sample rate and latency follow the device", "[audio-device]") {
+  const std::array<double, 3> rates{44100.0, 48000.0, 96000.0};
+  const std::array<double, 2> other_rates{44100.0, 88200.0};
+  const limit::DeviceLatency latency{
+      .sample_rate = kSampleRate, .buffer_size = 64, .input_samples = 32, .output_samples = 96};
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(limit::chooseSampleRate(rates) == kSampleRate);
+  REQUIRE(limit::chooseSampleRate(other_rates) == 44100.0);
+  REQUIRE(limit::chooseSampleRate({}) == limit::kPreferredSampleRate);
+  REQUIRE(limit::roundTripSamples(latency) == 256);
+  REQUIRE(limit::samplesToMilliseconds(480, kSampleRate) == 10.0);
+  REQUIRE(limit::samplesToMilliseconds(480, 0.0) == 0.0);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Buffer negotiation steps up until a size runs clean", "[audio-device]") {
+  const std::array<int, 6> sizes{512, 16, 64, 32, 128, 256};
+  limit::BufferSizeNegotiator negotiator;
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(negotiator.begin(sizes) == limit::kMinDeviceBufferSize);
+  REQUIRE_FALSE(negotiator.observe(3, 0.0).has_value());
+  REQUIRE_FALSE(negotiator.observe(3, 1.0).has_value());
+  REQUIRE(negotiator.observe(4, 2.0) == 64);
+  // The reopened device counts from zero again.
+  REQUIRE_FALSE(negotiator.observe(0, 2.5).has_value());
+  REQUIRE_FALSE(negotiator.observe(0, 4.0).has_value());
+  REQUIRE_FALSE(negotiator.isSettled());
+  REQUIRE_FALSE(negotiator.observe(0, 2.5 + limit::kBufferProbationSeconds).has_value());
+  REQUIRE(negotiator.isSettled());
+  REQUIRE(negotiator.bufferSize() == 64);
+  REQUIRE_FALSE(negotiator.observe(9, 100.0).has_value());
+
+  REQUIRE(negotiator.begin(sizes) == limit::kMinDeviceBufferSize);
+  REQUIRE_FALSE(negotiator.observe(-1, 0.0).has_value());
+  REQUIRE(negotiator.isSettled());
+
+  const std::array<int, 2> tiny{8, 16};
+  REQUIRE(negotiator.begin(tiny) == 16);
+  REQUIRE(negotiator.isSettled());
+
+  negotiator.settleAt(256);
+  REQUIRE(negotiator.isSettled());
+  REQUIRE(negotiator.bufferSize() == 256);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Latency probe measures a loopback round trip", "[audio-device]") {
+  constexpr int kBlockSize = 64;
+  limit::LatencyProbe probe;
+  probe.prepare(kSampleRate);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(probe.state() == limit::LatencyProbe::State::kIdle);
+  for (const auto delay : {kBlockSize, kBlockSize + 37, 300}) {
+    REQUIRE(measureLoopback(probe, delay, kBlockSize) == limit::LatencyProbe::State::kMeasured);
+    REQUIRE(probe.measuredSamples() == delay);
+  }
+
+  probe.prepare(kBlockSize * 4);
+  std::vector<float> silence(kBlockSize, 0.0f);
+  std::vector<float> left(kBlockSize, 0.0f);
+  std::vector<float> right(kBlockSize, 0.0f);
+  probe.arm();
+  probe.writeOutput(left, right);
+  for (int block = 0; block < 4; ++block) {
+    probe.scanInput(silence);
+  }
+  REQUIRE(probe.state() == limit::LatencyProbe::State::kTimedOut);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
@@ -0,0 +1,157 @@
+#include "audio-graph.h"
+#include "level-meter.h"
+#include "realtime-guard.h"
+#include "signal-flow.h"
+
+#include <algorithm>
+#include <array>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+constexpr float kInstrumentLevel = 0.25f;
+constexpr double kSampleRate = 48000.0;
+constexpr int kMidiReserveBytes = 1024;
+
+class ConstantInstrument final : public limit::AudioGraphNode {
+public:
+  void prepare(double /*sample_rate*/, int max_block_size) override {
+    prepared_block_size = max_block_size;
+  }
+
+  void process(limit::AudioGraphBuses &buses, const juce::MidiBuffer &midi,
+               int num_samples) override {
+    midi_events += midi.getNumEvents();
+    for (int channel = 0; channel < buses.instrument.getNumChannels(); ++channel) {
+      juce::FloatVectorOperations::fill(buses.instrument.getWritePointer(channel),
+                                        kInstrumentLevel, num_samples);
+    }
+  }
+
+  auto preparedBlockSize() const -> int { return prepared_block_size; }
+  auto midiEventCount() const -> int { return midi_events; }
+
+private:
+  int prepared_block_size = 0;
+  int midi_events = 0;
+};
+
+auto positionOf(const limit::SignalOrder &order, limit::SignalNode node) -> std::ptrdiff_t {
+  return std::distance(order.begin(), std::find(order.begin(), order.end(), node));
+}
+} // namespace
+
+TEST_CASE("Signal order follows the fixed signal flow", "[audio-graph]") {
+  const auto order = limit::computeSignalOrder(limit::kSignalEdges);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(order.has_value());
+  const auto nodes = order.value_or(limit::SignalOrder{});
+  for (const auto &edge : limit::kSignalEdges) {
+    REQUIRE(positionOf(nodes, edge.from) < positionOf(nodes, edge.to));
+  }
+  REQUIRE(nodes.front() == limit::SignalNode::kInstrument);
+  REQUIRE(nodes.back() == limit::SignalNode::kMasterEffect);
+
+  const std::array<limit::SignalEdge, 2> cycle = {{
+      {.from = limit::SignalNode::kInsert, .to = limit::SignalNode::kMasterEq},
+      {.from = limit::SignalNode::kMasterEq, .to = limit::SignalNode::kInsert},
+  }};
+  REQUIRE_FALSE(limit::computeSignalOrder(cycle).has_value());
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Audio graph routes the instrument to the output", "[audio-graph]") {
+  constexpr int kBlockSize = 32;
+  constexpr int kHostBlockSize = 80;
+  ConstantInstrument instrument;
+  limit::AudioGraph graph;
+  graph.setNode(limit::SignalNode::kInstrument, &instrument);
+  graph.prepare(kSampleRate, kBlockSize);
+
+  juce::MidiBuffer midi;
+  midi.addEvent(juce::MidiMessage::noteOn(1, 60, static_cast<juce::uint8>(100)), 0);
+  midi.addEvent(juce::MidiMessage::noteOff(1, 60), kHostBlockSize - 1);
+  juce::AudioBuffer<float> output(2, kHostBlockSize);
+  output.clear();
+  graph.process(midi, output, 0, kHostBlockSize);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(instrument.preparedBlockSize() == kBlockSize);
+  REQUIRE(instrument.midiEventCount() == 2);
+  for (int channel = 0; channel < output.getNumChannels(); ++channel) {
+    REQUIRE(juce::exactlyEqual(output.getSample(channel, 0), kInstrumentLevel));
+    REQUIRE(juce::exactlyEqual(output.getSample(channel, kHostBlockSize - 1), kInstrumentLevel));
+  }
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Audio graph publishes track and master levels per slice", "[audio-graph][meter]") {
+  constexpr int kBlockSize = 32;
+  constexpr int kHostBlockSize = 80;
+  ConstantInstrument instrument;
+  limit::MeterQueue meters;
+  limit::AudioGraph graph;
+  graph.setNode(limit::SignalNode::kInstrument, &instrument);
+  graph.setMeterQueue(&meters);
+  graph.prepare(kSampleRate, kBlockSize);
+
+  const juce::MidiBuffer midi;
+  juce::AudioBuffer<float> output(2, kHostBlockSize);
+  graph.process(midi, output, 0, kHostBlockSize);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(meters.size() == 3);
+  const auto frame = meters.pop();
+  REQUIRE(frame.has_value());
+  const auto levels = frame.value_or(limit::MeterFrame{}).levels;
+  REQUIRE(juce::exactlyEqual(levels.at(0).peak, kInstrumentLevel));
+  REQUIRE(juce::exactlyEqual(levels.at(1).peak, 0.0f));
+  REQUIRE(juce::exactlyEqual(levels.at(limit::kMasterMeterIndex).peak, kInstrumentLevel));
+
+  graph.setMeterQueue(nullptr);
+  graph.process(midi, output, 0, kHostBlockSize);
+  REQUIRE(meters.size() == 2);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Audio graph clears output before prepare", "[audio-graph]") {
+  limit::AudioGraph graph;
+  juce::MidiBuffer midi;
+  juce::AudioBuffer<float> output(2, 16);
+  output.clear();
+  output.setSample(0, 0, 1.0f);
+  graph.process(midi, output, 0, output.getNumSamples());
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(juce::exactlyEqual(output.getSample(0, 0), 0.0f));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Audio graph does not allocate on the audio thread", "[audio-graph][realtime]") {
+  constexpr int kBlockSize = 64;
+  ConstantInstrument instrument;
+  limit::MeterQueue meters;
+  limit::AudioGraph graph;
+  graph.setNode(limit::SignalNode::kInstrument, &instrument);
+  graph.setMeterQueue(&meters);
+  graph.prepare(kSampleRate, kBlockSize);
+
+  juce::MidiBuffer midi;
+  midi.ensureSize(kMidiReserveBytes);
+  juce::AudioBuffer<float> output(2, kBlockSize);
+
+  const auto before = limit::realtimeAllocationCount();
+  {
+    const limit::ScopedRealtimeSection realtime_section;
+    midi.addEvent(juce::MidiMessage::noteOn(1, 60, static_cast<juce::uint8>(100)), 0);
+    graph.process(midi, output, 0, kBlockSize);
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  if (limit::isAllocationTrapEnabled()) {
+    REQUIRE(limit::realtimeAllocationCount() == before);
+  }
+  REQUIRE(meters.size() == 1);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
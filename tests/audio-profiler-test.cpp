@@ -0,0 +1,98 @@
+#include "audio-profiler.h"
+#include "realtime-guard.h"
+
+#include <chrono>
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+constexpr double kSampleRate = 48000.0;
+constexpr int kShortBlock = 48;   // 1 ms budget
+constexpr int kLongBlock = 48000; // 1 s budget
+
+void spinFor(std::chrono::microseconds duration) {
+  const auto end = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+void runCallback(limit::AudioProfiler &profiler, int num_samples,
+                 std::chrono::microseconds stage_time) {
+  profiler.beginCallback();
+  const auto start = limit::profilerTicks();
+  spinFor(stage_time);
+  profiler.endStage(limit::SignalNode::kTapeTracks, start);
+  profiler.endCallback(num_samples);
+}
+} // namespace
+
+TEST_CASE("Audio profiler counts callbacks, stages and missed deadlines", "[profiler]") {
+  limit::AudioProfiler profiler;
+  profiler.prepare(kSampleRate);
+  runCallback(profiler, kLongBlock, std::chrono::microseconds(200));
+  runCallback(profiler, kShortBlock, std::chrono::microseconds(2000));
+  runCallback(profiler, kLongBlock, std::chrono::microseconds(100));
+  profiler.setDeviceSummary("ALSA 48000 Hz 64 smp");
+  const auto snapshot = profiler.snapshot();
+  const auto report = limit::formatProfileReport(snapshot);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(report.starts_with("device ALSA 48000 Hz 64 smp\n"));
+  if constexpr (limit::AudioProfiler::kEnabled) {
+    REQUIRE(snapshot.enabled);
+    REQUIRE(snapshot.callbacks == 3);
+    REQUIRE(snapshot.xruns == 1);
+    REQUIRE(snapshot.max_budget_percent >= 200.0);
+    REQUIRE(snapshot.histogram.at(0) == 2);
+    REQUIRE(snapshot.histogram.back() == 1);
+    const auto &tape = snapshot.stages.at(limit::signalNodeIndex(limit::SignalNode::kTapeTracks));
+    REQUIRE(tape.max_us >= 1500.0);
+    REQUIRE(tape.mean_us > 0.0);
+    REQUIRE(snapshot.stages.at(0).max_us == 0.0);
+    // The first callback is the slowest so far, the second misses its deadline.
+    REQUIRE(snapshot.traces.size() == 2);
+    REQUIRE(snapshot.traces.back().callback == 1);
+    REQUIRE(snapshot.traces.back().duration_ns > snapshot.traces.back().budget_ns);
+    REQUIRE(report.find("tape tracks") != std::string::npos);
+  } else {
+    REQUIRE_FALSE(snapshot.enabled);
+    REQUIRE(snapshot.callbacks == 0);
+    REQUIRE(report.find("LIMIT_PROFILER") != std::string::npos);
+  }
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Audio profiler resets at the next callback on request", "[profiler]") {
+  limit::AudioProfiler profiler;
+  profiler.prepare(kSampleRate);
+  runCallback(profiler, kShortBlock, std::chrono::microseconds(1500));
+  profiler.requestReset();
+  runCallback(profiler, kLongBlock, std::chrono::microseconds(0));
+  const auto snapshot = profiler.snapshot();
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(snapshot.xruns == 0);
+  REQUIRE(snapshot.callbacks == (limit::AudioProfiler::kEnabled ? 1U : 0U));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Audio profiler does not allocate on the audio thread", "[profiler][realtime]") {
+  if (!limit::isAllocationTrapEnabled()) {
+    SKIP("Needs the allocation trap (LIMIT_ALLOCATION_TRAP=ON)");
+  }
+  limit::AudioProfiler profiler;
+  profiler.prepare(kSampleRate);
+
+  const auto before = limit::realtimeAllocationCount();
+  {
+    const limit::ScopedRealtimeSection realtime_section;
+    for (int callback = 0; callback < 8; ++callback) {
+      runCallback(profiler, kShortBlock, std::chrono::microseconds(callback % 2 == 0 ? 0 : 1100));
+    }
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(limit::realtimeAllocationCount() == before);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
@@ -0,0 +1,124 @@
+#include "bench-report.h"
+
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <catch2/reporters/catch_reporter_event_listener.hpp>
+#include <catch2/reporters/catch_reporter_registrars.hpp>
+
+namespace limit::bench {
+auto benchmarkName(std::string_view kernel, int block_size) -> std::string {
+  return std::string(kernel) + "/" + std::to_string(block_size);
+}
+} // namespace limit::bench
+
+namespace {
+constexpr double kNanosecondsPerSecond = 1.0e9;
+constexpr double kPercent = 100.0;
+constexpr int kKernelColumn = 20;
+constexpr int kNumberColumn = 10;
+constexpr auto kDefaultJsonPath = "limit-bench.json";
+
+struct BudgetResult {
+  std::string kernel;
+  int block_size = 0;
+  double mean_ns = 0.0;
+  double std_dev_ns = 0.0;
+
+  auto budgetNs() const -> double {
+    return block_size * kNanosecondsPerSecond / limit::bench::kBenchSampleRate;
+  }
+  auto budgetPercent() const -> double { return mean_ns / budgetNs() * kPercent; }
+};
+
+// Kernel names are plain ASCII, but escape the JSON specials anyway.
+auto jsonString(std::string_view text) -> std::string {
+  std::string quoted = "\"";
+  for (const auto character : text) {
+    if (character == '"' || character == '\\') {
+      quoted += '\\';
+    }
+    quoted += character;
+  }
+  return quoted + "\"";
+}
+
+// Collects every benchmark's mean time, prints it as a share of the
+// real-time budget of its block (block_size / 48 kHz) and writes the same
+// table as JSON to $LIMIT_BENCH_JSON, or limit-bench.json, for comparing
+// runs between commits.
+class BudgetReporter final : public Catch::EventListenerBase {
+public:
+  using Catch::EventListenerBase::EventListenerBase;
+
+  void benchmarkEnded(const Catch::BenchmarkStats<> &stats) override {
+    const std::string_view name = stats.info.name;
+    const auto slash = name.rfind('/');
+    int block_size = 0;
+    if (slash == std::string_view::npos) {
+      return;
+    }
+    const auto digits = name.substr(slash + 1);
+    const auto [last, error] =
+        std::from_chars(digits.data(), digits.data() + digits.size(), block_size);
+    if (error != std::errc{} || last != digits.data() + digits.size() || block_size <= 0) {
+      return;
+    }
+    results.push_back({.kernel = std::string(name.substr(0, slash)),
+                       .block_size = block_size,
+                       .mean_ns = stats.mean.point.count(),
+                       .std_dev_ns = stats.standardDeviation.point.count()});
+  }
+
+  void testRunEnded(const Catch::TestRunStats & /*stats*/) override {
+    if (results.empty()) {
+      return;
+    }
+    printTable();
+    const auto *const configured = std::getenv("LIMIT_BENCH_JSON"); // NOLINT(concurrency-mt-unsafe)
+    const std::string path = configured != nullptr ? configured : kDefaultJsonPath;
+    if (!writeJson(path)) {
+      std::cerr << "limit-bench: cannot write " << path << "\n";
+    }
+  }
+
+private:
+  void printTable() const {
+    std::cout << "\n"
+              << std::left << std::setw(kKernelColumn) << "kernel" << std::right
+              << std::setw(kNumberColumn) << "block" << std::setw(kNumberColumn) << "mean us"
+              << std::setw(kNumberColumn) << "budget %" << "\n";
+    std::cout << std::fixed;
+    for (const auto &result : results) {
+      std::cout << std::left << std::setw(kKernelColumn) << result.kernel << std::right
+                << std::setw(kNumberColumn) << result.block_size << std::setprecision(2)
+                << std::setw(kNumberColumn) << result.mean_ns / 1000.0
+                << std::setw(kNumberColumn) << result.budgetPercent() << "\n";
+    }
+    std::cout << std::defaultfloat;
+  }
+
+  auto writeJson(const std::string &path) const -> bool {
+    std::ofstream file(path, std::ios::trunc);
+    file << std::setprecision(6);
+    file << "{\n  \"sample_rate\": " << limit::bench::kBenchSampleRate << ",\n  \"results\": [";
+    for (std::size_t index = 0; index < results.size(); ++index) {
+      const auto &result = results.at(index);
+      file << (index == 0 ? "\n" : ",\n") << "    {\"kernel\": " << jsonString(result.kernel)
+           << ", \"block_size\": " << result.block_size << ", \"mean_ns\": " << result.mean_ns
+           << ", \"std_dev_ns\": " << result.std_dev_ns << ", \"budget_ns\": " << result.budgetNs()
+           << ", \"budget_percent\": " << result.budgetPercent() << "}";
+    }
+    file << "\n  ]\n}\n";
+    return static_cast<bool>(file);
+  }
+
+  std::vector<BudgetResult> results;
+};
+} // namespace
+
+CATCH_REGISTER_LISTENER(BudgetReporter)
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace limit::bench {
+constexpr double kBenchSampleRate = 48000.0;
+constexpr int kMinBenchBlockSize = 16;
+constexpr int kMaxBenchBlockSize = 1024;
+
+// Benchmarks in limit-bench are named "<kernel>/<block size>" so the budget
+// reporter can relate each time to the length of its block.
+auto benchmarkName(std::string_view kernel, int block_size) -> std::string;
+} // namespace limit::bench
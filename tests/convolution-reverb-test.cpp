@@ -0,0 +1,273 @@
+#include "convolution-reverb.h"
+#include "partitioned-convolver.h"
+#include "realtime-guard.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <numbers>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+constexpr double kSampleRate = 48000.0;
+// Covers the head, the early partitions and three tail partitions.
+constexpr int kImpulseLength = limit::kReverbTailOffset + (3 * limit::kReverbTailPartition) - 100;
+constexpr int kSignalLength = 3 * kImpulseLength;
+constexpr float kTolerance = 1.0e-4f;
+
+auto noise(int length, std::uint32_t seed, float scale) -> std::vector<float> {
+  std::minstd_rand generator(seed);
+  std::uniform_real_distribution<float> amplitude(-scale, scale);
+  std::vector<float> samples(static_cast<std::size_t>(length));
+  std::generate(samples.begin(), samples.end(), [&] { return amplitude(generator); });
+  return samples;
+}
+
+auto convolve(const std::vector<float> &signal, const std::vector<float> &taps)
+    -> std::vector<float> {
+  std::vector<float> result(signal.size(), 0.0f);
+  for (std::size_t sample = 0; sample < signal.size(); ++sample) {
+    double sum = 0.0;
+    for (std::size_t tap = 0; tap < taps.size() && tap <= sample; ++tap) {
+      sum += static_cast<double>(taps[tap]) * static_cast<double>(signal[sample - tap]);
+    }
+    result[sample] = static_cast<float>(sum);
+  }
+  return result;
+}
+
+auto maxDifference(const std::vector<float> &left, const std::vector<float> &right) -> float {
+  float difference = 0.0f;
+  for (std::size_t index = 0; index < left.size(); ++index) {
+    difference = std::max(difference, std::abs(left[index] - right[index]));
+  }
+  return difference;
+}
+
+auto makeImpulse(const std::vector<float> &left, const std::vector<float> &right)
+    -> juce::AudioBuffer<float> {
+  juce::AudioBuffer<float> impulse(limit::kStereoChannelCount, static_cast<int>(left.size()));
+  for (std::size_t index = 0; index < left.size(); ++index) {
+    impulse.setSample(0, static_cast<int>(index), left[index]);
+    impulse.setSample(1, static_cast<int>(index), right[index]);
+  }
+  return impulse;
+}
+
+struct StereoSignal {
+  std::vector<float> left;
+  std::vector<float> right;
+};
+
+// Feeds the signal through in blocks of block_size, waiting for the tail
+// thread after each block when wait_for_tail is set.
+auto renderReverb(limit::ConvolutionReverb &reverb, const StereoSignal &input, int block_size,
+                  bool wait_for_tail) -> StereoSignal {
+  StereoSignal output{.left = input.left, .right = input.right};
+  juce::AudioBuffer<float> buffer(limit::kStereoChannelCount, block_size);
+  const auto length = static_cast<int>(input.left.size());
+  for (int start = 0; start < length; start += block_size) {
+    const auto count = std::min(block_size, length - start);
+    for (int sample = 0; sample < count; ++sample) {
+      const auto index = static_cast<std::size_t>(start + sample);
+      buffer.setSample(0, sample, input.left[index]);
+      buffer.setSample(1, sample, input.right[index]);
+    }
+    reverb.render(buffer, count);
+    for (int sample = 0; sample < count; ++sample) {
+      const auto index = static_cast<std::size_t>(start + sample);
+      output.left[index] = buffer.getSample(0, sample);
+      output.right[index] = buffer.getSample(1, sample);
+    }
+    while (wait_for_tail && reverb.pendingTailBlocks() > 0) {
+      std::this_thread::yield();
+    }
+  }
+  return output;
+}
+} // namespace
+
+TEST_CASE("Real FFT matches the DFT and inverts", "[convolution]") {
+  constexpr int kSize = 32;
+  limit::RealFft fft(kSize);
+  const auto input = noise(kSize, 1, 1.0f);
+  std::vector<std::complex<float>> spectrum(static_cast<std::size_t>(fft.binCount()));
+  std::vector<float> output(kSize);
+  fft.forward(input, spectrum);
+  fft.inverse(spectrum, output);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(fft.binCount() == (kSize / 2) + 1);
+  for (std::size_t bin = 0; bin < spectrum.size(); ++bin) {
+    std::complex<double> expected;
+    for (std::size_t index = 0; index < input.size(); ++index) {
+      const auto angle = -2.0 * std::numbers::pi * static_cast<double>(bin * index) / kSize;
+      expected += static_cast<double>(input[index]) * std::polar(1.0, angle);
+    }
+    REQUIRE(std::abs(std::complex<double>(spectrum[bin]) - expected) < kTolerance);
+  }
+  for (std::size_t index = 0; index < input.size(); ++index) {
+    REQUIRE(std::abs((output[index] / kSize) - input[index]) < kTolerance);
+  }
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Uniform convolver matches direct convolution", "[convolution]") {
+  constexpr int kPartition = 64;
+  const auto taps = noise(300, 2, 0.1f);
+  const auto signal = noise(1024, 3, 1.0f);
+  limit::UniformConvolver convolver;
+  convolver.prepare(taps, kPartition);
+  std::vector<float> output(signal.size());
+  for (std::size_t start = 0; start < signal.size(); start += kPartition) {
+    convolver.processBlock(std::span(signal).subspan(start, kPartition),
+                           std::span(output).subspan(start, kPartition));
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(convolver.partitionCount() == 5);
+  REQUIRE(maxDifference(output, convolve(signal, taps)) < kTolerance);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Convolution reverb matches direct convolution without latency", "[convolution]") {
+  const auto left_taps = noise(kImpulseLength, 4, 0.05f);
+  const auto right_taps = noise(kImpulseLength, 5, 0.05f);
+  const StereoSignal input{.left = noise(kSignalLength, 6, 1.0f),
+                           .right = noise(kSignalLength, 7, 1.0f)};
+  const auto expected_left = convolve(input.left, left_taps);
+  const auto expected_right = convolve(input.right, right_taps);
+  limit::ConvolutionReverb reverb;
+  reverb.setImpulseResponse(makeImpulse(left_taps, right_taps), kSampleRate);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  for (const auto block_size : {1, 37, 64, 100, 512, 1500}) {
+    reverb.prepare(kSampleRate, block_size);
+    const auto output = renderReverb(reverb, input, block_size, false);
+    REQUIRE(maxDifference(output.left, expected_left) < kTolerance);
+    REQUIRE(maxDifference(output.right, expected_right) < kTolerance);
+    REQUIRE(reverb.tailMissCount() == 0);
+  }
+
+  // An impulse comes back as the response itself from its first sample.
+  StereoSignal click{.left = std::vector<float>(kSignalLength, 0.0f),
+                     .right = std::vector<float>(kSignalLength, 0.0f)};
+  click.left.front() = 1.0f;
+  reverb.prepare(kSampleRate, 256);
+  const auto response = renderReverb(reverb, click, 256, false);
+  for (std::size_t index = 0; index < left_taps.size(); ++index) {
+    REQUIRE(std::abs(response.left[index] - left_taps[index]) < kTolerance);
+  }
+  REQUIRE(std::all_of(response.right.begin(), response.right.end(),
+                      [](float sample) { return std::abs(sample) < kTolerance; }));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Convolution reverb tail thread matches the inline tail", "[convolution]") {
+  const auto taps = noise(kImpulseLength, 8, 0.05f);
+  const StereoSignal input{.left = noise(kSignalLength, 9, 1.0f),
+                           .right = noise(kSignalLength, 10, 1.0f)};
+  juce::AudioBuffer<float> mono(1, kImpulseLength);
+  for (int index = 0; index < kImpulseLength; ++index) {
+    mono.setSample(0, index, taps[static_cast<std::size_t>(index)]);
+  }
+  limit::ConvolutionReverb inline_reverb;
+  inline_reverb.setImpulseResponse(mono, kSampleRate);
+  inline_reverb.prepare(kSampleRate, 128);
+  limit::ConvolutionReverb threaded_reverb;
+  threaded_reverb.setImpulseResponse(mono, kSampleRate);
+  threaded_reverb.start();
+  threaded_reverb.prepare(kSampleRate, 128);
+
+  const auto expected = renderReverb(inline_reverb, input, 128, false);
+  const auto output = renderReverb(threaded_reverb, input, 128, true);
+  threaded_reverb.stop();
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(output.left == expected.left);
+  REQUIRE(output.right == expected.right);
+  REQUIRE(threaded_reverb.tailMissCount() == 0);
+  REQUIRE(maxDifference(expected.right, convolve(input.right, taps)) < kTolerance);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Convolution reverb drops tail blocks that are too late to play", "[convolution]") {
+  constexpr int kBlock = limit::kReverbTailPartition;
+  constexpr int kNoiseBlocks = 4;
+  constexpr int kHeldBlocks = 3;
+  constexpr int kBlocks = 12;
+  // The built-in response's tail lasts seconds, so a tail that kept the
+  // noise blocks in its history would still be ringing at the end.
+  limit::ConvolutionReverb reverb;
+  reverb.setImpulseResponse(limit::makeRoomToHallImpulse(kSampleRate), kSampleRate);
+  reverb.start();
+  reverb.prepare(kSampleRate, kBlock);
+  const auto noise_input = noise(kNoiseBlocks * kBlock, 11, 1.0f);
+  juce::AudioBuffer<float> buffer(limit::kStereoChannelCount, kBlock);
+  std::vector<float> last_block(static_cast<std::size_t>(kBlock));
+
+  for (int block = 0; block < kBlocks; ++block) {
+    buffer.clear();
+    if (block < kNoiseBlocks) {
+      for (int sample = 0; sample < kBlock; ++sample) {
+        const auto value = noise_input[static_cast<std::size_t>((block * kBlock) + sample)];
+        buffer.setSample(0, sample, value);
+        buffer.setSample(1, sample, value);
+      }
+    }
+    // Blocks 4 to 6 queue up behind a stalled thread. By the time it runs
+    // again block 5 is due, so block 4 can never play and is dropped.
+    // Otherwise the thread catches up before every block.
+    const auto held = block >= kNoiseBlocks && block < kNoiseBlocks + kHeldBlocks;
+    if (!held) {
+      reverb.holdTailForTesting(false);
+    }
+    while ((!held || block == kNoiseBlocks) && reverb.pendingTailBlocks() > 0) {
+      std::this_thread::yield();
+    }
+    reverb.holdTailForTesting(held);
+    reverb.render(buffer, kBlock);
+    std::copy_n(buffer.getReadPointer(0), kBlock, last_block.begin());
+  }
+  reverb.stop();
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  // Blocks 4 and 5 were due while the thread was held.
+  REQUIRE(reverb.tailMissCount() == 2);
+  // Dropping block 4 restarted the tail history from block 5, which like
+  // everything after it is silent.
+  REQUIRE(std::all_of(last_block.begin(), last_block.end(),
+                      [](float sample) { return sample == 0.0f; }));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Convolution reverb does not allocate while processing", "[convolution][realtime]") {
+  constexpr int kBlockSize = 256;
+  limit::ConvolutionReverb reverb;
+  reverb.setImpulseResponse(limit::makeRoomToHallImpulse(kSampleRate), kSampleRate);
+  reverb.prepare(kSampleRate, kBlockSize);
+  limit::AudioGraphBuses buses;
+  buses.send1.setSize(limit::kStereoChannelCount, kBlockSize);
+  const juce::MidiBuffer midi;
+
+  const auto before = limit::realtimeAllocationCount();
+  for (int block = 0; block < 64; ++block) {
+    const limit::ScopedRealtimeSection realtime_section;
+    buses.send1.clear();
+    buses.send1.setSample(0, 0, 1.0f);
+    reverb.process(buses, midi, kBlockSize);
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  if (limit::isAllocationTrapEnabled()) {
+    REQUIRE(limit::realtimeAllocationCount() == before);
+  }
+  REQUIRE(reverb.impulseLength() > limit::kReverbTailOffset);
+  const std::span<const float> tail(buses.send1.getReadPointer(0), kBlockSize);
+  REQUIRE(std::any_of(tail.begin(), tail.end(), [](float sample) { return sample != 0.0f; }));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
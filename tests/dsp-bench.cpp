@@ -0,0 +1,312 @@
+#include "bench-report.h"
+#include "convolution-reverb.h"
+#include "kit-sampler.h"
+#include "oscillator-bank.h"
+#include "parameter-registry.h"
+#include "partitioned-convolver.h"
+#include "step-sequencer.h"
+#include "synth-instrument.h"
+#include "tape-mixer.h"
+#include "tape-storage.h"
+#include "tape-transport.h"
+#include "test-files.h"
+#include "wavetable.h"
+#include "worker-pool.h"
+
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+// Every kernel that runs on the audio thread, at 48 kHz and every power of
+// two block size from 16 to 1024, loaded the way a busy session would load
+// it: all voices sounding, every track playing. The budget reporter turns
+// the times into a share of the real-time budget of each block.
+
+namespace {
+using limit::bench::benchmarkName;
+using limit::bench::kBenchSampleRate;
+using limit::bench::kMaxBenchBlockSize;
+using limit::bench::kMinBenchBlockSize;
+using limit::test::TempDirectory;
+using limit::test::writeWav;
+
+constexpr auto kVelocity = static_cast<juce::uint8>(100);
+constexpr int kMidiReserveBytes = 4096;
+constexpr int kFirstNote = 40;
+constexpr double kKitSampleSeconds = 2.0;
+constexpr float kTrickSpeed = 1.37f;
+constexpr int kRampedParameters = 32;
+
+// Mono 32-bit float sawtooth at the session rate.
+auto writeSawtooth(const std::filesystem::path &path, int frames) -> std::filesystem::path {
+  constexpr int kPeriod = 1000;
+  std::vector<float> samples(static_cast<std::size_t>(frames));
+  for (int frame = 0; frame < frames; ++frame) {
+    samples.at(static_cast<std::size_t>(frame)) =
+        (static_cast<float>(frame % kPeriod) / kPeriod) - 0.5f;
+  }
+  return writeWav(path, static_cast<int>(kBenchSampleRate), 1, samples, true);
+}
+
+auto allPads() -> juce::MidiBuffer {
+  juce::MidiBuffer midi;
+  for (int pad = 0; pad < limit::kKitVoiceCount; ++pad) {
+    midi.addEvent(juce::MidiMessage::noteOn(1, limit::kKitBaseNote + pad, kVelocity), 0);
+  }
+  return midi;
+}
+
+auto everyStep() -> limit::StepPattern {
+  limit::StepPattern pattern;
+  for (auto &step : pattern.steps) {
+    step.note = limit::kDefaultStepNote;
+    step.velocity = kVelocity;
+  }
+  return pattern;
+}
+} // namespace
+
+TEST_CASE("Sine instrument", "[bench][engine]") {
+  for (int block_size = kMinBenchBlockSize; block_size <= kMaxBenchBlockSize; block_size *= 2) {
+    limit::SynthInstrument instrument([] { return std::make_unique<limit::SineVoiceEngine>(); });
+    instrument.prepare(kBenchSampleRate, block_size);
+    juce::AudioBuffer<float> output(limit::kStereoChannelCount, block_size);
+    juce::MidiBuffer midi;
+    for (int voice = 0; voice < limit::kMaxVoices; ++voice) {
+      midi.addEvent(juce::MidiMessage::noteOn(1, kFirstNote + voice, kVelocity), 0);
+    }
+    instrument.render(output, midi, block_size);
+    midi.clear();
+
+    BENCHMARK(benchmarkName("sine instrument", block_size)) {
+      output.clear();
+      instrument.render(output, midi, block_size);
+      return output.getSample(0, 0);
+    };
+  }
+}
+
+TEST_CASE("Wavetable oscillator bank", "[bench][engine]") {
+  constexpr double kRootHz = 55.0;
+  limit::WavetableCache cache;
+  cache.prebuild();
+  for (int block_size = kMinBenchBlockSize; block_size <= kMaxBenchBlockSize; block_size *= 2) {
+    limit::OscillatorBank bank;
+    bank.prepare(kBenchSampleRate, block_size);
+    for (int lane = 0; lane < limit::kMaxVoices; ++lane) {
+      bank.startLane(lane, cache.get(limit::WavetableShape::kSaw), kRootHz * (lane + 1));
+    }
+
+    BENCHMARK(benchmarkName("wavetable bank", block_size)) {
+      bank.render(block_size);
+      return bank.laneSample(0, 0);
+    };
+  }
+}
+
+// The samples fit in the resident attack, so this measures mixing voices
+// rather than the disk; streaming runs on the service thread.
+TEST_CASE("Kit sampler", "[bench][engine]") {
+  const TempDirectory directory("bench-kit");
+  const auto path = writeSawtooth(directory.get() / "hit.wav",
+                                  static_cast<int>(kKitSampleSeconds * kBenchSampleRate));
+  limit::KitSampler sampler(kKitSampleSeconds);
+  limit::KitDefinition kit;
+  for (auto &pad : kit.pads) {
+    pad.zones.push_back({.path = path});
+  }
+  sampler.loadKit(std::move(kit));
+  while (sampler.isKitLoading()) {
+    sampler.service();
+  }
+  const auto hits = allPads();
+  const juce::MidiBuffer none;
+  for (int block_size = kMinBenchBlockSize; block_size <= kMaxBenchBlockSize; block_size *= 2) {
+    sampler.prepare(kBenchSampleRate, block_size);
+    juce::AudioBuffer<float> output(limit::kStereoChannelCount, block_size);
+
+    BENCHMARK(benchmarkName("kit sampler", block_size)) {
+      output.clear();
+      sampler.render(output, sampler.activeVoiceCount() < limit::kKitVoiceCount ? hits : none,
+                     block_size);
+      return output.getSample(0, 0);
+    };
+  }
+}
+
+TEST_CASE("Tape mixer", "[bench][mixer]") {
+  for (int block_size = kMinBenchBlockSize; block_size <= kMaxBenchBlockSize; block_size *= 2) {
+    limit::TapeMixer mixer;
+    mixer.prepare(kBenchSampleRate, block_size);
+    juce::AudioBuffer<float> tape(limit::kStereoChannelCount * limit::kTapeTrackCount,
+                                  block_size);
+    juce::AudioBuffer<float> master(limit::kStereoChannelCount, block_size);
+    juce::AudioBuffer<float> send1(limit::kStereoChannelCount, block_size);
+    juce::AudioBuffer<float> send2(limit::kStereoChannelCount, block_size);
+    for (int channel = 0; channel < tape.getNumChannels(); ++channel) {
+      juce::FloatVectorOperations::fill(tape.getWritePointer(channel), 0.5f, block_size);
+    }
+    for (int track = 0; track < limit::kTapeTrackCount; ++track) {
+      mixer.setTrackSettings(track, {.level = 0.8f, .pan = 0.25f, .send1 = 0.3f, .send2 = 0.2f});
+    }
+
+    BENCHMARK(benchmarkName("tape mixer", block_size)) {
+      mixer.mix(tape, master, send1, send2, block_size);
+      return master.getSample(0, 0);
+    };
+  }
+}
+
+// The Send 1 reverb with the built-in response and a steady send. The
+// inline row computes the tail on the audio thread, so its blocks carry the
+// tail's cost; the threaded row is what the app runs. The uniform row is the
+// same response in short partitions only, the cost the split avoids.
+TEST_CASE("Convolution reverb", "[bench][effects]") {
+  const auto impulse = limit::makeRoomToHallImpulse(kBenchSampleRate);
+  const std::span<const float> taps(impulse.getReadPointer(0),
+                                    static_cast<std::size_t>(impulse.getNumSamples()));
+  for (int block_size = kMinBenchBlockSize; block_size <= kMaxBenchBlockSize; block_size *= 2) {
+    std::array<limit::ConvolutionReverb, 2> reverbs;
+    for (auto &reverb : reverbs) {
+      reverb.setImpulseResponse(impulse, kBenchSampleRate);
+      reverb.prepare(kBenchSampleRate, block_size);
+    }
+    auto &inline_reverb = reverbs.at(0);
+    auto &threaded_reverb = reverbs.at(1);
+    threaded_reverb.start();
+    juce::AudioBuffer<float> send(limit::kStereoChannelCount, block_size);
+
+    BENCHMARK(benchmarkName("reverb inline", block_size)) {
+      for (int channel = 0; channel < limit::kStereoChannelCount; ++channel) {
+        juce::FloatVectorOperations::fill(send.getWritePointer(channel), 0.25f, block_size);
+      }
+      inline_reverb.render(send, block_size);
+      return send.getSample(0, 0);
+    };
+    BENCHMARK(benchmarkName("reverb threaded", block_size)) {
+      for (int channel = 0; channel < limit::kStereoChannelCount; ++channel) {
+        juce::FloatVectorOperations::fill(send.getWritePointer(channel), 0.25f, block_size);
+      }
+      threaded_reverb.render(send, block_size);
+      return send.getSample(0, 0);
+    };
+    threaded_reverb.stop();
+
+    if (block_size >= limit::kReverbEarlyPartition) {
+      std::array<limit::UniformConvolver, limit::kStereoChannelCount> uniform;
+      for (auto &convolver : uniform) {
+        convolver.prepare(taps, limit::kReverbEarlyPartition);
+      }
+      constexpr auto kPartition = static_cast<std::size_t>(limit::kReverbEarlyPartition);
+      const std::vector<float> input(static_cast<std::size_t>(block_size), 0.25f);
+      std::vector<float> output(input.size());
+      BENCHMARK(benchmarkName("reverb uniform", block_size)) {
+        for (auto &convolver : uniform) {
+          for (std::size_t start = 0; start < input.size(); start += kPartition) {
+            convolver.processBlock(std::span(input).subspan(start, kPartition),
+                                   std::span(output).subspan(start, kPartition));
+          }
+        }
+        return output.front();
+      };
+    }
+  }
+}
+
+// A fractional speed is the worst case for the read head.
+TEST_CASE("Tape transport", "[bench][tape]") {
+  const TempDirectory directory("bench-tape");
+  constexpr int kChunkFrames = 4096;
+  const auto rate = static_cast<int>(kBenchSampleRate);
+  auto storage = limit::TapeStorage::open({.directory = directory.get(),
+                                           .sample_rate = rate,
+                                           .length_seconds = 1,
+                                           .chunk_frames = kChunkFrames,
+                                           .prefetch_chunks = (rate / kChunkFrames) + 1,
+                                           .retain_chunks = 0});
+  REQUIRE(storage != nullptr); // NOLINT(cppcoreguidelines-avoid-do-while)
+  const std::vector<float> level(static_cast<std::size_t>(storage->frameCount()), 0.25f);
+  for (int track = 0; track < storage->trackCount(); ++track) {
+    storage->writeFramesOffline(track, 0, level, level);
+  }
+  storage->service();
+  // The same load with the tracks spread over every other core.
+  limit::RealtimeWorkerPool pool;
+  pool.start();
+  for (int block_size = kMinBenchBlockSize; block_size <= kMaxBenchBlockSize; block_size *= 2) {
+    std::array<limit::TapeTransport, 2> transports;
+    juce::AudioBuffer<float> tape(limit::kStereoChannelCount * limit::kTapeTrackCount,
+                                  block_size);
+    for (auto &transport : transports) {
+      transport.prepare(kBenchSampleRate, block_size);
+      transport.setSpeed(kTrickSpeed);
+      transport.setLoop(kChunkFrames, rate - kChunkFrames);
+      transport.locate(kChunkFrames);
+      transport.play();
+    }
+    auto &serial = transports.at(0);
+    auto &pooled = transports.at(1);
+    pooled.setWorkerPool(&pool);
+
+    BENCHMARK(benchmarkName("tape transport", block_size)) {
+      serial.render(*storage, tape, block_size);
+      return tape.getSample(0, 0);
+    };
+    BENCHMARK(benchmarkName("tape transport pooled", block_size)) {
+      pooled.render(*storage, tape, block_size);
+      return tape.getSample(0, 0);
+    };
+  }
+}
+
+// The clock with a note on every step at a fast tempo, so most blocks emit
+// events.
+TEST_CASE("Step sequencer clock", "[bench][sequencer]") {
+  for (int block_size = kMinBenchBlockSize; block_size <= kMaxBenchBlockSize; block_size *= 2) {
+    limit::StepSequencer sequencer;
+    sequencer.prepare(kBenchSampleRate);
+    sequencer.setTempo(limit::kMaxTempoBpm);
+    sequencer.setPattern(everyStep());
+    sequencer.start();
+    juce::MidiBuffer midi;
+    midi.ensureSize(kMidiReserveBytes);
+
+    BENCHMARK(benchmarkName("step sequencer", block_size)) {
+      midi.clear();
+      sequencer.process(midi, block_size);
+      return midi.getNumEvents();
+    };
+  }
+}
+
+TEST_CASE("Parameter ramps", "[bench][parameters]") {
+  limit::ParameterRegistry registry;
+  std::vector<int> ids;
+  for (int index = 0; index < kRampedParameters; ++index) {
+    ids.push_back(registry.add({.label = "LEVEL", .max = 100.0f, .default_value = 50.0f}));
+  }
+  for (int block_size = kMinBenchBlockSize; block_size <= kMaxBenchBlockSize; block_size *= 2) {
+    limit::ParameterRamps ramps(registry);
+    ramps.prepare(kBenchSampleRate);
+    std::vector<float> values(static_cast<std::size_t>(block_size));
+    auto step = 1.0f;
+
+    BENCHMARK(benchmarkName("parameter ramps", block_size)) {
+      step = -step;
+      for (const auto id : ids) {
+        registry.nudge(id, step);
+      }
+      ramps.beginBlock(block_size);
+      for (const auto id : ids) {
+        ramps.fill(id, values);
+      }
+      return values.back();
+    };
+  }
+}
@@ -0,0 +1,145 @@
+#include "input-bindings.h"
+#include "keymap.h"
+#include "test-files.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+using limit::InputAction;
+using limit::InputKind;
+using limit::NamedKey;
+using limit::test::TempDirectory;
+
+auto keyFor(const limit::InputBindings &bindings, int key_char) -> InputAction {
+  return bindings.key(limit::inputCodeForChar(key_char));
+}
+
+auto keyFor(const limit::InputBindings &bindings, NamedKey key) -> InputAction {
+  return bindings.key(limit::inputCode(key));
+}
+} // namespace
+
+// The default table is generated at compile time.
+static_assert(limit::kDefaultKeyBindings.at('q').kind == InputKind::kPad);
+static_assert(limit::kDefaultKeyBindings.at('q').index == 4);
+static_assert(limit::kDefaultKeyBindings.at('t').kind == InputKind::kNone);
+
+TEST_CASE("Input bindings default to the documented layout", "[input]") {
+  const limit::InputBindings bindings;
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(keyFor(bindings, '1') == InputAction{.kind = InputKind::kPad, .index = 0});
+  REQUIRE(keyFor(bindings, 'V') == InputAction{.kind = InputKind::kPad, .index = 15});
+  REQUIRE(keyFor(bindings, 'g') == InputAction{.kind = InputKind::kNote, .index = 0});
+  REQUIRE(keyFor(bindings, '\\') == InputAction{.kind = InputKind::kNote, .index = 12});
+  REQUIRE(keyFor(bindings, NamedKey::kNum7) ==
+          InputAction{.kind = InputKind::kEncoder,
+                      .index = 0,
+                      .encoder = limit::DevEncoderAction::kDecrease});
+  REQUIRE(keyFor(bindings, NamedKey::kRight) ==
+          InputAction{.kind = InputKind::kEncoder,
+                      .index = 5,
+                      .encoder = limit::DevEncoderAction::kIncrease});
+  REQUIRE(keyFor(bindings, NamedKey::kUp).kind == InputKind::kControlBank);
+  REQUIRE(keyFor(bindings, NamedKey::kF1).kind == InputKind::kPadBank);
+  REQUIRE(keyFor(bindings, NamedKey::kF9).kind == InputKind::kTransport);
+  REQUIRE(keyFor(bindings, NamedKey::kF10).kind == InputKind::kDumpDiagnostics);
+  REQUIRE(keyFor(bindings, NamedKey::kF11).kind == InputKind::kDiagnostics);
+  REQUIRE(keyFor(bindings, NamedKey::kF12).kind == InputKind::kReloadMapping);
+  REQUIRE(keyFor(bindings, '5') == InputAction{.kind = InputKind::kMode, .index = 0});
+  REQUIRE(keyFor(bindings, '8') == InputAction{.kind = InputKind::kMode, .index = 3});
+  REQUIRE(keyFor(bindings, NamedKey::kTab).kind == InputKind::kSubView);
+  REQUIRE(keyFor(bindings, ' ').kind == InputKind::kNone);
+  REQUIRE(bindings.key(-1).kind == InputKind::kNone);
+  REQUIRE(bindings.key(limit::kInputKeyCount).kind == InputKind::kNone);
+  REQUIRE(bindings.midiController(16, 8) ==
+          InputAction{.kind = InputKind::kRelativeEncoder, .index = 2, .bank = 1});
+  REQUIRE(bindings.midiController(1, 8).kind == InputKind::kNone);
+  REQUIRE(bindings.midiNote(0, 36).kind == InputKind::kNone);
+  REQUIRE(limit::mapKeyToMidiNote('y') == limit::kKeymapMinNote + 1);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Input bindings apply a mapping over the defaults", "[input]") {
+  limit::InputBindings bindings;
+  const auto report = bindings.apply("# remap\n"
+                                     "t transport\n"
+                                     "\n"
+                                     "num+ encoder 2 inc\n"
+                                     "F10 octave-up\n"
+                                     "space pad 16\n"
+                                     "g none\n"
+                                     "midi-note 10 36 pad 1\n"
+                                     "midi-cc 1 64 sustain\n"
+                                     "n pad 17\n"
+                                     "capslock mod\n"
+                                     "midi-cc 17 1 mod\n"
+                                     "f12 measure-latency\n"
+                                     "b mode tape\n"
+                                     "m sub-view\n"
+                                     "i mode drums\n");
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(report.applied == 10);
+  REQUIRE(report.rejected == 4);
+  REQUIRE(report.first_rejected_line == 10);
+  REQUIRE(keyFor(bindings, 't').kind == InputKind::kTransport);
+  REQUIRE(keyFor(bindings, NamedKey::kNumAdd) ==
+          InputAction{.kind = InputKind::kEncoder,
+                      .index = 1,
+                      .encoder = limit::DevEncoderAction::kIncrease});
+  REQUIRE(keyFor(bindings, NamedKey::kF10).kind == InputKind::kOctaveUp);
+  REQUIRE(keyFor(bindings, NamedKey::kF12).kind == InputKind::kMeasureLatency);
+  REQUIRE(keyFor(bindings, 'b') == InputAction{.kind = InputKind::kMode, .index = 2});
+  REQUIRE(keyFor(bindings, 'm').kind == InputKind::kSubView);
+  REQUIRE(keyFor(bindings, 'i').kind == InputKind::kNone);
+  REQUIRE(keyFor(bindings, ' ') == InputAction{.kind = InputKind::kPad, .index = 15});
+  REQUIRE(keyFor(bindings, 'g').kind == InputKind::kNone);
+  REQUIRE(keyFor(bindings, 'n').kind == InputKind::kNone);
+  REQUIRE(bindings.midiNote(10, 36) == InputAction{.kind = InputKind::kPad, .index = 0});
+  REQUIRE(bindings.midiController(1, 64).kind == InputKind::kSustain);
+  REQUIRE(keyFor(bindings, NamedKey::kF9).kind == InputKind::kTransport);
+
+  bindings.reset();
+  REQUIRE(keyFor(bindings, 't').kind == InputKind::kNone);
+  REQUIRE(keyFor(bindings, 'g').kind == InputKind::kNote);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Input bindings reload from a mapping file", "[input]") {
+  const TempDirectory directory("input-test-reload");
+  const auto path = directory.get() / "input.map";
+  limit::InputBindings bindings;
+  {
+    std::ofstream file(path);
+    file << "b pad-bank\r\nm relative-encoder 3 6\r\n";
+  }
+  const auto first = bindings.load(path);
+  const auto bound = keyFor(bindings, 'b');
+  const auto relative = keyFor(bindings, 'm');
+  {
+    std::ofstream file(path);
+    file << "t transport\n";
+  }
+  const auto second = bindings.load(path);
+  const auto missing = bindings.load(directory.get() / "missing.map");
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(first.opened);
+  REQUIRE(first.applied == 2);
+  REQUIRE(first.rejected == 0);
+  REQUIRE(bound.kind == InputKind::kPadBank);
+  REQUIRE(relative == InputAction{.kind = InputKind::kRelativeEncoder, .index = 5, .bank = 2});
+  REQUIRE(second.applied == 1);
+  REQUIRE_FALSE(missing.opened);
+  REQUIRE(keyFor(bindings, 'b').kind == InputKind::kNone);
+  REQUIRE(keyFor(bindings, 't').kind == InputKind::kNone);
+  REQUIRE(limit::inputCodeForName("PageDown") == limit::inputCode(NamedKey::kPageDown));
+  REQUIRE(limit::inputCodeForName("=") == '=');
+  REQUIRE(limit::inputCodeForName("nope") == -1);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
@@ -0,0 +1,235 @@
+#include "kit-sampler.h"
+#include "realtime-guard.h"
+#include "test-files.h"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+using limit::test::TempDirectory;
+using limit::test::writeWav;
+
+constexpr double kSampleRate = 48000.0;
+constexpr int kBlockSize = 256;
+constexpr double kShortAttackSeconds = 0.05;
+constexpr int kAttackFrames = 2400;
+constexpr int kLongFrames = 100000;
+constexpr std::uint8_t kFullVelocity = 127;
+
+// Writes a mono 32-bit float WAV at the session rate, so playback is exact.
+auto writeSample(const std::filesystem::path &path, const std::vector<float> &samples)
+    -> std::filesystem::path {
+  return writeWav(path, static_cast<int>(kSampleRate), 1, samples, true);
+}
+
+auto sawtooth(int frames) -> std::vector<float> {
+  constexpr int kPeriod = 1000;
+  std::vector<float> samples(static_cast<std::size_t>(frames));
+  for (int frame = 0; frame < frames; ++frame) {
+    samples.at(static_cast<std::size_t>(frame)) =
+        (static_cast<float>(frame % kPeriod) / kPeriod) - 0.5f;
+  }
+  return samples;
+}
+
+void loadAndWait(limit::KitSampler &sampler, limit::KitDefinition definition) {
+  sampler.loadKit(std::move(definition));
+  while (sampler.isKitLoading()) {
+    sampler.service();
+  }
+}
+
+auto renderBlock(limit::KitSampler &sampler, const juce::MidiBuffer &midi)
+    -> juce::AudioBuffer<float> {
+  juce::AudioBuffer<float> output(limit::kStereoChannelCount, kBlockSize);
+  output.clear();
+  sampler.render(output, midi, kBlockSize);
+  return output;
+}
+
+auto hit(int pad, std::uint8_t velocity, int position = 0) -> juce::MidiBuffer {
+  juce::MidiBuffer midi;
+  midi.addEvent(juce::MidiMessage::noteOn(1, limit::kKitBaseNote + pad, velocity), position);
+  return midi;
+}
+} // namespace
+
+TEST_CASE("Kit sampler keeps only the attack of each zone resident", "[kit]") {
+  const TempDirectory directory("kit-test-resident");
+  const auto path = writeSample(directory.get() / "long.wav", sawtooth(kLongFrames));
+  limit::KitSampler sampler(kShortAttackSeconds);
+  limit::KitDefinition kit;
+  kit.pads.at(0).zones.push_back({.path = path});
+  kit.pads.at(limit::kKitPadCount - 1).zones.push_back({.path = path});
+  kit.pads.at(1).zones.push_back({.path = directory.get() / "missing.wav"});
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(sampler.residentBytes() == 0);
+  loadAndWait(sampler, std::move(kit));
+  REQUIRE(sampler.loadedKitCount() == 1);
+  REQUIRE(sampler.residentBytes() ==
+          2 * kAttackFrames * limit::kStereoChannelCount * sizeof(float));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Kit sampler streams past the attack without gaps", "[kit]") {
+  constexpr int kOnset = 10;
+  const TempDirectory directory("kit-test-stream");
+  const auto source = sawtooth(kLongFrames);
+  limit::KitSampler sampler(kShortAttackSeconds);
+  limit::KitDefinition kit;
+  kit.pads.at(0).zones.push_back({.path = writeSample(directory.get() / "long.wav", source)});
+  loadAndWait(sampler, std::move(kit));
+  sampler.prepare(kSampleRate, kBlockSize);
+
+  std::vector<float> left;
+  std::vector<float> right;
+  auto midi = hit(0, kFullVelocity, kOnset);
+  for (int rendered = 0; rendered < kLongFrames + kBlockSize; rendered += kBlockSize) {
+    const auto output = renderBlock(sampler, midi);
+    midi.clear();
+    sampler.service();
+    for (int index = 0; index < kBlockSize; ++index) {
+      left.push_back(output.getSample(0, index));
+      right.push_back(output.getSample(1, index));
+    }
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(sampler.underrunCount() == 0);
+  REQUIRE(sampler.activeVoiceCount() == 0);
+  for (std::size_t frame = 0; frame < source.size(); ++frame) {
+    REQUIRE(juce::exactlyEqual(left.at(frame + kOnset), source.at(frame)));
+    REQUIRE(juce::exactlyEqual(right.at(frame + kOnset), source.at(frame)));
+  }
+  REQUIRE(juce::exactlyEqual(left.at(kOnset - 1), 0.0f));
+  REQUIRE(juce::exactlyEqual(left.at(source.size() + kOnset), 0.0f));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Kit sampler picks velocity layers and alternates round-robin", "[kit]") {
+  constexpr int kShortFrames = 100;
+  constexpr std::uint8_t kSoft = 40;
+  constexpr std::uint8_t kLoud = 100;
+  const TempDirectory directory("kit-test-layers");
+  const auto constant = [&directory](const std::string &name, float value) {
+    return writeSample(directory.get() / (name + ".wav"),
+                       std::vector<float>(kShortFrames, value));
+  };
+  limit::KitSampler sampler(kShortAttackSeconds);
+  limit::KitDefinition kit;
+  auto &zones = kit.pads.at(1).zones;
+  zones.push_back({.path = constant("soft-a", 0.1f), .velocity_low = 1, .velocity_high = 63});
+  zones.push_back({.path = constant("soft-b", 0.2f), .velocity_low = 1, .velocity_high = 63});
+  zones.push_back({.path = constant("loud", 0.3f), .velocity_low = 64, .velocity_high = 127});
+  loadAndWait(sampler, std::move(kit));
+  sampler.prepare(kSampleRate, kBlockSize);
+
+  const auto first_sample = [&sampler](std::uint8_t velocity) {
+    return renderBlock(sampler, hit(1, velocity)).getSample(0, 0) * 127.0f /
+           static_cast<float>(velocity);
+  };
+  const auto near = [](float actual, float expected) {
+    return std::abs(actual - expected) < 1e-6f;
+  };
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(near(first_sample(kSoft), 0.1f));
+  REQUIRE(near(first_sample(kSoft), 0.2f));
+  REQUIRE(near(first_sample(kLoud), 0.3f));
+  REQUIRE(near(first_sample(kSoft), 0.1f));
+  REQUIRE(juce::exactlyEqual(renderBlock(sampler, hit(2, kLoud)).getSample(0, 0), 0.0f));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Kit sampler stops a voice whose stream falls behind", "[kit]") {
+  const TempDirectory directory("kit-test-underrun");
+  limit::KitSampler sampler(kShortAttackSeconds);
+  limit::KitDefinition kit;
+  kit.pads.at(0).zones.push_back(
+      {.path = writeSample(directory.get() / "long.wav", sawtooth(kLongFrames))});
+  loadAndWait(sampler, std::move(kit));
+  sampler.prepare(kSampleRate, kBlockSize);
+
+  auto midi = hit(0, kFullVelocity);
+  for (int rendered = 0; rendered < kAttackFrames * 2; rendered += kBlockSize) {
+    renderBlock(sampler, midi);
+    midi.clear();
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(sampler.underrunCount() == 1);
+  REQUIRE(sampler.activeVoiceCount() == 0);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Kit sampler frees a replaced kit once its voices finish", "[kit]") {
+  const TempDirectory directory("kit-test-switch");
+  const auto path = writeSample(directory.get() / "long.wav", sawtooth(kLongFrames));
+  limit::KitSampler sampler(kShortAttackSeconds);
+  limit::KitDefinition kit;
+  kit.pads.at(0).zones.push_back({.path = path});
+  loadAndWait(sampler, kit);
+  sampler.prepare(kSampleRate, kBlockSize);
+  renderBlock(sampler, hit(0, kFullVelocity));
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  loadAndWait(sampler, kit);
+  REQUIRE(sampler.loadedKitCount() == 2);
+  renderBlock(sampler, {});
+  sampler.service();
+  REQUIRE(sampler.activeVoiceCount() == 1);
+  REQUIRE(sampler.loadedKitCount() == 2);
+
+  juce::MidiBuffer all_notes_off;
+  all_notes_off.addEvent(juce::MidiMessage::controllerEvent(1, 123, 0), 0);
+  renderBlock(sampler, all_notes_off);
+  sampler.service();
+  REQUIRE(sampler.activeVoiceCount() == 0);
+  REQUIRE(sampler.loadedKitCount() == 1);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Kit sampler does not allocate on the audio thread", "[kit][realtime]") {
+  const TempDirectory directory("kit-test-realtime");
+  limit::KitSampler sampler(kShortAttackSeconds);
+  limit::KitDefinition kit;
+  const auto path = writeSample(directory.get() / "long.wav", sawtooth(kLongFrames));
+  for (auto &pad : kit.pads) {
+    pad.zones.push_back({.path = path});
+  }
+  loadAndWait(sampler, std::move(kit));
+  sampler.prepare(kSampleRate, kBlockSize);
+  juce::AudioBuffer<float> output(limit::kStereoChannelCount, kBlockSize);
+  std::vector<juce::MidiBuffer> blocks(64);
+  for (std::size_t block = 0; block < blocks.size(); ++block) {
+    blocks.at(block).addEvent(
+        juce::MidiMessage::noteOn(1, limit::kKitBaseNote + static_cast<int>(block % 48),
+                                  kFullVelocity),
+        static_cast<int>(block));
+  }
+
+  const auto before = limit::realtimeAllocationCount();
+  for (const auto &midi : blocks) {
+    {
+      const limit::ScopedRealtimeSection realtime_section;
+      output.clear();
+      sampler.render(output, midi, kBlockSize);
+    }
+    sampler.service();
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  if (limit::isAllocationTrapEnabled()) {
+    REQUIRE(limit::realtimeAllocationCount() == before);
+  }
+  REQUIRE(sampler.activeVoiceCount() == limit::kKitVoiceCount);
+  REQUIRE(sampler.underrunCount() == 0);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
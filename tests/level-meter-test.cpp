@@ -0,0 +1,65 @@
+#include "level-meter.h"
+
+#include <array>
+#include <cmath>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+constexpr float kTolerance = 1.0e-6f;
+
+auto makeFrame(float peak) -> limit::MeterFrame {
+  limit::MeterFrame frame;
+  frame.levels.fill({.peak = peak, .rms = peak / 2.0f});
+  return frame;
+}
+} // namespace
+
+TEST_CASE("Stereo measurement reports peak and RMS of both channels", "[meter]") {
+  const std::array<float, 4> left = {0.5f, -0.5f, 0.5f, -0.5f};
+  const std::array<float, 4> right = {0.0f, 0.0f, 0.0f, -0.75f};
+  const auto summary = limit::measureStereo(left, right);
+  const auto expected_rms = std::sqrt(((4.0f * 0.25f) + 0.5625f) / 8.0f);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(std::abs(summary.peak - 0.75f) < kTolerance);
+  REQUIRE(std::abs(summary.rms - expected_rms) < kTolerance);
+  const auto silent = limit::measureStereo({}, {});
+  REQUIRE(silent.peak < kTolerance);
+  REQUIRE(silent.rms < kTolerance);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Meter queue preserves order and drops frames when full", "[meter]") {
+  limit::MeterQueue queue;
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE_FALSE(queue.pop().has_value());
+  for (std::size_t index = 0; index < limit::kMeterQueueCapacity; ++index) {
+    REQUIRE(queue.push(makeFrame(static_cast<float>(index))));
+  }
+  REQUIRE_FALSE(queue.push(makeFrame(0.0f)));
+  REQUIRE(queue.droppedCount() == 1);
+
+  const auto first = queue.pop().value_or(makeFrame(-1.0f));
+  REQUIRE(std::abs(first.levels.at(0).peak) < kTolerance);
+  const auto second = queue.pop().value_or(makeFrame(-1.0f));
+  REQUIRE(std::abs(second.levels.at(0).peak - 1.0f) < kTolerance);
+  REQUIRE(queue.size() == limit::kMeterQueueCapacity - 2);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Meter ballistics hold peaks and fall back", "[meter]") {
+  limit::MeterBallistics ballistics;
+  ballistics.apply(makeFrame(0.8f));
+  ballistics.apply(makeFrame(0.2f));
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(std::abs(ballistics.level(limit::kMasterMeterIndex).peak - 0.8f) < kTolerance);
+  ballistics.decay(0.5f);
+  REQUIRE(std::abs(ballistics.level(0).peak - 0.3f) < kTolerance);
+  ballistics.decay(1.0f);
+  REQUIRE(ballistics.level(0).peak < kTolerance);
+  REQUIRE(ballistics.level(0).rms < kTolerance);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
@@ -1,5 +1,6 @@
 #include "main-component.h"
 #include "keymap.h"
+#include "realtime-guard.h"
 #include "ui-layout.h"
 #include "ui-theme.h"
 
@@ -54,12 +55,191 @@ TEST_CASE("MainComponent updates last MIDI message on incoming MIDI") {
 
   const auto incoming = juce::MidiMessage::noteOn(1, 60, static_cast<juce::uint8>(80));
   component.handleIncomingMidiMessageForTesting(incoming);
+  REQUIRE(component.getLastMidiMessageForTesting() == "message");
+  component.flushPendingMidiForTesting();
   const auto expected_incoming = juce::String("note-on ") +
                                  juce::MidiMessage::getMidiNoteName(60, true, true, 3);
   REQUIRE(component.getLastMidiMessageForTesting() == expected_incoming);
   // NOLINTEND(cppcoreguidelines-avoid-do-while)
 }
 
+TEST_CASE("MainComponent coalesces queued MIDI for display") {
+  juce::ScopedJuceInitialiser_GUI gui;
+  limit::MainComponent component(false);
+  component.prepareToPlay(0, 0.0);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  component.handleIncomingMidiMessageForTesting(
+      juce::MidiMessage::noteOn(1, 60, static_cast<juce::uint8>(90)));
+  component.handleIncomingMidiMessageForTesting(juce::MidiMessage::controllerEvent(1, 3, 42));
+  REQUIRE(component.getLastMidiMessageForTesting().isEmpty());
+
+  component.flushPendingMidiForTesting();
+  REQUIRE(component.getLastMidiMessageForTesting() == "cc 3 = 42");
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("MainComponent marks regions dirty instead of repainting") {
+  juce::ScopedJuceInitialiser_GUI gui;
+  limit::MainComponent component(false);
+  component.prepareToPlay(0, 0.0);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  component.refreshUiForTesting();
+  REQUIRE_FALSE(component.dirtyRegionsForTesting().any());
+
+  for (int value = 0; value < 100; ++value) {
+    component.handleIncomingMidiMessageForTesting(
+        juce::MidiMessage::controllerEvent(1, 3, value));
+  }
+  REQUIRE_FALSE(component.dirtyRegionsForTesting().any());
+
+  component.flushPendingMidiForTesting();
+  const auto dirty = component.dirtyRegionsForTesting();
+  REQUIRE(dirty.isDirty(limit::UiRegion::kSecondary));
+  REQUIRE_FALSE(dirty.isDirty(limit::UiRegion::kHeader));
+  REQUIRE_FALSE(dirty.isDirty(limit::UiRegion::kVisualization));
+  REQUIRE(component.getLastMidiMessageForTesting() == "cc 3 = 99");
+
+  component.refreshUiForTesting();
+  REQUIRE_FALSE(component.dirtyRegionsForTesting().any());
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("MainComponent drains incoming MIDI into the audio block") {
+  juce::ScopedJuceInitialiser_GUI gui;
+  limit::MainComponent component(false);
+  constexpr int kBlockSize = 64;
+  constexpr double kSampleRate = 48000.0;
+  component.prepareToPlay(kBlockSize, kSampleRate);
+
+  component.handleIncomingMidiMessageForTesting(
+      juce::MidiMessage::noteOn(1, 64, static_cast<juce::uint8>(100)));
+  component.handleIncomingMidiMessageForTesting(juce::MidiMessage::noteOff(1, 64));
+
+  juce::AudioBuffer<float> buffer(2, kBlockSize);
+  juce::AudioSourceChannelInfo info(&buffer, 0, buffer.getNumSamples());
+  component.getNextAudioBlock(info);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  const auto &midi = component.getBlockMidiForTesting();
+  REQUIRE(midi.getNumEvents() == 2);
+  for (const auto metadata : midi) {
+    REQUIRE(metadata.samplePosition >= 0);
+    REQUIRE(metadata.samplePosition < kBlockSize);
+    REQUIRE(metadata.getMessage().getNoteNumber() == 64);
+  }
+
+  component.getNextAudioBlock(info);
+  REQUIRE(component.getBlockMidiForTesting().getNumEvents() == 0);
+
+  const auto allocations_before = limit::realtimeAllocationCount();
+  component.handleIncomingMidiMessageForTesting(juce::MidiMessage::controllerEvent(1, 1, 10));
+  component.getNextAudioBlock(info);
+  if (limit::isAllocationTrapEnabled()) {
+    REQUIRE(limit::realtimeAllocationCount() == allocations_before);
+  }
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("MainComponent sends keyboard notes to the audio block") {
+  juce::ScopedJuceInitialiser_GUI gui;
+  limit::MainComponent component(false);
+  constexpr int kBlockSize = 64;
+  constexpr double kSampleRate = 48000.0;
+  component.prepareToPlay(kBlockSize, kSampleRate);
+  const auto expected_note = limit::mapKeyToMidiNote('g');
+
+  juce::AudioBuffer<float> buffer(2, kBlockSize);
+  juce::AudioSourceChannelInfo info(&buffer, 0, buffer.getNumSamples());
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  // 'g' is the lowest note key.
+  REQUIRE(expected_note == limit::kKeymapMinNote);
+  REQUIRE(component.processKeyCharForTesting('g'));
+  REQUIRE(component.processKeyCharForTesting('g'));
+  component.getNextAudioBlock(info);
+  const auto &midi = component.getBlockMidiForTesting();
+  REQUIRE(midi.getNumEvents() == 1);
+  for (const auto metadata : midi) {
+    REQUIRE(metadata.getMessage().isNoteOn());
+    REQUIRE(metadata.getMessage().getNoteNumber() == expected_note);
+  }
+
+  REQUIRE(component.releaseKeyCharForTesting('g'));
+  REQUIRE_FALSE(component.releaseKeyCharForTesting('g'));
+  component.getNextAudioBlock(info);
+  REQUIRE(component.getBlockMidiForTesting().getNumEvents() == 1);
+  for (const auto metadata : component.getBlockMidiForTesting()) {
+    REQUIRE(metadata.getMessage().isNoteOff());
+  }
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("MainComponent meters audio blocks in the visualization") {
+  juce::ScopedJuceInitialiser_GUI gui;
+  limit::MainComponent component(false);
+  constexpr int kBlockSize = 256;
+  constexpr double kSampleRate = 48000.0;
+  component.prepareToPlay(kBlockSize, kSampleRate);
+
+  juce::AudioBuffer<float> buffer(2, kBlockSize);
+  juce::AudioSourceChannelInfo info(&buffer, 0, buffer.getNumSamples());
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  component.getNextAudioBlock(info);
+  component.flushPendingMetersForTesting();
+  REQUIRE_FALSE(component.dirtyRegionsForTesting().any());
+
+  REQUIRE(component.processKeyCharForTesting('g'));
+  component.getNextAudioBlock(info);
+  component.getNextAudioBlock(info);
+  component.flushPendingMetersForTesting();
+  REQUIRE(component.dirtyRegionsForTesting().isDirty(limit::UiRegion::kVisualization));
+  REQUIRE(component.meterLevelForTesting(0).peak > 0.0f);
+  REQUIRE(component.meterLevelForTesting(limit::kMasterMeterIndex).peak > 0.0f);
+  REQUIRE(component.meterLevelForTesting(1).peak <= 0.0f);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("MainComponent plays pad steps from the sequencer in the audio block") {
+  juce::ScopedJuceInitialiser_GUI gui;
+  limit::MainComponent component(false);
+  constexpr int kBlockSize = 256;
+  constexpr double kSampleRate = 48000.0;
+  component.prepareToPlay(kBlockSize, kSampleRate);
+
+  juce::AudioBuffer<float> buffer(2, kBlockSize);
+  juce::AudioSourceChannelInfo info(&buffer, 0, buffer.getNumSamples());
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(component.processPadIndexForTesting(0));
+  REQUIRE(component.keyPressed(juce::KeyPress(juce::KeyPress::F9Key)));
+  REQUIRE(component.getLastMidiMessageForTesting() == "dev sequencer play");
+  REQUIRE(component.sequencerForTesting().isRunning());
+
+  component.getNextAudioBlock(info);
+  REQUIRE(component.getBlockMidiForTesting().getNumEvents() == 1);
+  for (const auto metadata : component.getBlockMidiForTesting()) {
+    REQUIRE(metadata.samplePosition == 0);
+    REQUIRE(metadata.getMessage().isNoteOn());
+    REQUIRE(metadata.getMessage().getNoteNumber() == limit::kDefaultStepNote);
+  }
+
+  const auto allocations_before = limit::realtimeAllocationCount();
+  component.getNextAudioBlock(info);
+  if (limit::isAllocationTrapEnabled()) {
+    REQUIRE(limit::realtimeAllocationCount() == allocations_before);
+  }
+
+  REQUIRE(component.keyPressed(juce::KeyPress(juce::KeyPress::F9Key)));
+  REQUIRE(component.getLastMidiMessageForTesting() == "dev sequencer stop");
+  component.getNextAudioBlock(info);
+  REQUIRE(component.getBlockMidiForTesting().getNumEvents() == 1);
+  REQUIRE(component.sequencerForTesting().currentStep() == -1);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
 TEST_CASE("MainComponent handles dev keys and pads") {
   juce::ScopedJuceInitialiser_GUI gui;
   limit::MainComponent component(false);
@@ -129,6 +309,76 @@ TEST_CASE("MainComponent handles dev keys and pads") {
   // NOLINTEND(cppcoreguidelines-avoid-do-while)
 }
 
+TEST_CASE("MainComponent switches modes and sub-views") {
+  juce::ScopedJuceInitialiser_GUI gui;
+  limit::MainComponent component(false);
+  component.prepareToPlay(0, 0.0);
+  const auto key = [](char key_char) {
+    return juce::KeyPress(static_cast<int>(key_char), juce::ModifierKeys::noModifiers,
+                          static_cast<juce::juce_wchar>(key_char));
+  };
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(component.processEncoderActionForTesting(0, limit::DevEncoderAction::kIncrease));
+  REQUIRE(component.getLastMidiMessageForTesting().contains("LEVEL 1"));
+
+  REQUIRE(component.keyPressed(juce::KeyPress(juce::KeyPress::tabKey)));
+  REQUIRE(component.getLastMidiMessageForTesting() == "dev mix pan");
+  REQUIRE(component.processEncoderActionForTesting(0, limit::DevEncoderAction::kIncrease));
+  REQUIRE(component.getLastMidiMessageForTesting().contains("PAN 1"));
+
+  REQUIRE(component.keyPressed(juce::KeyPress(juce::KeyPress::tabKey)));
+  REQUIRE(component.getLastMidiMessageForTesting() == "dev mix sends");
+  REQUIRE(component.processEncoderActionForTesting(0, limit::DevEncoderAction::kIncrease));
+  REQUIRE(component.getLastMidiMessageForTesting().contains("SEND1 1"));
+
+  REQUIRE(component.keyPressed(key('6')));
+  REQUIRE(component.getLastMidiMessageForTesting() == "dev sequence steps");
+  REQUIRE(component.keyPressed(key('7')));
+  REQUIRE(component.getLastMidiMessageForTesting() == "dev tape");
+  REQUIRE(component.keyPressed(juce::KeyPress(juce::KeyPress::tabKey)));
+  REQUIRE(component.getLastMidiMessageForTesting() == "dev tape");
+  REQUIRE(component.keyPressed(key('8')));
+  REQUIRE(component.getLastMidiMessageForTesting() == "dev mix levels");
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("MainComponent drives the tape transport in Tape mode") {
+  juce::ScopedJuceInitialiser_GUI gui;
+  limit::MainComponent component(false);
+  component.prepareToPlay(0, 0.0);
+  const auto tape_key = juce::KeyPress(static_cast<int>('7'), juce::ModifierKeys::noModifiers,
+                                       static_cast<juce::juce_wchar>('7'));
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(component.keyPressed(tape_key));
+  REQUIRE(component.keyPressed(juce::KeyPress(juce::KeyPress::F9Key)));
+  REQUIRE(component.getLastMidiMessageForTesting() == "dev tape play");
+  REQUIRE(component.tapeTransportForTesting().isPlaying());
+  REQUIRE_FALSE(component.sequencerForTesting().isRunning());
+
+  REQUIRE(component.processEncoderActionForTesting(0, limit::DevEncoderAction::kIncrease));
+  REQUIRE(component.getLastMidiMessageForTesting().contains("SPEED"));
+
+  REQUIRE(component.processPadIndexForTesting(0));
+  REQUIRE(component.getLastMidiMessageForTesting() == "dev tape brake on");
+  REQUIRE(component.processPadIndexForTesting(1));
+  REQUIRE(component.getLastMidiMessageForTesting() == "dev tape reverse on");
+  REQUIRE(component.processPadIndexForTesting(2));
+  REQUIRE(component.getLastMidiMessageForTesting() == "dev tape loop on");
+  REQUIRE(component.processPadIndexForTesting(3));
+  REQUIRE(component.getLastMidiMessageForTesting() == "dev tape chop on");
+  REQUIRE(component.processPadIndexForTesting(3));
+  REQUIRE(component.getLastMidiMessageForTesting() == "dev tape chop off");
+  REQUIRE(component.processPadIndexForTesting(0));
+  REQUIRE(component.getLastMidiMessageForTesting() == "dev tape brake off");
+
+  REQUIRE(component.keyPressed(juce::KeyPress(juce::KeyPress::F9Key)));
+  REQUIRE(component.getLastMidiMessageForTesting() == "dev tape stop");
+  REQUIRE_FALSE(component.tapeTransportForTesting().isPlaying());
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
 TEST_CASE("MainComponent paints into an image") {
   juce::ScopedJuceInitialiser_GUI gui;
   limit::MainComponent component(false);
@@ -160,6 +410,25 @@ TEST_CASE("MainComponent paints into an image") {
   // NOLINTEND(cppcoreguidelines-avoid-do-while)
 }
 
+TEST_CASE("MainComponent caches static chrome between repaints") {
+  juce::ScopedJuceInitialiser_GUI gui;
+  limit::MainComponent component(false);
+  const auto &theme = limit::getUiTheme();
+  juce::Image canvas(juce::Image::RGB, theme.window_width, theme.window_height, true);
+  juce::Graphics g(canvas);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  component.paint(g);
+  component.processMidiMessageForTesting(juce::MidiMessage::controllerEvent(1, 7, 99));
+  component.paint(g);
+  REQUIRE(component.chromeRenderCountForTesting() == 1);
+
+  component.setSize(theme.window_width / 2, theme.window_height / 2);
+  component.paint(g);
+  REQUIRE(component.chromeRenderCountForTesting() == 2);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
 TEST_CASE("MainComponent renders secondary status box styling") {
   juce::ScopedJuceInitialiser_GUI gui;
   limit::MainComponent component(false);
@@ -0,0 +1,83 @@
+#include "midi-event-queue.h"
+
+#include <array>
+#include <cstdint>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+constexpr std::uint8_t kNoteOnStatus = 0x90;
+constexpr std::uint8_t kVelocity = 100;
+
+auto makeNoteOn(int note, std::int64_t ticks) -> limit::MidiEvent {
+  const std::array<std::uint8_t, 3> bytes = {kNoteOnStatus, static_cast<std::uint8_t>(note),
+                                             kVelocity};
+  return limit::makeMidiEvent(bytes.data(), static_cast<int>(bytes.size()), ticks)
+      .value_or(limit::MidiEvent{});
+}
+} // namespace
+
+TEST_CASE("MIDI event queue preserves FIFO order", "[midi]") {
+  limit::MidiEventQueue queue;
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE_FALSE(queue.pop().has_value());
+  REQUIRE(queue.push(makeNoteOn(60, 1)));
+  REQUIRE(queue.push(makeNoteOn(62, 2)));
+  REQUIRE(queue.size() == 2);
+
+  const auto first = queue.pop().value_or(limit::MidiEvent{});
+  REQUIRE(first.bytes.at(1) == 60);
+  REQUIRE(first.timestamp_ticks == 1);
+  const auto second = queue.pop().value_or(limit::MidiEvent{});
+  REQUIRE(second.bytes.at(1) == 62);
+  REQUIRE_FALSE(queue.pop().has_value());
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("MIDI event queue drops events when full", "[midi]") {
+  limit::MidiEventQueue queue;
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  for (std::size_t index = 0; index < limit::kMidiEventQueueCapacity; ++index) {
+    REQUIRE(queue.push(makeNoteOn(60, static_cast<std::int64_t>(index))));
+  }
+  REQUIRE_FALSE(queue.push(makeNoteOn(61, 0)));
+  REQUIRE(queue.droppedCount() == 1);
+  REQUIRE(queue.size() == limit::kMidiEventQueueCapacity);
+
+  REQUIRE(queue.pop().has_value());
+  REQUIRE(queue.push(makeNoteOn(61, 0)));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("MIDI events reject oversized messages", "[midi]") {
+  const std::array<std::uint8_t, 4> sysex = {0xf0, 0x7e, 0x7f, 0xf7};
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE_FALSE(
+      limit::makeMidiEvent(sysex.data(), static_cast<int>(sysex.size()), 0).has_value());
+  REQUIRE_FALSE(limit::makeMidiEvent(nullptr, 3, 0).has_value());
+  REQUIRE(limit::makeMidiEvent(sysex.data(), 1, 0).has_value());
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("MIDI event timestamps map to sample offsets", "[midi]") {
+  constexpr double kTicksPerSecond = 48000.0;
+  constexpr double kSampleRate = 48000.0;
+  constexpr int kBlockSize = 64;
+  constexpr std::int64_t kBlockEnd = 10000;
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(limit::midiEventSampleOffset(kBlockEnd - kBlockSize, kBlockEnd, kTicksPerSecond,
+                                       kSampleRate, kBlockSize) == 0);
+  REQUIRE(limit::midiEventSampleOffset(kBlockEnd - 16, kBlockEnd, kTicksPerSecond, kSampleRate,
+                                       kBlockSize) == kBlockSize - 16);
+  REQUIRE(limit::midiEventSampleOffset(0, kBlockEnd, kTicksPerSecond, kSampleRate,
+                                       kBlockSize) == 0);
+  REQUIRE(limit::midiEventSampleOffset(kBlockEnd + 100, kBlockEnd, kTicksPerSecond,
+                                       kSampleRate, kBlockSize) == kBlockSize - 1);
+  REQUIRE(limit::midiEventSampleOffset(kBlockEnd, kBlockEnd, kTicksPerSecond, 0.0,
+                                       kBlockSize) == 0);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
@@ -0,0 +1,163 @@
+#include "offline-renderer.h"
+#include "test-files.h"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+constexpr int kTestBlock = 128;
+constexpr std::size_t kWavHeaderBytes = 44;
+
+const auto *const kTestScript = "length 0.25s\n"
+                                "0 note-on 1 60 100\n"
+                                "0 note-on 1 67 90\n"
+                                "1000 mix 1 level 50\n"
+                                "0.1s note-off 1 60\n"
+                                "0.2s note-off 1 67\n";
+
+auto testConfig() -> limit::OfflineRenderConfig {
+  limit::OfflineRenderConfig config;
+  config.block_size = kTestBlock;
+  return config;
+}
+
+auto renderSamples(limit::OfflineRenderer &renderer, const limit::RenderScript &script)
+    -> std::vector<float> {
+  std::vector<float> samples;
+  const auto result = renderer.render(
+      script, [&samples](std::int64_t /*offset*/, std::span<const float> left,
+                         std::span<const float> right) {
+        for (std::size_t frame = 0; frame < left.size(); ++frame) {
+          samples.push_back(left[frame]);
+          samples.push_back(right[frame]);
+        }
+        return true;
+      });
+  if (!result.completed) {
+    samples.clear();
+  }
+  return samples;
+}
+
+auto readBytes(const std::filesystem::path &path) -> std::vector<char> {
+  std::ifstream file(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+} // namespace
+
+TEST_CASE("Offline renders are deterministic and audible", "[offline-renderer]") {
+  auto renderer = limit::OfflineRenderer::open(testConfig());
+  const auto script = limit::parseRenderScript(kTestScript, limit::kTapeSampleRate);
+  const auto first = renderSamples(*renderer, script);
+  const auto second = renderSamples(*renderer, script);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(renderer != nullptr);
+  REQUIRE_FALSE(renderer->hasTape());
+  REQUIRE(first.size() == static_cast<std::size_t>(script.length_frames) * 2);
+  REQUIRE(first == second);
+
+  float peak = 0.0f;
+  for (const auto sample : first) {
+    peak = std::max(peak, std::abs(sample));
+  }
+  REQUIRE(peak > 0.0f);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Offline renders split blocks at controller events", "[offline-renderer]") {
+  auto renderer = limit::OfflineRenderer::open(testConfig());
+  const auto script = limit::parseRenderScript("length 300\n"
+                                               "50 mix 1 level 0\n"
+                                               "200 mix 1 level 100\n",
+                                               limit::kTapeSampleRate);
+  std::vector<std::int64_t> offsets;
+  const auto result = renderer->render(
+      script, [&offsets](std::int64_t offset, std::span<const float> /*left*/,
+                         std::span<const float> /*right*/) {
+        offsets.push_back(offset);
+        return true;
+      });
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(result.completed);
+  REQUIRE(result.frames_rendered == 300);
+  REQUIRE(offsets == std::vector<std::int64_t>{0, 50, 178, 200});
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Offline renders never create tape files", "[offline-renderer]") {
+  const limit::test::TempDirectory project("render-test-project");
+  auto config = testConfig();
+  config.project = project.get();
+  auto without_tape = limit::OfflineRenderer::open(config);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(without_tape != nullptr);
+  REQUIRE_FALSE(without_tape->hasTape());
+  REQUIRE_FALSE(std::filesystem::exists(project.get() / "tape"));
+
+  std::filesystem::create_directories(project.get() / "tape");
+  REQUIRE(limit::OfflineRenderer::open(config) == nullptr);
+  REQUIRE(std::filesystem::is_empty(project.get() / "tape"));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Offline renders ramp mix changes", "[offline-renderer]") {
+  const limit::test::TempDirectory project("render-test-ramp");
+  constexpr int kToneFrames = limit::kTapeSampleRate / 5;
+  {
+    auto storage = limit::TapeStorage::open({.directory = project.get() / "tape"});
+    const std::vector<float> tone(kToneFrames, 0.5f);
+    storage->writeFramesOffline(0, 0, tone, tone);
+    storage->flush();
+  }
+  auto config = testConfig();
+  config.project = project.get();
+  auto renderer = limit::OfflineRenderer::open(config);
+  const auto script = limit::parseRenderScript("length 0.1s\n"
+                                               "0 tape play\n"
+                                               "0.05s mix 1 level 0\n",
+                                               limit::kTapeSampleRate);
+  const auto samples = renderSamples(*renderer, script);
+  const auto change = static_cast<std::size_t>(limit::kTapeSampleRate / 20) * 2;
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(renderer->hasTape());
+  REQUIRE(samples.size() == static_cast<std::size_t>(script.length_frames) * 2);
+  const auto before = samples[change - 2];
+  REQUIRE(before > 0.0f);
+  // The level falls over the smoothing time instead of stepping to zero.
+  REQUIRE(samples[change + kTestBlock] > 0.0f);
+  REQUIRE(samples[change + kTestBlock] < before);
+  REQUIRE(samples.back() == 0.0f);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Offline WAV renders are byte-identical", "[offline-renderer]") {
+  const auto directory = std::filesystem::temp_directory_path() / "limit-offline-render-test";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+  const auto script = limit::parseRenderScript(kTestScript, limit::kTapeSampleRate);
+
+  auto renderer = limit::OfflineRenderer::open(testConfig());
+  const auto first = renderer->renderToWav(script, directory / "first.wav");
+  const auto second = renderer->renderToWav(script, directory / "second.wav");
+  const auto first_bytes = readBytes(directory / "first.wav");
+  const auto second_bytes = readBytes(directory / "second.wav");
+  std::filesystem::remove_all(directory);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(first.completed);
+  REQUIRE(second.completed);
+  REQUIRE(first_bytes.size() ==
+          kWavHeaderBytes + (static_cast<std::size_t>(script.length_frames) * 2 * sizeof(float)));
+  REQUIRE(first_bytes == second_bytes);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
@@ -0,0 +1,210 @@
+#include "parameter-registry.h"
+#include "realtime-guard.h"
+
+#include <array>
+#include <cmath>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+constexpr double kSampleRate = 48000.0;
+constexpr int kBlockSize = 64;
+constexpr float kTolerance = 1.0e-4f;
+constexpr std::array<std::string_view, 3> kShapes{"sine", "saw", "square"};
+
+auto cutoffSpec() -> limit::ParameterSpec {
+  return {.label = "CUTOFF",
+          .min = 20.0f,
+          .max = 20000.0f,
+          .default_value = 2400.0f,
+          .skew = 0.25f,
+          .unit = limit::ParameterUnit::kHertz};
+}
+
+auto levelSpec() -> limit::ParameterSpec {
+  return {.label = "LEVEL",
+          .min = 0.0f,
+          .max = 100.0f,
+          .default_value = 100.0f,
+          .unit = limit::ParameterUnit::kPercent};
+}
+
+auto near(float actual, float expected) -> bool {
+  return std::abs(actual - expected) <= kTolerance * std::max(1.0f, std::abs(expected));
+}
+} // namespace
+
+TEST_CASE("Parameter values round trip through the skewed range", "[parameters]") {
+  const auto spec = cutoffSpec();
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(near(limit::normalisedToValue(spec, 0.0f), 20.0f));
+  REQUIRE(near(limit::normalisedToValue(spec, 1.0f), 20000.0f));
+  REQUIRE(limit::normalisedToValue(spec, 0.5f) < 2000.0f);
+  for (const auto value : {20.0f, 440.0f, 2400.0f, 12500.0f}) {
+    REQUIRE(near(limit::normalisedToValue(spec, limit::valueToNormalised(spec, value)), value));
+  }
+  REQUIRE(near(limit::valueToNormalised(spec, 100000.0f), 1.0f));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Parameter values format in the display style", "[parameters]") {
+  const auto spec = [](limit::ParameterUnit unit) {
+    return limit::ParameterSpec{.label = "X", .min = -100.0f, .max = 20000.0f, .unit = unit};
+  };
+  const limit::ParameterSpec shape{.label = "SHAPE",
+                                   .unit = limit::ParameterUnit::kChoice,
+                                   .choices = kShapes};
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(limit::formatParameterValue(spec(limit::ParameterUnit::kHertz), 2400.0f) == "2400");
+  REQUIRE(limit::formatParameterValue(spec(limit::ParameterUnit::kHertz), 12500.0f) == "12.5K");
+  REQUIRE(limit::formatParameterValue(spec(limit::ParameterUnit::kMilliseconds), 450.0f) ==
+          "450");
+  REQUIRE(limit::formatParameterValue(spec(limit::ParameterUnit::kMilliseconds), 1250.0f) ==
+          "1:250");
+  REQUIRE(limit::formatParameterValue(spec(limit::ParameterUnit::kPercent), 63.6f) == "64");
+  REQUIRE(limit::formatParameterValue(spec(limit::ParameterUnit::kSemitones), 7.0f) == "+7");
+  REQUIRE(limit::formatParameterValue(spec(limit::ParameterUnit::kSemitones), 0.0f) == "0");
+  REQUIRE(limit::formatParameterValue(spec(limit::ParameterUnit::kSemitones), -12.0f) == "-12");
+  REQUIRE(limit::formatParameterValue(shape, 1.0f) == "SAW");
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Parameter registry binds encoders per mode and sub-view", "[parameters]") {
+  limit::ParameterRegistry registry;
+  const auto cutoff = registry.add(cutoffSpec());
+  const auto level = registry.add(levelSpec());
+  const limit::ParameterAddress sound{.mode = limit::AppMode::kSound, .bank = 1, .encoder = 2};
+  const limit::ParameterAddress mix{.mode = limit::AppMode::kMix, .sub_view = 1, .encoder = 2};
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(cutoff == 0);
+  REQUIRE(level == 1);
+  REQUIRE(registry.count() == 2);
+  REQUIRE(registry.bind(sound, cutoff));
+  REQUIRE(registry.bind(mix, level));
+  REQUIRE_FALSE(registry.bind(sound, 7));
+  REQUIRE_FALSE(registry.bind({.bank = limit::kDevBankCount}, cutoff));
+  REQUIRE(registry.lookup(sound) == cutoff);
+  REQUIRE(registry.lookup(mix) == level);
+  REQUIRE(registry.lookup({.mode = limit::AppMode::kMix, .encoder = 2}) == -1);
+  REQUIRE(registry.lookup({.encoder = limit::kDevEncoderCount}) == -1);
+  REQUIRE(registry.format(cutoff) == "2400");
+  REQUIRE(registry.format(level) == "100");
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Parameter registry nudges clamp and step through choices", "[parameters]") {
+  limit::ParameterRegistry registry;
+  const auto level = registry.add(levelSpec());
+  const auto shape = registry.add(
+      {.label = "SHAPE", .unit = limit::ParameterUnit::kChoice, .choices = kShapes});
+
+  registry.nudge(level, 10.0f);
+  const auto clamped = registry.value(level);
+  registry.nudge(level, -static_cast<float>(limit::kEncoderSteps) / 2.0f);
+  const auto halfway = registry.value(level);
+  registry.resetToDefault(level);
+  registry.nudge(shape, 1.0f);
+  const auto second = registry.format(shape);
+  registry.nudge(shape, 5.0f);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(near(clamped, 100.0f));
+  REQUIRE(halfway > 49.0f);
+  REQUIRE(halfway < 51.0f);
+  REQUIRE(near(registry.value(level), 100.0f));
+  REQUIRE(second == "SAW");
+  REQUIRE(registry.format(shape) == "SQUARE");
+  REQUIRE(registry.spec(shape).max > 1.5f);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Parameter registry keeps nudges from every thread", "[parameters]") {
+  constexpr int kNudges = 1000;
+  constexpr float kStep = 0.01f;
+  limit::ParameterRegistry registry;
+  const auto level = registry.add({.label = "LEVEL", .max = 1.0f});
+
+  const auto turn = [&registry, level] {
+    for (int nudge = 0; nudge < kNudges; ++nudge) {
+      registry.nudge(level, kStep);
+    }
+  };
+  std::thread first(turn);
+  std::thread second(turn);
+  first.join();
+  second.join();
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  const auto expected = 2.0f * kNudges * kStep / static_cast<float>(limit::kEncoderSteps);
+  REQUIRE(near(registry.normalised(level), expected));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Parameter ramps reach the target over the smoothing time", "[parameters]") {
+  limit::ParameterRegistry registry;
+  const auto level = registry.add(levelSpec());
+  limit::ParameterRamps ramps(registry);
+  ramps.prepare(kSampleRate);
+  registry.setNormalised(level, 0.0f);
+
+  std::vector<float> samples(kBlockSize);
+  ramps.beginBlock(kBlockSize);
+  ramps.fill(level, samples);
+  const auto first_start = ramps.blockStart(level);
+  const auto first_end = ramps.blockEnd(level);
+  auto monotonic = true;
+  for (std::size_t index = 1; index < samples.size(); ++index) {
+    monotonic = monotonic && samples.at(index) <= samples.at(index - 1);
+  }
+
+  const auto smoothing_blocks = static_cast<int>(
+      std::ceil(limit::kDefaultSmoothingSeconds * kSampleRate / kBlockSize));
+  for (int block = 1; block < smoothing_blocks; ++block) {
+    ramps.beginBlock(kBlockSize);
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(near(first_start, 100.0f));
+  REQUIRE(first_end < 100.0f);
+  REQUIRE(first_end > 0.0f);
+  REQUIRE(monotonic);
+  REQUIRE(near(samples.back(), first_end));
+  REQUIRE(near(ramps.blockEnd(level), 0.0f));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Parameter ramps do not allocate on the audio thread", "[parameters][realtime]") {
+  if (!limit::isAllocationTrapEnabled()) {
+    SKIP("Needs the allocation trap (LIMIT_ALLOCATION_TRAP=ON)");
+  }
+  limit::ParameterRegistry registry;
+  std::vector<int> ids;
+  for (int index = 0; index < 32; ++index) {
+    ids.push_back(registry.add(index % 2 == 0 ? cutoffSpec() : levelSpec()));
+  }
+  limit::ParameterRamps ramps(registry);
+  ramps.prepare(kSampleRate);
+  std::vector<float> samples(kBlockSize);
+
+  const auto before = limit::realtimeAllocationCount();
+  for (int block = 0; block < 16; ++block) {
+    for (const auto id : ids) {
+      registry.nudge(id, static_cast<float>((block % 3) - 1));
+    }
+    const limit::ScopedRealtimeSection realtime_section;
+    ramps.beginBlock(kBlockSize);
+    for (const auto id : ids) {
+      ramps.fill(id, samples);
+    }
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(limit::realtimeAllocationCount() == before);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
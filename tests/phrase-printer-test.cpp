@@ -0,0 +1,178 @@
+#include "audio-graph.h"
+#include "phrase-printer.h"
+#include "synth-instrument.h"
+#include "tape-storage.h"
+#include "test-files.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+using limit::test::TempDirectory;
+
+constexpr double kSampleRate = 8192.0;
+constexpr int kLiveBlockSize = 96;
+constexpr int kPhraseFrames = 2000;
+constexpr int kTailFrames = 1500;
+constexpr auto kVelocity = static_cast<juce::uint8>(90);
+
+auto makeSynth() -> std::unique_ptr<limit::SynthInstrument> {
+  return std::make_unique<limit::SynthInstrument>(
+      [] { return std::make_unique<limit::SineVoiceEngine>(); });
+}
+
+auto makeJob(int loop_count) -> limit::PhrasePrintJob {
+  limit::PhrasePrintJob job;
+  job.midi.addEvent(juce::MidiMessage::noteOn(1, 60, kVelocity), 0);
+  job.midi.addEvent(juce::MidiMessage::noteOn(1, 67, kVelocity), 333);
+  job.midi.addEvent(juce::MidiMessage::noteOff(1, 60), 1000);
+  job.midi.addEvent(juce::MidiMessage::noteOff(1, 67), kPhraseFrames - 1);
+  job.length_frames = kPhraseFrames;
+  job.loop_count = loop_count;
+  job.tail_frames = kTailFrames;
+  return job;
+}
+
+struct StereoCapture {
+  std::vector<float> left;
+  std::vector<float> right;
+};
+
+auto renderToMemory(limit::PhrasePrinter &printer, const limit::PhrasePrintJob &job)
+    -> std::pair<limit::PrintResult, StereoCapture> {
+  StereoCapture capture;
+  const auto result = printer.render(job, [&capture](std::int64_t /*offset*/,
+                                                     std::span<const float> left,
+                                                     std::span<const float> right) {
+    capture.left.insert(capture.left.end(), left.begin(), left.end());
+    capture.right.insert(capture.right.end(), right.begin(), right.end());
+    return true;
+  });
+  return {result, capture};
+}
+} // namespace
+
+TEST_CASE("Phrase printer matches the live graph bit for bit", "[print]") {
+  constexpr int kLoops = 2;
+  const auto job = makeJob(kLoops);
+  limit::PhrasePrinter printer(makeSynth());
+  printer.prepare(kSampleRate);
+  const auto [result, printed] = renderToMemory(printer, job);
+
+  // Play the same phrase through the live graph in small host blocks.
+  auto live_synth = makeSynth();
+  limit::AudioGraph graph;
+  graph.setNode(limit::SignalNode::kInstrument, live_synth.get());
+  graph.prepare(kSampleRate, kLiveBlockSize);
+  const auto total = (kPhraseFrames * kLoops) + kTailFrames;
+  StereoCapture live;
+  juce::AudioBuffer<float> block(2, kLiveBlockSize);
+  juce::MidiBuffer block_midi;
+  for (int start = 0; start < total; start += kLiveBlockSize) {
+    const auto count = std::min(kLiveBlockSize, total - start);
+    block_midi.clear();
+    for (const auto metadata : job.midi) {
+      for (int loop = 0; loop < kLoops; ++loop) {
+        const auto position = metadata.samplePosition + (loop * kPhraseFrames);
+        if (position >= start && position < start + count) {
+          block_midi.addEvent(metadata.getMessage(), position - start);
+        }
+      }
+    }
+    block.clear();
+    graph.process(block_midi, block, 0, count);
+    const std::span<const float> left(block.getReadPointer(0), static_cast<std::size_t>(count));
+    const std::span<const float> right(block.getReadPointer(1), static_cast<std::size_t>(count));
+    live.left.insert(live.left.end(), left.begin(), left.end());
+    live.right.insert(live.right.end(), right.begin(), right.end());
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(result.completed);
+  REQUIRE(result.frames_rendered == total);
+  REQUIRE(result.realtime_factor > 1.0);
+  REQUIRE(printed.left == live.left);
+  REQUIRE(printed.right == live.right);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Phrase printer writes to the armed track at the playhead", "[print][tape]") {
+  constexpr int kChunkFrames = 512;
+  constexpr std::int64_t kStartFrame = 700;
+  const TempDirectory directory("print-test-armed");
+  auto tape = limit::TapeStorage::open({.directory = directory.get(),
+                                        .track_count = 2,
+                                        .sample_rate = static_cast<int>(kSampleRate),
+                                        .length_seconds = 1,
+                                        .chunk_frames = kChunkFrames,
+                                        .prefetch_chunks = 16,
+                                        .retain_chunks = 1});
+  limit::PhrasePrinter printer(makeSynth());
+  printer.prepare(kSampleRate);
+  auto job = makeJob(1);
+  job.track = 1;
+  job.start_frame = kStartFrame;
+  const auto [reference, expected] = renderToMemory(printer, job);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(tape != nullptr);
+  REQUIRE(printer.startPrint(job, *tape));
+  const auto result = printer.waitForPrint();
+  REQUIRE(result.completed);
+  REQUIRE_FALSE(printer.isPrinting());
+
+  tape->setPlayhead(0);
+  tape->service();
+  std::vector<float> left(expected.left.size());
+  std::vector<float> right(expected.right.size());
+  REQUIRE(tape->readFrames(1, kStartFrame, left, right));
+  REQUIRE(left == expected.left);
+  REQUIRE(right == expected.right);
+
+  std::vector<float> untouched_left(expected.left.size());
+  std::vector<float> untouched_right(expected.right.size());
+  REQUIRE(tape->readFrames(0, kStartFrame, untouched_left, untouched_right));
+  REQUIRE(untouched_left == std::vector<float>(expected.left.size(), 0.0f));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+// A 4-bar loop at 120 BPM is 8 seconds of audio; the realtime factor is
+// printed alongside Catch's timing.
+TEST_CASE("Phrase printer 4-bar loop cost", "[.][benchmark][print]") {
+  constexpr double kTapeRate = 48000.0;
+  constexpr int kBarFrames = 96000;
+  constexpr int kBars = 4;
+  constexpr int kStepsPerBar = 16;
+  constexpr int kStepFrames = kBarFrames / kStepsPerBar;
+  limit::PhrasePrintJob job;
+  job.length_frames = static_cast<std::int64_t>(kBarFrames) * kBars;
+  for (int step = 0; step < kBars * kStepsPerBar; ++step) {
+    const auto note = 48 + ((step * 7) % 24);
+    job.midi.addEvent(juce::MidiMessage::noteOn(1, note, kVelocity), step * kStepFrames);
+    job.midi.addEvent(juce::MidiMessage::noteOff(1, note),
+                      (step * kStepFrames) + (kStepFrames / 2));
+  }
+  limit::PhrasePrinter printer(makeSynth());
+  printer.prepare(kTapeRate);
+  double realtime_factor = 0.0;
+
+  BENCHMARK("print 4 bars") {
+    const auto result = printer.render(
+        job, [](std::int64_t /*offset*/, std::span<const float> /*left*/,
+                std::span<const float> /*right*/) { return true; });
+    realtime_factor = result.realtime_factor;
+    return result.frames_rendered;
+  };
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  WARN("realtime factor " << realtime_factor);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
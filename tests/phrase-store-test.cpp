@@ -0,0 +1,143 @@
+#include "phrase-store.h"
+#include "test-files.h"
+
+#include <bit>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+using limit::test::TempDirectory;
+
+auto makeRecord(int seed) -> limit::PhraseRecord {
+  limit::PhraseRecord record;
+  record.pattern.length = 1 + (seed % limit::kMaxPhraseSteps);
+  for (int step = 0; step < record.pattern.length; step += 3) {
+    auto &entry = record.pattern.steps.at(static_cast<std::size_t>(step));
+    entry.note = static_cast<std::uint8_t>(36 + ((seed + step) % 48));
+    entry.velocity = static_cast<std::uint8_t>(1 + ((seed * 7 + step) % 127));
+    entry.gate = 0.25f;
+  }
+  record.sound.engine = static_cast<std::uint32_t>(seed % 5);
+  for (std::size_t index = 0; index < record.sound.parameters.size(); ++index) {
+    record.sound.parameters.at(index) = static_cast<float>(seed) + static_cast<float>(index);
+  }
+  return record;
+}
+
+auto sameContent(const limit::PhraseRecord &a, const limit::PhraseRecord &b) -> bool {
+  if (a.pattern.length != b.pattern.length || a.pattern.channel != b.pattern.channel ||
+      a.sound.engine != b.sound.engine || a.sound.parameters != b.sound.parameters) {
+    return false;
+  }
+  for (std::size_t step = 0; step < a.pattern.steps.size(); ++step) {
+    const auto &left = a.pattern.steps.at(step);
+    const auto &right = b.pattern.steps.at(step);
+    if (left.note != right.note || left.velocity != right.velocity ||
+        std::bit_cast<std::uint32_t>(left.gate) != std::bit_cast<std::uint32_t>(right.gate)) {
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+TEST_CASE("Phrase store starts with every slot empty", "[phrase-store]") {
+  const TempDirectory directory("phrase-test-empty");
+  const auto path = directory.get() / "phrases.bin";
+  const auto store = limit::PhraseStore::open(path);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(store != nullptr);
+  REQUIRE(store->slotCount() == limit::kPhraseSlotCount);
+  for (int slot = 0; slot < limit::kPhraseSlotCount; ++slot) {
+    REQUIRE_FALSE(store->isOccupied(slot));
+  }
+  REQUIRE(store->phrase(-1) == nullptr);
+  REQUIRE(store->phrase(limit::kPhraseSlotCount) == nullptr);
+  REQUIRE_FALSE(store->save(limit::kPhraseSlotCount, makeRecord(1)));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Phrase store round-trips records across reopen", "[phrase-store]") {
+  const TempDirectory directory("phrase-test-round-trip");
+  const auto path = directory.get() / "phrases.bin";
+  const std::vector<int> slots = {0, 1, 255, limit::kPhraseSlotCount - 1};
+  {
+    auto store = limit::PhraseStore::open(path);
+    // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+    REQUIRE(store != nullptr);
+    for (const auto slot : slots) {
+      REQUIRE(store->save(slot, makeRecord(slot)));
+    }
+    REQUIRE(store->save(1, makeRecord(99)));
+    // NOLINTEND(cppcoreguidelines-avoid-do-while)
+  }
+
+  auto store = limit::PhraseStore::open(path);
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(store != nullptr);
+  for (const auto slot : slots) {
+    const auto *record = store->phrase(slot);
+    REQUIRE(record != nullptr);
+    REQUIRE(sameContent(*record, makeRecord(slot == 1 ? 99 : slot)));
+  }
+  REQUIRE(store->phrase(1)->revision == 2);
+  REQUIRE_FALSE(store->isOccupied(2));
+
+  REQUIRE(store->clear(255));
+  REQUIRE_FALSE(store->isOccupied(255));
+  REQUIRE(store->save(255, makeRecord(7)));
+  REQUIRE(store->phrase(255)->revision == 3);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Phrase store rejects files with another layout", "[phrase-store]") {
+  const TempDirectory directory("phrase-test-layout");
+  const auto path = directory.get() / "phrases.bin";
+  {
+    // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+    REQUIRE(limit::PhraseStore::open(path) != nullptr);
+    // NOLINTEND(cppcoreguidelines-avoid-do-while)
+  }
+  {
+    std::fstream stream(path, std::ios::in | std::ios::out | std::ios::binary);
+    stream.seekp(8);
+    const char version = 2;
+    stream.write(&version, 1);
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(limit::PhraseStore::open(path) == nullptr);
+  std::filesystem::resize_file(path, 4096);
+  REQUIRE(limit::PhraseStore::open(path) == nullptr);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Phrase store recall and open cost", "[.][benchmark][phrase-store]") {
+  const TempDirectory directory("phrase-test-benchmark");
+  const auto path = directory.get() / "phrases.bin";
+  {
+    auto store = limit::PhraseStore::open(path);
+    for (int slot = 0; slot < limit::kPhraseSlotCount; ++slot) {
+      store->save(slot, makeRecord(slot));
+    }
+  }
+  auto store = limit::PhraseStore::open(path);
+  limit::StepSequencer sequencer;
+  int slot = 0;
+
+  BENCHMARK("phrase recall") {
+    const auto *record = store->phrase(slot);
+    slot = (slot + 1) % limit::kPhraseSlotCount;
+    sequencer.setPattern(record->pattern);
+    return record->revision;
+  };
+
+  BENCHMARK("phrase store open") { return limit::PhraseStore::open(path) != nullptr; };
+}
@@ -0,0 +1,190 @@
+#include "phrase-store.h"
+#include "project-journal.h"
+#include "realtime-guard.h"
+#include "test-files.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+using limit::test::TempDirectory;
+
+auto makePayload(std::uint8_t value, std::size_t size) -> std::vector<std::byte> {
+  return std::vector<std::byte>(size, static_cast<std::byte>(value));
+}
+
+struct ReplayedChange {
+  int slot = 0;
+  std::vector<std::byte> payload;
+
+  auto operator==(const ReplayedChange &) const -> bool = default;
+};
+
+auto replayAll(limit::ProjectJournal &journal) -> std::vector<ReplayedChange> {
+  std::vector<ReplayedChange> replayed;
+  journal.replay([&replayed](const limit::JournalChange &change) {
+    const auto bytes = change.bytes();
+    replayed.push_back({.slot = change.slot, .payload = {bytes.begin(), bytes.end()}});
+  });
+  return replayed;
+}
+} // namespace
+
+TEST_CASE("Project journal replays appended changes in order", "[journal]") {
+  const TempDirectory directory("journal-test-replay");
+  const auto path = directory.get() / "journal.log";
+  {
+    auto journal = limit::ProjectJournal::open({.path = path});
+    // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+    REQUIRE(journal != nullptr);
+    REQUIRE(journal->append(limit::JournalKind::kPhrase, 3, makePayload(1, 16)));
+    REQUIRE(journal->append(limit::JournalKind::kPhrase, 7, makePayload(2, 1024)));
+    journal->service();
+    REQUIRE(journal->logBytes() > 1040);
+    REQUIRE(journal->append(limit::JournalKind::kPhrase, 3, makePayload(3, 8)));
+    journal->service();
+    // NOLINTEND(cppcoreguidelines-avoid-do-while)
+  }
+
+  auto journal = limit::ProjectJournal::open({.path = path});
+  const auto replayed = replayAll(*journal);
+  const std::vector<ReplayedChange> expected = {
+      {.slot = 3, .payload = makePayload(1, 16)},
+      {.slot = 7, .payload = makePayload(2, 1024)},
+      {.slot = 3, .payload = makePayload(3, 8)},
+  };
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(replayed == expected);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Project journal drops a torn tail record", "[journal]") {
+  const TempDirectory directory("journal-test-torn");
+  const auto path = directory.get() / "journal.log";
+  {
+    auto journal = limit::ProjectJournal::open({.path = path});
+    journal->append(limit::JournalKind::kPhrase, 1, makePayload(1, 64));
+    journal->append(limit::JournalKind::kPhrase, 2, makePayload(2, 64));
+    journal->service();
+  }
+  const auto intact_bytes = std::filesystem::file_size(path);
+  std::filesystem::resize_file(path, intact_bytes - 10);
+
+  {
+    auto journal = limit::ProjectJournal::open({.path = path});
+    const auto replayed = replayAll(*journal);
+    // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+    REQUIRE(replayed.size() == 1);
+    REQUIRE(replayed.front().slot == 1);
+    REQUIRE(std::filesystem::file_size(path) == intact_bytes / 2);
+    REQUIRE(journal->append(limit::JournalKind::kPhrase, 4, makePayload(4, 64)));
+    journal->service();
+    // NOLINTEND(cppcoreguidelines-avoid-do-while)
+  }
+
+  auto journal = limit::ProjectJournal::open({.path = path});
+  const auto replayed = replayAll(*journal);
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(replayed.size() == 2);
+  REQUIRE(replayed.back().slot == 4);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Project journal compacts into the snapshot", "[journal]") {
+  const TempDirectory directory("journal-test-compact");
+  constexpr std::size_t kCompactBytes = 4096;
+  auto journal =
+      limit::ProjectJournal::open({.path = directory.get() / "journal.log",
+                                   .compact_bytes = kCompactBytes});
+  int compactions = 0;
+  bool snapshot_ok = false;
+  journal->start([&compactions, &snapshot_ok] {
+    ++compactions;
+    return snapshot_ok;
+  });
+  journal->stop();
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  for (int slot = 0; slot < 4; ++slot) {
+    REQUIRE(journal->append(limit::JournalKind::kPhrase, slot, makePayload(1, 1024)));
+  }
+  journal->service();
+  REQUIRE(journal->logBytes() > kCompactBytes);
+  REQUIRE(compactions > 0);
+
+  snapshot_ok = true;
+  journal->service();
+  REQUIRE(journal->logBytes() == 0);
+  REQUIRE(replayAll(*journal).empty());
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Project journal append never blocks or allocates", "[journal][realtime]") {
+  const TempDirectory directory("journal-test-full");
+  auto journal = limit::ProjectJournal::open({.path = directory.get() / "journal.log"});
+  const auto payload = makePayload(1, 32);
+  const auto oversized = makePayload(1, limit::kJournalMaxPayloadBytes + 1);
+
+  const auto before = limit::realtimeAllocationCount();
+  {
+    const limit::ScopedRealtimeSection realtime_section;
+    for (std::size_t index = 0; index < limit::kJournalQueueCapacity; ++index) {
+      journal->append(limit::JournalKind::kPhrase, 0, payload);
+    }
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  if (limit::isAllocationTrapEnabled()) {
+    REQUIRE(limit::realtimeAllocationCount() == before);
+  }
+  REQUIRE_FALSE(journal->append(limit::JournalKind::kPhrase, 0, payload));
+  REQUIRE_FALSE(journal->append(limit::JournalKind::kPhrase, 0, oversized));
+  REQUIRE(journal->droppedCount() == 2);
+  journal->service();
+  REQUIRE(journal->append(limit::JournalKind::kPhrase, 0, payload));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Project journal restores phrases lost from the snapshot", "[journal]") {
+  const TempDirectory directory("journal-test-recover");
+  limit::PhraseRecord record;
+  record.pattern.length = 12;
+  record.pattern.steps.at(5).velocity = 90;
+  {
+    auto journal = limit::ProjectJournal::open({.path = directory.get() / "journal.log"});
+    journal->append(limit::JournalKind::kPhrase, 42,
+                    std::as_bytes(std::span(&record, 1)));
+    journal->service();
+  }
+
+  // A fresh phrase file stands in for snapshot pages that never reached disk.
+  auto store = limit::PhraseStore::open(directory.get() / "phrases.bin");
+  auto journal = limit::ProjectJournal::open({.path = directory.get() / "journal.log"});
+  const auto replayed = journal->replay([&store](const limit::JournalChange &change) {
+    limit::PhraseRecord recovered;
+    if (change.kind == limit::JournalKind::kPhrase && change.size == sizeof(recovered)) {
+      std::memcpy(&recovered, change.bytes().data(), sizeof(recovered));
+      store->save(change.slot, recovered);
+    }
+  });
+  journal->start([&store] {
+    store->flush();
+    return true;
+  });
+  journal->stop();
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(replayed == 1);
+  REQUIRE(store->phrase(42) != nullptr);
+  REQUIRE(store->phrase(42)->pattern.length == 12);
+  REQUIRE(store->phrase(42)->pattern.steps.at(5).velocity == 90);
+  REQUIRE(journal->logBytes() == 0);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
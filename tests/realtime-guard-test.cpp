@@ -0,0 +1,73 @@
+#include "realtime-guard.h"
+
+#include <array>
+#include <cstdlib>
+#include <memory>
+
+#include <catch2/catch_test_macros.hpp>
+#include <juce_audio_basics/juce_audio_basics.h>
+
+namespace {
+// Keeps the optimiser from pairing up and eliding the allocations under test.
+void *volatile escaped_pointer = nullptr;
+
+struct alignas(64) OverAligned {
+  std::array<float, 16> samples;
+};
+} // namespace
+
+TEST_CASE("Allocation trap is compiled in to match the build option", "[realtime]") {
+#if defined(LIMIT_ALLOCATION_TRAP)
+  REQUIRE(limit::isAllocationTrapEnabled()); // NOLINT(cppcoreguidelines-avoid-do-while)
+#else
+  REQUIRE_FALSE(limit::isAllocationTrapEnabled()); // NOLINT(cppcoreguidelines-avoid-do-while)
+#endif
+}
+
+TEST_CASE("Allocation trap counts every allocator inside a realtime section", "[realtime]") {
+  if (!limit::isAllocationTrapEnabled()) {
+    SKIP("Needs the allocation trap (LIMIT_ALLOCATION_TRAP=ON)");
+  }
+
+  const auto outside = limit::realtimeAllocationCount();
+  auto plain = std::make_unique<int>(1);
+  escaped_pointer = plain.get();
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-do-while)
+  REQUIRE(limit::realtimeAllocationCount() == outside);
+
+  const auto count = [](auto &&allocate) {
+    const auto before = limit::realtimeAllocationCount();
+    {
+      const limit::ScopedRealtimeSection realtime_section;
+      allocate();
+    }
+    return limit::realtimeAllocationCount() - before;
+  };
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while,cppcoreguidelines-no-malloc)
+  REQUIRE(count([] {
+            auto value = std::make_unique<int>(1);
+            escaped_pointer = value.get();
+          }) == 1);
+  REQUIRE(count([] {
+            auto block = std::make_unique<OverAligned>();
+            escaped_pointer = block.get();
+          }) == 1);
+#if defined(LIMIT_ALLOCATION_TRAP_WRAPS_MALLOC)
+  REQUIRE(count([] {
+            escaped_pointer = std::malloc(16);
+            std::free(escaped_pointer);
+          }) == 1);
+  REQUIRE(count([] {
+            escaped_pointer = std::calloc(4, 4);
+            std::free(escaped_pointer);
+          }) == 1);
+  REQUIRE(count([] {
+            juce::HeapBlock<float> block(16);
+            escaped_pointer = block.get();
+            block.realloc(1024);
+            escaped_pointer = block.get();
+          }) == 2);
+#endif
+  // NOLINTEND(cppcoreguidelines-avoid-do-while,cppcoreguidelines-no-malloc)
+}
@@ -0,0 +1,66 @@
+#include "render-script.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+constexpr double kTestSampleRate = 48000.0;
+} // namespace
+
+TEST_CASE("Render scripts parse times, events and length", "[render-script]") {
+  const auto script = limit::parseRenderScript("# intro\n"
+                                               "length 2s\n"
+                                               "\n"
+                                               "0.5s note-off 1 60\n"
+                                               "0 note-on 2 60 100\n"
+                                               "24000 tape loop 0 1s\n"
+                                               "0 mix 3 pan -50\n",
+                                               kTestSampleRate);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(script.applied == 5);
+  REQUIRE(script.rejected == 0);
+  REQUIRE(script.length_frames == 96000);
+  REQUIRE(script.events.size() == 4);
+
+  const auto &note_on = script.events.at(0);
+  REQUIRE(note_on.frame == 0);
+  REQUIRE(note_on.command == limit::RenderCommand::kMidi);
+  REQUIRE(note_on.midi_size == 3);
+  REQUIRE(note_on.midi.at(0) == 0x91);
+  REQUIRE(note_on.midi.at(2) == 100);
+
+  const auto &pan = script.events.at(1);
+  REQUIRE(pan.command == limit::RenderCommand::kMixPan);
+  REQUIRE(pan.track == 2);
+  REQUIRE(pan.value == -50.0);
+
+  REQUIRE(script.events.at(2).frame == 24000);
+  REQUIRE(script.events.at(2).command == limit::RenderCommand::kMidi);
+  REQUIRE(script.events.at(2).midi.at(0) == 0x80);
+
+  const auto &loop = script.events.at(3);
+  REQUIRE(loop.command == limit::RenderCommand::kTapeLoop);
+  REQUIRE(loop.value == 0.0);
+  REQUIRE(loop.end_frame == 48000);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Render scripts skip and count malformed lines", "[render-script]") {
+  const auto script = limit::parseRenderScript("0 tape play\n"
+                                               "0 note-on 17 60 100\n"
+                                               "1s tape speed 4\n"
+                                               "-1 tape stop\n"
+                                               "0 mix 1 level\n"
+                                               "0 warp 9\n"
+                                               "1s tempo 140\n",
+                                               kTestSampleRate);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(script.applied == 2);
+  REQUIRE(script.rejected == 5);
+  REQUIRE(script.first_rejected_line == 2);
+  REQUIRE(script.events.size() == 2);
+  REQUIRE(script.events.at(1).command == limit::RenderCommand::kTempo);
+  REQUIRE(script.events.at(1).frame == 48000);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
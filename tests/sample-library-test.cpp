@@ -0,0 +1,156 @@
+#include "sample-library.h"
+#include "test-files.h"
+
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+using limit::test::TempDirectory;
+using limit::test::writeWav;
+
+constexpr int kSourceRate = 44100;
+constexpr float kToneHz = 441.0f;
+
+auto tone(int sample_rate, int frames) -> std::vector<float> {
+  std::vector<float> samples(static_cast<std::size_t>(frames));
+  for (int frame = 0; frame < frames; ++frame) {
+    samples.at(static_cast<std::size_t>(frame)) =
+        0.5f * std::sin(juce::MathConstants<float>::twoPi * kToneHz * static_cast<float>(frame) /
+                        static_cast<float>(sample_rate));
+  }
+  return samples;
+}
+
+auto makeConfig(const std::filesystem::path &directory) -> limit::SampleLibraryConfig {
+  limit::SampleLibraryConfig config;
+  config.directory = directory;
+  return config;
+}
+} // namespace
+
+TEST_CASE("Sample library indexes files without decoding them", "[samples]") {
+  const TempDirectory directory("sample-test-index");
+  const auto short_tone = tone(limit::kSampleLibraryRate, 64);
+  for (const auto *file : {"drums/snare.WAV", "drums/kick.wav", "synth/pad.wav", "loose.wav"}) {
+    writeWav(directory.get() / file, limit::kSampleLibraryRate, 1, short_tone);
+  }
+  std::ofstream(directory.get() / "drums" / "readme.txt") << "not a sample";
+
+  const auto library = limit::SampleLibrary::open(makeConfig(directory.get()));
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(library != nullptr);
+  REQUIRE(library->sampleCount() == 4);
+  REQUIRE(library->info(0).name == "loose");
+  REQUIRE(library->info(0).category.empty());
+  REQUIRE(library->info(1).name == "kick");
+  REQUIRE(library->info(2).name == "snare");
+  REQUIRE(library->info(3).category == "synth");
+  REQUIRE(library->find("drums", "snare") == 2);
+  REQUIRE(library->find("drums", "pad") == -1);
+  REQUIRE(library->info(1).file_bytes > 0);
+  REQUIRE(library->cachedBytes() == 0);
+  REQUIRE(library->pendingCount() == 0);
+  REQUIRE_FALSE(library->isCached(1));
+  REQUIRE(limit::SampleLibrary::open(makeConfig(directory.get() / "missing")) == nullptr);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Sample library decodes on demand at the session rate", "[samples]") {
+  constexpr int kSourceFrames = 4410;
+  constexpr int kStereoFrames = 256;
+  const TempDirectory directory("sample-test-decode");
+  writeWav(directory.get() / "tone.wav", kSourceRate, 1, tone(kSourceRate, kSourceFrames));
+  std::vector<float> stereo;
+  for (int frame = 0; frame < kStereoFrames; ++frame) {
+    stereo.push_back(static_cast<float>(frame) / kStereoFrames);
+    stereo.push_back(-static_cast<float>(frame) / kStereoFrames);
+  }
+  writeWav(directory.get() / "wide.wav", limit::kSampleLibraryRate, 2, stereo, true);
+  const auto library = limit::SampleLibrary::open(makeConfig(directory.get()));
+  const auto tone_id = library->find("", "tone");
+  const auto wide_id = library->find("", "wide");
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(library->acquire(tone_id) == nullptr);
+  library->request(wide_id);
+  library->waitUntilIdle();
+  REQUIRE(library->pendingCount() == 0);
+
+  const auto decoded = library->acquire(tone_id);
+  REQUIRE(decoded != nullptr);
+  REQUIRE(decoded->audio.getNumChannels() == 1);
+  REQUIRE(decoded->audio.getNumSamples() == 4800);
+  REQUIRE(juce::exactlyEqual(decoded->source_rate, static_cast<double>(kSourceRate)));
+  const auto expected = tone(limit::kSampleLibraryRate, decoded->audio.getNumSamples());
+  for (int frame = 0; frame < decoded->audio.getNumSamples() - 4; ++frame) {
+    REQUIRE(std::abs(decoded->audio.getSample(0, frame) -
+                     expected.at(static_cast<std::size_t>(frame))) < 0.01f);
+  }
+
+  const auto wide = library->acquire(wide_id);
+  REQUIRE(wide != nullptr);
+  REQUIRE(wide->audio.getNumChannels() == 2);
+  REQUIRE(wide->audio.getNumSamples() == kStereoFrames);
+  REQUIRE(juce::exactlyEqual(wide->audio.getSample(0, 100), 100.0f / kStereoFrames));
+  REQUIRE(juce::exactlyEqual(wide->audio.getSample(1, 100), -100.0f / kStereoFrames));
+  REQUIRE(library->cachedBytes() == decoded->bytes() + wide->bytes());
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Sample library cache stays in budget without dropping held samples", "[samples]") {
+  constexpr int kFrames = 1000;
+  constexpr std::size_t kSampleBytes = kFrames * sizeof(float);
+  const TempDirectory directory("sample-test-cache");
+  for (const auto *name : {"a", "b", "c"}) {
+    writeWav(directory.get() / (std::string(name) + ".wav"), limit::kSampleLibraryRate, 1,
+             tone(limit::kSampleLibraryRate, kFrames));
+  }
+  auto config = makeConfig(directory.get());
+  config.cache_bytes = (kSampleBytes * 2) + (kSampleBytes / 2);
+  const auto library = limit::SampleLibrary::open(config);
+  const auto load = [&library](int id) {
+    library->request(id);
+    library->waitUntilIdle();
+  };
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  load(0);
+  auto held = library->acquire(0);
+  REQUIRE(held != nullptr);
+  load(1);
+  load(2);
+  REQUIRE(library->isCached(0));
+  REQUIRE_FALSE(library->isCached(1));
+  REQUIRE(library->isCached(2));
+  REQUIRE(library->cachedBytes() == kSampleBytes * 2);
+
+  held.reset();
+  load(1);
+  REQUIRE_FALSE(library->isCached(0));
+  REQUIRE(library->isCached(1));
+  REQUIRE(library->isCached(2));
+  REQUIRE(library->cachedBytes() <= config.cache_bytes);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Sample library gives up on unreadable files", "[samples]") {
+  const TempDirectory directory("sample-test-broken");
+  std::ofstream(directory.get() / "broken.wav") << "not a wav file";
+  const auto library = limit::SampleLibrary::open(makeConfig(directory.get()));
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(library->sampleCount() == 1);
+  REQUIRE(library->acquire(0) == nullptr);
+  library->waitUntilIdle();
+  REQUIRE(library->acquire(0) == nullptr);
+  REQUIRE(library->pendingCount() == 0);
+  REQUIRE(library->failedCount() == 1);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
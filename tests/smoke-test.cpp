@@ -1,9 +1,16 @@
 #include <array>
+#include <cmath>
 #include <catch2/catch_test_macros.hpp>
 
 #include "dev-controller.h"
 #include "keymap.h"
 
+namespace {
+auto sameSteps(float actual, float expected) -> bool {
+  return std::abs(actual - expected) < 1.0e-6f;
+}
+} // namespace
+
 TEST_CASE("smoke", "[limit]") {
   // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
   REQUIRE(true);
@@ -74,6 +81,69 @@ TEST_CASE("dev controller encoder mapping", "[limit]") {
   // NOLINTEND(cppcoreguidelines-avoid-do-while)
 }
 
+TEST_CASE("dev controller encoder speed and acceleration", "[limit]") {
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  limit::DevControllerState state;
+  const auto turn = [&state](int encoder_index, const limit::DevEncoderTurn &encoder_turn) {
+    return limit::handleDevEncoderTurn(encoder_index, encoder_turn, state)
+        .value_or(limit::DevEncoderEvent{});
+  };
+
+  const auto fine = turn(0, {.detents = 1, .speed = limit::DevEncoderSpeed::kFine});
+  REQUIRE(sameSteps(fine.steps, 0.125f));
+  REQUIRE(fine.position == 16);
+  REQUIRE(fine.value == 0);
+
+  const auto coarse = turn(0, {.detents = -1, .speed = limit::DevEncoderSpeed::kCoarse});
+  REQUIRE(sameSteps(coarse.steps, -8.0f));
+  REQUIRE(coarse.position == 0);
+
+  REQUIRE(sameSteps(turn(1, {.detents = 1, .time_seconds = 1.0}).steps, 1.0f));
+  REQUIRE(sameSteps(turn(1, {.detents = 1, .time_seconds = 1.5}).steps, 1.0f));
+  const auto quick = turn(1, {.detents = 1, .time_seconds = 1.53});
+  REQUIRE(quick.steps > 3.9f);
+  REQUIRE(quick.steps < 4.1f);
+  REQUIRE(sameSteps(turn(1, {.detents = 1, .time_seconds = 1.531}).steps, 8.0f));
+  REQUIRE(sameSteps(turn(1, {.detents = -1, .time_seconds = 1.532}).steps, -1.0f));
+  REQUIRE_FALSE(limit::handleDevEncoderTurn(1, {.detents = 0}, state).has_value());
+
+  const auto reset = limit::handleDevEncoderAction(1, limit::DevEncoderAction::kReset, state)
+                         .value_or(limit::DevEncoderEvent{});
+  REQUIRE(reset.reset);
+  REQUIRE(sameSteps(reset.steps, 0.0f));
+  REQUIRE(reset.position == 64 * limit::kDevEncoderFineSteps);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("dev controller relative encoder CCs", "[limit]") {
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  using Mode = limit::DevRelativeMode;
+  REQUIRE(limit::decodeRelativeCc(1, Mode::kTwosComplement) == 1);
+  REQUIRE(limit::decodeRelativeCc(127, Mode::kTwosComplement) == -1);
+  REQUIRE(limit::decodeRelativeCc(125, Mode::kTwosComplement) == -3);
+  REQUIRE(limit::decodeRelativeCc(65, Mode::kBinaryOffset) == 1);
+  REQUIRE(limit::decodeRelativeCc(63, Mode::kBinaryOffset) == -1);
+  REQUIRE(limit::decodeRelativeCc(3, Mode::kSignMagnitude) == 3);
+  REQUIRE(limit::decodeRelativeCc(66, Mode::kSignMagnitude) == -2);
+
+  limit::DevControllerState state;
+  auto event = limit::handleDevEncoderCc(8, 3, -1.0, state);
+  const auto turned = event.value_or(limit::DevEncoderEvent{});
+  REQUIRE(event.has_value());
+  REQUIRE(state.encoder_bank == 1);
+  REQUIRE(turned.bank == 1);
+  REQUIRE(turned.encoder_index == 2);
+  REQUIRE(turned.cc == 8);
+  REQUIRE(sameSteps(turned.steps, 3.0f));
+  REQUIRE(turned.value == 3);
+
+  event = limit::handleDevEncoderCc(18, 1, -1.0, state);
+  REQUIRE_FALSE(event.has_value());
+  event = limit::handleDevEncoderCc(0, 0, -1.0, state);
+  REQUIRE_FALSE(event.has_value());
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
 TEST_CASE("dev controller pad mapping", "[limit]") {
   // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
   limit::DevControllerState state;
@@ -0,0 +1,183 @@
+#include "realtime-guard.h"
+#include "step-sequencer.h"
+
+#include <initializer_list>
+#include <cstdint>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+constexpr double kSampleRate = 48000.0;
+constexpr int kSamplesPerStep = 6000; // 16th notes at 120 BPM.
+constexpr int kMidiReserveBytes = 4096;
+constexpr std::uint8_t kVelocity = 100;
+
+struct TimedEvent {
+  std::int64_t sample = 0;
+  int note = 0;
+  bool note_on = false;
+
+  auto operator==(const TimedEvent &) const -> bool = default;
+};
+
+auto makePattern(int length, std::initializer_list<int> active_steps) -> limit::StepPattern {
+  limit::StepPattern pattern;
+  pattern.length = length;
+  for (const auto step : active_steps) {
+    auto &entry = pattern.steps.at(static_cast<std::size_t>(step));
+    entry.note = static_cast<std::uint8_t>(limit::kDefaultStepNote + step);
+    entry.velocity = kVelocity;
+  }
+  return pattern;
+}
+
+// Runs the sequencer for total_samples in blocks of block_size and returns
+// every event at its absolute sample position.
+auto runSequencer(limit::StepSequencer &sequencer, int block_size, std::int64_t total_samples)
+    -> std::vector<TimedEvent> {
+  std::vector<TimedEvent> events;
+  juce::MidiBuffer midi;
+  midi.ensureSize(kMidiReserveBytes);
+  for (std::int64_t position = 0; position < total_samples; position += block_size) {
+    midi.clear();
+    sequencer.process(midi, block_size);
+    for (const auto metadata : midi) {
+      const auto message = metadata.getMessage();
+      events.push_back({.sample = position + metadata.samplePosition,
+                        .note = message.getNoteNumber(),
+                        .note_on = message.isNoteOn()});
+    }
+  }
+  return events;
+}
+
+auto noteOnSamples(const std::vector<TimedEvent> &events) -> std::vector<std::int64_t> {
+  std::vector<std::int64_t> samples;
+  for (const auto &event : events) {
+    if (event.note_on) {
+      samples.push_back(event.sample);
+    }
+  }
+  return samples;
+}
+} // namespace
+
+TEST_CASE("Step sequencer places steps on exact sample boundaries", "[sequencer]") {
+  limit::StepSequencer sequencer;
+  sequencer.prepare(kSampleRate);
+  sequencer.setPattern(makePattern(4, {0, 1, 3}));
+  sequencer.start();
+  const auto events = runSequencer(sequencer, 250, kSamplesPerStep * 8);
+
+  const std::vector<std::int64_t> expected = {
+      0, kSamplesPerStep, kSamplesPerStep * 3, kSamplesPerStep * 4, kSamplesPerStep * 5,
+      kSamplesPerStep * 7};
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(noteOnSamples(events) == expected);
+  REQUIRE(events.front() == TimedEvent{.sample = 0, .note = 60, .note_on = true});
+  REQUIRE(events.at(1) ==
+          TimedEvent{.sample = kSamplesPerStep / 2, .note = 60, .note_on = false});
+  REQUIRE(sequencer.currentStep() == 3);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Step sequencer timing does not depend on block size", "[sequencer]") {
+  const auto render = [](int block_size) {
+    limit::StepSequencer sequencer;
+    sequencer.prepare(kSampleRate);
+    sequencer.setTempo(137.0);
+    sequencer.setSwing(0.3f);
+    sequencer.setPattern(makePattern(16, {0, 1, 2, 5, 7, 8, 11, 15}));
+    sequencer.start();
+    return runSequencer(sequencer, block_size, static_cast<std::int64_t>(kSampleRate) * 4);
+  };
+  const auto reference = render(1);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE_FALSE(reference.empty());
+  for (const auto block_size : {16, 37, 64, 512, 1024}) {
+    REQUIRE(render(block_size) == reference);
+  }
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Step sequencer delays odd steps by swing", "[sequencer]") {
+  constexpr float kSwing = 0.25f;
+  limit::StepSequencer sequencer;
+  sequencer.prepare(kSampleRate);
+  sequencer.setSwing(kSwing);
+  sequencer.setPattern(makePattern(2, {0, 1}));
+  sequencer.start();
+  const auto events = runSequencer(sequencer, 200, kSamplesPerStep * 4);
+
+  const std::vector<std::int64_t> expected = {
+      0, kSamplesPerStep + (kSamplesPerStep / 4), kSamplesPerStep * 2,
+      (kSamplesPerStep * 3) + (kSamplesPerStep / 4)};
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(noteOnSamples(events) == expected);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Step sequencer releases notes on stop and retrigger", "[sequencer]") {
+  limit::StepSequencer sequencer;
+  sequencer.prepare(kSampleRate);
+  auto pattern = makePattern(1, {0});
+  pattern.steps.front().gate = 1.0f;
+  sequencer.setPattern(pattern);
+  sequencer.start();
+  const auto events = runSequencer(sequencer, 1000, kSamplesPerStep + 1);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(events.size() == 3);
+  REQUIRE(events.at(1) ==
+          TimedEvent{.sample = kSamplesPerStep, .note = 60, .note_on = false});
+  REQUIRE(events.at(2) == TimedEvent{.sample = kSamplesPerStep, .note = 60, .note_on = true});
+
+  sequencer.stop();
+  const auto stopped = runSequencer(sequencer, 64, 64);
+  REQUIRE(stopped == std::vector<TimedEvent>{{.sample = 0, .note = 60, .note_on = false}});
+  REQUIRE(sequencer.currentStep() == -1);
+  REQUIRE(runSequencer(sequencer, 64, 64).empty());
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Step sequencer picks up pattern edits at the next block", "[sequencer]") {
+  limit::StepSequencer sequencer;
+  sequencer.prepare(kSampleRate);
+  sequencer.setPattern(makePattern(4, {}));
+  sequencer.start();
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(runSequencer(sequencer, 1000, kSamplesPerStep).empty());
+  sequencer.setPattern(makePattern(4, {1, 2}));
+  const auto events = runSequencer(sequencer, 1000, kSamplesPerStep * 2);
+  REQUIRE(noteOnSamples(events) == std::vector<std::int64_t>{0, kSamplesPerStep});
+  REQUIRE(events.front().note == 61);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Step sequencer does not allocate on the audio thread", "[sequencer][realtime]") {
+  if (!limit::isAllocationTrapEnabled()) {
+    SKIP("Needs the allocation trap (LIMIT_ALLOCATION_TRAP=ON)");
+  }
+  limit::StepSequencer sequencer;
+  sequencer.prepare(kSampleRate);
+  sequencer.setPattern(makePattern(16, {0, 2, 4, 6, 8, 10, 12, 14}));
+  sequencer.start();
+  juce::MidiBuffer midi;
+  midi.ensureSize(kMidiReserveBytes);
+
+  const auto before = limit::realtimeAllocationCount();
+  {
+    const limit::ScopedRealtimeSection realtime_section;
+    for (int block = 0; block < 64; ++block) {
+      midi.clear();
+      sequencer.process(midi, 1024);
+    }
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(limit::realtimeAllocationCount() == before);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
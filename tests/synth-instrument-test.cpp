@@ -0,0 +1,103 @@
+#include "realtime-guard.h"
+#include "synth-instrument.h"
+
+#include <memory>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+constexpr double kSampleRate = 48000.0;
+constexpr int kBlockSize = 256;
+constexpr int kMidiReserveBytes = 4096;
+constexpr auto kVelocity = static_cast<juce::uint8>(100);
+
+auto makeSineInstrument(int voice_count,
+                        limit::VoiceStealPolicy policy = limit::VoiceStealPolicy::kQuietest)
+    -> limit::SynthInstrument {
+  return limit::SynthInstrument(
+      [] { return std::make_unique<limit::SineVoiceEngine>(); }, voice_count, policy);
+}
+
+auto firstNonZeroSample(const juce::AudioBuffer<float> &buffer) -> int {
+  for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
+    if (!juce::exactlyEqual(buffer.getSample(0, sample), 0.0f)) {
+      return sample;
+    }
+  }
+  return -1;
+}
+} // namespace
+
+TEST_CASE("Synth instrument starts notes on the event sample", "[voices]") {
+  constexpr int kOnset = 97;
+  auto instrument = makeSineInstrument(limit::kMaxVoices);
+  instrument.prepare(kSampleRate, kBlockSize);
+
+  juce::MidiBuffer midi;
+  midi.addEvent(juce::MidiMessage::noteOn(1, 69, kVelocity), kOnset);
+  juce::AudioBuffer<float> output(2, kBlockSize);
+  output.clear();
+  instrument.render(output, midi, kBlockSize);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  // The oscillator starts at phase zero, so the first audible sample is the
+  // one after the onset.
+  REQUIRE(firstNonZeroSample(output) == kOnset + 1);
+  REQUIRE(instrument.activeVoiceCount() == 1);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Synth instrument steals voices when the pool is full", "[voices]") {
+  constexpr int kVoiceCount = 4;
+  auto instrument = makeSineInstrument(kVoiceCount, limit::VoiceStealPolicy::kOldest);
+  instrument.prepare(kSampleRate, kBlockSize);
+
+  juce::MidiBuffer midi;
+  for (int note = 60; note < 60 + kVoiceCount + 2; ++note) {
+    midi.addEvent(juce::MidiMessage::noteOn(1, note, kVelocity), note - 60);
+  }
+  juce::AudioBuffer<float> output(2, kBlockSize);
+  output.clear();
+  instrument.render(output, midi, kBlockSize);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(instrument.activeVoiceCount() == kVoiceCount);
+  REQUIRE(instrument.allocator().voiceForNote(60 + kVoiceCount + 1) >= 0);
+  REQUIRE(instrument.allocator().voiceForNote(60) == -1);
+
+  midi.clear();
+  midi.addEvent(juce::MidiMessage::controllerEvent(1, 123, 0), 0);
+  for (int block = 0; block < 40; ++block) {
+    output.clear();
+    instrument.render(output, midi, kBlockSize);
+    midi.clear();
+  }
+  REQUIRE(instrument.activeVoiceCount() == 0);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Synth instrument does not allocate on the audio thread", "[voices][realtime]") {
+  if (!limit::isAllocationTrapEnabled()) {
+    SKIP("Needs the allocation trap (LIMIT_ALLOCATION_TRAP=ON)");
+  }
+  auto instrument = makeSineInstrument(limit::kMaxVoices);
+  instrument.prepare(kSampleRate, kBlockSize);
+
+  juce::MidiBuffer midi;
+  midi.ensureSize(kMidiReserveBytes);
+  juce::AudioBuffer<float> output(2, kBlockSize);
+
+  const auto before = limit::realtimeAllocationCount();
+  {
+    const limit::ScopedRealtimeSection realtime_section;
+    for (int note = 0; note < limit::kMaxVoices * 2; ++note) {
+      midi.addEvent(juce::MidiMessage::noteOn(1, 40 + note, kVelocity), note);
+    }
+    output.clear();
+    instrument.render(output, midi, kBlockSize);
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(limit::realtimeAllocationCount() == before);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
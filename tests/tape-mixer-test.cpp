@@ -0,0 +1,146 @@
+#include "realtime-guard.h"
+#include "tape-mixer.h"
+
+#include <cmath>
+#include <string>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+constexpr double kSampleRate = 48000.0;
+constexpr float kTolerance = 1.0e-5f;
+
+auto near(float actual, float expected) -> bool { return std::abs(actual - expected) < kTolerance; }
+
+struct MixerBuses {
+  explicit MixerBuses(int block_size)
+      : tape(limit::kStereoChannelCount * limit::kTapeTrackCount, block_size),
+        master(limit::kStereoChannelCount, block_size),
+        send1(limit::kStereoChannelCount, block_size),
+        send2(limit::kStereoChannelCount, block_size) {
+    for (int channel = 0; channel < tape.getNumChannels(); ++channel) {
+      juce::FloatVectorOperations::fill(tape.getWritePointer(channel), 1.0f, block_size);
+    }
+  }
+
+  void clearOutputs() {
+    master.clear();
+    send1.clear();
+    send2.clear();
+  }
+
+  juce::AudioBuffer<float> tape;
+  juce::AudioBuffer<float> master;
+  juce::AudioBuffer<float> send1;
+  juce::AudioBuffer<float> send2;
+};
+} // namespace
+
+TEST_CASE("Track gains follow level, pan and sends", "[mixer]") {
+  constexpr float kLevel = 0.5f;
+  constexpr float kSend = 0.5f;
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  const auto centre = limit::computeTrackGains({});
+  REQUIRE(near(centre.master_left, 1.0f));
+  REQUIRE(near(centre.master_right, 1.0f));
+  REQUIRE(near(centre.send1, 0.0f));
+
+  const auto hard_left = limit::computeTrackGains({.level = 1.0f, .pan = -1.0f});
+  REQUIRE(near(hard_left.master_left, 1.0f));
+  REQUIRE(near(hard_left.master_right, 0.0f));
+
+  const auto hard_right = limit::computeTrackGains({.level = 1.0f, .pan = 1.0f});
+  REQUIRE(near(hard_right.master_left, 0.0f));
+  REQUIRE(near(hard_right.master_right, 1.0f));
+
+  const auto sends =
+      limit::computeTrackGains({.level = kLevel, .pan = 0.0f, .send1 = kSend, .send2 = 1.0f});
+  REQUIRE(near(sends.master_left, kLevel));
+  REQUIRE(near(sends.send1, kLevel * kSend));
+  REQUIRE(near(sends.send2, kLevel));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape mixer sums tracks into master and sends with gain ramps", "[mixer]") {
+  constexpr int kBlockSize = 64;
+  constexpr float kLevel = 0.5f;
+  constexpr float kSend = 0.25f;
+  constexpr auto kTracks = static_cast<float>(limit::kTapeTrackCount);
+  limit::TapeMixer mixer;
+  mixer.prepare(kSampleRate, kBlockSize);
+  MixerBuses buses(kBlockSize);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  mixer.mix(buses.tape, buses.master, buses.send1, buses.send2, kBlockSize);
+  REQUIRE(near(buses.master.getSample(0, 0), kTracks));
+  REQUIRE(near(buses.send1.getSample(0, kBlockSize - 1), 0.0f));
+
+  for (int track = 0; track < limit::kTapeTrackCount; ++track) {
+    mixer.setTrackRamp(track, {}, {.level = kLevel, .pan = 0.0f, .send1 = kSend, .send2 = 0.0f});
+  }
+  buses.clearOutputs();
+  mixer.mix(buses.tape, buses.master, buses.send1, buses.send2, kBlockSize);
+  const auto first_gain = 1.0f + ((kLevel - 1.0f) / static_cast<float>(kBlockSize));
+  REQUIRE(near(buses.master.getSample(0, 0), kTracks * first_gain));
+  REQUIRE(near(buses.master.getSample(1, kBlockSize - 1), kTracks * kLevel));
+  REQUIRE(near(buses.send1.getSample(0, kBlockSize - 1), kTracks * kLevel * kSend));
+  REQUIRE(near(buses.send2.getSample(1, kBlockSize - 1), 0.0f));
+
+  buses.clearOutputs();
+  mixer.mix(buses.tape, buses.master, buses.send1, buses.send2, kBlockSize);
+  REQUIRE(near(buses.master.getSample(0, 0), kTracks * kLevel));
+  REQUIRE(near(buses.send1.getSample(1, 0), kTracks * kLevel * kSend));
+
+  // Settings without a ramp take effect from the first sample.
+  for (int track = 0; track < limit::kTapeTrackCount; ++track) {
+    mixer.setTrackSettings(track, {});
+  }
+  buses.clearOutputs();
+  mixer.mix(buses.tape, buses.master, buses.send1, buses.send2, kBlockSize);
+  REQUIRE(near(buses.master.getSample(0, 0), kTracks));
+  REQUIRE(near(buses.send1.getSample(0, 0), 0.0f));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape mixer does not allocate while mixing", "[mixer][realtime]") {
+  if (!limit::isAllocationTrapEnabled()) {
+    SKIP("Needs the allocation trap (LIMIT_ALLOCATION_TRAP=ON)");
+  }
+  constexpr int kBlockSize = 128;
+  limit::TapeMixer mixer;
+  mixer.prepare(kSampleRate, kBlockSize);
+  MixerBuses buses(kBlockSize);
+  mixer.setTrackSettings(0, {.level = 0.5f, .pan = -0.5f, .send1 = 1.0f, .send2 = 1.0f});
+
+  const auto before = limit::realtimeAllocationCount();
+  {
+    const limit::ScopedRealtimeSection realtime_section;
+    mixer.mix(buses.tape, buses.master, buses.send1, buses.send2, kBlockSize);
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(limit::realtimeAllocationCount() == before);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+// Hidden from the default run; use `limit-tests "[benchmark]"`. Catch reports
+// the mean time per iteration, i.e. ns per block at 48 kHz.
+TEST_CASE("Tape mixer block cost", "[.][benchmark][mixer]") {
+  constexpr int kMinBlockSize = 32;
+  constexpr int kMaxBlockSize = 1024;
+  for (int block_size = kMinBlockSize; block_size <= kMaxBlockSize; block_size *= 2) {
+    limit::TapeMixer mixer;
+    mixer.prepare(kSampleRate, block_size);
+    MixerBuses buses(block_size);
+    auto toggle = false;
+
+    BENCHMARK("tape mixer " + std::to_string(block_size) + " samples") {
+      toggle = !toggle;
+      mixer.setTrackRamp(0, {.level = toggle ? 0.5f : 1.0f}, {.level = toggle ? 1.0f : 0.5f});
+      mixer.mix(buses.tape, buses.master, buses.send1, buses.send2, block_size);
+      return buses.master.getSample(0, 0);
+    };
+  }
+}
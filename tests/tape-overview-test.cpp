@@ -0,0 +1,111 @@
+#include "tape-overview.h"
+
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+constexpr int kBucketFrames = 64;
+constexpr std::int64_t kFrames = 64 * 1000;
+constexpr float kTolerance = 1.0e-4f;
+
+auto near(float actual, float expected) -> bool { return std::abs(actual - expected) < kTolerance; }
+} // namespace
+
+TEST_CASE("Tape overview builds a pyramid up to one bucket", "[tape][overview]") {
+  const limit::TapeOverview overview(2, kFrames, kBucketFrames);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(overview.bucketCount(0) == 1000);
+  REQUIRE(overview.bucketCount(1) == 500);
+  REQUIRE(overview.bucketCount(overview.levelCount() - 1) == 1);
+  REQUIRE(overview.bucketFrames(1) == 2 * kBucketFrames);
+  REQUIRE(overview.memoryBytes() < 2 * 2 * 1000 * sizeof(std::uint32_t) + 64);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape overview follows sequential recording", "[tape][overview]") {
+  constexpr int kBlock = 48;
+  limit::TapeOverview overview(1, kFrames, kBucketFrames);
+  std::vector<float> left(kBlock);
+  std::vector<float> right(kBlock);
+
+  // First pass records a loud burst, second pass overwrites it with a quiet
+  // signal: buckets must shrink back rather than keep the old peaks.
+  for (const auto level : {0.9f, 0.25f}) {
+    for (std::int64_t start = 0; start < kBucketFrames * 8; start += kBlock) {
+      for (int frame = 0; frame < kBlock; ++frame) {
+        left.at(static_cast<std::size_t>(frame)) = level;
+        right.at(static_cast<std::size_t>(frame)) = -level;
+      }
+      overview.write(0, start, left, right);
+    }
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  for (int index = 0; index < 8; ++index) {
+    const auto bucket = overview.bucket(0, 0, index);
+    REQUIRE(near(bucket.max, 0.25f));
+    REQUIRE(near(bucket.min, -0.25f));
+  }
+  const auto top = overview.bucket(0, overview.levelCount() - 1, 0);
+  REQUIRE(near(top.max, 0.25f));
+  REQUIRE(near(overview.bucket(0, 0, 9).max, 0.0f));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape overview renders any zoom from a few buckets", "[tape][overview]") {
+  limit::TapeOverview overview(1, kFrames, kBucketFrames);
+  std::vector<float> interleaved(static_cast<std::size_t>(kBucketFrames) * 2, 0.0f);
+  interleaved.at(10) = 0.5f;
+  interleaved.at(11) = -0.75f;
+  const std::int64_t spike_frame = kBucketFrames * 700;
+  overview.writeInterleaved(0, spike_frame, interleaved);
+
+  std::vector<limit::OverviewBucket> columns(100);
+  overview.render(0, 0, kFrames, columns);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(near(columns.at(70).max, 0.5f));
+  REQUIRE(near(columns.at(70).min, -0.75f));
+  REQUIRE(near(columns.at(10).max, 0.0f));
+
+  overview.render(0, spike_frame, spike_frame + kBucketFrames, columns);
+  REQUIRE(near(columns.front().max, 0.5f));
+  REQUIRE(near(columns.back().min, -0.75f));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape overview keeps the peaks of concurrent writers", "[tape][overview]") {
+  constexpr int kPasses = 8;
+  limit::TapeOverview overview(1, kFrames, kBucketFrames);
+  const auto bucket_count = overview.bucketCount(0);
+
+  // Both writers widen every bucket from a frame past its start, one with
+  // rising peaks and one with falling troughs, so any lost update shows up
+  // as a bucket or parent missing one of the extremes.
+  const auto widen = [&overview, bucket_count](int offset, float sign) {
+    for (int pass = 1; pass <= kPasses; ++pass) {
+      const std::vector<float> level(1, sign * static_cast<float>(pass) / kPasses);
+      for (std::int64_t index = 0; index < bucket_count; ++index) {
+        overview.write(0, (index * kBucketFrames) + offset, level, level);
+      }
+    }
+  };
+  std::thread rising(widen, 1, 1.0f);
+  std::thread falling(widen, 2, -1.0f);
+  rising.join();
+  falling.join();
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  for (int level = 0; level < overview.levelCount(); ++level) {
+    for (std::int64_t index = 0; index < overview.bucketCount(level); ++index) {
+      const auto bucket = overview.bucket(0, level, index);
+      REQUIRE(near(bucket.max, 1.0f));
+      REQUIRE(near(bucket.min, -1.0f));
+    }
+  }
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
@@ -0,0 +1,250 @@
+#include "tape-storage.h"
+#include "test-files.h"
+
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+using limit::test::TempDirectory;
+
+constexpr int kTestSampleRate = 8192;
+constexpr int kTestChunkFrames = 512;
+constexpr int kTestTracks = 2;
+constexpr int kTestPrefetchChunks = 2;
+constexpr int kTestRetainChunks = 1;
+constexpr int kTestBlock = 64;
+
+auto makeTestConfig(const std::filesystem::path &directory) -> limit::TapeStorageConfig {
+  return {.directory = directory,
+          .track_count = kTestTracks,
+          .sample_rate = kTestSampleRate,
+          .length_seconds = 1,
+          .chunk_frames = kTestChunkFrames,
+          .prefetch_chunks = kTestPrefetchChunks,
+          .retain_chunks = kTestRetainChunks};
+}
+} // namespace
+
+TEST_CASE("Tape storage maps tracks lazily", "[tape]") {
+  const TempDirectory directory("tape-test-lazy");
+  auto storage = limit::TapeStorage::open(makeTestConfig(directory.get()));
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(storage != nullptr);
+  REQUIRE(storage->frameCount() == kTestSampleRate);
+  REQUIRE(storage->chunkCount() == kTestSampleRate / kTestChunkFrames);
+  REQUIRE(storage->residentChunkCount() == 0);
+  REQUIRE(std::filesystem::exists(directory.get() / "track-1.wav"));
+  REQUIRE(std::filesystem::exists(directory.get() / "track-2.wav"));
+
+  std::ifstream file(directory.get() / "track-1.wav", std::ios::binary);
+  std::array<char, 4> riff{};
+  file.read(riff.data(), riff.size());
+  REQUIRE(std::string(riff.begin(), riff.end()) == "RIFF");
+
+  std::array<float, kTestBlock> left{};
+  std::array<float, kTestBlock> right{};
+  left.fill(1.0f);
+  REQUIRE_FALSE(storage->readFrames(0, 0, left, right));
+  REQUIRE(left == std::array<float, kTestBlock>{});
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape storage records and plays back resident chunks", "[tape]") {
+  const TempDirectory directory("tape-test-roundtrip");
+  constexpr std::int64_t kStartFrame = kTestChunkFrames - (kTestBlock / 2);
+  constexpr float kLeftLevel = 0.5f;
+  constexpr float kRightLevel = -0.25f;
+
+  std::array<float, kTestBlock> left{};
+  std::array<float, kTestBlock> right{};
+  left.fill(kLeftLevel);
+  right.fill(kRightLevel);
+
+  {
+    auto storage = limit::TapeStorage::open(makeTestConfig(directory.get()));
+    // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+    REQUIRE(storage != nullptr);
+    storage->setRecordTrack(1);
+    REQUIRE_FALSE(storage->writeFrames(1, kStartFrame, left, right));
+
+    storage->service();
+    REQUIRE(storage->residentChunkCount() == kTestTracks * (kTestPrefetchChunks + 1));
+    REQUIRE(storage->writeFrames(1, kStartFrame, left, right));
+    REQUIRE(storage->isChunkDirty(1, 0));
+    REQUIRE(storage->isChunkDirty(1, 1));
+
+    std::array<float, kTestBlock> read_left{};
+    std::array<float, kTestBlock> read_right{};
+    REQUIRE(storage->readFrames(1, kStartFrame, read_left, read_right));
+    REQUIRE(read_left == left);
+    REQUIRE(read_right == right);
+
+    storage->flush();
+    REQUIRE_FALSE(storage->isChunkDirty(1, 0));
+    // NOLINTEND(cppcoreguidelines-avoid-do-while)
+  }
+
+  auto reopened = limit::TapeStorage::open(makeTestConfig(directory.get()));
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(reopened != nullptr);
+  reopened->service();
+  std::array<float, kTestBlock> read_left{};
+  std::array<float, kTestBlock> read_right{};
+  REQUIRE(reopened->readFrames(1, kStartFrame, read_left, read_right));
+  REQUIRE(read_left == left);
+  REQUIRE(read_right == right);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape storage summarises existing and new audio", "[tape][overview]") {
+  const TempDirectory directory("tape-test-overview");
+  constexpr std::int64_t kEarlyFrame = 100;
+  constexpr std::int64_t kLateFrame = kTestSampleRate - kTestBlock;
+  constexpr float kEarlyLevel = 0.5f;
+  constexpr float kLateLevel = 0.125f;
+  std::array<float, kTestBlock> samples{};
+  samples.fill(kEarlyLevel);
+  {
+    auto storage = limit::TapeStorage::open(makeTestConfig(directory.get()));
+    // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+    REQUIRE(storage != nullptr);
+    REQUIRE(storage->writeFramesOffline(0, kEarlyFrame, samples, samples));
+    const auto &overview = storage->overview();
+    REQUIRE(overview.bucket(0, 0, kEarlyFrame / limit::kOverviewBucketFrames).max > 0.4f);
+    // NOLINTEND(cppcoreguidelines-avoid-do-while)
+  }
+
+  auto reopened = limit::TapeStorage::open(makeTestConfig(directory.get()));
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(reopened != nullptr);
+  const auto &overview = reopened->overview();
+  const auto top_level = overview.levelCount() - 1;
+  REQUIRE(overview.bucket(0, top_level, 0).max < 0.1f);
+  while (!reopened->isOverviewScanComplete()) {
+    reopened->service();
+  }
+  REQUIRE(overview.bucket(0, top_level, 0).max > 0.4f);
+  REQUIRE(overview.bucket(1, top_level, 0).max < 0.1f);
+
+  samples.fill(kLateLevel);
+  REQUIRE(reopened->writeFramesOffline(1, kLateFrame, samples, samples));
+  REQUIRE(overview.bucket(1, top_level, 0).max > 0.1f);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape storage keeps the resident set bounded to the window", "[tape]") {
+  const TempDirectory directory("tape-test-window");
+  auto storage = limit::TapeStorage::open(makeTestConfig(directory.get()));
+  constexpr int kWindowChunks = kTestRetainChunks + 1 + kTestPrefetchChunks;
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(storage != nullptr);
+  for (std::int64_t frame = 0; frame < storage->frameCount(); frame += kTestChunkFrames) {
+    storage->setPlayhead(frame);
+    storage->service();
+    REQUIRE(storage->residentChunkCount() <= kTestTracks * kWindowChunks);
+    REQUIRE(storage->isChunkResident(0, frame / kTestChunkFrames));
+  }
+  REQUIRE_FALSE(storage->isChunkResident(0, 0));
+  REQUIRE(storage->residentBytes() <=
+          static_cast<std::size_t>(kTestTracks * kWindowChunks * kTestChunkFrames) * 2 *
+              sizeof(float));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape storage follows a locate and writes back offline chunks", "[tape]") {
+  const TempDirectory directory("tape-test-locate");
+  auto storage = limit::TapeStorage::open(makeTestConfig(directory.get()));
+  constexpr std::int64_t kFarChunk = 12;
+  std::array<float, kTestBlock> samples{};
+  samples.fill(0.5f);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(storage != nullptr);
+  storage->service();
+  REQUIRE(storage->writeFrames(0, 0, samples, samples));
+
+  // A reader inside a block keeps its window readable across the eviction.
+  storage->beginAudioBlock();
+  const auto window = storage->residentFrames(0, 0, kTestBlock);
+  REQUIRE(window.size() == kTestBlock * 2);
+  storage->setPlayhead(kFarChunk * kTestChunkFrames);
+  storage->service();
+  REQUIRE_FALSE(storage->isChunkResident(0, 0));
+  REQUIRE(window.front() == 0.5f);
+  storage->endAudioBlock();
+  storage->service();
+  REQUIRE(storage->isChunkResident(1, kFarChunk));
+  REQUIRE(storage->residentFrames(0, 0, kTestBlock).empty());
+
+  REQUIRE(storage->writeFramesOffline(1, 0, samples, samples));
+  REQUIRE_FALSE(storage->isChunkDirty(1, 0));
+  REQUIRE(storage->writeFramesOffline(1, kFarChunk * kTestChunkFrames, samples, samples));
+  REQUIRE(storage->isChunkDirty(1, kFarChunk));
+  storage->service();
+  REQUIRE_FALSE(storage->isChunkDirty(1, kFarChunk));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape storage prefetches on its service thread", "[tape]") {
+  const TempDirectory directory("tape-test-thread");
+  auto storage = limit::TapeStorage::open(makeTestConfig(directory.get()));
+  constexpr auto kTimeout = std::chrono::seconds(2);
+  constexpr auto kPollInterval = std::chrono::milliseconds(1);
+  constexpr std::int64_t kPlayheadChunk = 4;
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(storage != nullptr);
+  storage->setPlayhead(kPlayheadChunk * kTestChunkFrames);
+  storage->start();
+  const auto deadline = std::chrono::steady_clock::now() + kTimeout;
+  while (!storage->isChunkResident(0, kPlayheadChunk + kTestPrefetchChunks) &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(kPollInterval);
+  }
+  storage->stop();
+  REQUIRE(storage->isChunkResident(0, kPlayheadChunk + kTestPrefetchChunks));
+  REQUIRE_FALSE(storage->isChunkResident(0, 0));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape storage rejects invalid configurations", "[tape]") {
+  const TempDirectory directory("tape-test-invalid");
+  auto config = makeTestConfig(directory.get());
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  auto unaligned = config;
+  unaligned.chunk_frames = kTestChunkFrames + 1;
+  REQUIRE(limit::TapeStorage::open(unaligned) == nullptr);
+
+  REQUIRE(limit::TapeStorage::open(config) != nullptr);
+  auto resized = config;
+  resized.length_seconds = 2;
+  REQUIRE(limit::TapeStorage::open(resized) == nullptr);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape storage can refuse to create missing tracks", "[tape]") {
+  const TempDirectory directory("tape-test-existing");
+  auto config = makeTestConfig(directory.get());
+  config.create_missing = false;
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(limit::TapeStorage::open(config) == nullptr);
+  REQUIRE(std::filesystem::is_empty(directory.get()));
+  std::ofstream(directory.get() / "track-1.wav").close();
+  REQUIRE(limit::TapeStorage::open(config) == nullptr);
+  REQUIRE(std::filesystem::file_size(directory.get() / "track-1.wav") == 0);
+
+  std::filesystem::remove(directory.get() / "track-1.wav");
+  REQUIRE(limit::TapeStorage::open(makeTestConfig(directory.get())) != nullptr);
+  REQUIRE(limit::TapeStorage::open(config) != nullptr);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
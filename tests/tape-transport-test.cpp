@@ -0,0 +1,360 @@
+#include "realtime-guard.h"
+#include "tape-transport.h"
+#include "test-files.h"
+
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+using limit::test::TempDirectory;
+
+constexpr int kTestSampleRate = 8192;
+constexpr int kTestChunkFrames = 512;
+constexpr int kTestBlock = 64;
+constexpr float kLeftLevel = 0.5f;
+constexpr float kRightLevel = -0.25f;
+constexpr float kTolerance = 1.0e-3f;
+
+auto near(float actual, float expected) -> bool { return std::abs(actual - expected) < kTolerance; }
+
+// One second of tape whose whole length fits in the prefetch window, with
+// constant levels on every track and a frame-number ramp on the left of
+// track 0 so positions can be read back.
+auto openTestTape(const std::filesystem::path &directory) -> std::unique_ptr<limit::TapeStorage> {
+  auto storage = limit::TapeStorage::open({.directory = directory,
+                                           .sample_rate = kTestSampleRate,
+                                           .length_seconds = 1,
+                                           .chunk_frames = kTestChunkFrames,
+                                           .prefetch_chunks = kTestSampleRate / kTestChunkFrames,
+                                           .retain_chunks = 0});
+  if (storage == nullptr) {
+    return nullptr;
+  }
+  std::vector<float> left(static_cast<std::size_t>(storage->frameCount()), kLeftLevel);
+  const std::vector<float> right(left.size(), kRightLevel);
+  for (int track = 1; track < storage->trackCount(); ++track) {
+    storage->writeFramesOffline(track, 0, left, right);
+  }
+  for (std::size_t frame = 0; frame < left.size(); ++frame) {
+    left[frame] = static_cast<float>(frame);
+  }
+  storage->writeFramesOffline(0, 0, left, right);
+  storage->service();
+  return storage;
+}
+
+void renderBlocks(limit::TapeTransport &transport, limit::TapeStorage &storage,
+                  juce::AudioBuffer<float> &tape, int blocks) {
+  for (int block = 0; block < blocks; ++block) {
+    tape.clear();
+    transport.render(storage, tape, kTestBlock);
+  }
+}
+} // namespace
+
+TEST_CASE("Tape kernels pass DC at unity gain", "[tape][transport]") {
+  const auto &kernels = limit::tapeKernels();
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  for (int bank = 0; bank < limit::kTapeKernelBankCount; ++bank) {
+    for (int phase = 0; phase <= limit::kTapeInterpolationPhases; phase += 32) {
+      const auto row = kernels.row(bank, phase);
+      auto left = 0.0f;
+      auto right = 0.0f;
+      for (std::size_t tap = 0; tap < row.size(); tap += 2) {
+        left += row[tap];
+        right += row[tap + 1];
+      }
+      REQUIRE(near(left, 1.0f));
+      REQUIRE(near(right, 1.0f));
+    }
+  }
+  REQUIRE(limit::TapeKernels::bankForRate(0.5) == 0);
+  REQUIRE(limit::TapeKernels::bankForRate(-1.0) == 0);
+  REQUIRE(limit::TapeKernels::bankForRate(1.2) == 1);
+  REQUIRE(limit::TapeKernels::bankForRate(limit::kTapeMaxSpeed) ==
+          limit::kTapeKernelBankCount - 1);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape transport copies tape exactly at unity speed", "[tape][transport]") {
+  const TempDirectory directory("transport-test-unity");
+  auto storage = openTestTape(directory.get());
+  REQUIRE(storage != nullptr); // NOLINT(cppcoreguidelines-avoid-do-while)
+  limit::TapeTransport transport;
+  transport.prepare(kTestSampleRate, kTestBlock);
+  juce::AudioBuffer<float> tape(limit::kStereoChannelCount * limit::kTapeTrackCount, kTestBlock);
+
+  constexpr int kStartFrame = 1000;
+  transport.locate(kStartFrame);
+  transport.play();
+  // Spin up to speed, then land on a whole frame again.
+  renderBlocks(transport, *storage, tape, 4);
+  transport.locate(kStartFrame);
+  renderBlocks(transport, *storage, tape, 1);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  for (int sample = 0; sample < kTestBlock; ++sample) {
+    REQUIRE(juce::exactlyEqual(tape.getSample(0, sample),
+                               static_cast<float>(kStartFrame + sample)));
+    REQUIRE(juce::exactlyEqual(tape.getSample(2, sample), kLeftLevel));
+    REQUIRE(juce::exactlyEqual(tape.getSample(3, sample), kRightLevel));
+  }
+  REQUIRE(transport.position() == kStartFrame + kTestBlock);
+  REQUIRE(transport.underrunCount() == 0);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape transport varies speed and direction smoothly", "[tape][transport]") {
+  const TempDirectory directory("transport-test-speed");
+  auto storage = openTestTape(directory.get());
+  REQUIRE(storage != nullptr); // NOLINT(cppcoreguidelines-avoid-do-while)
+  limit::TapeTransport transport;
+  transport.prepare(kTestSampleRate, kTestBlock);
+  juce::AudioBuffer<float> tape(limit::kStereoChannelCount * limit::kTapeTrackCount, kTestBlock);
+
+  constexpr int kStartFrame = 4000;
+  constexpr float kHalfSpeed = 0.5f;
+  transport.locate(kStartFrame);
+  transport.setSpeed(kHalfSpeed);
+  transport.play();
+  renderBlocks(transport, *storage, tape, 4);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  // Once up to speed the ramp on track 0 rises half a frame per sample and
+  // the constant tracks read back their level.
+  const auto step = tape.getSample(0, kTestBlock - 1) - tape.getSample(0, kTestBlock - 2);
+  REQUIRE(near(step, kHalfSpeed));
+  REQUIRE(near(tape.getSample(2, kTestBlock - 1), kLeftLevel));
+  REQUIRE(near(tape.getSample(3, kTestBlock - 1), kRightLevel));
+  const auto forward_position = transport.position();
+  REQUIRE(forward_position > kStartFrame);
+  REQUIRE(forward_position < kStartFrame + (2 * kTestBlock));
+
+  transport.setReverse(true);
+  renderBlocks(transport, *storage, tape, 8);
+  REQUIRE(transport.position() < forward_position);
+  const auto reverse_step =
+      tape.getSample(0, kTestBlock - 1) - tape.getSample(0, kTestBlock - 2);
+  REQUIRE(near(reverse_step, -kHalfSpeed));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape transport brakes to silence and spins back up", "[tape][transport]") {
+  const TempDirectory directory("transport-test-brake");
+  auto storage = openTestTape(directory.get());
+  REQUIRE(storage != nullptr); // NOLINT(cppcoreguidelines-avoid-do-while)
+  limit::TapeTransport transport;
+  transport.prepare(kTestSampleRate, kTestBlock);
+  juce::AudioBuffer<float> tape(limit::kStereoChannelCount * limit::kTapeTrackCount, kTestBlock);
+
+  constexpr float kBrakeSeconds = 0.05f;
+  const auto brake_blocks =
+      static_cast<int>(std::ceil(kBrakeSeconds * kTestSampleRate / kTestBlock)) + 1;
+  transport.setBrakeSeconds(kBrakeSeconds);
+  transport.play();
+  renderBlocks(transport, *storage, tape, 4);
+  transport.setBrake(true);
+  renderBlocks(transport, *storage, tape, brake_blocks);
+  const auto stopped_at = transport.position();
+  renderBlocks(transport, *storage, tape, 1);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(transport.position() == stopped_at);
+  REQUIRE(transport.isPlaying());
+  for (int sample = 0; sample < kTestBlock; ++sample) {
+    REQUIRE(juce::exactlyEqual(tape.getSample(2, sample), 0.0f));
+  }
+
+  transport.setBrake(false);
+  renderBlocks(transport, *storage, tape, brake_blocks);
+  REQUIRE(transport.position() > stopped_at);
+  REQUIRE(near(tape.getSample(2, kTestBlock - 1), kLeftLevel));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape transport wraps inside a loop", "[tape][transport]") {
+  const TempDirectory directory("transport-test-loop");
+  auto storage = openTestTape(directory.get());
+  REQUIRE(storage != nullptr); // NOLINT(cppcoreguidelines-avoid-do-while)
+  limit::TapeTransport transport;
+  transport.prepare(kTestSampleRate, kTestBlock);
+  juce::AudioBuffer<float> tape(limit::kStereoChannelCount * limit::kTapeTrackCount, kTestBlock);
+
+  constexpr int kLoopStart = 2000;
+  constexpr int kLoopEnd = kLoopStart + 100;
+  transport.locate(kLoopStart);
+  transport.setLoop(kLoopStart, kLoopEnd);
+  transport.play();
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  for (int block = 0; block < 16; ++block) {
+    renderBlocks(transport, *storage, tape, 1);
+    REQUIRE(transport.position() >= kLoopStart);
+    REQUIRE(transport.position() < kLoopEnd);
+  }
+  transport.clearLoop();
+  renderBlocks(transport, *storage, tape, 4);
+  REQUIRE(transport.position() >= kLoopEnd);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape transport plays a loop longer than the storage window", "[tape][transport]") {
+  const TempDirectory directory("transport-test-long-loop");
+  // Default prefetch and retain, so only part of the loop is ever resident.
+  auto storage = limit::TapeStorage::open({.directory = directory.get(),
+                                           .sample_rate = kTestSampleRate,
+                                           .length_seconds = 2,
+                                           .chunk_frames = kTestChunkFrames});
+  REQUIRE(storage != nullptr); // NOLINT(cppcoreguidelines-avoid-do-while)
+  const std::vector<float> left(static_cast<std::size_t>(storage->frameCount()), kLeftLevel);
+  const std::vector<float> right(left.size(), kRightLevel);
+  storage->writeFramesOffline(1, 0, left, right);
+  limit::TapeTransport transport;
+  transport.prepare(kTestSampleRate, kTestBlock);
+  juce::AudioBuffer<float> tape(limit::kStereoChannelCount * limit::kTapeTrackCount, kTestBlock);
+
+  constexpr int kLoopStart = (2 * kTestChunkFrames) + 100;
+  constexpr int kLoopEnd = kLoopStart + (18 * kTestChunkFrames);
+  constexpr int kSpinUpBlocks = 4;
+  transport.locate(kLoopStart);
+  transport.setLoop(kLoopStart, kLoopEnd);
+  transport.play();
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  auto wraps = 0;
+  auto previous = transport.position();
+  for (int block = 0; block < 3 * (kLoopEnd - kLoopStart) / kTestBlock; ++block) {
+    storage->service();
+    renderBlocks(transport, *storage, tape, 1);
+    if (transport.position() < previous) {
+      ++wraps;
+    }
+    previous = transport.position();
+    if (block >= kSpinUpBlocks) {
+      REQUIRE(near(tape.getSample(2, 0), kLeftLevel));
+      REQUIRE(near(tape.getSample(2, kTestBlock - 1), kLeftLevel));
+    }
+  }
+  REQUIRE(wraps >= 2);
+  REQUIRE(transport.underrunCount() == 0);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape transport plays silence outside the resident window", "[tape][transport]") {
+  const TempDirectory directory("transport-test-underrun");
+  auto storage = limit::TapeStorage::open({.directory = directory.get(),
+                                           .sample_rate = kTestSampleRate,
+                                           .length_seconds = 1,
+                                           .chunk_frames = kTestChunkFrames});
+  REQUIRE(storage != nullptr); // NOLINT(cppcoreguidelines-avoid-do-while)
+  limit::TapeTransport transport;
+  transport.prepare(kTestSampleRate, kTestBlock);
+  juce::AudioBuffer<float> tape(limit::kStereoChannelCount * limit::kTapeTrackCount, kTestBlock);
+  transport.play();
+  renderBlocks(transport, *storage, tape, 1);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(transport.underrunCount() == static_cast<std::uint64_t>(storage->trackCount()));
+  REQUIRE(juce::exactlyEqual(tape.getSample(0, kTestBlock - 1), 0.0f));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape transport does not allocate while rendering", "[tape][transport][realtime]") {
+  if (!limit::isAllocationTrapEnabled()) {
+    SKIP("Needs the allocation trap (LIMIT_ALLOCATION_TRAP=ON)");
+  }
+  const TempDirectory directory("transport-test-realtime");
+  auto storage = openTestTape(directory.get());
+  REQUIRE(storage != nullptr); // NOLINT(cppcoreguidelines-avoid-do-while)
+  limit::TapeTransport transport;
+  transport.prepare(kTestSampleRate, kTestBlock);
+  juce::AudioBuffer<float> tape(limit::kStereoChannelCount * limit::kTapeTrackCount, kTestBlock);
+  transport.setSpeed(limit::kTapeMaxSpeed);
+  transport.setReverse(true);
+  transport.locate(kTestSampleRate / 2);
+  transport.play();
+
+  const auto before = limit::realtimeAllocationCount();
+  {
+    const limit::ScopedRealtimeSection realtime_section;
+    renderBlocks(transport, *storage, tape, 4);
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(limit::realtimeAllocationCount() == before);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Tape transport renders the same tracks on a worker pool", "[tape][transport]") {
+  constexpr float kTrickSpeed = 1.37f;
+  const TempDirectory directory("transport-test-pool");
+  auto storage = openTestTape(directory.get());
+  REQUIRE(storage != nullptr); // NOLINT(cppcoreguidelines-avoid-do-while)
+  limit::RealtimeWorkerPool pool({.worker_count = 3,
+                                  .pin_threads = false,
+                                  .first_core = 1,
+                                  .realtime_priority = 0,
+                                  .spin_iterations = limit::kDefaultPoolSpinIterations});
+  pool.start();
+
+  std::array<limit::TapeTransport, 2> transports;
+  std::array<juce::AudioBuffer<float>, 2> tapes;
+  for (auto &transport : transports) {
+    transport.prepare(kTestSampleRate, kTestBlock);
+    transport.setSpeed(kTrickSpeed);
+    transport.locate(kTestChunkFrames);
+    transport.play();
+  }
+  transports.at(1).setWorkerPool(&pool);
+  for (auto &tape : tapes) {
+    tape.setSize(limit::kStereoChannelCount * limit::kTapeTrackCount, kTestBlock);
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  for (int block = 0; block < 16; ++block) {
+    for (std::size_t index = 0; index < transports.size(); ++index) {
+      renderBlocks(transports.at(index), *storage, tapes.at(index), 1);
+    }
+    for (int channel = 0; channel < tapes.at(0).getNumChannels(); ++channel) {
+      for (int sample = 0; sample < kTestBlock; ++sample) {
+        REQUIRE(juce::exactlyEqual(tapes.at(1).getSample(channel, sample),
+                                   tapes.at(0).getSample(channel, sample)));
+      }
+    }
+  }
+  REQUIRE(transports.at(1).position() == transports.at(0).position());
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+// Hidden from the default run; use `limit-tests "[benchmark]"`. Eight tracks
+// at a fractional speed is the worst case for the read head.
+TEST_CASE("Tape transport block cost", "[.][benchmark][transport]") {
+  constexpr int kMinBlockSize = 32;
+  constexpr int kMaxBlockSize = 1024;
+  constexpr float kTrickSpeed = 1.37f;
+  const TempDirectory directory("transport-test-benchmark");
+  auto storage = openTestTape(directory.get());
+  REQUIRE(storage != nullptr); // NOLINT(cppcoreguidelines-avoid-do-while)
+  for (int block_size = kMinBlockSize; block_size <= kMaxBlockSize; block_size *= 2) {
+    limit::TapeTransport transport;
+    transport.prepare(kTestSampleRate, block_size);
+    juce::AudioBuffer<float> tape(limit::kStereoChannelCount * limit::kTapeTrackCount,
+                                  block_size);
+    transport.setSpeed(kTrickSpeed);
+    transport.setLoop(kTestChunkFrames, kTestSampleRate - kTestChunkFrames);
+    transport.locate(kTestChunkFrames);
+    transport.play();
+
+    BENCHMARK("tape transport " + std::to_string(block_size) + " samples") {
+      transport.render(*storage, tape, block_size);
+      return tape.getSample(0, 0);
+    };
+  }
+}
@@ -0,0 +1,65 @@
+#include "test-files.h"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+namespace limit::test {
+namespace {
+constexpr std::uint16_t kPcmFormat = 1;
+constexpr std::uint16_t kFloatFormat = 3;
+constexpr std::uint32_t kFmtChunkBytes = 16;
+// The RIFF size counts everything after itself: "WAVE", the fmt chunk and
+// the data chunk header.
+constexpr std::uint32_t kRiffHeaderBytes = 36;
+constexpr float kPcmScale = 32767.0f;
+
+template <typename T> void writeValue(std::ofstream &out, T value) {
+  std::array<char, sizeof(T)> bytes{};
+  std::memcpy(bytes.data(), &value, sizeof(value));
+  out.write(bytes.data(), bytes.size());
+}
+} // namespace
+
+TempDirectory::TempDirectory(const std::string &name)
+    : path(std::filesystem::temp_directory_path() / ("limit-" + name)) {
+  std::filesystem::remove_all(path);
+  std::filesystem::create_directories(path);
+}
+
+TempDirectory::~TempDirectory() { std::filesystem::remove_all(path); }
+
+auto TempDirectory::get() const -> const std::filesystem::path & { return path; }
+
+auto writeWav(const std::filesystem::path &path, int sample_rate, int channels,
+              std::span<const float> interleaved, bool as_float) -> std::filesystem::path {
+  std::filesystem::create_directories(path.parent_path());
+  const auto bytes_per_sample = static_cast<std::uint32_t>(as_float ? 4 : 2);
+  const auto data_bytes = static_cast<std::uint32_t>(interleaved.size()) * bytes_per_sample;
+  const auto block_align = static_cast<std::uint32_t>(channels) * bytes_per_sample;
+
+  std::ofstream out(path, std::ios::binary);
+  out.write("RIFF", 4);
+  writeValue<std::uint32_t>(out, kRiffHeaderBytes + data_bytes);
+  out.write("WAVEfmt ", 8);
+  writeValue<std::uint32_t>(out, kFmtChunkBytes);
+  writeValue<std::uint16_t>(out, as_float ? kFloatFormat : kPcmFormat);
+  writeValue<std::uint16_t>(out, static_cast<std::uint16_t>(channels));
+  writeValue<std::uint32_t>(out, static_cast<std::uint32_t>(sample_rate));
+  writeValue<std::uint32_t>(out, static_cast<std::uint32_t>(sample_rate) * block_align);
+  writeValue<std::uint16_t>(out, static_cast<std::uint16_t>(block_align));
+  writeValue<std::uint16_t>(out, static_cast<std::uint16_t>(bytes_per_sample * 8));
+  out.write("data", 4);
+  writeValue<std::uint32_t>(out, data_bytes);
+  for (const auto sample : interleaved) {
+    if (as_float) {
+      writeValue(out, sample);
+    } else {
+      writeValue(out, static_cast<std::int16_t>(std::lround(sample * kPcmScale)));
+    }
+  }
+  return path;
+}
+} // namespace limit::test
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <string>
+
+namespace limit::test {
+// An empty directory "limit-<name>" under the system temporary directory,
+// removed with everything in it when the object goes away.
+class TempDirectory {
+public:
+  explicit TempDirectory(const std::string &name);
+  ~TempDirectory();
+  TempDirectory(const TempDirectory &) = delete;
+  auto operator=(const TempDirectory &) -> TempDirectory & = delete;
+  TempDirectory(TempDirectory &&) = delete;
+  auto operator=(TempDirectory &&) -> TempDirectory & = delete;
+
+  auto get() const -> const std::filesystem::path &;
+
+private:
+  std::filesystem::path path;
+};
+
+// Writes interleaved samples as a canonical 16-bit PCM or 32-bit float WAV
+// and returns path.
+auto writeWav(const std::filesystem::path &path, int sample_rate, int channels,
+              std::span<const float> interleaved, bool as_float = false)
+    -> std::filesystem::path;
+} // namespace limit::test
@@ -56,3 +56,41 @@ TEST_CASE("UI theme is available for tests") {
   REQUIRE(theme.font_name != nullptr);
   // NOLINTEND(cppcoreguidelines-avoid-do-while)
 }
+
+TEST_CASE("UI dirty regions coalesce until taken") {
+  limit::UiDirtyRegions dirty;
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE_FALSE(dirty.any());
+  dirty.mark(limit::UiRegion::kSecondary);
+  dirty.mark(limit::UiRegion::kSecondary);
+  dirty.mark(limit::UiRegion::kEncoder);
+  REQUIRE(dirty.isDirty(limit::UiRegion::kSecondary));
+  REQUIRE(dirty.isDirty(limit::UiRegion::kEncoder));
+  REQUIRE_FALSE(dirty.isDirty(limit::UiRegion::kHeader));
+
+  const auto taken = dirty.take();
+  REQUIRE(taken.isDirty(limit::UiRegion::kSecondary));
+  REQUIRE_FALSE(dirty.any());
+
+  dirty.markAll();
+  for (int region = 0; region < limit::kUiRegionCount; ++region) {
+    REQUIRE(dirty.isDirty(static_cast<limit::UiRegion>(region)));
+  }
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("UI layout regions map to layout rectangles") {
+  const auto layout = limit::computeUiLayout({.width = 200,
+                                              .height = 100,
+                                              .header_height = 20,
+                                              .visualization_ratio = 0.5f,
+                                              .encoder_ratio = 0.25f});
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(limit::layoutRegion(layout, limit::UiRegion::kHeader).height == 20);
+  REQUIRE(limit::layoutRegion(layout, limit::UiRegion::kVisualization).y == 20);
+  REQUIRE(limit::layoutRegion(layout, limit::UiRegion::kEncoder).width == 50);
+  REQUIRE(limit::layoutRegion(layout, limit::UiRegion::kSecondary).x == 50);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
@@ -0,0 +1,76 @@
+#include "voice-allocator.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE("Voice allocator assigns and releases voices", "[voices]") {
+  limit::VoiceAllocator allocator(4);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  const auto first = allocator.noteOn(60);
+  const auto second = allocator.noteOn(64);
+  REQUIRE(first.voice == 0);
+  REQUIRE(second.voice == 1);
+  REQUIRE(first.stolen_note == -1);
+  REQUIRE(allocator.voiceForNote(64) == 1);
+  REQUIRE(allocator.activeVoiceCount() == 2);
+
+  REQUIRE(allocator.noteOn(60).voice == first.voice);
+  REQUIRE(allocator.activeVoiceCount() == 2);
+
+  REQUIRE(allocator.noteOff(60) == first.voice);
+  REQUIRE(allocator.voiceForNote(60) == -1);
+  REQUIRE(allocator.isVoiceReleasing(first.voice));
+  REQUIRE(allocator.isVoiceActive(first.voice));
+  REQUIRE(allocator.noteOff(60) == -1);
+
+  allocator.voiceFinished(first.voice);
+  REQUIRE_FALSE(allocator.isVoiceActive(first.voice));
+  REQUIRE(allocator.activeVoiceCount() == 1);
+  REQUIRE(allocator.noteOn(67).voice == first.voice);
+
+  REQUIRE(allocator.noteOn(-1).voice == -1);
+  REQUIRE(allocator.noteOn(limit::kMidiNoteCount).voice == -1);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Voice allocator steals the oldest voice", "[voices]") {
+  limit::VoiceAllocator allocator(3, limit::VoiceStealPolicy::kOldest);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  allocator.noteOn(60);
+  allocator.noteOn(62);
+  allocator.noteOn(64);
+  const auto stolen = allocator.noteOn(65);
+  REQUIRE(stolen.voice == 0);
+  REQUIRE(stolen.stolen_note == 60);
+  REQUIRE(allocator.voiceForNote(60) == -1);
+  REQUIRE(allocator.voiceForNote(65) == 0);
+
+  allocator.noteOff(64);
+  const auto released = allocator.noteOn(67);
+  REQUIRE(released.voice == 2);
+  REQUIRE(released.stolen_note == 64);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Voice allocator steals the quietest voice", "[voices]") {
+  constexpr float kLoud = 0.9f;
+  constexpr float kQuiet = 0.1f;
+  limit::VoiceAllocator allocator(3, limit::VoiceStealPolicy::kQuietest);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  allocator.noteOn(60);
+  allocator.noteOn(62);
+  allocator.noteOn(64);
+  allocator.setVoiceLevel(0, kLoud);
+  allocator.setVoiceLevel(1, kQuiet);
+  allocator.setVoiceLevel(2, kLoud);
+
+  const auto stolen = allocator.noteOn(65);
+  REQUIRE(stolen.voice == 1);
+  REQUIRE(stolen.stolen_note == 62);
+
+  allocator.setVoiceLevel(1, kLoud);
+  REQUIRE(allocator.noteOn(67).voice == 0);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
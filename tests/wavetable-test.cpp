@@ -0,0 +1,131 @@
+#include "oscillator-bank.h"
+#include "realtime-guard.h"
+#include "wavetable.h"
+
+#include <cmath>
+#include <numbers>
+#include <string>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+constexpr double kSampleRate = 48000.0;
+constexpr int kBlockSize = 256;
+// Eight presets' worth of tables plus the oscillator state for every voice
+// should fit comfortably in a typical 256 KiB L2 cache.
+constexpr std::size_t kCacheBudgetBytes = 256 * 1024;
+} // namespace
+
+TEST_CASE("Wavetable picks the richest level below Nyquist", "[wavetable]") {
+  limit::WavetableCache cache;
+  const auto &saw = cache.get(limit::WavetableShape::kSaw);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  for (const auto frequency : {20.0, 110.0, 440.0, 1760.0, 7040.0, 15000.0}) {
+    const auto level = saw.levelForIncrement(frequency / kSampleRate);
+    const auto top_harmonic = limit::Wavetable::levelHarmonics(level) * frequency;
+    REQUIRE(top_harmonic < kSampleRate / 2.0);
+    if (level > 0) {
+      REQUIRE(limit::Wavetable::levelHarmonics(level - 1) * frequency >= kSampleRate / 2.0);
+    }
+  }
+  for (int level = 0; level < limit::kWavetableLevelCount; ++level) {
+    const auto samples = saw.level(level);
+    REQUIRE(samples.size() == static_cast<std::size_t>(limit::Wavetable::levelSize(level)) + 1);
+    REQUIRE(limit::Wavetable::levelSize(level) >= 4 * limit::Wavetable::levelHarmonics(level));
+  }
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Oscillator bank renders each lane at its own pitch", "[wavetable]") {
+  limit::WavetableCache cache;
+  limit::OscillatorBank bank;
+  bank.prepare(kSampleRate, kBlockSize);
+  bank.startLane(0, cache.get(limit::WavetableShape::kSine), 440.0);
+  bank.startLane(3, cache.get(limit::WavetableShape::kSine), 1000.0);
+  bank.render(kBlockSize);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  for (int sample = 0; sample < kBlockSize; ++sample) {
+    const auto time = static_cast<double>(sample) / kSampleRate;
+    const auto expected_a = std::sin(2.0 * std::numbers::pi * 440.0 * time);
+    const auto expected_b = std::sin(2.0 * std::numbers::pi * 1000.0 * time);
+    REQUIRE(std::abs(bank.laneSample(0, sample) - expected_a) < 1.0e-3);
+    REQUIRE(std::abs(bank.laneSample(3, sample) - expected_b) < 1.0e-3);
+    REQUIRE(std::abs(bank.laneSample(1, sample)) < 1.0e-9);
+  }
+
+  std::vector<float> mixed(kBlockSize, 0.0f);
+  bank.addLane(3, mixed, 0.5f);
+  REQUIRE(std::abs(mixed.at(10) - (0.5f * bank.laneSample(3, 10))) < 1.0e-6f);
+
+  bank.stopLane(3);
+  bank.render(kBlockSize);
+  REQUIRE(bank.laneLevel(3) == -1);
+  REQUIRE(std::abs(bank.laneSample(3, kBlockSize - 1)) < 1.0e-9);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Oscillator bank switches level with pitch", "[wavetable]") {
+  limit::WavetableCache cache;
+  limit::OscillatorBank bank;
+  bank.prepare(kSampleRate, kBlockSize);
+  bank.startLane(0, cache.get(limit::WavetableShape::kSquare), 55.0);
+  const auto low_level = bank.laneLevel(0);
+  bank.setLaneFrequency(0, 3520.0);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(bank.laneLevel(0) > low_level);
+
+  const auto before = limit::realtimeAllocationCount();
+  {
+    const limit::ScopedRealtimeSection realtime_section;
+    bank.render(kBlockSize);
+  }
+  if (limit::isAllocationTrapEnabled()) {
+    REQUIRE(limit::realtimeAllocationCount() == before);
+  }
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Wavetable footprint stays cache friendly", "[wavetable]") {
+  constexpr int kPresetCount = 8;
+  std::vector<limit::Wavetable> presets;
+  presets.reserve(kPresetCount);
+  for (int preset = 0; preset < kPresetCount; ++preset) {
+    const auto shape = static_cast<limit::WavetableShape>(preset % limit::kWavetableShapeCount);
+    presets.emplace_back(limit::makeShapeHarmonics(shape));
+  }
+  limit::OscillatorBank bank;
+  bank.prepare(kSampleRate, kBlockSize);
+
+  std::size_t total = bank.memoryBytes();
+  for (const auto &table : presets) {
+    total += table.memoryBytes();
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(total < kCacheBudgetBytes);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Oscillator bank block cost", "[.][benchmark][wavetable]") {
+  constexpr int kMinBlockSize = 32;
+  constexpr int kMaxBlockSize = 1024;
+  limit::WavetableCache cache;
+  cache.prebuild();
+  for (int block_size = kMinBlockSize; block_size <= kMaxBlockSize; block_size *= 2) {
+    limit::OscillatorBank bank;
+    bank.prepare(kSampleRate, block_size);
+    for (int lane = 0; lane < limit::kMaxVoices; ++lane) {
+      bank.startLane(lane, cache.get(limit::WavetableShape::kSaw), 55.0 * (lane + 1));
+    }
+
+    BENCHMARK("oscillator bank " + std::to_string(block_size) + " samples") {
+      bank.render(block_size);
+      return bank.laneSample(0, 0);
+    };
+  }
+}
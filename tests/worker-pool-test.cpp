@@ -0,0 +1,116 @@
+#include "realtime-guard.h"
+#include "worker-pool.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+constexpr int kTestWorkers = 3;
+constexpr int kMaxItems = 64;
+
+struct CountingJob {
+  std::array<std::atomic<int>, kMaxItems> runs{};
+};
+
+void countRun(void *context, int index) {
+  static_cast<CountingJob *>(context)->runs.at(static_cast<std::size_t>(index)).fetch_add(1);
+}
+
+auto everyItemRanOnce(const CountingJob &job, int count) -> bool {
+  for (int index = 0; index < kMaxItems; ++index) {
+    const auto expected = index < count ? 1 : 0;
+    if (job.runs.at(static_cast<std::size_t>(index)).load() != expected) {
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+TEST_CASE("Worker pool runs every item exactly once", "[worker-pool]") {
+  constexpr int kJobs = 2000;
+  limit::RealtimeWorkerPool pool({.worker_count = kTestWorkers,
+                                  .pin_threads = false,
+                                  .first_core = 1,
+                                  .realtime_priority = 0,
+                                  .spin_iterations = limit::kDefaultPoolSpinIterations});
+  pool.start();
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(pool.workerCount() == kTestWorkers);
+  for (int job_index = 0; job_index < kJobs; ++job_index) {
+    const auto count = 1 + (job_index % kMaxItems);
+    CountingJob job;
+    pool.parallelFor(count, &countRun, &job);
+    REQUIRE(everyItemRanOnce(job, count));
+  }
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Worker pool wakes parked workers", "[worker-pool]") {
+  constexpr auto kIdle = std::chrono::milliseconds(20);
+  limit::RealtimeWorkerPool pool({.worker_count = kTestWorkers,
+                                  .pin_threads = false,
+                                  .first_core = 1,
+                                  .realtime_priority = 0,
+                                  .spin_iterations = 0});
+  pool.start();
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  for (int round = 0; round < 3; ++round) {
+    std::this_thread::sleep_for(kIdle);
+    CountingJob job;
+    pool.parallelFor(kMaxItems, &countRun, &job);
+    REQUIRE(everyItemRanOnce(job, kMaxItems));
+  }
+  pool.stop();
+  CountingJob inline_job;
+  pool.parallelFor(kMaxItems, &countRun, &inline_job);
+  REQUIRE(everyItemRanOnce(inline_job, kMaxItems));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Worker pool stays below the submitter's priority", "[worker-pool]") {
+  constexpr int kRequestedPriority = 70;
+  limit::RealtimeWorkerPool pool({.worker_count = kTestWorkers,
+                                  .pin_threads = false,
+                                  .first_core = 1,
+                                  .realtime_priority = kRequestedPriority,
+                                  .spin_iterations = limit::kDefaultPoolSpinIterations});
+  pool.start();
+  CountingJob job;
+  // The test thread runs on the normal scheduler, so the workers must too.
+  pool.parallelFor(kMaxItems, &countRun, &job);
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  REQUIRE(everyItemRanOnce(job, kMaxItems));
+  REQUIRE(pool.workerPriority() == 0);
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}
+
+TEST_CASE("Worker pool does not allocate per job", "[worker-pool][realtime]") {
+  limit::RealtimeWorkerPool pool({.worker_count = kTestWorkers,
+                                  .pin_threads = false,
+                                  .first_core = 1,
+                                  .realtime_priority = 0,
+                                  .spin_iterations = limit::kDefaultPoolSpinIterations});
+  pool.start();
+  CountingJob job;
+
+  const auto before = limit::realtimeAllocationCount();
+  {
+    const limit::ScopedRealtimeSection realtime_section;
+    pool.parallelFor(kMaxItems, &countRun, &job);
+  }
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-do-while)
+  if (limit::isAllocationTrapEnabled()) {
+    REQUIRE(limit::realtimeAllocationCount() == before);
+  }
+  REQUIRE(everyItemRanOnce(job, kMaxItems));
+  // NOLINTEND(cppcoreguidelines-avoid-do-while)
+}